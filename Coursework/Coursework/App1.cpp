@@ -2,6 +2,7 @@
 // Lab 1 example, simple coloured triangle mesh
 #include "App1.h"
 #include "DXF.h"
+#include "WaveMath.h"
 
 App1::App1()
 {
@@ -62,30 +63,62 @@ App1::~App1()
 		manipulationDepthShader = 0;
 	}
 
-	if (verticalBlurShader)
+	for (int i = 0; i < 4; i++) {
+		if (verticalBlurShaders[i])
+		{
+			delete verticalBlurShaders[i];
+			verticalBlurShaders[i] = 0;
+		}
+
+		if (horizontalBlurShaders[i])
+		{
+			delete horizontalBlurShaders[i];
+			horizontalBlurShaders[i] = 0;
+		}
+	}
+
+	if (mergeShader)
+	{
+		delete mergeShader;
+		mergeShader = 0;
+	}
+	
+	if (kawaseDownShader)
 	{
-		delete verticalBlurShader;
-		verticalBlurShader = 0;
+		delete kawaseDownShader;
+		kawaseDownShader = 0;
 	}
 
-	if (horizontalBlurShader)
+	if (kawaseUpShader)
 	{
-		delete horizontalBlurShader;
-		horizontalBlurShader = 0;
+		delete kawaseUpShader;
+		kawaseUpShader = 0;
 	}
 
-	if (thresholdShader)
+	if (summedAreaDownsampleShader)
 	{
-		delete thresholdShader;
-		thresholdShader = 0;
+		delete summedAreaDownsampleShader;
+		summedAreaDownsampleShader = 0;
 	}
 
-	if (mergeShader)
+	if (summedAreaScanShader)
 	{
-		delete mergeShader;
-		mergeShader = 0;
+		delete summedAreaScanShader;
+		summedAreaScanShader = 0;
 	}
-	
+
+	if (summedAreaBoxShader)
+	{
+		delete summedAreaBoxShader;
+		summedAreaBoxShader = 0;
+	}
+
+	if (bilateralDownsampleShader)
+	{
+		delete bilateralDownsampleShader;
+		bilateralDownsampleShader = 0;
+	}
+
 	if (toneMapper)
 	{
 		delete toneMapper;
@@ -116,11 +149,77 @@ App1::~App1()
 		manipTessDepthShader = 0;
 	}
 
+	if (tessBakeShader)
+	{
+		delete tessBakeShader;
+		tessBakeShader = 0;
+	}
+
+	if (bakedShader)
+	{
+		delete bakedShader;
+		bakedShader = 0;
+	}
+
 	if (manipGeometryShader)
 	{
 		delete manipGeometryShader;
 		manipGeometryShader = 0;
 	}
+
+	if (shadowAtlas)
+	{
+		delete shadowAtlas;
+		shadowAtlas = 0;
+	}
+
+	if (pointShadowMaps)
+	{
+		delete pointShadowMaps;
+		pointShadowMaps = 0;
+	}
+
+	if (lightFrame)
+	{
+		delete lightFrame;
+		lightFrame = 0;
+	}
+
+	if (displacementMap)
+	{
+		delete displacementMap;
+		displacementMap = 0;
+	}
+
+	if (exposureMeter)
+	{
+		delete exposureMeter;
+		exposureMeter = 0;
+	}
+
+	if (gradeLut)
+	{
+		delete gradeLut;
+		gradeLut = 0;
+	}
+
+	if (patchCulling)
+	{
+		delete patchCulling;
+		patchCulling = 0;
+	}
+
+	if (graphTargets)
+	{
+		delete graphTargets;
+		graphTargets = 0;
+	}
+
+	if (postTargets)
+	{
+		delete postTargets;
+		postTargets = 0;
+	}
 }
 
 
@@ -149,46 +248,111 @@ bool App1::frame()
 
 bool App1::render()
 {
-	// generate each light's depth textures
-	for (int i = 0; i < 4; i++) {
-		// if the light is enabled
-		if (lightData[i]->lightEnabled) {
-			// if it's a point light
-			if (lightType[i] == 0) {
-				// generate the 6 depth map cube faces
-				for (int j = 0; j < 6; j++) {
-					// set the direction to the normalised vectors of the faces
-					lights[i]->setDirection(dirs[j].x, dirs[j].y, dirs[j].z);
-					depthPass(shadowMap[i][j], lights[i], i);
-				}
-
-			}
-			else {
-				// only generate one depth map
-				depthPass(shadowMap[i][0], lights[i], i);
-			}
-		}
+	allocateShadowMaps();
+	updateCascades();
+
+	// every pass that draws the manipulation plane reads its displacement from this, so build it first
+	displacementMap->update(renderer->getDeviceContext(), time, waveSettings, heightMapAmplitude);
+	planeBounds.update(displacementMap->getField().getHeightMapMin(), displacementMap->getField().getHeightMapMax(), heightMapAmplitude,
+		float2(waveSettings[0].x, waveSettings[1].x), planeToSphere, float4(spherePosition.x, spherePosition.y, spherePosition.z, spherePosition.w),
+		TESSELLATED_PLANE_RESOLUTION - 1.0f, float3(-15.0f, -8.0f, -15.0f));
+	patchCulling->setSurface(displacementMap->getField().getHeightMapMin(), displacementMap->getField().getHeightMapMax(), heightMapAmplitude, waveSettings,
+		planeToSphere, spherePosition, TESSELLATED_PLANE_RESOLUTION);
+
+	// declare the frame's passes, the graph works out which of them run and when their targets are bound and cleared
+	frameGraph.reset();
+	int backBuffer = frameGraph.importResource("back buffer", true);
+	int shadowMaps = frameGraph.importResource("shadow maps", false);
+	int bakedPlane = frameGraph.importResource("baked plane", false);
+
+	// displace the plane once, every depth view and the camera pass below draw the same triangles
+	if (bakeTessellation) {
+		int bake = frameGraph.addPass("tessellation bake", [this]() {
+			// every view reuses the bake, so it can't drop anything one of them might see
+			patchCulling->disable(renderer->getDeviceContext());
+			tessBakeShader->bake(renderer->getDeviceContext(), planeSphere, XMMatrixTranslation(-15, -8, -15), displacementMap->getShaderResourceView(), time, waveSettings,
+				planeToSphere, heightMapAmplitude, spherePosition, tessInsideFactor, tessEdgeFactor, dynamicTessNear, dynamicTessFar, dynamicTess, camera);
+		});
+		frameGraph.writeExternal(bake, bakedPlane);
 	}
 
+	int shadows = frameGraph.addPass("shadow maps", [this]() { renderShadowMaps(); });
+	frameGraph.read(shadows, bakedPlane);
+	frameGraph.writeExternal(shadows, shadowMaps);
+
+	int scene;
 	if (enableBlur || enableBloom) {
-		// renders scene to rendertexture
-		renderScene(true);
-		// blur scene
-		doPostProcessing();
+		// render the scene to a texture and post process it onto the back buffer
+		int sceneTarget = frameGraph.createTarget("scene", sWidth, sHeight, DXGI_FORMAT_R32G32B32A32_FLOAT);
+		scene = frameGraph.addPass("scene", [this]() { renderScene(); });
+		frameGraph.write(scene, sceneTarget, RenderGraph::WRITE_CLEAR);
+
+		addPostProcessing(sceneTarget, backBuffer);
 	}
 	else {
 		// render the scene to the back buffer
-		renderScene(false);
+		scene = frameGraph.addPass("scene", [this]() { renderScene(); });
+		frameGraph.write(scene, backBuffer, RenderGraph::WRITE_CLEAR);
 	}
+	frameGraph.read(scene, shadowMaps);
+	frameGraph.read(scene, bakedPlane);
+
+	int overlay = frameGraph.addPass("overlay", [this]() { overlayPass(); });
+	frameGraph.write(overlay, backBuffer, RenderGraph::WRITE_LOAD);
+
+	postTargets->beginFrame();
+	frameGraph.compile();
+	frameGraph.execute(*graphTargets);
+
+	// Present the rendered scene to the screen.
+	renderer->endScene();
 
 	return true;
 }
 
+void App1::renderShadowMaps()
+{
+	// the atlas is shared by every light that isn't using a cube, clear it once then render each light to its own tiles
+	shadowAtlas->bindAndClear(renderer->getDeviceContext());
+	for (int i = 0; i < 4; i++) {
+		for (int c = 0; c < 4 && shadowTiles[i][c] >= 0; c++) {
+			// dual paraboloid point lights render the down and up hemispheres
+			if (lightType[i] == POINT)
+				lights[i]->setDirection(dirs[c].x, dirs[c].y, dirs[c].z);
+
+			shadowAtlas->setTileViewport(renderer->getDeviceContext(), shadowTiles[i][c]);
+			depthPass(lights[i], i, c);
+		}
+	}
+
+	// cube point lights render each cube face to its own slice of the cube array
+	for (int i = 0; i < 4; i++) {
+		if (pointCubes[i] >= 0) {
+			// generate the 6 depth map cube faces
+			for (int j = 0; j < 6; j++) {
+				// set the direction to the normalised vectors of the faces
+				lights[i]->setDirection(dirs[j].x, dirs[j].y, dirs[j].z);
+				pointShadowMaps->BindDsvAndSetNullRenderTarget(renderer->getDeviceContext(), pointCubes[i] * 6 + j);
+				depthPass(lights[i], i);
+			}
+		}
+	}
+
+	// every lit draw shares the same light data, so build it once now the depth passes have set up each light's matrices
+	lightFrame->update(renderer->getDeviceContext(), shadowAtlas, shadowTiles, pointShadowMaps, pointCubes, pointShadowMode, cascades, mapBias, nearPlane, farPlane,
+		lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff);
+}
+
 void App1::update() {
 	// update time
 	time += timer->getTime();
-	// update map to render
-	shadowMapToRender = shadowMap[mapToRender][0];		
+
+	// measure whichever capture of the scene has come back, the exposure eases towards what suits it
+	if (enablePP && enableHDR && autoExposureEnabled) {
+		if (exposureMeter->read(renderer->getDeviceContext(), meterPixels))
+			autoExposure.measure(meterPixels.data(), exposureMeter->getWidth(), exposureMeter->getHeight());
+		exposure = autoExposure.update(timer->getTime());
+	}
 
 	// set post processing modes
 	if (enablePP) {
@@ -225,15 +389,13 @@ void App1::update() {
 }
 
 #pragma region Post Processing
-void App1::horizontalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture)
+void App1::horizontalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, bool threshold)
 {
 	// create matrices
 	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
 
-	// set the screen size and render target
+	// the graph has already bound the target
 	float screenSizeX = (float)target->getTextureWidth();
-	target->setRenderTarget(renderer->getDeviceContext());
-	target->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
 
 	worldMatrix = renderer->getWorldMatrix();
 	baseViewMatrix = camera->getOrthoViewMatrix();
@@ -242,12 +404,9 @@ void App1::horizontalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture*
 	// Render for Horizontal Blur
 	renderer->setZBuffer(false);
 	mesh->sendData(renderer->getDeviceContext());
-	horizontalBlurShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), screenSizeX);
-	horizontalBlurShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	horizontalBlurShaders[blurRadius]->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), screenSizeX, threshold, bloomThreshold);
+	horizontalBlurShaders[blurRadius]->render(renderer->getDeviceContext(), mesh->getIndexCount());
 	renderer->setZBuffer(true);
-
-	// Reset the render target back to the original back buffer and not the render to texture anymore.
-	renderer->setBackBufferRenderTarget();
 }
 
 void App1::verticalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture)
@@ -255,11 +414,8 @@ void App1::verticalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* t
 	// create the matrices
 	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
 
-	// set the screen size and create a render target
+	// the graph has already bound the target
 	float screenSizeY = (float)target->getTextureHeight();
-	target->setRenderTarget(renderer->getDeviceContext());
-	target->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
-	
 
 	worldMatrix = renderer->getWorldMatrix();
 	baseViewMatrix = camera->getOrthoViewMatrix();
@@ -268,185 +424,478 @@ void App1::verticalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* t
 	// Render for Vertical Blur
 	renderer->setZBuffer(false);
 	mesh->sendData(renderer->getDeviceContext());
-	verticalBlurShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), screenSizeY);
-	verticalBlurShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	verticalBlurShaders[blurRadius]->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), screenSizeY);
+	verticalBlurShaders[blurRadius]->render(renderer->getDeviceContext(), mesh->getIndexCount());
 	renderer->setZBuffer(true);
-
-	// Reset the render target back to the original back buffer and not the render to texture anymore.
-	renderer->setBackBufferRenderTarget();
 }
 
-void App1::scaleTexture(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture)
+void App1::additiveBlend(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture1, RenderTexture* texture2, float intensity)
 {
-	// create the matrices
 	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
-	// set the render target
-	target->setRenderTarget(renderer->getDeviceContext());
-	target->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
 
 	worldMatrix = renderer->getWorldMatrix();
 	baseViewMatrix = camera->getOrthoViewMatrix();
 	orthoMatrix = target->getOrthoMatrix();
 
-	// render the texture to the render target and ortho mesh of the same size
+	// add the two textures
 	renderer->setZBuffer(false);
 	mesh->sendData(renderer->getDeviceContext());
-	textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView());
-	textureShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	mergeShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture1->getShaderResourceView(), texture2->getShaderResourceView(), intensity);
+	mergeShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
 	renderer->setZBuffer(true);
+}
+
+void App1::composite(RenderTexture* scene, RenderTexture* bloom, RenderTexture* guide, float sceneWeight, float bloomWeight)
+{
+	XMMATRIX worldMatrix = renderer->getWorldMatrix();
+	XMMATRIX orthoMatrix = renderer->getOrthoMatrix();
+	XMMATRIX orthoViewMatrix = camera->getOrthoViewMatrix();
+
+	// the LUT is only rebaked when the grade changes, the exposure is applied to its coordinates
+	if (enableHDR)
+		gradeLut->update(renderer->getDeviceContext(), gradeSettings());
 
-	// Reset the render target back to the original back buffer and not the render to texture anymore.
-	renderer->setBackBufferRenderTarget();
+	// add the bloom or blur to the scene and tone map it straight onto the back buffer
+	renderer->setZBuffer(false);
+	fullScreenMesh->sendData(renderer->getDeviceContext());
+	toneMapper->setShaderParameters(renderer->getDeviceContext(), worldMatrix, orthoViewMatrix, orthoMatrix, scene->getShaderResourceView(), bloom->getShaderResourceView(),
+		sceneWeight, bloomWeight, enableHDR, gradeLut->getShaderResourceView(), exposure);
+	if (guide)
+		toneMapper->setUpsampleParameters(renderer->getDeviceContext(), guide->getShaderResourceView(), scene->getDepthShaderResourceView(), guide->getTextureWidth(), guide->getTextureHeight(),
+			upsampleDepthSigma, upsampleLuminanceSigma, SCREEN_NEAR, SCREEN_DEPTH);
+	else
+		toneMapper->setUpsampleParameters(renderer->getDeviceContext(), NULL, NULL, 0, 0, 0.0f, 0.0f, SCREEN_NEAR, SCREEN_DEPTH);
+	toneMapper->render(renderer->getDeviceContext(), fullScreenMesh->getIndexCount());
+	renderer->setZBuffer(true);
 }
 
-void App1::getBloomThreshold()
+void App1::kawaseDown(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, bool threshold)
 {
 	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
-	// set render target
-	thresholdTexture->setRenderTarget(renderer->getDeviceContext());
-	thresholdTexture->clearRenderTarget(renderer->getDeviceContext(), 0.0f, 0.0f, 0.0f, 1.0f);
 
 	worldMatrix = renderer->getWorldMatrix();
 	baseViewMatrix = camera->getOrthoViewMatrix();
-	orthoMatrix = thresholdTexture->getOrthoMatrix();
+	orthoMatrix = target->getOrthoMatrix();
 
-	// get the brightest parts of the scene ready for bloom 
+	// the taps are spread in the texels of the texture being halved
 	renderer->setZBuffer(false);
-	fullScreenMesh->sendData(renderer->getDeviceContext());
-	thresholdShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, renderTexture->getShaderResourceView(), bloomThreshold);
-	thresholdShader->render(renderer->getDeviceContext(), fullScreenMesh->getIndexCount());
+	mesh->sendData(renderer->getDeviceContext());
+	kawaseDownShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(),
+		(float)texture->getTextureWidth(), (float)texture->getTextureHeight(), kawaseOffset, threshold, bloomThreshold);
+	kawaseDownShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
 	renderer->setZBuffer(true);
+}
+
+void App1::kawaseUp(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, RenderTexture* level, float levelWeight)
+{
+	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
+
+	worldMatrix = renderer->getWorldMatrix();
+	baseViewMatrix = camera->getOrthoViewMatrix();
+	orthoMatrix = target->getOrthoMatrix();
 
-	// Reset the render target back to the original back buffer and not the render to texture anymore.
-	renderer->setBackBufferRenderTarget();
+	// the taps are spread in the texels of the texture being doubled
+	renderer->setZBuffer(false);
+	mesh->sendData(renderer->getDeviceContext());
+	kawaseUpShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), level->getShaderResourceView(),
+		(float)texture->getTextureWidth(), (float)texture->getTextureHeight(), kawaseOffset, levelWeight);
+	kawaseUpShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	renderer->setZBuffer(true);
 }
 
-void App1::doToneMapping(RenderTexture* texture)
+void App1::summedAreaDownsample(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, bool threshold)
 {
 	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
-	// set the render target
-	toneMappedFilter->setRenderTarget(renderer->getDeviceContext());
-	toneMappedFilter->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
 
 	worldMatrix = renderer->getWorldMatrix();
 	baseViewMatrix = camera->getOrthoViewMatrix();
-	orthoMatrix = toneMappedFilter->getOrthoMatrix();
+	orthoMatrix = target->getOrthoMatrix();
 
-	// do tone mapping 
+	// the target has the table's zero row and column on top of the downsampled image
 	renderer->setZBuffer(false);
-	fullScreenMesh->sendData(renderer->getDeviceContext());
-	toneMapper->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), exposure, gammaCorrection);
-	toneMapper->render(renderer->getDeviceContext(), fullScreenMesh->getIndexCount());
+	mesh->sendData(renderer->getDeviceContext());
+	summedAreaDownsampleShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(),
+		target->getTextureWidth() - 1, target->getTextureHeight() - 1, threshold, bloomThreshold);
+	summedAreaDownsampleShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
 	renderer->setZBuffer(true);
+}
+
+void App1::summedAreaScan(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, XMINT2 direction, int stride)
+{
+	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
+
+	worldMatrix = renderer->getWorldMatrix();
+	baseViewMatrix = camera->getOrthoViewMatrix();
+	orthoMatrix = target->getOrthoMatrix();
 
-	// Reset the render target back to the original back buffer and not the render to texture anymore.
-	renderer->setBackBufferRenderTarget();
+	renderer->setZBuffer(false);
+	mesh->sendData(renderer->getDeviceContext());
+	summedAreaScanShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture->getShaderResourceView(), direction, stride);
+	summedAreaScanShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	renderer->setZBuffer(true);
 }
 
-void App1::additiveBlend(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture1, RenderTexture* texture2, float intensity)
+void App1::summedAreaBox(OrthoMesh* mesh, RenderTexture* target, RenderTexture* table, const StackedBoxes& boxes)
 {
 	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
-	// set the render target
-	target->setRenderTarget(renderer->getDeviceContext());
-	target->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
 
 	worldMatrix = renderer->getWorldMatrix();
 	baseViewMatrix = camera->getOrthoViewMatrix();
 	orthoMatrix = target->getOrthoMatrix();
 
-	// add the two textures
 	renderer->setZBuffer(false);
 	mesh->sendData(renderer->getDeviceContext());
-	mergeShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, texture1->getShaderResourceView(), texture2->getShaderResourceView(), intensity);
-	mergeShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	summedAreaBoxShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, table->getShaderResourceView(), boxes);
+	summedAreaBoxShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+	renderer->setZBuffer(true);
+}
+
+ColourGrade::Settings App1::gradeSettings()
+{
+	ColourGrade::Settings settings;
+	settings.toneCurve = toneCurve;
+	settings.balance[0] = colourBalance.x;
+	settings.balance[1] = colourBalance.y;
+	settings.balance[2] = colourBalance.z;
+	settings.saturation = saturation;
+	settings.gamma = gammaCorrection ? 2.2f : 1.0f;
+	return settings;
+}
+
+void App1::meterScene(RenderTexture* target, RenderTexture* scene)
+{
+	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
+
+	worldMatrix = renderer->getWorldMatrix();
+	baseViewMatrix = camera->getOrthoViewMatrix();
+	orthoMatrix = target->getOrthoMatrix();
+
+	// a bilinear tap every 8 texels, plenty of samples for a histogram
+	renderer->setZBuffer(false);
+	meterMesh->sendData(renderer->getDeviceContext());
+	textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, scene->getShaderResourceView());
+	textureShader->render(renderer->getDeviceContext(), meterMesh->getIndexCount());
 	renderer->setZBuffer(true);
+}
+
+void App1::addExposureMeter(int scene)
+{
+	// the readback is an output so the graph keeps the passes, nothing this frame reads it
+	int readback = frameGraph.importResource("exposure readback", true);
+	int meter = frameGraph.createTarget("exposure meter", meterSize.x, meterSize.y, DXGI_FORMAT_R32G32B32A32_FLOAT);
+
+	int pass = frameGraph.addPass("exposure meter", [=]() { meterScene(graphTargets->get(meter), graphTargets->get(scene)); });
+	frameGraph.read(pass, scene);
+	frameGraph.write(pass, meter, RenderGraph::WRITE_COVER);
+
+	pass = frameGraph.addPass("exposure readback", [=]() { exposureMeter->capture(renderer->getDeviceContext(), graphTargets->get(meter)); });
+	frameGraph.read(pass, meter);
+	frameGraph.writeExternal(pass, readback);
+}
+
+void App1::reduceScene(RenderTexture* target, RenderTexture* scene)
+{
+	XMMATRIX worldMatrix, baseViewMatrix, orthoMatrix;
 
-	// Reset the render target back to the original back buffer and not the render to texture anymore.
-	renderer->setBackBufferRenderTarget();
+	worldMatrix = renderer->getWorldMatrix();
+	baseViewMatrix = camera->getOrthoViewMatrix();
+	orthoMatrix = target->getOrthoMatrix();
+
+	// the scene's depth buffer isn't bound any more, the graph has bound the reduced target's
+	int scale = 1 << postResolution;
+	renderer->setZBuffer(false);
+	reducedMeshes[postResolution]->sendData(renderer->getDeviceContext());
+	bilateralDownsampleShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, baseViewMatrix, orthoMatrix, scene->getShaderResourceView(), scene->getDepthShaderResourceView(),
+		scale, scene->getTextureWidth(), scene->getTextureHeight(), SCREEN_NEAR, SCREEN_DEPTH);
+	bilateralDownsampleShader->render(renderer->getDeviceContext(), reducedMeshes[postResolution]->getIndexCount());
+	renderer->setZBuffer(true);
 }
 
-void App1::doPostProcessing()
+void App1::addPostProcessing(int scene, int backBuffer)
 {
+	if (enableHDR && autoExposureEnabled)
+		addExposureMeter(scene);
+
+	// at half or quarter resolution the blur starts from a reduced copy of the scene, which also guides the composite's
+	// upsample so the blur doesn't bleed over depth edges. only the composite is full size
+	int source = scene;
+	int guide = -1;
+	int pass;
+	if (postResolution != FULL_RESOLUTION) {
+		guide = frameGraph.createTarget("reduced scene", reducedSizes[postResolution].x, reducedSizes[postResolution].y, DXGI_FORMAT_R32G32B32A32_FLOAT);
+		pass = frameGraph.addPass("reduced scene", [=]() { reduceScene(graphTargets->get(guide), graphTargets->get(scene)); });
+		frameGraph.read(pass, scene);
+		frameGraph.write(pass, guide, RenderGraph::WRITE_COVER);
+		source = guide;
+	}
 
-	if (enableBloom)
-		getBloomThreshold();
+	// blur and bloom each pick their own blur, the composite adds the result to the scene in the same pass that tone maps it
+	int filter;
+	if (blurMethod[ppMode] == KAWASE_BLUR)
+		filter = addKawaseBlur(source);
+	else if (blurMethod[ppMode] == SUMMED_AREA_BLUR)
+		filter = addSummedAreaBlur(source);
+	else
+		filter = addGaussianBlur(source);
+
+	// blur only shows the blurred image, bloom adds it to the scene
+	float sceneWeight = enableBloom ? 1.0f : 0.0f;
+	float bloomWeight = enableBloom ? bloomIntensity : 1.0f;
+	pass = frameGraph.addPass("composite", [=]() { composite(graphTargets->get(scene), graphTargets->get(filter), guide >= 0 ? graphTargets->get(guide) : 0, sceneWeight, bloomWeight); });
+	frameGraph.read(pass, scene);
+	frameGraph.read(pass, filter);
+	if (guide >= 0)
+		frameGraph.read(pass, guide);
+	frameGraph.write(pass, backBuffer, RenderGraph::WRITE_COVER);
+}
 
-	// loop for the amount of blur passes selected
+int App1::addGaussianBlur(int scene)
+{
+	// every stage is declared, the graph drops the ones the shown image doesn't use, like the upsampling when only blurring.
+	// bloom thresholds the scene in its first horizontal blur and merges each level straight from the bilinear sampled
+	// level below it, so none of these passes are full size
+	unsigned int format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	int pass;
+
+	// blur either the thresholded scene or the full scene, each pass blurring the last vertical blur at a smaller size
+	int verticalBlurTexture[9];
 	for (int i = 0; i < blurPasses; i++) {
-		// if this is the first pass
-		if (i == 0) {
-			// blur either the threshold texture, or full scene
-			if (enableBloom)
-				horizontalBlur(sampleMeshes[i], horizontalBlurTexture[i], thresholdTexture);
+		int source = (i == 0) ? scene : verticalBlurTexture[i - 1];
+		bool threshold = enableBloom && i == 0;
+		int horizontalBlurTexture = frameGraph.createTarget("horizontal blur", aspectRatios[postResolution][i].x, aspectRatios[postResolution][i].y, format);
+		pass = frameGraph.addPass("horizontal blur", [=]() { horizontalBlur(sampleMeshes[postResolution][i], graphTargets->get(horizontalBlurTexture), graphTargets->get(source), threshold); });
+		frameGraph.read(pass, source);
+		frameGraph.write(pass, horizontalBlurTexture, RenderGraph::WRITE_COVER);
+
+		// apply a vertical blur to the most recent horizontal blur texture
+		verticalBlurTexture[i] = frameGraph.createTarget("vertical blur", aspectRatios[postResolution][i].x, aspectRatios[postResolution][i].y, format);
+		int target = verticalBlurTexture[i];
+		pass = frameGraph.addPass("vertical blur", [=]() { verticalBlur(sampleMeshes[postResolution][i], graphTargets->get(target), graphTargets->get(horizontalBlurTexture)); });
+		frameGraph.read(pass, horizontalBlurTexture);
+		frameGraph.write(pass, target, RenderGraph::WRITE_COVER);
+	}
+	int lastBlur = verticalBlurTexture[blurPasses - 1];
+
+	// bloom adds each level to the one below it on the way back up, the merge samples the smaller level bilinearly
+	// so it doesn't need scaling to the level's size first
+	int combinedPass = lastBlur;
+	for (int i = blurPasses - 2; i >= 0; i--) {
+		int source = combinedPass;
+		int level = verticalBlurTexture[i];
+		combinedPass = frameGraph.createTarget("combined pass", aspectRatios[postResolution][i].x, aspectRatios[postResolution][i].y, format);
+		int target = combinedPass;
+		pass = frameGraph.addPass("combine", [=]() { additiveBlend(sampleMeshes[postResolution][i], graphTargets->get(target), graphTargets->get(level), graphTargets->get(source), 1.0f); });
+		frameGraph.read(pass, level);
+		frameGraph.read(pass, source);
+		frameGraph.write(pass, target, RenderGraph::WRITE_COVER);
+	}
+
+	// blur only shows the last level
+	return enableBloom ? combinedPass : lastBlur;
+}
+
+int App1::addKawaseBlur(int scene)
+{
+	// each downsample halves the image with 5 taps and each upsample doubles it back with 8, the radius doubling with every
+	// level, so a blur as wide as 9 gaussian levels takes 6 levels at an offset of 3, with a 13th of the taps. it ends at half size and the
+	// composite's bilinear sample does the last doubling
+	unsigned int format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	int pass;
+
+	int downTexture[6];
+	for (int i = 0; i < kawasePasses; i++) {
+		int source = (i == 0) ? scene : downTexture[i - 1];
+		bool threshold = enableBloom && i == 0;
+		downTexture[i] = frameGraph.createTarget("kawase down", kawaseSizes[postResolution][i].x, kawaseSizes[postResolution][i].y, format);
+		int target = downTexture[i];
+		pass = frameGraph.addPass("kawase down", [=]() { kawaseDown(kawaseMeshes[postResolution][i], graphTargets->get(target), graphTargets->get(source), threshold); });
+		frameGraph.read(pass, source);
+		frameGraph.write(pass, target, RenderGraph::WRITE_COVER);
+	}
+
+	// bloom adds each level on the way back up, like the gaussian levels' merge
+	int result = downTexture[kawasePasses - 1];
+	float levelWeight = enableBloom ? 1.0f : 0.0f;
+	for (int i = kawasePasses - 2; i >= 0; i--) {
+		int source = result;
+		int level = enableBloom ? downTexture[i] : source; // blur doesn't sample the level, so don't keep it alive for this pass
+		result = frameGraph.createTarget("kawase up", kawaseSizes[postResolution][i].x, kawaseSizes[postResolution][i].y, format);
+		int target = result;
+		pass = frameGraph.addPass("kawase up", [=]() { kawaseUp(kawaseMeshes[postResolution][i], graphTargets->get(target), graphTargets->get(source), graphTargets->get(level), levelWeight); });
+		frameGraph.read(pass, source);
+		frameGraph.read(pass, level);
+		frameGraph.write(pass, target, RenderGraph::WRITE_COVER);
+	}
+
+	return result;
+}
+
+int App1::addSummedAreaBlur(int scene)
+{
+	// the scene is box filtered to a quarter of its size and summed along the rows then down the columns, after which any
+	// box average is 4 loads. a few stacked boxes stand in for a gaussian, so the blur costs the same at any radius and
+	// takes 11 small passes where 9 gaussian levels take up to 26. bloom is one wide glow rather than the sum of the levels
+	unsigned int format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	int tableWidth = summedAreaSize[postResolution].x + 1;
+	int tableHeight = summedAreaSize[postResolution].y + 1;
+	int pass;
+
+	int table = frameGraph.createTarget("summed area downsample", tableWidth, tableHeight, format);
+	int target = table;
+	bool threshold = enableBloom;
+	pass = frameGraph.addPass("summed area downsample", [=]() { summedAreaDownsample(summedAreaMeshes[postResolution][0], graphTargets->get(target), graphTargets->get(scene), threshold); });
+	frameGraph.read(pass, scene);
+	frameGraph.write(pass, target, RenderGraph::WRITE_COVER);
+
+	// each pass adds 3 more texels 4 times further back, until the stride passes the table's edge
+	for (int axis = 0; axis < 2; axis++) {
+		XMINT2 direction = (axis == 0) ? XMINT2(1, 0) : XMINT2(0, 1);
+		int size = (axis == 0) ? tableWidth : tableHeight;
+		for (int stride = 1; stride < size; stride *= 4) {
+			int source = table;
+			table = frameGraph.createTarget("summed area scan", tableWidth, tableHeight, format);
+			target = table;
+			pass = frameGraph.addPass("summed area scan", [=]() { summedAreaScan(summedAreaMeshes[postResolution][0], graphTargets->get(target), graphTargets->get(source), direction, stride); });
+			frameGraph.read(pass, source);
+			frameGraph.write(pass, target, RenderGraph::WRITE_COVER);
+		}
+	}
+
+	// sigma in the table's texels, the radius stays in screen pixels at any resolution
+	XMINT2 size = summedAreaSize[postResolution];
+	StackedBoxes boxes = makeStackedBoxes(summedAreaRadius / 3.0f * size.x / sWidth);
+	int result = frameGraph.createTarget("summed area box", size.x, size.y, format);
+	int source = table;
+	pass = frameGraph.addPass("summed area box", [=]() { summedAreaBox(summedAreaMeshes[postResolution][1], graphTargets->get(result), graphTargets->get(source), boxes); });
+	frameGraph.read(pass, source);
+	frameGraph.write(pass, result, RenderGraph::WRITE_COVER);
+
+	return result;
+}
+#pragma endregion
+
+void App1::allocateShadowMaps()
+{
+	// enabled spot and directional lights request a tile of the atlas, cascaded directional lights request one per cascade
+	// and dual paraboloid point lights request one per hemisphere
+	shadowAtlas->clearRequests();
+	for (int i = 0; i < 4; i++) {
+		int tiles = 0;
+		if (lightData[i]->lightEnabled) {
+			if (lightType[i] == POINT)
+				tiles = (pointShadowMode[i] == PARABOLOID_SHADOWS) ? 2 : 0;
 			else
-				horizontalBlur(sampleMeshes[i], horizontalBlurTexture[i], renderTexture);
+				tiles = (lightType[i] == DIRECTIONAL && cascadeEnabled[i]) ? cascadeCount[i] : 1;
 		}
-		else {
-			// if this is not the first loop, blur the last vertical blur texture
-			horizontalBlur(sampleMeshes[i], horizontalBlurTexture[i], verticalBlurTexture[i - 1]);
+
+		for (int c = 0; c < 4; c++)
+			shadowTiles[i][c] = (c < tiles) ? shadowAtlas->requestTile(shadowTileSize[lightType[i]]) : -1;
+	}
+
+	// only reallocates when the requested tiles or format have changed, the atlas is released when nothing is requested
+	shadowAtlas->setFormat(shadowFormats[atlasFormat]);
+	shadowAtlas->pack(renderer->getDevice());
+
+	// if the tiles don't fit there's no atlas to render to, so these lights go without shadows until they do
+	if (shadowAtlas->hasFailed()) {
+		for (int i = 0; i < 4; i++) {
+			for (int c = 0; c < 4; c++)
+				shadowTiles[i][c] = -1;
 		}
+	}
 
-		// apply a vertical blur to the most recent horizontal blur texture
-		verticalBlur(sampleMeshes[i], verticalBlurTexture[i], horizontalBlurTexture[i]);
-
-		// no more scaling needs to be done so scale the texture to the screen size
-		if (!enableBloom)
-			scaleTexture(fullScreenMesh, blurFilter, verticalBlurTexture[i]);
-	}
-
-	if (enableBloom) {
-		// if there is more than one blur pass
-		if (blurPasses != 1) {
-			// loop through blur passes - 2. 
-			// (There will always be "blurpasses - 1" number of combined textures, and we're accessing i + 1. Hence "-2")
-			for (int i = blurPasses - 2; i >= 0; i--) {
-				// add all the blooms together
-				if (i == blurPasses - 2) {
-					// if this is the first loop, upSample the final blurpass texture
-					scaleTexture(sampleMeshes[i], upscaledPasses[i], verticalBlurTexture[i + 1]);
-				}
-				else {
-					// upsample the previoulsly combined texture
-					scaleTexture(sampleMeshes[i], upscaledPasses[i], combinedPasses[i + 1]); // +1 because we're counting down
-				}
-
-				// set combinedPasses as the target, then combine the vertical blur texture and upscaled texture  
-				additiveBlend(sampleMeshes[i], combinedPasses[i], verticalBlurTexture[i], upscaledPasses[i], 1.0f);
-			}
+	// enabled cube point lights get a cube each
+	int cubes = 0;
+	for (int i = 0; i < 4; i++) {
+		pointCubes[i] = -1;
+		if (lightData[i]->lightEnabled && lightType[i] == POINT && pointShadowMode[i] == CUBE_SHADOWS)
+			pointCubes[i] = cubes++;
+	}
 
-			// if we're done looping then render the final combined texture to the bloom filter
-			additiveBlend(fullScreenMesh, bloomFilter, renderTexture, combinedPasses[0], bloomIntensity);
+	// release the cube array if the number of cubes, their size or their format has changed
+	if (pointShadowMaps) {
+		if (pointShadowMaps->getSliceCount() != cubes * 6 || pointShadowMaps->getWidth() != shadowTileSize[POINT] ||
+			pointShadowMaps->getFormat() != shadowFormats[pointFormat]) {
+			delete pointShadowMaps;
+			pointShadowMaps = 0;
 		}
+	}
+
+	if (!pointShadowMaps && cubes > 0)
+		pointShadowMaps = new ShadowMap(renderer->getDevice(), shadowTileSize[POINT], shadowTileSize[POINT], cubes, true, shadowFormats[pointFormat]);
+}
+
+void App1::shadowMemoryGui()
+{
+	const char* typeNames[3] = { "Point", "Directional", "Spot" };
+	float megabyte = 1024.0f * 1024.0f;
+
+	ImGui::Combo("Atlas Format", &atlasFormat, "D16\0D24S8\0D32F\0");
+	ImGui::Combo("Point Light Format", &pointFormat, "D16\0D24S8\0D32F\0");
+	ImGui::Dummy(ImVec2(0, 5));
+
+	for (int i = 0; i < 4; i++) {
+		size_t bytes = 0;
+		if (pointCubes[i] >= 0)
+			bytes = pointShadowMaps->getMemorySize() / (pointShadowMaps->getSliceCount() / 6);
 		else {
-			// if there is only one blur pass then set the bloom filter to the scene + blur texture
-			additiveBlend(fullScreenMesh, bloomFilter, renderTexture, verticalBlurTexture[0], bloomIntensity);
+			for (int c = 0; c < 4; c++)
+				bytes += shadowAtlas->getTileMemorySize(shadowTiles[i][c]);
 		}
 
-	}
-
-	// do tone mapping if enabled
-	if (enableHDR) {
-		if (enableBloom)
-			doToneMapping(bloomFilter);
+		if (bytes)
+			ImGui::Text("Light %d (%s): %.2f MB", i + 1, typeNames[lightType[i]], bytes / megabyte);
 		else
-			doToneMapping(blurFilter);
-		// render the final filter to the screen
-		finalPass(toneMappedFilter);
+			ImGui::Text("Light %d (%s): none", i + 1, typeNames[lightType[i]]);
 	}
-	else {
-		// render the unaltered bloom/blur filter
-		if (enableBloom) 
-			finalPass(bloomFilter);		
-		else
-			finalPass(blurFilter);
+
+	size_t atlasBytes = shadowAtlas->getMemorySize();
+	size_t pointBytes = pointShadowMaps ? pointShadowMaps->getMemorySize() : 0;
+	ImGui::Text("Atlas: %.2f MB (%d x %d)", atlasBytes / megabyte, shadowAtlas->getWidth(), shadowAtlas->getHeight());
+	ImGui::Text("Point light cubes: %.2f MB", pointBytes / megabyte);
+	ImGui::Text("Total: %.2f MB", (atlasBytes + pointBytes) / megabyte);
+}
+
+void App1::postMemoryGui()
+{
+	const RenderTargetPool::Stats& stats = postTargets->getStats();
+	const RenderGraph::Stats& graphStats = frameGraph.getStats();
+	float megabyte = 1024.0f * 1024.0f;
+
+	ImGui::Text("Passes: %d run, %d culled", graphStats.passes - graphStats.culled, graphStats.culled);
+	ImGui::Text("Clears: %d, %d skipped. Binds: %d, %d skipped", graphStats.clears, graphStats.skippedClears, graphStats.binds, graphStats.skippedBinds);
+	ImGui::Text("Targets: %d aliased into %d", graphStats.targets, graphStats.physicalTargets);
+	ImGui::Text("Pool: %d textures, %.2f MB", stats.textures, stats.memory / megabyte);
+	ImGui::Text("Requests: %d, %d reused, %d allocated", stats.requests, stats.reuses, stats.allocations);
+}
+
+void App1::updateCascades()
+{
+	// cascades follow the camera, so it needs to be up to date before they're fitted
+	camera->update();
+	XMMATRIX viewMatrix = camera->getViewMatrix();
+	XMMATRIX projectionMatrix = renderer->getProjectionMatrix();
+
+	for (int i = 0; i < 4; i++) {
+		bool cascaded = lightData[i]->lightEnabled && lightType[i] == DIRECTIONAL && cascadeEnabled[i];
+		cascades[i].setCascadeCount(cascaded ? cascadeCount[i] : 0);
+		cascades[i].setSplitLambda(cascadeSplitLambda[i]);
+		cascades[i].setBlendRange(cascadeBlend[i]);
+
+		if (cascaded && shadowTiles[i][0] >= 0)
+			cascades[i].update(viewMatrix, projectionMatrix, SCREEN_NEAR, shadowDistance, lightData[i]->lightDirection, shadowAtlas->getTileSize(shadowTiles[i][0]));
 	}
 }
-#pragma endregion
 
-void App1::depthPass(ShadowMap* map, Light* light, int index)
+bool App1::planeInView(const XMMATRIX& view, const XMMATRIX& projection)
+{
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, view * projection);
+	return planeBounds.intersects(viewProjection.m);
+}
+
+void App1::depthPass(Light* light, int index, int cascade)
 {
-	// Set the render target to the shadow map
-	map->BindDsvAndSetNullRenderTarget(renderer->getDeviceContext());
 
 	// get the world, view, and projection matrices from the camera and d3d objects.
 	XMMATRIX lightProjectionMatrix;
@@ -466,6 +915,16 @@ void App1::depthPass(ShadowMap* map, Light* light, int index)
 
 	light->generateViewMatrix();
 	XMMATRIX lightViewMatrix = light->getViewMatrix();
+
+	// cascades replace the light's own view with one fitted to their slice of the camera frustum
+	if (lightType[index] == DIRECTIONAL && cascades[index].getCascadeCount() > 0) {
+		lightViewMatrix = cascades[index].getViewMatrix(cascade);
+		lightProjectionMatrix = cascades[index].getProjectionMatrix(cascade);
+	}
+
+	// dual paraboloid views are warped in the depth shaders instead of using the projection matrix
+	bool paraboloid = lightType[index] == POINT && pointShadowMode[index] == PARABOLOID_SHADOWS;
+
 	XMMATRIX worldMatrix = renderer->getWorldMatrix();
 	// save the default world matrix
 	XMMATRIX temp = worldMatrix;
@@ -474,9 +933,9 @@ void App1::depthPass(ShadowMap* map, Light* light, int index)
 		// render the 4 spheres
 		worldMatrix *= XMMatrixScaling(5.0f, 5.0f, 5.0f);
 		worldMatrix *= XMMatrixTranslation(spherePos[i].x, spherePos[i].y, spherePos[i].z);
-		sphere->sendData(renderer->getDeviceContext());
-		depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix);
-		depthShader->render(renderer->getDeviceContext(), plane->getIndexCount());
+		sphere->sendDepthData(renderer->getDeviceContext());
+		depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, paraboloid, nearPlane[index], farPlane[index]);
+		depthShader->render(renderer->getDeviceContext(), sphere->getIndexCount());
 		worldMatrix = temp;
 
 		// render the 4 cubes, scale and rotate them
@@ -484,50 +943,55 @@ void App1::depthPass(ShadowMap* map, Light* light, int index)
 		if (i > 1)
 			worldMatrix *= XMMatrixRotationY(XMConvertToRadians(90.0f));
 		worldMatrix *= XMMatrixTranslation(cubePos[i].x, cubePos[i].y, cubePos[i].z);
-		cube->sendData(renderer->getDeviceContext());
-		depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix);
+		cube->sendDepthData(renderer->getDeviceContext());
+		depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, paraboloid, nearPlane[index], farPlane[index]);
 		depthShader->render(renderer->getDeviceContext(), cube->getIndexCount());
 		worldMatrix = temp;
 	}
 
 	// render the vertex manipulation plane
 	worldMatrix *= XMMatrixTranslation(-15, -8, -15);
-	planeSphere->sendData(renderer->getDeviceContext(), D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
-	manipTessDepthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, textureMgr->getTexture(L"height"),
-		time, waveSettings, planeToSphere, heightMapAmplitude, spherePosition, tessInsideFactor, tessEdgeFactor, dynamicTessNear, dynamicTessFar, dynamicTess, camera);
-	manipTessDepthShader->render(renderer->getDeviceContext(), planeSphere->getIndexCount());	
+	if (!paraboloid && !planeInView(lightViewMatrix, lightProjectionMatrix)) {
+		// the plane can't reach this view, don't tessellate or rasterise it. paraboloids aren't a frustum so they always draw it
+	}
+	else if (bakeTessellation) {
+		// the baked plane is already in world space
+		tessBakeShader->sendDepthData(renderer->getDeviceContext());
+		depthShader->setShaderParameters(renderer->getDeviceContext(), XMMatrixIdentity(), lightViewMatrix, lightProjectionMatrix, paraboloid, nearPlane[index], farPlane[index]);
+		depthShader->renderAuto(renderer->getDeviceContext());
+	}
+	else {
+		// paraboloids have no frustum planes, and ortho light views have no single viewpoint to find a horizon from
+		if (paraboloid)
+			patchCulling->disable(renderer->getDeviceContext());
+		else
+			patchCulling->setView(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, light->getPosition(), lightType[index] != DIRECTIONAL);
+
+		planeSphere->sendDepthData(renderer->getDeviceContext(), D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST, true);
+		manipTessDepthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, displacementMap->getShaderResourceView(),
+			time, waveSettings, planeToSphere, heightMapAmplitude, spherePosition, tessInsideFactor, tessEdgeFactor, dynamicTessNear, dynamicTessFar, dynamicTess, camera,
+			paraboloid, nearPlane[index], farPlane[index]);
+		manipTessDepthShader->render(renderer->getDeviceContext(), planeSphere->getIndexCount());
+	}
 
 	// render the sphere-position-sphere
 	worldMatrix *= XMMatrixTranslation(spherePosition.x, spherePosition.y, spherePosition.z);
-	sphere->sendData(renderer->getDeviceContext());
-	depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix);
+	sphere->sendDepthData(renderer->getDeviceContext());
+	depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, paraboloid, nearPlane[index], farPlane[index]);
 	depthShader->render(renderer->getDeviceContext(), sphere->getIndexCount());
 	worldMatrix = temp;
 
 	// render the floor
 	worldMatrix *= XMMatrixTranslation(-50, -10, -50);
-	plane->sendData(renderer->getDeviceContext());
-	depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix);
+	plane->sendDepthData(renderer->getDeviceContext());
+	depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix, paraboloid, nearPlane[index], farPlane[index]);
 	depthShader->render(renderer->getDeviceContext(), plane->getIndexCount());
 	worldMatrix = temp;	
 
 }
 
-void App1::renderScene(bool renderToTexture)
+void App1::renderScene()
 {
-	// if we're not blurring the scene, set the render target to the back buffer
-	if (!renderToTexture) {
-		renderer->setBackBufferRenderTarget();
-		renderer->resetViewport();
-		// Clear the scene. (default blue colour)
-		renderer->beginScene(0.05f, 0.05f, 0.05f, 1.0f);
-	}
-	else {
-		 // Set the render target to be the render texture and clear it
-		renderTexture->setRenderTarget(renderer->getDeviceContext());
-		renderTexture->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
-	}
-
 	camera->update();
 
 	// Get the world, view, projection, and ortho matrices from the camera and Direct3D objects.
@@ -543,7 +1007,7 @@ void App1::renderScene(bool renderToTexture)
 		worldMatrix *= XMMatrixTranslation(lightData[i]->lightPosition.x, lightData[i]->lightPosition.y, lightData[i]->lightPosition.z);
 		sphere->sendData(renderer->getDeviceContext());
 		textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L""));
-		textureShader->render(renderer->getDeviceContext(), plane->getIndexCount());
+		textureShader->render(renderer->getDeviceContext(), sphere->getIndexCount());
 		worldMatrix = temp;		
 
 		// render the 4 spheres
@@ -551,7 +1015,7 @@ void App1::renderScene(bool renderToTexture)
 		worldMatrix *= XMMatrixTranslation(spherePos[i].x, spherePos[i].y, spherePos[i].z);
 		sphere->sendData(renderer->getDeviceContext());
 		textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, sphereTextures[i]);
-		textureShader->render(renderer->getDeviceContext(), plane->getIndexCount());
+		textureShader->render(renderer->getDeviceContext(), sphere->getIndexCount());
 		worldMatrix = temp;
 
 		// render the 4 cubes
@@ -561,7 +1025,7 @@ void App1::renderScene(bool renderToTexture)
 		worldMatrix *= XMMatrixTranslation(cubePos[i].x, cubePos[i].y, cubePos[i].z);
 		cube->sendData(renderer->getDeviceContext());
 		shadowShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix,
-			textureMgr->getTexture(L"brick"), shadowMap, mapBias, lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff, camera);
+			textureMgr->getTexture(L"brick"), lightFrame, camera);
 		shadowShader->render(renderer->getDeviceContext(), cube->getIndexCount());
 		worldMatrix = temp;
 
@@ -569,11 +1033,22 @@ void App1::renderScene(bool renderToTexture)
 
 	// render vertex manipulation plane
 	worldMatrix *= XMMatrixTranslation(-15, -8, -15);
-	planeSphere->sendData(renderer->getDeviceContext(), D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
-	manipTessShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L"height"),
-		textureMgr->getTexture(L"mars"), shadowMap, mapBias, lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff, time,
-		waveSettings, planeToSphere, heightMapAmplitude, spherePosition, tessInsideFactor, tessEdgeFactor, dynamicTessNear, dynamicTessFar, dynamicTess, showNormals, camera);
-	manipTessShader->render(renderer->getDeviceContext(), planeSphere->getIndexCount());
+	if (!planeInView(viewMatrix, projectionMatrix)) {
+		// off screen
+	}
+	else if (bakeTessellation) {
+		tessBakeShader->sendData(renderer->getDeviceContext());
+		bakedShader->setShaderParameters(renderer->getDeviceContext(), viewMatrix, projectionMatrix, textureMgr->getTexture(L"mars"), lightFrame, showNormals, camera);
+		bakedShader->renderAuto(renderer->getDeviceContext());
+	}
+	else {
+		patchCulling->setView(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, camera->getPosition(), true);
+		planeSphere->sendData(renderer->getDeviceContext(), D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+		manipTessShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, displacementMap->getShaderResourceView(),
+			textureMgr->getTexture(L"mars"), lightFrame, time,
+			waveSettings, planeToSphere, heightMapAmplitude, spherePosition, tessInsideFactor, tessEdgeFactor, dynamicTessNear, dynamicTessFar, dynamicTess, showNormals, camera);
+		manipTessShader->render(renderer->getDeviceContext(), planeSphere->getIndexCount());
+	}
 
 	// if the geometry shader is enabled, render the grass
 	if (enableGeometryShader) {
@@ -581,9 +1056,13 @@ void App1::renderScene(bool renderToTexture)
 		if (!wireframeToggle)
 			renderer->getDeviceContext()->RSSetState(newRasterState);
 
+		// grass blades stand 1.5 units off the surface (grassHeight in manipulationGeometry_gs) and sway with the wind
+		float grassReach = 1.5f + fabsf(windSettings[0].x) + fabsf(windSettings[1].x);
+		patchCulling->setView(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, camera->getPosition(), true, grassReach);
+
 		planeSphere->sendData(renderer->getDeviceContext(), D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
-		manipGeometryShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L"height"),
-			textureMgr->getTexture(L"mars"), shadowMap, mapBias, lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff, time,
+		manipGeometryShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, displacementMap->getShaderResourceView(),
+			textureMgr->getTexture(L"mars"), lightFrame, time,
 			waveSettings, windSettings, planeToSphere, heightMapAmplitude, spherePosition, tessInsideFactor, tessEdgeFactor, dynamicTessNear, dynamicTessFar, dynamicTess, surfaceLighting, camera);
 		manipGeometryShader->render(renderer->getDeviceContext(), planeSphere->getIndexCount());
 
@@ -595,7 +1074,7 @@ void App1::renderScene(bool renderToTexture)
 	worldMatrix *= XMMatrixTranslation(spherePosition.x, spherePosition.y, spherePosition.z);
 	sphere->sendData(renderer->getDeviceContext());
 	shadowShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix,
-		textureMgr->getTexture(L""), shadowMap, mapBias, lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff, camera);
+		textureMgr->getTexture(L""), lightFrame, camera);
 	shadowShader->render(renderer->getDeviceContext(), sphere->getIndexCount());	
 	worldMatrix = temp;	
 
@@ -604,71 +1083,50 @@ void App1::renderScene(bool renderToTexture)
 		worldMatrix *= XMMatrixTranslation(-50, -10, -50);
 		plane->sendData(renderer->getDeviceContext());
 		if (enablePP)
-			shadowShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L"dwood"), shadowMap, mapBias, lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff, camera);
+			shadowShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L"dwood"), lightFrame, camera);
 		else
-			shadowShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L"lwood"), shadowMap, mapBias, lights, attenuation, lightType, spotOuterAngle, spotInnerAngle, spotFalloff, camera);
+			shadowShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, viewMatrix, projectionMatrix, textureMgr->getTexture(L"lwood"), lightFrame, camera);
 
 		shadowShader->render(renderer->getDeviceContext(), plane->getIndexCount());
 		worldMatrix = temp;
 	}
-
-	// render the depth map if we're not doing post processing
-	if (!renderToTexture) {
-		if (displayMap) {
-			renderer->setZBuffer(false);
-			XMMATRIX orthoMatrix = renderer->getOrthoMatrix();  // ortho matrix for 2D rendering
-			XMMATRIX orthoViewMatrix = camera->getOrthoViewMatrix();	// Default camera position for orthographic rendering
-
-			ortho->sendData(renderer->getDeviceContext());
-			textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, orthoViewMatrix, orthoMatrix, shadowMapToRender->getDepthMapSRV());
-			textureShader->render(renderer->getDeviceContext(), ortho->getIndexCount());
-			renderer->setZBuffer(true);
-		}
-		// Render GUI
-		gui();
-
-		// Present the rendered scene to the screen.
-		renderer->endScene();
-	}
-	else {
-		// Reset the render target back to the original back buffer and not the render to texture anymore.
-		renderer->setBackBufferRenderTarget();
-	}
 }
 
-void App1::finalPass(RenderTexture* texture)
+void App1::overlayPass()
 {
-	renderer->beginScene(0.05f, 0.05f, 0.05f, 1.0f);
-
-	// RENDER THE RENDER TEXTURE SCENE
-	renderer->setZBuffer(false);
-	XMMATRIX worldMatrix = renderer->getWorldMatrix();
-	XMMATRIX orthoMatrix = renderer->getOrthoMatrix();  // ortho matrix for 2D rendering
-	XMMATRIX orthoViewMatrix = camera->getOrthoViewMatrix();	// Default camera position for orthographic rendering
-
-	// render the post processed scene to a screen sized ortho mesh
-	fullScreenMesh->sendData(renderer->getDeviceContext());
-	textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, orthoViewMatrix, orthoMatrix, texture->getShaderResourceView());
-	textureShader->render(renderer->getDeviceContext(), fullScreenMesh->getIndexCount());
-	renderer->setZBuffer(true);
-
 	// render the depth map if enabled
 	if (displayMap) {
 		renderer->setZBuffer(false);
+		XMMATRIX worldMatrix = renderer->getWorldMatrix();
 		XMMATRIX orthoMatrix = renderer->getOrthoMatrix();  // ortho matrix for 2D rendering
 		XMMATRIX orthoViewMatrix = camera->getOrthoViewMatrix();	// Default camera position for orthographic rendering
 
 		ortho->sendData(renderer->getDeviceContext());
-		textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, orthoViewMatrix, orthoMatrix, shadowMapToRender->getDepthMapSRV());
+		textureShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, orthoViewMatrix, orthoMatrix, shadowAtlas->getDepthMapSRV());
 		textureShader->render(renderer->getDeviceContext(), ortho->getIndexCount());
 		renderer->setZBuffer(true);
 	}
 
 	// Render GUI
 	gui();
+}
 
-	// Present the rendered scene to the screen.
-	renderer->endScene();
+void App1::autoExposureGui()
+{
+	AutoExposure::Settings settings = autoExposure.getSettings();
+	ImGui::SliderFloat("Exposure Key", &settings.key, 0.05f, 0.5f);
+	ImGui::SliderFloat("Adapt Up Speed", &settings.speedUp, 0.1f, 10.0f);
+	ImGui::SliderFloat("Adapt Down Speed", &settings.speedDown, 0.1f, 10.0f);
+	autoExposure.setSettings(settings);
+
+	// the histogram of the last readback, log2 luminance from minLogLuminance on the left to maxLogLuminance on the right
+	float bins[AutoExposure::HISTOGRAM_BINS];
+	for (int i = 0; i < AutoExposure::HISTOGRAM_BINS; i++)
+		bins[i] = (float)autoExposure.getHistogram()[i];
+	ImGui::PlotHistogram("Luminance", bins, AutoExposure::HISTOGRAM_BINS, 0, NULL, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+	const char* states[] = { "Waiting", "Adapting Up", "Adapting Down", "Settled" };
+	ImGui::Text("Exposure: %.3f -> %.3f (%s)", autoExposure.getExposure(), autoExposure.getTargetExposure(), states[autoExposure.getState()]);
 }
 
 void App1::gui()
@@ -688,12 +1146,42 @@ void App1::gui()
 		}
 		ImGui::RadioButton("Blur", &ppMode, 0); ImGui::SameLine();
 		ImGui::RadioButton("Bloom", &ppMode, 1);
-		ImGui::SliderInt("Blur Passes", &blurPasses, 1, 9);
+		ImGui::Combo("Blur Method", &blurMethod[ppMode], "Gaussian\0Dual Kawase\0Summed Area Table\0");
+		ImGui::Combo("Post Resolution", &postResolution, "Full\0Half\0Quarter\0");
+		if (postResolution != FULL_RESOLUTION) {
+			// 0 ignores depth or luminance, both at 0 is a plain bilinear upsample
+			ImGui::SliderFloat("Upsample Depth Sigma", &upsampleDepthSigma, 0.0f, 0.5f);
+			ImGui::SliderFloat("Upsample Luminance Sigma", &upsampleLuminanceSigma, 0.0f, 4.0f);
+		}
+		if (blurMethod[ppMode] == KAWASE_BLUR) {
+			ImGui::SliderInt("Kawase Passes", &kawasePasses, 1, 6);
+			ImGui::SliderFloat("Kawase Offset", &kawaseOffset, 0.5f, 3.0f);
+		}
+		else if (blurMethod[ppMode] == SUMMED_AREA_BLUR) {
+			ImGui::SliderFloat("Blur Radius (px)", &summedAreaRadius, 16.0f, 600.0f);
+		}
+		else {
+			ImGui::SliderInt("Blur Passes", &blurPasses, 1, 9);
+			ImGui::Combo("Blur Radius", &blurRadius, "3\0" "5\0" "8\0" "12\0");
+		}
 		ImGui::SliderFloat("Bloom Threshold", &bloomThreshold, 0.0f, 3.0f);
 		ImGui::SliderFloat("Bloom Intensity", &bloomIntensity, 0.0f, 1.0f);
 
-		if(enableHDR)
-			ImGui::SliderFloat("Tone Map Exposure", &exposure, 0.0f, 3.0f);
+		if (enableHDR) {
+			// switching it on starts from the next measurement instead of easing from the manual exposure
+			if (ImGui::Checkbox("Auto Exposure", &autoExposureEnabled))
+				autoExposure.reset();
+			if (autoExposureEnabled)
+				autoExposureGui();
+			else
+				ImGui::SliderFloat("Tone Map Exposure", &exposure, 0.01f, 3.0f);
+			ImGui::Combo("Tone Curve", &toneCurve, "Reinhard\0ACES\0");
+			ImGui::SliderFloat3("Colour Balance", &colourBalance.x, 0.0f, 2.0f);
+			ImGui::SliderFloat("Saturation", &saturation, 0.0f, 2.0f);
+		}
+
+		ImGui::Dummy(ImVec2(0, 5));
+		postMemoryGui();
 	}
 
 	ImGui::Dummy(ImVec2(0, 10));	
@@ -737,6 +1225,7 @@ void App1::gui()
 			ImGui::SliderInt("Inside Tessellation", &tessInsideFactor, 1, 16);
 			ImGui::SliderInt("Edge Tessellation", &tessEdgeFactor, 1, 16);
 		}
+		ImGui::Checkbox("Reuse Tessellated Plane", &bakeTessellation);
 	}
 
 	ImGui::PushID(10);
@@ -763,14 +1252,29 @@ void App1::gui()
 	ImGui::Dummy(ImVec2(0, 10));
 
 	// DEPTH MAP
-	ImGui::Checkbox("Display Depth Map", &displayMap);
+	ImGui::Checkbox("Display Shadow Atlas", &displayMap);
 	if (displayMap) {
-		ImGui::Text("Depth Map to Render (Point lights show bottom face)");
-		ImGui::RadioButton("Light 1", &mapToRender, 0); ImGui::SameLine();
-		ImGui::RadioButton("Light 2", &mapToRender, 1); ImGui::SameLine();
-		ImGui::RadioButton("Light 3", &mapToRender, 2); ImGui::SameLine();
-		ImGui::RadioButton("Light 4", &mapToRender, 3); ImGui::SameLine();
+		if (shadowAtlas->hasFailed())
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Atlas: the tiles don't fit in %d x %d, shadows are off", shadowAtlas->getMaxSize(), shadowAtlas->getMaxSize());
+		else
+			ImGui::Text("Atlas: %d x %d, %d tiles", shadowAtlas->getWidth(), shadowAtlas->getHeight(), shadowAtlas->getTileCount());
+		if (shadowAtlas->getScaleShift() > 0)
+			ImGui::Text("Tiles scaled down by %d to fit", 1 << shadowAtlas->getScaleShift());
+		ImGui::SliderInt("Point Cube Size", &shadowTileSize[POINT], 256, 2048);
+		ImGui::SliderInt("Directional Tile Size", &shadowTileSize[DIRECTIONAL], 256, 4096);
+		ImGui::SliderInt("Spot Tile Size", &shadowTileSize[SPOT], 256, 4096);
+		ImGui::Dummy(ImVec2(0, 5));
+	}
+
+	// SHADOW SETTINGS
+	if (ImGui::CollapsingHeader("Shadow Settings"))
+	{
+		ImGui::Indent(20);
+		// shared by every cascaded light, so it lives here rather than under each light
+		ImGui::SliderFloat("Shadow Distance", &shadowDistance, 20.0f, SCREEN_DEPTH);
 		ImGui::Dummy(ImVec2(0, 5));
+		shadowMemoryGui();
+		ImGui::Indent(-20);
 	}
 
 	// LIGHTS
@@ -841,6 +1345,26 @@ void App1::lightGui(int i)
 
 	ImGui::Dummy(ImVec2(0, 5));
 
+	// DIRECTIONAL
+	if (lightType[i] == DIRECTIONAL) {
+		ImGui::Checkbox("Cascaded Shadows", &cascadeEnabled[i]);
+		if (cascadeEnabled[i]) {
+			ImGui::SliderInt("Cascades", &cascadeCount[i], 2, CascadedShadows::MAX_CASCADES);
+			ImGui::SliderFloat("Split Lambda", &cascadeSplitLambda[i], 0.0f, 1.0f);
+			ImGui::SliderFloat("Cascade Blend", &cascadeBlend[i], 0.0f, 0.5f);
+			for (int c = 0; c < cascades[i].getCascadeCount(); c++)
+				ImGui::Text("Cascade %d ends at %.1f", c + 1, cascades[i].getSplit(c));
+		}
+		ImGui::Dummy(ImVec2(0, 5));
+	}
+
+	// POINT
+	if (lightType[i] == POINT) {
+		ImGui::Combo("Shadow Mode", &pointShadowMode[i], "Cube\0Dual Paraboloid\0");
+		ImGui::Text("%d depth passes, %d x %d per pass", (pointShadowMode[i] == PARABOLOID_SHADOWS) ? 2 : 6, shadowTileSize[POINT], shadowTileSize[POINT]);
+		ImGui::Dummy(ImVec2(0, 5));
+	}
+
 	// SPOTLIGHT
 	if (lightType[i] == SPOT) {
 		ImGui::SliderFloat("Outer Angle", &spotOuterAngle[i], 0, 180);
@@ -863,34 +1387,65 @@ void App1::initShaders(HWND hwnd)
 
 	// depth and shadow shaders
 	manipTessDepthShader = new ManipulationTessDepthShader(renderer->getDevice(), hwnd);
+	tessBakeShader = new ManipulationTessBakeShader(renderer->getDevice(), hwnd);
+	bakedShader = new ManipulationBakedShader(renderer->getDevice(), hwnd);
 	manipulationDepthShader = new ManipulationDepthShader(renderer->getDevice(), hwnd);
 	tessDepthShader = new TessellationDepthShader(renderer->getDevice(), hwnd);
 	depthShader = new DepthShader(renderer->getDevice(), hwnd);
 	shadowShader = new ShadowShader(renderer->getDevice(), hwnd);
 
 	// post processing shaders
-	verticalBlurShader = new VerticalBlurShader(renderer->getDevice(), hwnd);
-	horizontalBlurShader = new HorizontalBlurShader(renderer->getDevice(), hwnd);
-	thresholdShader = new BloomThresholdShader(renderer->getDevice(), hwnd);
+	for (int i = 0; i < 4; i++) {
+		verticalBlurShaders[i] = new VerticalBlurShader(renderer->getDevice(), hwnd, GAUSSIAN_RADII[i]);
+		horizontalBlurShaders[i] = new HorizontalBlurShader(renderer->getDevice(), hwnd, GAUSSIAN_RADII[i]);
+	}
 	mergeShader = new BloomMergeShader(renderer->getDevice(), hwnd);
+	kawaseDownShader = new KawaseDownShader(renderer->getDevice(), hwnd);
+	kawaseUpShader = new KawaseUpShader(renderer->getDevice(), hwnd);
+	summedAreaDownsampleShader = new SummedAreaDownsampleShader(renderer->getDevice(), hwnd);
+	summedAreaScanShader = new SummedAreaScanShader(renderer->getDevice(), hwnd);
+	summedAreaBoxShader = new SummedAreaBoxShader(renderer->getDevice(), hwnd);
+	bilateralDownsampleShader = new BilateralDownsampleShader(renderer->getDevice(), hwnd);
 	toneMapper = new ToneMapShader(renderer->getDevice(), hwnd);
 }
 
 void App1::initObjects(int width, int height)
 {
-	plane = new PlaneMesh(renderer->getDevice(), renderer->getDeviceContext(), 100);
-	planeSphere = new TessellatedPlaneMesh(renderer->getDevice(), renderer->getDeviceContext(), 30);
+	plane = new PlaneMesh(renderer->getDevice(), renderer->getDeviceContext(), PLANE_RESOLUTION);
+	planeSphere = new TessellatedPlaneMesh(renderer->getDevice(), renderer->getDeviceContext(), TESSELLATED_PLANE_RESOLUTION);
 	sphere = new SphereMesh(renderer->getDevice(), renderer->getDeviceContext());
 	cube = new CubeMesh(renderer->getDevice(), renderer->getDeviceContext());
+	// the shadow passes only read positions, and texture coordinates for the displaced plane
+	plane->buildDepthStreams(renderer->getDevice(), renderer->getDeviceContext());
+	planeSphere->buildDepthStreams(renderer->getDevice(), renderer->getDeviceContext());
+	sphere->buildDepthStreams(renderer->getDevice(), renderer->getDeviceContext());
+	cube->buildDepthStreams(renderer->getDevice(), renderer->getDeviceContext());
 	ortho = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
 		height / 3, height / 3, -width / 2.7, height / 2.7);
 	fullScreenMesh = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
 		width, height, 0.0, 0.0);
 
-	for (int i = 0; i < 9; i++) {
-		sampleMeshes[i] = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
-			aspectRatios[i].x, aspectRatios[i].y, 0, 0);
+	for (int r = 0; r < 3; r++) {
+		for (int i = 0; i < 9; i++) {
+			sampleMeshes[r][i] = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
+				aspectRatios[r][i].x, aspectRatios[r][i].y, 0, 0);
+		}
+
+		for (int i = 0; i < 6; i++) {
+			kawaseMeshes[r][i] = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
+				kawaseSizes[r][i].x, kawaseSizes[r][i].y, 0, 0);
+		}
+
+		summedAreaMeshes[r][0] = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
+			summedAreaSize[r].x + 1, summedAreaSize[r].y + 1, 0, 0);
+		summedAreaMeshes[r][1] = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
+			summedAreaSize[r].x, summedAreaSize[r].y, 0, 0);
+		reducedMeshes[r] = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
+			reducedSizes[r].x, reducedSizes[r].y, 0, 0);
 	}
+
+	meterMesh = new OrthoMesh(renderer->getDevice(), renderer->getDeviceContext(),
+		meterSize.x, meterSize.y, 0, 0);
 }
 
 void App1::initLights()
@@ -924,7 +1479,13 @@ void App1::initLights()
 		sceneWidth[i] = 100.0f;
 		lights[i]->generateOrthoMatrix(sceneWidth[i], sceneHeight[i], nearPlane[i], farPlane[i]);
 		mapBias[i] = 0.005f;
+		pointShadowMode[i] = CUBE_SHADOWS;
+		cascadeEnabled[i] = false;
+		cascadeCount[i] = 3;
+		cascadeSplitLambda[i] = 0.75f;
+		cascadeBlend[i] = 0.1f;
 	}
+	shadowDistance = 150.0f;
 	lightData[1]->lightEnabled = false;
 
 	// change specific defaults
@@ -977,35 +1538,34 @@ void App1::initTextures(int screenWidth, int screenHeight)
 	sphereTextures[2] = textureMgr->getTexture(L"colour2");
 	sphereTextures[3] = textureMgr->getTexture(L"colour3");
 
-	int shadowmapWidth = 2048;
-	int shadowmapHeight = 2048;
-
-	// create 24 shadow maps
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			shadowMap[i][j] = new ShadowMap(renderer->getDevice(), shadowmapWidth, shadowmapHeight);
-		}
-	}
-
-	renderTexture = new RenderTexture(renderer->getDevice(), screenWidth, screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
-	bloomFilter = new RenderTexture(renderer->getDevice(), screenWidth, screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
-	blurFilter = new RenderTexture(renderer->getDevice(), screenWidth, screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
-	toneMappedFilter = new RenderTexture(renderer->getDevice(), screenWidth, screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
-	thresholdTexture = new RenderTexture(renderer->getDevice(), screenWidth, screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
-
-	for (int i = 0; i < 9; i++) {
-		horizontalBlurTexture[i] = new RenderTexture(renderer->getDevice(), aspectRatios[i].x, aspectRatios[i].y, SCREEN_NEAR, SCREEN_DEPTH);
-		verticalBlurTexture[i] = new RenderTexture(renderer->getDevice(), aspectRatios[i].x, aspectRatios[i].y, SCREEN_NEAR, SCREEN_DEPTH);
-	}
-
-	for (int i = 0; i < 8; i++) {
-		combinedPasses[i] = new RenderTexture(renderer->getDevice(), aspectRatios[i].x, aspectRatios[i].y, SCREEN_NEAR, SCREEN_DEPTH);
-		upscaledPasses[i] = new RenderTexture(renderer->getDevice(), aspectRatios[i].x, aspectRatios[i].y, SCREEN_NEAR, SCREEN_DEPTH);
-	}
+	// shadow storage is allocated on the first frame once the lights have requested it
+	shadowFormats[0] = DXGI_FORMAT_D16_UNORM;
+	shadowFormats[1] = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	shadowFormats[2] = DXGI_FORMAT_D32_FLOAT;
+	atlasFormat = 2;
+	pointFormat = 0;
+
+	shadowAtlas = new ShadowAtlas(8192, shadowFormats[atlasFormat]);
+	pointShadowMaps = 0;
+	lightFrame = new LightFrameData(renderer->getDevice());
+	// 256 texels across the 30 unit plane keeps about 13 texels per wave at the highest frequency
+	displacementMap = new DisplacementMap(renderer->getDevice(), renderer->getDeviceContext(), textureMgr->getTexture(L"height"), 256, 30.0f);
+	patchCulling = new PatchCullData(renderer->getDevice());
+	shadowTileSize[POINT] = 1024;
+	shadowTileSize[DIRECTIONAL] = 2048;
+	shadowTileSize[SPOT] = 2048;
+
+	// post processing targets are created on first use, the render graph shares them between passes
+	postTargets = new RenderTargetPool(renderer->getDevice(), SCREEN_NEAR, SCREEN_DEPTH);
+	graphTargets = new RenderGraphTargets(renderer, postTargets);
+	exposureMeter = new ExposureMeter(renderer->getDevice(), meterSize.x, meterSize.y);
+	gradeLut = new ColourGradeLut(renderer->getDevice());
 }
 
 void App1::initVariables(int screenWidth, int screenHeight)
 {
+	sWidth = screenWidth;
+	sHeight = screenHeight;
 	time = 0.0f;
 	heightMapAmplitude = 14.0f;
 	waveSettings[0] = XMFLOAT3(0.0f, 0.65f, 1.0f);
@@ -1016,7 +1576,6 @@ void App1::initVariables(int screenWidth, int screenHeight)
 
 	planeToSphere = 0.0f;
 	spherePosition = XMFLOAT4(15.1f, 11.0f, 15.0f, 8.0f); // z value is radius
-	mapToRender = 0;
 
 	dirs[0] = XMFLOAT3(0.0f, -1.0f, 0.0f);
 	dirs[1] = XMFLOAT3(0.0f,  1.0f, 0.0f);
@@ -1041,8 +1600,10 @@ void App1::initVariables(int screenWidth, int screenHeight)
 	enablePP = false;
 	displayMap = false;
 	enableHDR = false;
+	autoExposureEnabled = false;
 	gammaCorrection = false;
 	dynamicTess = false;
+	bakeTessellation = true;
 	surfaceLighting = false;
 	enableGeometryShader = true;
 
@@ -1050,6 +1611,18 @@ void App1::initVariables(int screenWidth, int screenHeight)
 	tessEdgeFactor = 5;
 	bloomThreshold = 1.4f;
 	blurPasses = 9;
+	blurRadius = 1;
+	kawasePasses = 5;
+	kawaseOffset = 1.0f;
+	summedAreaRadius = 200.0f;
+	toneCurve = ColourGrade::REINHARD;
+	colourBalance = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	saturation = 1.0f;
+	postResolution = FULL_RESOLUTION;
+	upsampleDepthSigma = 0.1f;
+	upsampleLuminanceSigma = 2.0f;
+	blurMethod[0] = GAUSSIAN_BLUR;
+	blurMethod[1] = GAUSSIAN_BLUR;
 	ppMode = 1;
 	exposure = 1.0f;
 	bloomIntensity = 1.0f;
@@ -1057,32 +1630,49 @@ void App1::initVariables(int screenWidth, int screenHeight)
 	dynamicTessNear = 10.0f;
 
 	// get every 8th 16:9 aspect ratio to 128x72
-	aspectRatios[0].x = 1200 - 16;
-	aspectRatios[0].y = 675 - 9;
+	aspectRatios[0][0].x = 1200 - 16;
+	aspectRatios[0][0].y = 675 - 9;
+
+	aspectRatios[0][1].x = 1024;
+	aspectRatios[0][1].y = 576;
+
+	aspectRatios[0][2].x = 896;
+	aspectRatios[0][2].y = 504;
 
-	aspectRatios[1].x = 1024;
-	aspectRatios[1].y = 576;
+	aspectRatios[0][3].x = 512;
+	aspectRatios[0][3].y = 288;
 
-	aspectRatios[2].x = 896;
-	aspectRatios[2].y = 504;
+	aspectRatios[0][4].x = 256;
+	aspectRatios[0][4].y = 144;
 
-	aspectRatios[3].x = 512;
-	aspectRatios[3].y = 288;
+	aspectRatios[0][5].x = 128;
+	aspectRatios[0][5].y = 72;
 
-	aspectRatios[4].x = 256;
-	aspectRatios[4].y = 144;
+	aspectRatios[0][6].x = 64;
+	aspectRatios[0][6].y = 36;
 
-	aspectRatios[5].x = 128;
-	aspectRatios[5].y = 72;
+	aspectRatios[0][7].x = 32;
+	aspectRatios[0][7].y = 18;
 
-	aspectRatios[6].x = 64;
-	aspectRatios[6].y = 36;
+	aspectRatios[0][8].x = 16;
+	aspectRatios[0][8].y = 9;
 
-	aspectRatios[7].x = 32;
-	aspectRatios[7].y = 18;
+	// half and quarter resolution divide everything by 2 and 4, rounding up so odd sizes keep their edge texels
+	for (int r = 0; r < 3; r++) {
+		int scale = 1 << r;
+		reducedSizes[r] = XMINT2((sWidth + scale - 1) / scale, (sHeight + scale - 1) / scale);
+		for (int i = 0; i < 9; i++)
+			aspectRatios[r][i] = XMINT2((aspectRatios[0][i].x + scale - 1) / scale, (aspectRatios[0][i].y + scale - 1) / scale);
 
-	aspectRatios[8].x = 16;
-	aspectRatios[8].y = 9;
+		// each dual kawase level halves the last
+		kawaseSizes[r][0] = XMINT2((reducedSizes[r].x + 1) / 2, (reducedSizes[r].y + 1) / 2);
+		for (int i = 1; i < 6; i++)
+			kawaseSizes[r][i] = XMINT2((kawaseSizes[r][i - 1].x + 1) / 2, (kawaseSizes[r][i - 1].y + 1) / 2);
+
+		// a quarter of the scene it's made from keeps the table's sums small enough for floats
+		summedAreaSize[r] = XMINT2((reducedSizes[r].x + 3) / 4, (reducedSizes[r].y + 3) / 4);
+	}
+	meterSize = XMINT2((sWidth + 7) / 8, (sHeight + 7) / 8);
 
 	D3D11_RASTERIZER_DESC rasterDesc;
 	// Recreate the default raster state
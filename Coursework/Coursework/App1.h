@@ -11,15 +11,34 @@
 #include "TextureShader.h"
 #include "VerticalBlurShader.h"
 #include "HorizontalBlurShader.h"
-#include "BloomThresholdShader.h"
+#include "GaussianKernel.h"
 #include "BloomMergeShader.h"
+#include "KawaseDownShader.h"
+#include "KawaseUpShader.h"
+#include "SummedAreaDownsampleShader.h"
+#include "SummedAreaScanShader.h"
+#include "SummedAreaBoxShader.h"
+#include "BilateralDownsampleShader.h"
 #include "ToneMapShader.h"
 #include "TessellationShader.h"
 #include "TessellationDepthShader.h"
 #include "ManipulationTessShader.h"
 #include "ManipulationTessDepthShader.h"
+#include "ManipulationTessBakeShader.h"
+#include "ManipulationBakedShader.h"
 #include "TessellatedPlaneMesh.h"
 #include "ManipulationGeometryShader.h"
+#include "ShadowAtlas.h"
+#include "CascadedShadows.h"
+#include "LightFrameData.h"
+#include "DisplacementMap.h"
+#include "SurfaceBounds.h"
+#include "PatchCullData.h"
+#include "RenderTargetPool.h"
+#include "RenderGraphTargets.h"
+#include "AutoExposure.h"
+#include "ExposureMeter.h"
+#include "ColourGradeLut.h"
 
 class App1 : public BaseApplication
 {
@@ -37,16 +56,33 @@ protected:
 	void update();
 	void gui();
 
-	void depthPass(ShadowMap* map, Light* light, int index); // renders depth data to a shadowmap
-	void horizontalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture); 
+	void allocateShadowMaps(); // allocates shadow storage for the enabled lights, reallocating only when their types, sizes or formats change
+	void shadowMemoryGui(); // per light breakdown of the shadow map memory
+	void postMemoryGui(); // render graph and render target pool usage
+	void autoExposureGui(); // auto exposure settings, the last histogram and where the exposure is heading
+	void updateCascades(); // refits each cascaded directional light to the camera frustum
+	void depthPass(Light* light, int index, int cascade = 0); // renders depth data to whichever shadow map is bound
+	bool planeInView(const XMMATRIX& view, const XMMATRIX& projection); // false if the manipulation plane's bounds are outside the view
+	void horizontalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, bool threshold = false); // threshold keeps only the bright parts of the texture, for bloom
 	void verticalBlur(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture);
-	void scaleTexture(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture); // normal textureshader pass but the render target and mesh will up or down sample the image
-	void getBloomThreshold(); // generates an image consisting of the brightest parts of the scene only
-	void doToneMapping(RenderTexture* texture); // adjusts the bloom texture based on exposure and gamma
-	void doPostProcessing(); // does the multiple downscaling and upscaling passes to generate blur or bloom textures
+	void composite(RenderTexture* scene, RenderTexture* bloom, RenderTexture* guide, float sceneWeight, float bloomWeight); // weighted sum of the two, tone mapped if HDR is on. a reduced bloom is upsampled guided by guide
+	void addPostProcessing(int scene, int backBuffer); // adds the downscaling and upscaling passes that generate blur or bloom textures to the frame graph, composited onto the back buffer
+	void reduceScene(RenderTexture* target, RenderTexture* scene); // shrinks the scene to postResolution's size with its linear depth in alpha
+	void kawaseDown(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, bool threshold = false); // halves the texture, threshold keeps only its bright parts
+	void kawaseUp(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, RenderTexture* level, float levelWeight); // doubles the texture, adding level for bloom
+	int addGaussianBlur(int scene); // separable blur levels, returns the blurred image
+	int addKawaseBlur(int scene); // dual kawase down and upsampling, returns the blurred image
+	void summedAreaDownsample(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, bool threshold = false); // quarters the texture with a zero row and column for the table
+	void summedAreaScan(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture, XMINT2 direction, int stride); // one prefix sum pass along the rows or columns
+	void summedAreaBox(OrthoMesh* mesh, RenderTexture* target, RenderTexture* table, const StackedBoxes& boxes); // blurs with stacked boxes looked up in the table
+	int addSummedAreaBlur(int scene); // box blur from a summed area table at a quarter of the size, returns the blurred image
+	ColourGrade::Settings gradeSettings(); // the tone curve and grade picked in the GUI
+	void meterScene(RenderTexture* target, RenderTexture* scene); // shrinks the scene to the exposure meter's size
+	void addExposureMeter(int scene); // reads a shrunk copy of the scene back for auto exposure
 	void additiveBlend(OrthoMesh* mesh, RenderTexture* target, RenderTexture* texture1, RenderTexture* texture2, float intensity); // combines two render textures
-	void renderScene(bool renderToTexture); // renders the objects in a scene
-	void finalPass(RenderTexture* texture); // renders the post processed scene
+	void renderShadowMaps(); // renders every light's depth views and builds the frame's light data
+	void renderScene(); // renders the objects in a scene to whichever target the graph has bound
+	void overlayPass(); // depth map preview and GUI over the finished frame
 
 private:
 	// used to update light variables
@@ -73,15 +109,22 @@ private:
 	ManipulationDepthShader* manipulationDepthShader; // carries out the same vertex manipulation, but outputs a depth texture
 	ShadowShader* shadowShader; // shadow shader for calculating lighting and shadows
 	DepthShader* depthShader; // calculates a depth texture
-	VerticalBlurShader* verticalBlurShader; // blurs and image vertically with a kernel size of 11
-	HorizontalBlurShader* horizontalBlurShader; // blurs and image horizontally
-	BloomThresholdShader* thresholdShader; // outputs the pixels of the scene that are over a certain threshold
+	VerticalBlurShader* verticalBlurShaders[4]; // blurs an image vertically, one for each of GAUSSIAN_RADII
+	HorizontalBlurShader* horizontalBlurShaders[4]; // blurs an image horizontally
 	BloomMergeShader* mergeShader; // combines two blur passes together (in bloom, this is used while upsampling)
-	ToneMapShader* toneMapper; // uses exposure and gamma to change a render texture's brightness
+	KawaseDownShader* kawaseDownShader; // halves an image with a 5 tap dual kawase filter
+	KawaseUpShader* kawaseUpShader; // doubles an image with an 8 tap dual kawase filter
+	SummedAreaDownsampleShader* summedAreaDownsampleShader; // box filters an image down to the summed area table's size
+	SummedAreaScanShader* summedAreaScanShader; // one prefix sum pass of the summed area table
+	SummedAreaBoxShader* summedAreaBoxShader; // blurs with a few box lookups into the summed area table
+	BilateralDownsampleShader* bilateralDownsampleShader; // averages blocks of the scene and its depth for reduced resolution post processing
+	ToneMapShader* toneMapper; // adds the blur or bloom to the scene and tone maps it with exposure and gamma
 	TessellationShader* tessShader; // basic tessellation shader
 	TessellationDepthShader* tessDepthShader;
 	ManipulationTessShader* manipTessShader; // vertex manipulation on a tessellated plane
 	ManipulationTessDepthShader* manipTessDepthShader; // depth pass for vertex manipulation plane
+	ManipulationTessBakeShader* tessBakeShader; // tessellates the manipulation plane once a frame for every pass to reuse
+	ManipulationBakedShader* bakedShader; // lights the baked manipulation plane
 	ManipulationGeometryShader* manipGeometryShader; // applies a geometry shader to the manipulated plane
 
 	// vertex manipulation
@@ -98,15 +141,26 @@ private:
 	CubeMesh* cube;
 	OrthoMesh* ortho;
 	OrthoMesh* fullScreenMesh;
-	OrthoMesh* sampleMeshes[9]; // contains ortho meshes with scaled aspect ratios used for blur/bloom passes
+	// the post processing meshes and sizes below have a set for each PostResolution
+	OrthoMesh* sampleMeshes[3][9]; // contains ortho meshes with scaled aspect ratios used for blur/bloom passes
+	OrthoMesh* kawaseMeshes[3][6]; // the same for the dual kawase levels
+	OrthoMesh* summedAreaMeshes[3][2]; // the summed area table and the image blurred from it
+	OrthoMesh* reducedMeshes[3]; // the reduced scene, unused at full resolution
+	OrthoMesh* meterMesh; // the scene shrunk for the exposure meter
 
 	// lights
 	enum LightType { POINT = 0, DIRECTIONAL, SPOT };
+	enum PointShadowMode { CUBE_SHADOWS = 0, PARABOLOID_SHADOWS };
+
+	// post processing
+	enum BlurMethod { GAUSSIAN_BLUR = 0, KAWASE_BLUR, SUMMED_AREA_BLUR };
+	enum PostResolution { FULL_RESOLUTION = 0, HALF_RESOLUTION, QUARTER_RESOLUTION };
 
 	Light* lights[4]; // two of each light type
 	LightData* lightData[4];	
 
 	int lightType[4]; // 1 = POINT, 2 = DIRECTIONAL, 3 = SPOT
+	int pointShadowMode[4]; // six cube faces or two paraboloid hemispheres
 	int sceneWidth[4];
 	int sceneHeight[4];
 	int lightCount;
@@ -120,26 +174,45 @@ private:
 	XMFLOAT3 dirs[6]; // normalised direction vectors for each face of a depth map cube
 
 	// textures
-	ShadowMap* shadowMap[4][6]; // potential for all four lights to be point lights
-	ShadowMap* shadowMapToRender; // shadow map to render to the screen's ortho mesh
+	ShadowAtlas* shadowAtlas; // every spot/directional light's depth view packed into one texture
+	ShadowMap* pointShadowMaps; // cube array with a cube for each enabled point light
+	int shadowTiles[4][4]; // atlas tiles for each light, one per cascade or paraboloid hemisphere. -1 if it has none
+	int pointCubes[4]; // cube in the cube array for each point light, -1 if it has none
+	int shadowTileSize[3]; // shadow map size used by each light type
+	int atlasFormat; // index into shadowFormats
+	int pointFormat;
+	DXGI_FORMAT shadowFormats[3]; // D16 for short range lights, D32F where precision matters
+	CascadedShadows cascades[4]; // only used by directional lights
+	bool cascadeEnabled[4];
+	int cascadeCount[4];
+	float cascadeSplitLambda[4];
+	float cascadeBlend[4];
+	float shadowDistance; // how far from the camera cascades cover
+	LightFrameData* lightFrame; // light and shadow constants shared by every lit draw
+	DisplacementMap* displacementMap; // the manipulation plane's heightmap and waves, baked on the CPU each frame
+	SurfaceBounds planeBounds; // conservative bounds of the manipulation plane, refitted each frame
+	PatchCullData* patchCulling; // per view constants for the hull shaders to skip patches the view can't see
+
+	AutoExposure autoExposure; // picks the tone map exposure from the meter's readbacks
+	ExposureMeter* exposureMeter;
+	vector<float> meterPixels; // the last readback
+	ColourGradeLut* gradeLut; // the composite's tone curve and grade
 
-	RenderTexture* horizontalBlurTexture[9]; // all the horizontal blur passes
-	RenderTexture* verticalBlurTexture[9]; // all fully blurred blur passes
-	RenderTexture* upscaledPasses[8]; // stores the upscaled versions of the blurred textures
-	RenderTexture* combinedPasses[8]; // stores the combined versions of the upscaled textures
+	RenderTargetPool* postTargets; // every post processing target, only held for the passes that use them
 
 	ID3D11RasterizerState* defaultRasterState;
 	ID3D11RasterizerState* newRasterState; // used to turn off backface culling for the grass
 
 	ID3D11ShaderResourceView* sphereTextures[4]; // simple blur green red and yellow textures for the spheres
 
-	RenderTexture* blurFilter; // the final blurred texture that should be displayed to the screen
-	RenderTexture* bloomFilter; // the final bloom texture
-	RenderTexture* toneMappedFilter; // the edited bloom filter
-	RenderTexture* renderTexture; // the first texture the scene is rendered to
-	RenderTexture* thresholdTexture; // the brightest parts of the scene
+	RenderGraph frameGraph; // the frame's passes, declared again every frame
+	RenderGraphTargets* graphTargets; // binds the graph's targets from postTargets
 
-	XMINT2 aspectRatios[9]; // array of aspect ratios largest -> smallest
+	XMINT2 aspectRatios[3][9]; // array of aspect ratios largest -> smallest
+	XMINT2 kawaseSizes[3][6]; // each dual kawase level, half the one before
+	XMINT2 summedAreaSize[3]; // the image the summed area table blurs, a quarter of the scene it's made from
+	XMINT2 reducedSizes[3]; // the screen divided by 1, 2 and 4
+	XMINT2 meterSize; // an eighth of the screen
 
 	// variables
 	float time;
@@ -148,21 +221,33 @@ private:
 	float bloomThreshold;
 	float bloomIntensity;
 	float exposure;
+	float kawaseOffset; // spreads the dual kawase taps, widening the blur
+	float summedAreaRadius; // in screen pixels, three standard deviations of the gaussian the boxes approximate
+	XMFLOAT3 colourBalance; // scales the exposed red, green and blue before the tone curve
+	float saturation;
+	float upsampleDepthSigma; // how different a reduced texel's depth can be, as a fraction of the pixel's, before it stops counting
+	float upsampleLuminanceSigma; // the same for luminance in stops
 
 	bool enableBlur;
 	bool enableBloom;
 	bool enablePP;
 	bool enableHDR;
+	bool autoExposureEnabled;
 	bool enableGeometryShader;
 	bool gammaCorrection;
 	bool surfaceLighting;
 	bool dynamicTess;
+	bool bakeTessellation; // draw every pass from one baked plane instead of tessellating it per view
 	bool showNormals;
 	bool displayMap;
 
-	int mapToRender;
 	int ppMode;
 	int blurPasses;
+	int blurRadius; // index into GAUSSIAN_RADII
+	int kawasePasses;
+	int blurMethod[2]; // BlurMethod for blur and bloom, indexed by ppMode
+	int toneCurve; // ColourGrade::ToneCurve
+	int postResolution; // PostResolution the blur or bloom runs at
 	int sWidth;
 	int sHeight;
 	int tessInsideFactor;
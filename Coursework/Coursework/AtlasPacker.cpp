@@ -0,0 +1,91 @@
+// Atlas packer
+// imgui compiles its copy of the skyline packer statically so we need our own.
+#include "AtlasPacker.h"
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imGUI/stb_rect_pack.h"
+
+AtlasPacker::AtlasPacker(int maxAtlasSize)
+{
+	width = 0;
+	height = 0;
+	scaleShift = 0;
+	maxSize = maxAtlasSize;
+}
+
+bool AtlasPacker::pack(const std::vector<int>& sizes)
+{
+	rects.clear();
+	width = 0;
+	height = 0;
+	scaleShift = 0;
+
+	if (sizes.empty())
+		return true;
+
+	int largest = 0;
+	for (int i = 0; i < (int)sizes.size(); i++)
+		largest = sizes[i] > largest ? sizes[i] : largest;
+
+	// try every power of two width and keep the layout with the smallest area.
+	// if nothing fits, halve every tile and try again
+	for (int shift = 0; shift == 0 || (largest >> shift) >= 16; shift++) {
+		std::vector<Rect> candidate;
+		int candidateHeight;
+		long long bestArea = 0;
+
+		// the narrowest power of two the largest tile fits across
+		int narrowest = 1;
+		while (narrowest < (largest >> shift))
+			narrowest *= 2;
+
+		for (int w = narrowest; w <= maxSize; w *= 2) {
+			if (packAt(sizes, w, shift, candidateHeight, candidate)) {
+				if (rects.empty() || (long long)w * candidateHeight < bestArea) {
+					rects = candidate;
+					width = w;
+					height = candidateHeight;
+					bestArea = (long long)w * candidateHeight;
+				}
+			}
+		}
+
+		if (!rects.empty()) {
+			scaleShift = shift;
+			return true;
+		}
+	}
+
+	// nothing fits, leave the layout empty rather than half built
+	width = 0;
+	height = 0;
+	return false;
+}
+
+bool AtlasPacker::packAt(const std::vector<int>& sizes, int atlasWidth, int shift, int& packedHeight, std::vector<Rect>& out) const
+{
+	std::vector<stbrp_rect> packed(sizes.size());
+	for (int i = 0; i < (int)packed.size(); i++) {
+		packed[i].id = i;
+		packed[i].w = (stbrp_coord)(sizes[i] >> shift);
+		packed[i].h = (stbrp_coord)(sizes[i] >> shift);
+	}
+
+	std::vector<stbrp_node> nodes(atlasWidth);
+	stbrp_context context;
+	stbrp_init_target(&context, atlasWidth, maxSize, nodes.data(), (int)nodes.size());
+	if (!stbrp_pack_rects(&context, packed.data(), (int)packed.size()))
+		return false;
+
+	packedHeight = 0;
+	out.resize(packed.size());
+	for (int i = 0; i < (int)packed.size(); i++) {
+		Rect& rect = out[packed[i].id];
+		rect.x = packed[i].x;
+		rect.y = packed[i].y;
+		rect.size = packed[i].w;
+		packedHeight = packed[i].y + packed[i].h > packedHeight ? packed[i].y + packed[i].h : packedHeight;
+	}
+
+	return true;
+}
@@ -0,0 +1,39 @@
+// Atlas packer
+// Lays square tiles out in an atlas with the skyline packer vendored with imgui. Every power of two width up to the
+// largest atlas is tried and the layout with the smallest area is kept. If the tiles don't fit at all they're all halved
+// and packed again, down to 16 texels. ShadowAtlas turns the layout into viewports and uv rects
+// Doesn't depend on D3D
+#pragma once
+
+#include <vector>
+
+class AtlasPacker
+{
+public:
+	struct Rect
+	{
+		int x;
+		int y;
+		int size;
+	};
+
+	AtlasPacker(int maxAtlasSize = 8192);
+
+	// packs a tile of each size, false if they don't fit even at the smallest scale. the layout is empty after a failure
+	bool pack(const std::vector<int>& sizes);
+
+	const std::vector<Rect>& getRects() const { return rects; }; // in the same order as the sizes
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+	int getScaleShift() const { return scaleShift; }; // every tile was halved this many times to fit
+	int getMaxSize() const { return maxSize; };
+
+private:
+	bool packAt(const std::vector<int>& sizes, int atlasWidth, int shift, int& packedHeight, std::vector<Rect>& out) const;
+
+	std::vector<Rect> rects;
+	int width;
+	int height;
+	int scaleShift;
+	int maxSize;
+};
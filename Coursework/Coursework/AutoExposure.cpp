@@ -0,0 +1,215 @@
+// Auto exposure
+#include "AutoExposure.h"
+#include <math.h>
+#include <thread>
+#include <vector>
+#include <emmintrin.h>
+
+AutoExposure::Settings::Settings()
+{
+	minLogLuminance = -10.0f;
+	maxLogLuminance = 6.0f;
+	lowPercentile = 0.5f;
+	highPercentile = 0.95f;
+	key = 0.18f;
+	speedUp = 1.0f;
+	speedDown = 3.0f;
+	minExposure = 1.0f / 64.0f;
+	maxExposure = 64.0f;
+	startThreshold = 0.5f;
+	settleThreshold = 0.05f;
+}
+
+AutoExposure::AutoExposure(int lthreadCount)
+{
+	threadCount = lthreadCount;
+	exposure = 1.0f;
+	targetExposure = 1.0f;
+	reset();
+	for (int i = 0; i < HISTOGRAM_BINS; i++)
+		histogram[i] = 0;
+}
+
+// the float's exponent is the whole part, a polynomial fits log2(1 + t) for the mantissa's t in [0, 1) to within
+// 0.0002 stops, far finer than a bin. x has to be positive
+static inline __m128 fastLog2(__m128 x)
+{
+	__m128i bits = _mm_castps_si128(x);
+	__m128 whole = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	__m128 t = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))), _mm_set1_ps(1.0f));
+
+	__m128 fraction = _mm_set1_ps(-0.084273162f);
+	fraction = _mm_add_ps(_mm_mul_ps(fraction, t), _mm_set1_ps(0.32361048f));
+	fraction = _mm_add_ps(_mm_mul_ps(fraction, t), _mm_set1_ps(-0.67807154f));
+	fraction = _mm_add_ps(_mm_mul_ps(fraction, t), _mm_set1_ps(1.4385454f));
+	return _mm_add_ps(whole, _mm_mul_ps(fraction, t));
+}
+
+// which bin each of 4 pixels falls in, from their red, green and blue
+struct Binning
+{
+	__m128 floor; // the darkest luminance the log is taken of, so black and NaN land in the first bin
+	__m128 offset;
+	__m128 scale;
+	__m128 lastBin;
+
+	__m128i bins(__m128 red, __m128 green, __m128 blue) const
+	{
+		__m128 luminance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(red, _mm_set1_ps(0.2126f)), _mm_mul_ps(green, _mm_set1_ps(0.7152f))), _mm_mul_ps(blue, _mm_set1_ps(0.0722f)));
+		luminance = _mm_max_ps(luminance, floor);
+		__m128 bin = _mm_mul_ps(_mm_sub_ps(fastLog2(luminance), offset), scale);
+		bin = _mm_min_ps(_mm_max_ps(bin, _mm_setzero_ps()), lastBin);
+		return _mm_cvttps_epi32(bin);
+	}
+};
+
+static void binRow(const float* row, int width, const Binning& binning, unsigned int* bins)
+{
+	int x = 0;
+	int indices[4];
+	for (; x + 4 <= width; x += 4) {
+		// turn 4 RGBA pixels into the 4 reds, 4 greens and 4 blues
+		__m128 red = _mm_loadu_ps(row + x * 4);
+		__m128 green = _mm_loadu_ps(row + x * 4 + 4);
+		__m128 blue = _mm_loadu_ps(row + x * 4 + 8);
+		__m128 alpha = _mm_loadu_ps(row + x * 4 + 12);
+		_MM_TRANSPOSE4_PS(red, green, blue, alpha);
+
+		_mm_storeu_si128((__m128i*)indices, binning.bins(red, green, blue));
+		bins[indices[0]]++;
+		bins[indices[1]]++;
+		bins[indices[2]]++;
+		bins[indices[3]]++;
+	}
+
+	// the last few pixels one at a time
+	for (; x < width; x++) {
+		__m128i bin = binning.bins(_mm_set1_ps(row[x * 4]), _mm_set1_ps(row[x * 4 + 1]), _mm_set1_ps(row[x * 4 + 2]));
+		bins[_mm_cvtsi128_si32(bin)]++;
+	}
+}
+
+void AutoExposure::buildHistogram(const float* pixels, int width, int height, unsigned int lhistogram[HISTOGRAM_BINS]) const
+{
+	Binning binning;
+	float range = settings.maxLogLuminance - settings.minLogLuminance;
+	binning.floor = _mm_set1_ps(powf(2.0f, settings.minLogLuminance));
+	binning.offset = _mm_set1_ps(settings.minLogLuminance);
+	binning.scale = _mm_set1_ps(range > 0.0f ? HISTOGRAM_BINS / range : 0.0f);
+	binning.lastBin = _mm_set1_ps((float)(HISTOGRAM_BINS - 1));
+
+	int threads = threadCount;
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads > height)
+		threads = height;
+	if (threads < 1)
+		threads = 1;
+
+	// each thread counts a band of rows into its own histogram so they never write to the same counts
+	std::vector<unsigned int> partial((size_t)threads * HISTOGRAM_BINS, 0);
+	std::vector<std::thread> workers;
+	int rowsPerThread = (height + threads - 1) / threads;
+	for (int t = 0; t < threads; t++) {
+		int first = t * rowsPerThread;
+		int last = first + rowsPerThread < height ? first + rowsPerThread : height;
+		if (first >= last)
+			break;
+
+		unsigned int* bins = &partial[(size_t)t * HISTOGRAM_BINS];
+		auto band = [first, last, width, pixels, &binning, bins]() {
+			for (int y = first; y < last; y++)
+				binRow(pixels + (size_t)y * width * 4, width, binning, bins);
+		};
+		if (t == threads - 1 || last == height)
+			band();
+		else
+			workers.push_back(std::thread(band));
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	for (int b = 0; b < HISTOGRAM_BINS; b++) {
+		lhistogram[b] = 0;
+		for (int t = 0; t < threads; t++)
+			lhistogram[b] += partial[(size_t)t * HISTOGRAM_BINS + b];
+	}
+}
+
+float AutoExposure::trimmedAverage(const unsigned int lhistogram[HISTOGRAM_BINS]) const
+{
+	double total = 0.0;
+	for (int b = 0; b < HISTOGRAM_BINS; b++)
+		total += lhistogram[b];
+
+	// the pixels ranked between the percentiles, a bin straddling either end counts for the part inside
+	double low = total * settings.lowPercentile;
+	double high = total * settings.highPercentile;
+	if (high < low + 1.0)
+		high = low + 1.0;
+
+	float binSize = (settings.maxLogLuminance - settings.minLogLuminance) / HISTOGRAM_BINS;
+	double below = 0.0;
+	double sum = 0.0;
+	double weight = 0.0;
+	for (int b = 0; b < HISTOGRAM_BINS; b++) {
+		double start = below;
+		double end = below + lhistogram[b];
+		double overlap = (end < high ? end : high) - (start > low ? start : low);
+		if (overlap > 0.0) {
+			sum += overlap * (settings.minLogLuminance + (b + 0.5f) * binSize);
+			weight += overlap;
+		}
+		below = end;
+	}
+
+	// an empty histogram is treated as the key itself
+	return weight > 0.0 ? (float)(sum / weight) : log2f(settings.key);
+}
+
+void AutoExposure::measure(const float* pixels, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return;
+
+	buildHistogram(pixels, width, height, histogram);
+	setMeasurement(trimmedAverage(histogram));
+}
+
+void AutoExposure::setMeasurement(float averageLogLuminance)
+{
+	// the exposure that brings the average to the key
+	targetExposure = settings.key / powf(2.0f, averageLogLuminance);
+	targetExposure = targetExposure < settings.minExposure ? settings.minExposure : (targetExposure > settings.maxExposure ? settings.maxExposure : targetExposure);
+
+	if (state == WAITING) {
+		exposure = targetExposure;
+		state = SETTLED;
+	}
+}
+
+float AutoExposure::update(float deltaTime)
+{
+	if (state == WAITING)
+		return exposure;
+
+	// in stops, so a scene twice as bright adapts the same way at any exposure
+	float stops = log2f(targetExposure / exposure);
+	if (state == SETTLED && fabsf(stops) < settings.startThreshold)
+		return exposure;
+
+	// close a fraction of the gap that only depends on the time passed, whatever the frame rate
+	state = (stops > 0.0f) ? ADAPTING_UP : ADAPTING_DOWN;
+	float speed = (stops > 0.0f) ? settings.speedUp : settings.speedDown;
+	exposure *= powf(2.0f, stops * (1.0f - expf(-speed * deltaTime)));
+
+	if (fabsf(log2f(targetExposure / exposure)) < settings.settleThreshold)
+		state = SETTLED;
+	return exposure;
+}
+
+void AutoExposure::reset()
+{
+	state = WAITING;
+}
@@ -0,0 +1,66 @@
+// Auto exposure
+// Picks the tone mapper's exposure from the scene's brightness. Each measurement bins the luminance of an HDR image into
+// a log2 histogram and averages the bins between two percentiles, so the darkest pixels and the brightest highlights
+// don't drag the exposure around. The exposure then moves towards the one that maps that average to the key value,
+// quickly when the scene gets brighter and slowly when it gets darker, like eyes adjusting.
+// The histogram is built by a band of rows per thread into its own histogram, summed at the end, 4 pixels at a time
+// with SSE. Works on any RGBA float image, App1 feeds it ExposureMeter's readback and headless runs a PostProcessChain::Image
+// Doesn't depend on D3D
+#pragma once
+
+class AutoExposure
+{
+public:
+	static const int HISTOGRAM_BINS = 64;
+
+	// SETTLED holds the exposure until the measured scene moves far enough from it to start ADAPTING again
+	enum State { WAITING, ADAPTING_UP, ADAPTING_DOWN, SETTLED };
+
+	struct Settings
+	{
+		float minLogLuminance; // the histogram's range in log2 luminance, anything outside goes in the end bins
+		float maxLogLuminance;
+		float lowPercentile; // the fraction of pixels ignored at the dark end
+		float highPercentile; // and where the ignored bright end starts
+		float key; // the luminance the average is exposed to, middle grey
+		float speedUp; // how fast the exposure rises when the scene darkens, per second
+		float speedDown; // how fast it falls when the scene brightens
+		float minExposure;
+		float maxExposure;
+		float startThreshold; // stops the target has to be away before a settled exposure adapts again
+		float settleThreshold; // stops away from the target that counts as settled
+
+		Settings();
+	};
+
+	// threadCount 0 uses one per core
+	AutoExposure(int threadCount = 0);
+
+	void setSettings(const Settings& lsettings) { settings = lsettings; };
+	const Settings& getSettings() const { return settings; };
+
+	// pixels is RGBA rows, the histogram is the count of pixels in each bin
+	void buildHistogram(const float* pixels, int width, int height, unsigned int histogram[HISTOGRAM_BINS]) const;
+	// mean log2 luminance of the pixels between the percentiles
+	float trimmedAverage(const unsigned int histogram[HISTOGRAM_BINS]) const;
+
+	// measures an image and aims for the exposure that suits it, the first measurement is used straight away
+	void measure(const float* pixels, int width, int height);
+	void setMeasurement(float averageLogLuminance); // measure without the histogram
+
+	float update(float deltaTime); // moves the exposure towards the target and returns it
+	void reset(); // back to WAITING, for a cut to a new scene
+
+	float getExposure() const { return exposure; };
+	float getTargetExposure() const { return targetExposure; };
+	State getState() const { return state; };
+	const unsigned int* getHistogram() const { return histogram; }; // the last measurement's
+
+private:
+	Settings settings;
+	int threadCount;
+	State state;
+	float exposure;
+	float targetExposure;
+	unsigned int histogram[HISTOGRAM_BINS];
+};
@@ -0,0 +1,97 @@
+// Bilateral downsample shader
+#include "BilateralDownsampleShader.h"
+
+
+BilateralDownsampleShader::BilateralDownsampleShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	initShader(L"bilateralDownsample_vs.cso", L"bilateralDownsample_ps.cso");
+}
+
+
+BilateralDownsampleShader::~BilateralDownsampleShader()
+{
+	if (matrixBuffer)
+	{
+		matrixBuffer->Release();
+		matrixBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+	if (downsampleBuffer)
+	{
+		downsampleBuffer->Release();
+		downsampleBuffer = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+
+void BilateralDownsampleShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	D3D11_BUFFER_DESC matrixBufferDesc;
+	D3D11_BUFFER_DESC downsampleBufferDesc;
+
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+	loadPixelShader(psFilename);
+
+	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
+	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	matrixBufferDesc.MiscFlags = 0;
+	matrixBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
+
+	// every texel is loaded, so there's no sampler. Setup the description of the downsample buffer.
+	downsampleBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	downsampleBufferDesc.ByteWidth = sizeof(DownsampleBufferType);
+	downsampleBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	downsampleBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	downsampleBufferDesc.MiscFlags = 0;
+	downsampleBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&downsampleBufferDesc, NULL, &downsampleBuffer);
+}
+
+void BilateralDownsampleShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* scene, ID3D11ShaderResourceView* depth,
+	int scale, int sceneWidth, int sceneHeight, float screenNear, float screenFar)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	MatrixBufferType* dataPtr;
+	XMMATRIX tworld, tview, tproj;
+
+	// Transpose the matrices to prepare them for the shader.
+	tworld = XMMatrixTranspose(worldMatrix);
+	tview = XMMatrixTranspose(viewMatrix);
+	tproj = XMMatrixTranspose(projectionMatrix);
+
+	deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr->world = tworld;
+	dataPtr->view = tview;
+	dataPtr->projection = tproj;
+	deviceContext->Unmap(matrixBuffer, 0);
+	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	DownsampleBufferType* downsamplePtr;
+	deviceContext->Map(downsampleBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	downsamplePtr = (DownsampleBufferType*)mappedResource.pData;
+	downsamplePtr->scale = scale;
+	downsamplePtr->nearPlane = screenNear;
+	downsamplePtr->farPlane = screenFar;
+	downsamplePtr->padding = 0.0f;
+	downsamplePtr->sceneSize = XMINT2(sceneWidth, sceneHeight);
+	downsamplePtr->padding2 = XMFLOAT2(0.0f, 0.0f);
+	deviceContext->Unmap(downsampleBuffer, 0);
+	deviceContext->PSSetConstantBuffers(0, 1, &downsampleBuffer);
+
+	// Set shader texture resources in the pixel shader.
+	deviceContext->PSSetShaderResources(0, 1, &scene);
+	deviceContext->PSSetShaderResources(1, 1, &depth);
+}
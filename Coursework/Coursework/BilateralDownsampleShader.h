@@ -0,0 +1,39 @@
+// Bilateral downsample shader handler
+// Loads the bilateral downsample shaders (vs and ps)
+// Passes the reduction scale, the scene's size and the camera's planes to linearise its depth
+#pragma once
+
+#include "DXF.h"
+
+using namespace std;
+using namespace DirectX;
+
+class BilateralDownsampleShader : public BaseShader
+{
+private:
+	struct DownsampleBufferType
+	{
+		int scale;
+		float nearPlane;
+		float farPlane;
+		float padding;
+		XMINT2 sceneSize;
+		XMFLOAT2 padding2;
+	};
+
+public:
+
+	BilateralDownsampleShader(ID3D11Device* device, HWND hwnd);
+	~BilateralDownsampleShader();
+
+	// depth is the scene's depth buffer, the target is the scene's size divided by scale, rounded up
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* scene, ID3D11ShaderResourceView* depth,
+		int scale, int sceneWidth, int sceneHeight, float screenNear, float screenFar);
+
+private:
+	void initShader(const wchar_t* vs, const wchar_t* ps);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11Buffer* downsampleBuffer;
+};
@@ -1,125 +0,0 @@
-#include "BloomThresholdShader.h"
-
-BloomThresholdShader::BloomThresholdShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
-{
-	initShader(L"bloomThreshold_vs.cso", L"bloomThreshold_ps.cso");
-}
-
-BloomThresholdShader::~BloomThresholdShader()
-{
-	// Release the sampler state.
-	if (sampleState)
-	{
-		sampleState->Release();
-		sampleState = 0;
-	}
-
-	if (thresholdBuffer)
-	{
-		thresholdBuffer->Release();
-		thresholdBuffer = 0;
-	}
-
-	// Release the matrix constant buffer.
-	if (matrixBuffer)
-	{
-		matrixBuffer->Release();
-		matrixBuffer = 0;
-	}
-
-	// Release the layout.
-	if (layout)
-	{
-		layout->Release();
-		layout = 0;
-	}
-
-	//Release base shader components
-	BaseShader::~BaseShader();
-}
-
-
-void BloomThresholdShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
-{
-	D3D11_BUFFER_DESC matrixBufferDesc;
-	D3D11_BUFFER_DESC thresholdBufferDesc;
-	D3D11_SAMPLER_DESC samplerDesc;
-
-	// Load (+ compile) shader files
-	loadVertexShader(vsFilename);
-	loadPixelShader(psFilename);
-
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
-
-	thresholdBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	thresholdBufferDesc.ByteWidth = sizeof(ThresholdBufferType);
-	thresholdBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	thresholdBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	thresholdBufferDesc.MiscFlags = 0;
-	thresholdBufferDesc.StructureByteStride = 0;
-	renderer->CreateBuffer(&thresholdBufferDesc, NULL, &thresholdBuffer);
-
-	// Create a texture sampler state description.
-	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.MipLODBias = 0.0f;
-	samplerDesc.MaxAnisotropy = 1;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-	samplerDesc.MinLOD = 0;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	// Create the texture sampler state.
-	renderer->CreateSamplerState(&samplerDesc, &sampleState);
-
-}
-
-
-void BloomThresholdShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, ID3D11ShaderResourceView* texture, float thresh)
-{
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	ThresholdBufferType* threshPtr;
-	XMMATRIX tworld, tview, tproj;
-
-	// Transpose the matrices to prepare them for the shader.
-	tworld = XMMatrixTranspose(worldMatrix);
-	tview = XMMatrixTranspose(viewMatrix);
-	tproj = XMMatrixTranspose(projectionMatrix);
-
-	// Send matrix data
-	result = deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
-	dataPtr->world = tworld;// worldMatrix;
-	dataPtr->view = tview;
-	dataPtr->projection = tproj;
-	deviceContext->Unmap(matrixBuffer, 0);
-	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
-
-	deviceContext->Map(thresholdBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	threshPtr = (ThresholdBufferType*)mappedResource.pData;
-	threshPtr->threshold = thresh;
-	threshPtr->padding = XMFLOAT3(1.0f, 1.0f, 1.0f);
-	deviceContext->Unmap(thresholdBuffer, 0);
-	deviceContext->PSSetConstantBuffers(0, 1, &thresholdBuffer);
-
-	// Set shader texture and sampler resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
-	deviceContext->PSSetSamplers(0, 1, &sampleState);
-}
-
-
-
-
-
@@ -0,0 +1,134 @@
+// Cascaded shadows
+#include "CascadedShadows.h"
+#include <math.h>
+
+CascadedShadows::CascadedShadows()
+{
+	cascadeCount = 0;
+	splitLambda = 0.75f;
+	casterDistance = 100.0f;
+	blendRange = 0.1f;
+
+	for (int i = 0; i < MAX_CASCADES; i++) {
+		splits[i] = 0.0f;
+		XMStoreFloat4x4(&viewMatrix[i], XMMatrixIdentity());
+		XMStoreFloat4x4(&projectionMatrix[i], XMMatrixIdentity());
+	}
+}
+
+void CascadedShadows::setCascadeCount(int count)
+{
+	if (count < 0)
+		count = 0;
+	if (count > MAX_CASCADES)
+		count = MAX_CASCADES;
+	cascadeCount = count;
+}
+
+void CascadedShadows::update(const XMMATRIX& cameraView, const XMMATRIX& cameraProjection, float nearPlane, float farPlane,
+	const XMFLOAT3& lightDirection, int resolution)
+{
+	if (cascadeCount == 0)
+		return;
+
+	calculateSplits(cascadeCount, nearPlane, farPlane, splitLambda, splits);
+	XMMATRIX inverseView = XMMatrixInverse(nullptr, cameraView);
+
+	// light space has a fixed orientation, only the translation changes with the camera
+	XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	if (fabsf(XMVectorGetY(dir)) > 0.99f)
+		up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+
+	XMMATRIX lightRotation = XMMatrixLookToLH(XMVectorZero(), dir, up);
+	XMMATRIX inverseRotation = XMMatrixTranspose(lightRotation);
+
+	float start = nearPlane;
+	for (int i = 0; i < cascadeCount; i++) {
+		XMVECTOR corners[8];
+		XMVECTOR centre;
+		float radius;
+
+		getFrustumCorners(inverseView, cameraProjection, start, splits[i], corners);
+		fitSphere(corners, &centre, &radius);
+
+		// snap the centre to whole texels in light space, then move it back to world space
+		XMVECTOR lightCentre = XMVector3TransformCoord(centre, lightRotation);
+		lightCentre = snapToTexel(lightCentre, radius, resolution);
+		centre = XMVector3TransformCoord(lightCentre, inverseRotation);
+
+		// pull the eye back so casters between the light and the cascade are still captured
+		XMVECTOR eye = centre - dir * (radius + casterDistance);
+		XMStoreFloat4x4(&viewMatrix[i], XMMatrixLookToLH(eye, dir, up));
+		XMStoreFloat4x4(&projectionMatrix[i], XMMatrixOrthographicLH(radius * 2.0f, radius * 2.0f, 0.0f, radius * 2.0f + casterDistance));
+
+		start = splits[i];
+	}
+}
+
+XMMATRIX CascadedShadows::getViewMatrix(int cascade)
+{
+	return XMLoadFloat4x4(&viewMatrix[cascade]);
+}
+
+XMMATRIX CascadedShadows::getProjectionMatrix(int cascade)
+{
+	return XMLoadFloat4x4(&projectionMatrix[cascade]);
+}
+
+void CascadedShadows::calculateSplits(int count, float nearPlane, float farPlane, float lambda, float* splitsOut)
+{
+	for (int i = 1; i <= count; i++) {
+		float fraction = (float)i / (float)count;
+		float logSplit = nearPlane * powf(farPlane / nearPlane, fraction);
+		float uniformSplit = nearPlane + (farPlane - nearPlane) * fraction;
+		splitsOut[i - 1] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+
+	// avoid the last split drifting from the far plane through rounding
+	splitsOut[count - 1] = farPlane;
+}
+
+void CascadedShadows::getFrustumCorners(const XMMATRIX& inverseView, const XMMATRIX& cameraProjection, float nearPlane, float farPlane, XMVECTOR corners[8])
+{
+	// the projection's scale terms give the frustum's slope in x and y
+	XMFLOAT4X4 projection;
+	XMStoreFloat4x4(&projection, cameraProjection);
+	float slopeX = 1.0f / projection._11;
+	float slopeY = 1.0f / projection._22;
+
+	float depths[2] = { nearPlane, farPlane };
+	for (int i = 0; i < 2; i++) {
+		float x = depths[i] * slopeX;
+		float y = depths[i] * slopeY;
+		corners[i * 4 + 0] = XMVector3TransformCoord(XMVectorSet(-x, y, depths[i], 1.0f), inverseView);
+		corners[i * 4 + 1] = XMVector3TransformCoord(XMVectorSet(x, y, depths[i], 1.0f), inverseView);
+		corners[i * 4 + 2] = XMVector3TransformCoord(XMVectorSet(x, -y, depths[i], 1.0f), inverseView);
+		corners[i * 4 + 3] = XMVector3TransformCoord(XMVectorSet(-x, -y, depths[i], 1.0f), inverseView);
+	}
+}
+
+void CascadedShadows::fitSphere(const XMVECTOR corners[8], XMVECTOR* centre, float* radius)
+{
+	XMVECTOR sum = XMVectorZero();
+	for (int i = 0; i < 8; i++)
+		sum += corners[i];
+	*centre = sum / 8.0f;
+
+	float largest = 0.0f;
+	for (int i = 0; i < 8; i++)
+		largest = fmaxf(largest, XMVectorGetX(XMVector3Length(corners[i] - *centre)));
+
+	// round up so floating point noise in the corners can't change the size between frames
+	*radius = ceilf(largest * 16.0f) / 16.0f;
+}
+
+XMVECTOR CascadedShadows::snapToTexel(FXMVECTOR lightSpacePosition, float radius, int resolution)
+{
+	float texelSize = (radius * 2.0f) / (float)resolution;
+	XMFLOAT3 position;
+	XMStoreFloat3(&position, lightSpacePosition);
+	position.x = floorf(position.x / texelSize) * texelSize;
+	position.y = floorf(position.y / texelSize) * texelSize;
+	return XMLoadFloat3(&position);
+}
@@ -0,0 +1,50 @@
+// Cascaded shadows
+// Splits the camera frustum into cascades for a directional light and fits an ortho projection to each one.
+// Cascades are fitted to a bounding sphere and snapped to whole texels so they don't shimmer as the camera moves.
+#pragma once
+
+#include <directxmath.h>
+
+using namespace DirectX;
+
+class CascadedShadows
+{
+public:
+	static const int MAX_CASCADES = 4;
+
+	CascadedShadows();
+
+	// fits every cascade to the part of the camera frustum between nearPlane and farPlane.
+	// resolution is the size of each cascade's shadow map
+	void update(const XMMATRIX& cameraView, const XMMATRIX& cameraProjection, float nearPlane, float farPlane,
+		const XMFLOAT3& lightDirection, int resolution);
+
+	void setCascadeCount(int count); // 0 turns cascades off
+	void setSplitLambda(float lambda) { splitLambda = lambda; }; // 0 = uniform splits, 1 = logarithmic splits
+	void setCasterDistance(float distance) { casterDistance = distance; }; // how far behind a cascade casters are captured
+	void setBlendRange(float range) { blendRange = range; }; // fraction of each cascade's edge that fades into the next
+
+	int getCascadeCount() { return cascadeCount; };
+	float getBlendRange() { return blendRange; };
+	float getSplit(int cascade) { return splits[cascade]; }; // view depth the cascade ends at
+	XMMATRIX getViewMatrix(int cascade);
+	XMMATRIX getProjectionMatrix(int cascade);
+
+	// split distances using the practical split scheme, a blend of logarithmic and uniform splits
+	static void calculateSplits(int count, float nearPlane, float farPlane, float lambda, float* splitsOut);
+	// world space corners of the camera frustum between two view depths, near corners first
+	static void getFrustumCorners(const XMMATRIX& inverseView, const XMMATRIX& cameraProjection, float nearPlane, float farPlane, XMVECTOR corners[8]);
+	// bounding sphere of the corners. the radius only depends on the frustum's shape, not its orientation
+	static void fitSphere(const XMVECTOR corners[8], XMVECTOR* centre, float* radius);
+	// moves a light space position onto the shadow map's texel grid
+	static XMVECTOR snapToTexel(FXMVECTOR lightSpacePosition, float radius, int resolution);
+
+private:
+	int cascadeCount;
+	float splitLambda;
+	float casterDistance;
+	float blendRange;
+	float splits[MAX_CASCADES];
+	XMFLOAT4X4 viewMatrix[MAX_CASCADES];
+	XMFLOAT4X4 projectionMatrix[MAX_CASCADES];
+};
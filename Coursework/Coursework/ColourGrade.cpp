@@ -0,0 +1,149 @@
+// Colour grade
+#include "ColourGrade.h"
+#include <math.h>
+#include <thread>
+
+ColourGrade::Settings::Settings()
+{
+	toneCurve = REINHARD;
+	balance[0] = 1.0f;
+	balance[1] = 1.0f;
+	balance[2] = 1.0f;
+	saturation = 1.0f;
+	gamma = 1.0f;
+}
+
+bool ColourGrade::Settings::operator==(const Settings& other) const
+{
+	return toneCurve == other.toneCurve && balance[0] == other.balance[0] && balance[1] == other.balance[1] && balance[2] == other.balance[2]
+		&& saturation == other.saturation && gamma == other.gamma;
+}
+
+ColourGrade::ColourGrade(int lthreadCount)
+{
+	threadCount = lthreadCount;
+	baked = false;
+	table.resize((size_t)LUT_SIZE * LUT_SIZE * LUT_SIZE * 4);
+}
+
+void ColourGrade::evaluate(const Settings& lsettings, const float colour[3], float graded[3])
+{
+	float mapped[3];
+	for (int c = 0; c < 3; c++) {
+		float x = colour[c] * lsettings.balance[c];
+		x = x > 0.0f ? x : 0.0f;
+
+		if (lsettings.toneCurve == ACES) {
+			// Narkowicz's fit of the ACES filmic curve
+			x = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+		}
+		else {
+			// https://learnopengl.com/Advanced-Lighting/HDR
+			x = x / (x + 1.0f);
+		}
+		mapped[c] = x;
+	}
+
+	// saturation pushes each channel towards or away from the luminance. after the curve, so it's working on channels that
+	// the table's texels are close enough together for, scene colours with one bright channel would swing it from clipped
+	// to bright between neighbouring texels
+	float luminance = mapped[0] * 0.2126f + mapped[1] * 0.7152f + mapped[2] * 0.0722f;
+	for (int c = 0; c < 3; c++) {
+		float x = luminance + (mapped[c] - luminance) * lsettings.saturation;
+		x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+		graded[c] = powf(x, lsettings.gamma);
+	}
+}
+
+bool ColourGrade::bake(const Settings& lsettings)
+{
+	if (baked && settings == lsettings)
+		return false;
+	settings = lsettings;
+	baked = true;
+
+	// each texel's channel is 2^log2 colour at the texel's centre
+	float exposed[LUT_SIZE];
+	for (int i = 0; i < LUT_SIZE; i++)
+		exposed[i] = powf(2.0f, MIN_LOG + (float)(MAX_LOG - MIN_LOG) * i / (LUT_SIZE - 1));
+
+	int threads = threadCount;
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads > LUT_SIZE)
+		threads = LUT_SIZE;
+	if (threads < 1)
+		threads = 1;
+
+	// each thread bakes a band of blue slices, the calling thread takes the last band
+	std::vector<std::thread> workers;
+	int slicesPerThread = (LUT_SIZE + threads - 1) / threads;
+	for (int t = 0; t < threads; t++) {
+		int first = t * slicesPerThread;
+		int last = first + slicesPerThread < LUT_SIZE ? first + slicesPerThread : LUT_SIZE;
+		if (first >= last)
+			break;
+
+		float* data = table.data();
+		const Settings* grade = &settings;
+		auto band = [first, last, data, grade, &exposed]() {
+			for (int b = first; b < last; b++) {
+				for (int g = 0; g < LUT_SIZE; g++) {
+					float* texel = data + ((size_t)(b * LUT_SIZE + g) * LUT_SIZE) * 4;
+					for (int r = 0; r < LUT_SIZE; r++, texel += 4) {
+						float colour[3] = { exposed[r], exposed[g], exposed[b] };
+						evaluate(*grade, colour, texel);
+						texel[3] = 1.0f;
+					}
+				}
+			}
+		};
+		if (t == threads - 1 || last == LUT_SIZE)
+			band();
+		else
+			workers.push_back(std::thread(band));
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+	return true;
+}
+
+void ColourGrade::coordinates(float exposure, float& scale, float& offset)
+{
+	// MIN_LOG lands on the first texel's centre and MAX_LOG on the last's, the exposure shifts the log2 colour. an exposure
+	// of 0 would shift it to -infinity, anything this small already grades every colour as black
+	exposure = exposure > 1e-6f ? exposure : 1e-6f;
+	scale = (float)(LUT_SIZE - 1) / (LUT_SIZE * (float)(MAX_LOG - MIN_LOG));
+	offset = (log2f(exposure) - MIN_LOG) * scale + 0.5f / LUT_SIZE;
+}
+
+void ColourGrade::lookup(const float colour[3], float exposure, float graded[3]) const
+{
+	float scale, offset;
+	coordinates(exposure, scale, offset);
+
+	// texel coordinates, clamped at the edge texels' centres like a clamped sampler
+	int first[3];
+	int second[3];
+	float weight[3];
+	for (int c = 0; c < 3; c++) {
+		float position = (log2f(colour[c] > 1e-10f ? colour[c] : 1e-10f) * scale + offset) * LUT_SIZE - 0.5f;
+		position = position < 0.0f ? 0.0f : (position > LUT_SIZE - 1 ? (float)(LUT_SIZE - 1) : position);
+		first[c] = (int)position;
+		second[c] = first[c] + 1 < LUT_SIZE ? first[c] + 1 : first[c];
+		weight[c] = position - first[c];
+	}
+
+	for (int c = 0; c < 3; c++)
+		graded[c] = 0.0f;
+	for (int corner = 0; corner < 8; corner++) {
+		int r = (corner & 1) ? second[0] : first[0];
+		int g = (corner & 2) ? second[1] : first[1];
+		int b = (corner & 4) ? second[2] : first[2];
+		float w = ((corner & 1) ? weight[0] : 1.0f - weight[0]) * ((corner & 2) ? weight[1] : 1.0f - weight[1]) * ((corner & 4) ? weight[2] : 1.0f - weight[2]);
+		const float* texel = &table[((size_t)(b * LUT_SIZE + g) * LUT_SIZE + r) * 4];
+		for (int c = 0; c < 3; c++)
+			graded[c] += texel[c] * w;
+	}
+}
@@ -0,0 +1,53 @@
+// Colour grade
+// The final composite's tone curve and grade baked into a LUT_SIZE cubed table, so toneMap_ps does one 3D texture fetch
+// whatever the grade does. Each axis of the table is one channel's log2 exposed colour from MIN_LOG to MAX_LOG, which
+// gives the toe and the shoulder of the curve the same share of texels and turns the exposure into an offset on the
+// coordinates, so only changing the grade itself needs a new table. The table's slices are baked in bands per thread.
+// Doesn't depend on D3D
+#pragma once
+
+#include <vector>
+
+class ColourGrade
+{
+public:
+	static const int LUT_SIZE = 32;
+	static const int MIN_LOG = -10; // exposed colours darker than 2^MIN_LOG grade like 2^MIN_LOG
+	static const int MAX_LOG = 8;
+
+	enum ToneCurve { REINHARD = 0, ACES };
+
+	struct Settings
+	{
+		int toneCurve;
+		float balance[3]; // scales each channel before the curve, white balance and tints
+		float saturation; // 0 is grey, 1 leaves the colour alone
+		float gamma; // the curve's output is raised to this
+
+		Settings();
+		bool operator==(const Settings& other) const;
+		bool operator!=(const Settings& other) const { return !(*this == other); };
+	};
+
+	// threadCount 0 uses one per core
+	ColourGrade(int threadCount = 0);
+
+	// rebuilds the table if the settings have changed since the last bake, true if it did
+	bool bake(const Settings& lsettings);
+
+	// the grade of one exposed linear colour, what the table holds at each texel
+	static void evaluate(const Settings& lsettings, const float colour[3], float graded[3]);
+	// looks an unexposed colour up in the table the way toneMap_ps does, clamped and trilinear
+	void lookup(const float colour[3], float exposure, float graded[3]) const;
+	// the table's texture coordinate for a colour is log2(colour) * scale + offset, exposures down to 0 are clamped just above it
+	static void coordinates(float exposure, float& scale, float& offset);
+
+	const float* getTable() const { return table.data(); }; // RGBA, red along the rows, green down them, blue through the slices
+	const Settings& getSettings() const { return settings; };
+
+private:
+	Settings settings;
+	bool baked;
+	int threadCount;
+	std::vector<float> table;
+};
@@ -0,0 +1,44 @@
+// Colour grade LUT
+#include "ColourGradeLut.h"
+
+ColourGradeLut::ColourGradeLut(ID3D11Device* device)
+{
+	texture = 0;
+	textureSRV = 0;
+
+	// rewritten by the CPU now and then, so default usage rather than dynamic
+	D3D11_TEXTURE3D_DESC textureDesc;
+	ZeroMemory(&textureDesc, sizeof(textureDesc));
+	textureDesc.Width = ColourGrade::LUT_SIZE;
+	textureDesc.Height = ColourGrade::LUT_SIZE;
+	textureDesc.Depth = ColourGrade::LUT_SIZE;
+	textureDesc.MipLevels = 1;
+	textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	device->CreateTexture3D(&textureDesc, NULL, &texture);
+	device->CreateShaderResourceView(texture, NULL, &textureSRV);
+}
+
+ColourGradeLut::~ColourGradeLut()
+{
+	if (textureSRV)
+	{
+		textureSRV->Release();
+		textureSRV = 0;
+	}
+	if (texture)
+	{
+		texture->Release();
+		texture = 0;
+	}
+}
+
+void ColourGradeLut::update(ID3D11DeviceContext* deviceContext, const ColourGrade::Settings& settings)
+{
+	if (!grade.bake(settings))
+		return;
+
+	UINT rowPitch = ColourGrade::LUT_SIZE * 4 * sizeof(float);
+	deviceContext->UpdateSubresource(texture, 0, NULL, grade.getTable(), rowPitch, rowPitch * ColourGrade::LUT_SIZE);
+}
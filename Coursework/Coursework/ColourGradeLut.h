@@ -0,0 +1,23 @@
+// Colour grade LUT
+// Uploads a ColourGrade's table as a 3D texture for toneMap_ps, rebaking and uploading it only when the grade changes
+#pragma once
+
+#include "DXF.h"
+#include "ColourGrade.h"
+
+class ColourGradeLut
+{
+public:
+	ColourGradeLut(ID3D11Device* device);
+	~ColourGradeLut();
+
+	void update(ID3D11DeviceContext* deviceContext, const ColourGrade::Settings& settings);
+
+	ID3D11ShaderResourceView* getShaderResourceView() { return textureSRV; };
+	const ColourGrade& getGrade() { return grade; };
+
+private:
+	ColourGrade grade;
+	ID3D11Texture3D* texture;
+	ID3D11ShaderResourceView* textureSRV;
+};
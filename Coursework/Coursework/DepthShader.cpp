@@ -8,6 +8,12 @@ DepthShader::DepthShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, h
 
 DepthShader::~DepthShader()
 {
+	if (paraboloidBuffer)
+	{
+		paraboloidBuffer->Release();
+		paraboloidBuffer = 0;
+	}
+
 	// Release the matrix constant buffer.
 	if (matrixBuffer)
 	{
@@ -30,8 +36,8 @@ void DepthShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilenam
 {
 	D3D11_BUFFER_DESC matrixBufferDesc;
 
-	// Load (+ compile) shader files
-	loadVertexShader(vsFilename);
+	// Load (+ compile) shader files, depth only reads the position stream
+	loadPositionVertexShader(vsFilename);
 	loadPixelShader(psFilename);
 
 	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
@@ -43,9 +49,18 @@ void DepthShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilenam
 	matrixBufferDesc.StructureByteStride = 0;
 	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
 
+	D3D11_BUFFER_DESC paraboloidBufferDesc;
+	paraboloidBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	paraboloidBufferDesc.ByteWidth = sizeof(ParaboloidBufferType);
+	paraboloidBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	paraboloidBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	paraboloidBufferDesc.MiscFlags = 0;
+	paraboloidBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&paraboloidBufferDesc, NULL, &paraboloidBuffer);
 }
 
-void DepthShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix)
+void DepthShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix,
+	bool paraboloid, float nearPlane, float farPlane)
 {
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	MatrixBufferType* dataPtr;
@@ -63,4 +78,15 @@ void DepthShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const
 	dataPtr->projection = tproj;
 	deviceContext->Unmap(matrixBuffer, 0);
 	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	// dual paraboloid point lights skip the projection matrix
+	ParaboloidBufferType* paraboloidPtr;
+	deviceContext->Map(paraboloidBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	paraboloidPtr = (ParaboloidBufferType*)mappedResource.pData;
+	paraboloidPtr->paraboloid = paraboloid;
+	paraboloidPtr->nearPlane = nearPlane;
+	paraboloidPtr->farPlane = farPlane;
+	paraboloidPtr->padding = 0.0f;
+	deviceContext->Unmap(paraboloidBuffer, 0);
+	deviceContext->VSSetConstantBuffers(1, 1, &paraboloidBuffer);
 }
@@ -12,15 +12,24 @@ class DepthShader : public BaseShader
 {
 
 public:
+	struct ParaboloidBufferType
+	{
+		int paraboloid; // 1 warps the view space position onto a paraboloid instead of using the projection matrix
+		float nearPlane;
+		float farPlane;
+		float padding;
+	};
 
 	DepthShader(ID3D11Device* device, HWND hwnd);
 	~DepthShader();
 
-	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection);
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection,
+		bool paraboloid = false, float nearPlane = 0.0f, float farPlane = 1.0f);
 
 private:
 	void initShader(const wchar_t* vs, const wchar_t* ps);
 
 private:
 	ID3D11Buffer* matrixBuffer;
+	ID3D11Buffer* paraboloidBuffer;
 };
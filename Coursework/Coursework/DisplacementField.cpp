@@ -0,0 +1,204 @@
+// Displacement field
+#include "DisplacementField.h"
+#include "WaveMath.h"
+#include <math.h>
+#include <thread>
+#include <xmmintrin.h>
+
+DisplacementField::DisplacementField(int lwidth, int lheight, float lplaneSize)
+{
+	width = (lwidth + 3) & ~3;
+	height = lheight;
+	planeSize = lplaneSize;
+
+	// flat until a heightmap is set
+	mapWidth = 1;
+	mapHeight = 1;
+	heightMap.assign(1, 0.0f);
+	heightMapMin = 0.0f;
+	heightMapMax = 0.0f;
+
+	baseHeight.resize(width * height);
+	baseNormalX.resize(width * height);
+	baseNormalY.resize(width * height);
+	baseNormalZ.resize(width * height);
+	bakedAmplitude = -1.0f;
+
+	waveX.resize(width);
+	slopeX.resize(width);
+	data.assign(width * height * 4, 0.0f);
+}
+
+void DisplacementField::setHeightMap(const unsigned char* pixels, int lmapWidth, int lmapHeight, int pixelStride, int rowPitch)
+{
+	mapWidth = lmapWidth;
+	mapHeight = lmapHeight;
+	heightMap.resize(mapWidth * mapHeight);
+	heightMapMin = 1.0f;
+	heightMapMax = 0.0f;
+	for (int y = 0; y < mapHeight; y++) {
+		for (int x = 0; x < mapWidth; x++) {
+			float texel = pixels[y * rowPitch + x * pixelStride] / 255.0f;
+			heightMap[y * mapWidth + x] = texel;
+			heightMapMin = texel < heightMapMin ? texel : heightMapMin;
+			heightMapMax = texel > heightMapMax ? texel : heightMapMax;
+		}
+	}
+
+	// force the heightmap part to rebuild on the next update
+	bakedAmplitude = -1.0f;
+}
+
+float DisplacementField::sampleHeightMap(float u, float v) const
+{
+	// texel centres are at half texel offsets, clamp like the shaders' sampler
+	float x = u * mapWidth - 0.5f;
+	float y = v * mapHeight - 0.5f;
+	x = x < 0.0f ? 0.0f : (x > mapWidth - 1 ? (float)(mapWidth - 1) : x);
+	y = y < 0.0f ? 0.0f : (y > mapHeight - 1 ? (float)(mapHeight - 1) : y);
+
+	int x0 = (int)x;
+	int y0 = (int)y;
+	int x1 = x0 + 1 < mapWidth ? x0 + 1 : x0;
+	int y1 = y0 + 1 < mapHeight ? y0 + 1 : y0;
+	float fx = x - x0;
+	float fy = y - y0;
+
+	float top = heightMap[y0 * mapWidth + x0] * (1.0f - fx) + heightMap[y0 * mapWidth + x1] * fx;
+	float bottom = heightMap[y1 * mapWidth + x0] * (1.0f - fx) + heightMap[y1 * mapWidth + x1] * fx;
+	return top * (1.0f - fy) + bottom * fy;
+}
+
+void DisplacementField::heightMapTexel(int x, int y, float heightAmplitude, float out[4]) const
+{
+	float u = (x + 0.5f) / width;
+	float v = (y + 0.5f) / height;
+
+	float h = sampleHeightMap(u, v) * heightAmplitude;
+	float hN = sampleHeightMap(u, v + HEIGHTMAP_UV_STEP) * heightAmplitude;
+	float hS = sampleHeightMap(u, v - HEIGHTMAP_UV_STEP) * heightAmplitude;
+	float hE = sampleHeightMap(u + HEIGHTMAP_UV_STEP, v) * heightAmplitude;
+	float hW = sampleHeightMap(u - HEIGHTMAP_UV_STEP, v) * heightAmplitude;
+
+	float3 normal = getHeightMapNormal(h, hN, hS, hE, hW, HEIGHTMAP_WORLD_STEP);
+	out[0] = normal.x;
+	out[1] = normal.y;
+	out[2] = normal.z;
+	out[3] = h;
+}
+
+void DisplacementField::evaluate(int x, int y, float time, const Wave waves[2], float heightAmplitude, float out[4]) const
+{
+	float base[4];
+	heightMapTexel(x, y, heightAmplitude, base);
+
+	// straight from the shared wave functions, so this is also the reference for the shaders
+	float2 pos((x + 0.5f) / width * planeSize, (y + 0.5f) / height * planeSize);
+	float2 amplitude(waves[0].amplitude, waves[1].amplitude);
+	float2 frequency(waves[0].frequency, waves[1].frequency);
+	float2 speed(waves[0].speed, waves[1].speed);
+	float offset = getWaveOffset(pos, amplitude, frequency, speed, time);
+	float3 waveNormal = getWaveNormal(pos, amplitude, frequency, speed, time);
+
+	out[0] = (waveNormal.x + base[0]) / 2.0f;
+	out[1] = (waveNormal.y + base[1]) / 2.0f;
+	out[2] = (waveNormal.z + base[2]) / 2.0f;
+	out[3] = base[3] + offset;
+}
+
+template <typename F>
+void DisplacementField::parallelRows(int threadCount, F rowFunction) const
+{
+	if (threadCount <= 0)
+		threadCount = (int)std::thread::hardware_concurrency();
+	if (threadCount > height)
+		threadCount = height;
+	if (threadCount < 1)
+		threadCount = 1;
+
+	// contiguous bands of rows, the calling thread takes the last band
+	std::vector<std::thread> workers;
+	int rowsPerThread = (height + threadCount - 1) / threadCount;
+	for (int t = 0; t < threadCount; t++) {
+		int first = t * rowsPerThread;
+		int last = first + rowsPerThread < height ? first + rowsPerThread : height;
+		if (first >= last)
+			break;
+
+		auto band = [first, last, &rowFunction]() {
+			for (int y = first; y < last; y++)
+				rowFunction(y);
+		};
+		if (t == threadCount - 1 || last == height)
+			band();
+		else
+			workers.push_back(std::thread(band));
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void DisplacementField::rebuildHeightMap(float heightAmplitude, int threadCount)
+{
+	parallelRows(threadCount, [this, heightAmplitude](int y) {
+		for (int x = 0; x < width; x++) {
+			float texel[4];
+			heightMapTexel(x, y, heightAmplitude, texel);
+			baseNormalX[y * width + x] = texel[0];
+			baseNormalY[y * width + x] = texel[1];
+			baseNormalZ[y * width + x] = texel[2];
+			baseHeight[y * width + x] = texel[3];
+		}
+	});
+	bakedAmplitude = heightAmplitude;
+}
+
+bool DisplacementField::update(float time, const Wave waves[2], float heightAmplitude, int threadCount)
+{
+	// the heightmap doesn't move, only rebuild it when its amplitude is changed
+	bool rebuilt = heightAmplitude != bakedAmplitude;
+	if (rebuilt)
+		rebuildHeightMap(heightAmplitude, threadCount);
+
+	// the x wave is the same down every column, getWaveSlope split into its x and z halves
+	for (int x = 0; x < width; x++) {
+		float phase = (x + 0.5f) / width * planeSize * waves[0].frequency + time * waves[0].speed;
+		waveX[x] = sinf(phase) * waves[0].amplitude / 2.0f;
+		slopeX[x] = cosf(phase) * waves[0].amplitude * waves[0].frequency / 2.0f;
+	}
+
+	parallelRows(threadCount, [this, time, waves](int y) {
+		float phase = (y + 0.5f) / height * planeSize * waves[1].frequency + time * waves[1].speed;
+		__m128 waveZ = _mm_set1_ps(sinf(phase) * waves[1].amplitude / 2.0f);
+		__m128 slopeZ = _mm_set1_ps(cosf(phase) * waves[1].amplitude * waves[1].frequency / 2.0f);
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 slopeZ2 = _mm_mul_ps(slopeZ, slopeZ);
+
+		const float* baseX = &baseNormalX[y * width];
+		const float* baseY = &baseNormalY[y * width];
+		const float* baseZ = &baseNormalZ[y * width];
+		const float* baseH = &baseHeight[y * width];
+		float* out = &data[y * width * 4];
+
+		// four texels at a time, the wave normal is (-slopeX, 1, -slopeZ) normalised
+		for (int x = 0; x < width; x += 4) {
+			__m128 sx = _mm_loadu_ps(&slopeX[x]);
+			__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, sx), slopeZ2), one)));
+
+			__m128 nx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&baseX[x]), _mm_mul_ps(sx, inverseLength)), half);
+			__m128 ny = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&baseY[x]), inverseLength), half);
+			__m128 nz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&baseZ[x]), _mm_mul_ps(slopeZ, inverseLength)), half);
+			__m128 h = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&baseH[x]), _mm_loadu_ps(&waveX[x])), waveZ);
+
+			// structure of arrays back to one float4 per texel
+			_MM_TRANSPOSE4_PS(nx, ny, nz, h);
+			_mm_storeu_ps(out + x * 4, nx);
+			_mm_storeu_ps(out + x * 4 + 4, ny);
+			_mm_storeu_ps(out + x * 4 + 8, nz);
+			_mm_storeu_ps(out + x * 4 + 12, h);
+		}
+	});
+	return rebuilt;
+}
@@ -0,0 +1,74 @@
+// Displacement field
+// CPU bake of the manipulation plane's displacement, the heightmap plus the sine waves with their combined normal.
+// Doesn't depend on D3D so it can be built and checked on its own, DisplacementMap uploads it for the shaders
+#pragma once
+
+#include <vector>
+
+class DisplacementField
+{
+public:
+	// same layout as the wave settings in App1, x = amplitude, y = frequency, z = speed. [0] is along x, [1] along z
+	struct Wave
+	{
+		float amplitude;
+		float frequency;
+		float speed;
+	};
+
+	// width is rounded up to a multiple of 4 so rows can be processed four texels at a time.
+	// planeSize is the plane's size in object space, TessellatedPlaneMesh maps uv * planeSize to position xz
+	DisplacementField(int width, int height, float planeSize);
+
+	// copies the heightmap's red channel. texels are 8 bit, pixelStride bytes apart and rowPitch bytes per row
+	void setHeightMap(const unsigned char* pixels, int mapWidth, int mapHeight, int pixelStride, int rowPitch);
+
+	// evaluates every texel across threadCount threads (0 uses one per core).
+	// the heightmap part is only rebuilt when heightAmplitude changes, the waves are separable so each frame
+	// only needs one sin/cos per row and per column. true if the heightmap part was rebuilt
+	bool update(float time, const Wave waves[2], float heightAmplitude, int threadCount = 0);
+
+	// width * height float4 texels, xyz = flat normal (not normalised, same as the shaders' average), w = height
+	const float* getData() const { return data.data(); };
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+	float getHeightMapMin() const { return heightMapMin; }; // lowest heightmap texel, in [0, 1]
+	float getHeightMapMax() const { return heightMapMax; };
+
+	// reference evaluation of a single texel, the result update() should match
+	void evaluate(int x, int y, float time, const Wave waves[2], float heightAmplitude, float out[4]) const;
+
+	// the decoded heightmap, bilinear and clamped like the shaders' sampler. in [0, 1]
+	float sampleHeightMap(float u, float v) const;
+
+private:
+	void heightMapTexel(int x, int y, float heightAmplitude, float out[4]) const; // scaled height and normal
+	void rebuildHeightMap(float heightAmplitude, int threadCount);
+
+	template <typename F>
+	void parallelRows(int threadCount, F rowFunction) const;
+
+private:
+	int width;
+	int height;
+	float planeSize;
+
+	std::vector<float> heightMap; // source heightmap's red channel
+	int mapWidth;
+	int mapHeight;
+	float heightMapMin;
+	float heightMapMax;
+
+	// heightmap part at bakedAmplitude, structure of arrays so update() can load four texels at once
+	std::vector<float> baseHeight;
+	std::vector<float> baseNormalX;
+	std::vector<float> baseNormalY;
+	std::vector<float> baseNormalZ;
+	float bakedAmplitude;
+
+	// per column wave along x, rebuilt each update
+	std::vector<float> waveX;
+	std::vector<float> slopeX;
+
+	std::vector<float> data;
+};
@@ -0,0 +1,115 @@
+// Displacement map
+#include "DisplacementMap.h"
+
+DisplacementMap::DisplacementMap(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* heightMap, int resolution, float planeSize)
+	: field(resolution, resolution, planeSize)
+{
+	texture = 0;
+	textureSRV = 0;
+
+	readHeightMap(device, deviceContext, heightMap);
+
+	// rewritten every frame by the CPU
+	D3D11_TEXTURE2D_DESC textureDesc;
+	ZeroMemory(&textureDesc, sizeof(textureDesc));
+	textureDesc.Width = field.getWidth();
+	textureDesc.Height = field.getHeight();
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_DYNAMIC;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	device->CreateTexture2D(&textureDesc, NULL, &texture);
+	device->CreateShaderResourceView(texture, NULL, &textureSRV);
+}
+
+DisplacementMap::~DisplacementMap()
+{
+	if (textureSRV)
+	{
+		textureSRV->Release();
+		textureSRV = 0;
+	}
+	if (texture)
+	{
+		texture->Release();
+		texture = 0;
+	}
+}
+
+void DisplacementMap::readHeightMap(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* heightMap)
+{
+	ID3D11Resource* resource = 0;
+	heightMap->GetResource(&resource);
+	ID3D11Texture2D* source = 0;
+	resource->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&source);
+	resource->Release();
+	if (!source)
+		return;
+
+	D3D11_TEXTURE2D_DESC sourceDesc;
+	source->GetDesc(&sourceDesc);
+
+	// only the red channel is used, find where it sits in each texel
+	int pixelStride, redOffset;
+	switch (sourceDesc.Format)
+	{
+	case DXGI_FORMAT_R8_UNORM:
+		pixelStride = 1; redOffset = 0; break;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		pixelStride = 4; redOffset = 0; break;
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+		pixelStride = 4; redOffset = 2; break;
+	default:
+		// anything else leaves the plane flat
+		source->Release();
+		return;
+	}
+
+	// copy the top mip somewhere the CPU can read it
+	D3D11_TEXTURE2D_DESC stagingDesc = sourceDesc;
+	stagingDesc.MipLevels = 1;
+	stagingDesc.ArraySize = 1;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags = 0;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	stagingDesc.MiscFlags = 0;
+	ID3D11Texture2D* staging = 0;
+	device->CreateTexture2D(&stagingDesc, NULL, &staging);
+	deviceContext->CopySubresourceRegion(staging, 0, 0, 0, 0, source, 0, NULL);
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (deviceContext->Map(staging, 0, D3D11_MAP_READ, 0, &mappedResource) == S_OK)
+	{
+		field.setHeightMap((const unsigned char*)mappedResource.pData + redOffset, sourceDesc.Width, sourceDesc.Height, pixelStride, mappedResource.RowPitch);
+		deviceContext->Unmap(staging, 0);
+	}
+
+	staging->Release();
+	source->Release();
+}
+
+void DisplacementMap::update(ID3D11DeviceContext* deviceContext, float time, XMFLOAT3 waveSettings[2], float heightAmplitude)
+{
+	DisplacementField::Wave waves[2];
+	for (int i = 0; i < 2; i++) {
+		waves[i].amplitude = waveSettings[i].x;
+		waves[i].frequency = waveSettings[i].y;
+		waves[i].speed = waveSettings[i].z;
+	}
+	field.update(time, waves, heightAmplitude);
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	deviceContext->Map(texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	const float* data = field.getData();
+	size_t rowSize = field.getWidth() * 4 * sizeof(float);
+	for (int y = 0; y < field.getHeight(); y++) {
+		memcpy((unsigned char*)mappedResource.pData + y * mappedResource.RowPitch, data + y * field.getWidth() * 4, rowSize);
+	}
+	deviceContext->Unmap(texture, 0);
+}
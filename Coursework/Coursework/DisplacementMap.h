@@ -0,0 +1,32 @@
+// Displacement map
+// Uploads a DisplacementField each frame so the manipulation plane's shaders fetch one texel per vertex
+// instead of sampling the heightmap and evaluating the waves in every stage of every pass.
+// Bound in place of the heightmap, xyz = flat normal, w = height
+#pragma once
+
+#include "DXF.h"
+#include "DisplacementField.h"
+
+using namespace DirectX;
+
+class DisplacementMap
+{
+public:
+	// reads the heightmap back from the GPU once, planeSize is the plane mesh's resolution
+	DisplacementMap(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* heightMap, int resolution, float planeSize);
+	~DisplacementMap();
+
+	// waveSettings are x = amplitude, y = frequency, z = speed for the x and z waves
+	void update(ID3D11DeviceContext* deviceContext, float time, XMFLOAT3 waveSettings[2], float heightAmplitude);
+
+	ID3D11ShaderResourceView* getShaderResourceView() { return textureSRV; };
+	const DisplacementField& getField() { return field; };
+
+private:
+	void readHeightMap(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* heightMap);
+
+private:
+	DisplacementField field;
+	ID3D11Texture2D* texture;
+	ID3D11ShaderResourceView* textureSRV;
+};
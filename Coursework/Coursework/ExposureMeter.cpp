@@ -0,0 +1,75 @@
+// Exposure meter
+#include "ExposureMeter.h"
+
+ExposureMeter::ExposureMeter(ID3D11Device* device, int lwidth, int lheight)
+{
+	width = lwidth;
+	height = lheight;
+	next = 0;
+
+	D3D11_TEXTURE2D_DESC stagingDesc;
+	ZeroMemory(&stagingDesc, sizeof(stagingDesc));
+	stagingDesc.Width = width;
+	stagingDesc.Height = height;
+	stagingDesc.MipLevels = 1;
+	stagingDesc.ArraySize = 1;
+	stagingDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	stagingDesc.SampleDesc.Count = 1;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags = 0;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	for (int i = 0; i < STAGING_COUNT; i++) {
+		staging[i] = 0;
+		pending[i] = false;
+		device->CreateTexture2D(&stagingDesc, NULL, &staging[i]);
+	}
+}
+
+ExposureMeter::~ExposureMeter()
+{
+	for (int i = 0; i < STAGING_COUNT; i++) {
+		if (staging[i])
+		{
+			staging[i]->Release();
+			staging[i] = 0;
+		}
+	}
+}
+
+void ExposureMeter::capture(ID3D11DeviceContext* deviceContext, RenderTexture* source)
+{
+	ID3D11Resource* resource = 0;
+	source->getShaderResourceView()->GetResource(&resource);
+	if (!resource)
+		return;
+
+	// a capture nobody read in time is overwritten, the newer one is more use
+	deviceContext->CopyResource(staging[next], resource);
+	resource->Release();
+	pending[next] = true;
+	next = (next + 1) % STAGING_COUNT;
+}
+
+bool ExposureMeter::read(ID3D11DeviceContext* deviceContext, vector<float>& pixels)
+{
+	// the oldest capture is the one most likely to be finished, it's the one after the newest
+	for (int i = 0; i < STAGING_COUNT; i++) {
+		int index = (next + i) % STAGING_COUNT;
+		if (!pending[index])
+			continue;
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		if (deviceContext->Map(staging[index], 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedResource) != S_OK)
+			return false; // still drawing, the newer ones will be too
+
+		pixels.resize((size_t)width * height * 4);
+		size_t rowSize = width * 4 * sizeof(float);
+		for (int y = 0; y < height; y++) {
+			memcpy(&pixels[(size_t)y * width * 4], (const unsigned char*)mappedResource.pData + y * mappedResource.RowPitch, rowSize);
+		}
+		deviceContext->Unmap(staging[index], 0);
+		pending[index] = false;
+		return true;
+	}
+	return false;
+}
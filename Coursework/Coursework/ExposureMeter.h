@@ -0,0 +1,33 @@
+// Exposure meter
+// Reads a small copy of the HDR scene back to the CPU for AutoExposure to measure. Each frame's copy goes into the next
+// of a few staging textures and the oldest is read once the GPU has finished with it, so the CPU never waits on the
+// GPU and the measurement lags a couple of frames behind
+#pragma once
+
+#include "DXF.h"
+#include <vector>
+
+using namespace std;
+
+class ExposureMeter
+{
+public:
+	static const int STAGING_COUNT = 3;
+
+	// width and height are the size of the render texture captured each frame
+	ExposureMeter(ID3D11Device* device, int width, int height);
+	~ExposureMeter();
+
+	void capture(ID3D11DeviceContext* deviceContext, RenderTexture* source); // source has to be width x height and R32G32B32A32_FLOAT
+	bool read(ID3D11DeviceContext* deviceContext, vector<float>& pixels); // false if no capture has finished, RGBA rows otherwise
+
+	int getWidth() { return width; };
+	int getHeight() { return height; };
+
+private:
+	ID3D11Texture2D* staging[STAGING_COUNT];
+	bool pending[STAGING_COUNT]; // copied to but not read yet
+	int next; // the staging texture the next capture copies to
+	int width;
+	int height;
+};
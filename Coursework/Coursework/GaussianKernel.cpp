@@ -0,0 +1,75 @@
+// Gaussian kernel
+#include "GaussianKernel.h"
+#include "GaussianKernels.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	// the token pasting the shaders use to pick a radius
+	constexpr float weights3[] = GAUSSIAN_KERNEL(3, WEIGHTS);
+	constexpr float offsets3[] = GAUSSIAN_KERNEL(3, OFFSETS);
+	constexpr float weights5[] = GAUSSIAN_KERNEL(5, WEIGHTS);
+	constexpr float offsets5[] = GAUSSIAN_KERNEL(5, OFFSETS);
+	constexpr float weights8[] = GAUSSIAN_KERNEL(8, WEIGHTS);
+	constexpr float offsets8[] = GAUSSIAN_KERNEL(8, OFFSETS);
+	constexpr float weights12[] = GAUSSIAN_KERNEL(12, WEIGHTS);
+	constexpr float offsets12[] = GAUSSIAN_KERNEL(12, OFFSETS);
+
+	constexpr bool matches(int radius, int samples, const float* weights, const float* offsets)
+	{
+		GaussianKernel kernel = makeGaussianKernel(radius);
+		if (kernel.samples != samples)
+			return false;
+		for (int i = 0; i < samples; i++) {
+			if (kernel.sampleWeights[i] != weights[i] || kernel.offsets[i] != offsets[i])
+				return false;
+		}
+		return true;
+	}
+}
+
+// regenerate GaussianKernels.h with gaussianKernelDefines if these fail
+static_assert(matches(3, GAUSSIAN_KERNEL(3, SAMPLES), weights3, offsets3), "GaussianKernels.h is out of date for radius 3");
+static_assert(matches(5, GAUSSIAN_KERNEL(5, SAMPLES), weights5, offsets5), "GaussianKernels.h is out of date for radius 5");
+static_assert(matches(8, GAUSSIAN_KERNEL(8, SAMPLES), weights8, offsets8), "GaussianKernels.h is out of date for radius 8");
+static_assert(matches(12, GAUSSIAN_KERNEL(12, SAMPLES), weights12, offsets12), "GaussianKernels.h is out of date for radius 12");
+
+std::string gaussianKernelDefines(const int* radii, int count)
+{
+	std::string text;
+	text += "// Gaussian kernels\n";
+	text += "// Written by gaussianKernelDefines from makeGaussianKernel in GaussianKernel.h, regenerate it rather than editing.\n";
+	text += "// Each radius's bilinear samples, the centre first then the paired taps mirrored either side of it.\n";
+	text += "// Shared by the C++ code and the blur shaders, a shader picks a radius with GAUSSIAN_KERNEL(BLUR_RADIUS, ...)\n";
+	text += "#ifndef _GAUSSIANKERNELS_H\n";
+	text += "#define _GAUSSIANKERNELS_H\n\n";
+	text += "#define GAUSSIAN_KERNEL(radius, table) GAUSSIAN_KERNEL_TABLE(radius, table)\n";
+	text += "#define GAUSSIAN_KERNEL_TABLE(radius, table) GAUSSIAN_##radius##_##table\n";
+
+	char line[64];
+	char number[32];
+	for (int r = 0; r < count; r++) {
+		GaussianKernel kernel = makeGaussianKernel(radii[r]);
+		snprintf(line, sizeof(line), "\n// radius %d, %d samples instead of %d\n", kernel.radius, kernel.samples * 2 - 1, kernel.radius * 2 + 1);
+		text += line;
+		snprintf(line, sizeof(line), "#define GAUSSIAN_%d_SAMPLES %d\n", kernel.radius, kernel.samples);
+		text += line;
+
+		const char* names[2] = { "WEIGHTS", "OFFSETS" };
+		for (int table = 0; table < 2; table++) {
+			snprintf(line, sizeof(line), "#define GAUSSIAN_%d_%s {", kernel.radius, names[table]);
+			text += line;
+			for (int i = 0; i < kernel.samples; i++) {
+				// 9 significant digits read back as the same float, whole numbers need a point to take the f suffix
+				snprintf(number, sizeof(number), "%.9g", table == 0 ? kernel.sampleWeights[i] : kernel.offsets[i]);
+				snprintf(line, sizeof(line), "%s %s%sf", i == 0 ? "" : ",", number, strpbrk(number, ".e") ? "" : ".0");
+				text += line;
+			}
+			text += " }\n";
+		}
+	}
+
+	text += "\n#endif\n";
+	return text;
+}
@@ -0,0 +1,86 @@
+// Gaussian kernel
+// Normalised gaussian blur weights for any radius, worked out at compile time. sigma is a third of the radius, so the
+// last tap is three standard deviations out. The blur shaders can't run C++, so GaussianKernels.h holds the same
+// kernels as HLSL defines, written by gaussianKernelDefines, and GaussianKernel.cpp fails to compile if they drift apart.
+// Linear sampling: the kernel is symmetric and every weight is positive, so two neighbouring taps can be one bilinear
+// sample placed between their texels at their weighted offset. The filter blends the texels in the same ratio as the
+// two weights, so a radius r kernel takes 1 + 2 * ceil(r / 2) samples instead of 2r + 1.
+// Doesn't depend on D3D
+#pragma once
+
+#include <string>
+
+static const int MAX_GAUSSIAN_RADIUS = 16;
+
+// the radii the blur shaders are compiled for, horizontalBlur_ps and verticalBlur_ps are radius 5
+static const int GAUSSIAN_RADII[4] = { 3, 5, 8, 12 };
+
+struct GaussianKernel
+{
+	int radius;
+	float weights[MAX_GAUSSIAN_RADIUS + 1]; // tap i texels either side of the centre, 0 is the centre
+
+	// after pairing, sample 0 is the centre on its own and the rest are mirrored either side of it
+	int samples;
+	float offsets[MAX_GAUSSIAN_RADIUS / 2 + 1]; // in texels
+	float sampleWeights[MAX_GAUSSIAN_RADIUS / 2 + 1];
+};
+
+// e^x for x <= 0. halves x until it's small enough for the series to be exact in a double, then squares it back up
+constexpr double gaussianExp(double x)
+{
+	int halvings = 0;
+	while (x < -0.5) {
+		x *= 0.5;
+		halvings++;
+	}
+
+	double sum = 1.0;
+	double term = 1.0;
+	for (int n = 1; n < 20; n++) {
+		term *= x / n;
+		sum += term;
+	}
+
+	for (int i = 0; i < halvings; i++)
+		sum *= sum;
+	return sum;
+}
+
+constexpr GaussianKernel makeGaussianKernel(int radius)
+{
+	GaussianKernel kernel = {};
+	radius = radius < 1 ? 1 : (radius > MAX_GAUSSIAN_RADIUS ? MAX_GAUSSIAN_RADIUS : radius);
+	kernel.radius = radius;
+
+	// the centre and both sides add up to one
+	double sigma = radius / 3.0;
+	double weights[MAX_GAUSSIAN_RADIUS + 1] = {};
+	double total = 0.0;
+	for (int i = 0; i <= radius; i++) {
+		weights[i] = gaussianExp(-(i * i) / (2.0 * sigma * sigma));
+		total += (i == 0) ? weights[i] : weights[i] * 2.0;
+	}
+	for (int i = 0; i <= radius; i++)
+		kernel.weights[i] = (float)(weights[i] / total);
+
+	// pair taps 1 and 2, 3 and 4..., an odd radius leaves the last tap on its own
+	kernel.offsets[0] = 0.0f;
+	kernel.sampleWeights[0] = (float)(weights[0] / total);
+	kernel.samples = 1;
+	for (int i = 1; i <= radius; i += 2) {
+		double weight = weights[i];
+		double offset = i * weights[i];
+		if (i + 1 <= radius) {
+			weight += weights[i + 1];
+			offset += (i + 1) * weights[i + 1];
+		}
+		kernel.offsets[kernel.samples] = (float)(offset / weight);
+		kernel.sampleWeights[kernel.samples] = (float)(weight / total);
+		kernel.samples++;
+	}
+	return kernel;
+}
+
+// GaussianKernels.h's contents for these radii
+std::string gaussianKernelDefines(const int* radii, int count);
@@ -0,0 +1,31 @@
+// Gaussian kernels
+// Written by gaussianKernelDefines from makeGaussianKernel in GaussianKernel.h, regenerate it rather than editing.
+// Each radius's bilinear samples, the centre first then the paired taps mirrored either side of it.
+// Shared by the C++ code and the blur shaders, a shader picks a radius with GAUSSIAN_KERNEL(BLUR_RADIUS, ...)
+#ifndef _GAUSSIANKERNELS_H
+#define _GAUSSIANKERNELS_H
+
+#define GAUSSIAN_KERNEL(radius, table) GAUSSIAN_KERNEL_TABLE(radius, table)
+#define GAUSSIAN_KERNEL_TABLE(radius, table) GAUSSIAN_##radius##_##table
+
+// radius 3, 5 samples instead of 7
+#define GAUSSIAN_3_SAMPLES 3
+#define GAUSSIAN_3_WEIGHTS { 0.399050266f, 0.296041816f, 0.00443304796f }
+#define GAUSSIAN_3_OFFSETS { 0.0f, 1.1824255f, 3.0f }
+
+// radius 5, 7 samples instead of 11
+#define GAUSSIAN_5_SAMPLES 4
+#define GAUSSIAN_5_WEIGHTS { 0.239559412f, 0.316702932f, 0.0608561076f, 0.00266126473f }
+#define GAUSSIAN_5_OFFSETS { 0.0f, 1.36818755f, 3.22097397f, 5.0f }
+
+// radius 8, 9 samples instead of 17
+#define GAUSSIAN_8_SAMPLES 5
+#define GAUSSIAN_8_WEIGHTS { 0.14980486f, 0.252712131f, 0.128195271f, 0.0377479978f, 0.00644217664f }
+#define GAUSSIAN_8_OFFSETS { 0.0f, 1.44746029f, 3.37937832f, 5.31573582f, 7.25832605f }
+
+// radius 12, 13 samples instead of 25
+#define GAUSSIAN_12_SAMPLES 7
+#define GAUSSIAN_12_WEIGHTS { 0.0999083593f, 0.18500331f, 0.136012271f, 0.0781768709f, 0.0351278223f, 0.0123383272f, 0.00338721089f }
+#define GAUSSIAN_12_OFFSETS { 0.0f, 1.47657967f, 3.44552946f, 5.41489887f, 7.38491201f, 9.35577488f, 11.3276682f }
+
+#endif
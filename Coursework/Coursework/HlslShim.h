@@ -0,0 +1,47 @@
+// HLSL shim
+// The small part of HLSL the shared C++/HLSL headers (ShadowMath.h, WaveMath.h, PatchCulling.h) are allowed to use:
+// float2/float3/float4, +-*/, dot, cross, length, normalize, lerp, saturate, and sin/cos/acos/sqrt/abs from math.h.
+// Only include it from C++, the shaders already have all of this
+#ifndef _HLSLSHIM_H
+#define _HLSLSHIM_H
+
+#include <math.h>
+
+struct float2
+{
+	float x, y;
+	float2() : x(0.0f), y(0.0f) {}
+	float2(float x_, float y_) : x(x_), y(y_) {}
+};
+
+struct float3
+{
+	float x, y, z;
+	float3() : x(0.0f), y(0.0f), z(0.0f) {}
+	float3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+};
+
+struct float4
+{
+	float x, y, z, w;
+	float4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+	float4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+};
+
+inline float2 operator+(const float2& a, const float2& b) { return float2(a.x + b.x, a.y + b.y); }
+inline float2 operator-(const float2& a, const float2& b) { return float2(a.x - b.x, a.y - b.y); }
+inline float2 operator*(const float2& a, float b) { return float2(a.x * b, a.y * b); }
+inline float2 operator/(const float2& a, float b) { return float2(a.x / b, a.y / b); }
+inline float3 operator+(const float3& a, const float3& b) { return float3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline float3 operator-(const float3& a, const float3& b) { return float3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline float3 operator*(const float3& a, float b) { return float3(a.x * b, a.y * b, a.z * b); }
+inline float3 operator/(const float3& a, float b) { return float3(a.x / b, a.y / b, a.z / b); }
+
+inline float dot(const float3& a, const float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float3 cross(const float3& a, const float3& b) { return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+inline float length(const float3& v) { return sqrtf(dot(v, v)); }
+inline float3 normalize(const float3& v) { return v / length(v); }
+inline float3 lerp(const float3& a, const float3& b, float t) { return a + (b - a) * t; }
+inline float saturate(float v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); }
+
+#endif
@@ -2,9 +2,15 @@
 #include "horizontalblurshader.h"
 
 
-HorizontalBlurShader::HorizontalBlurShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+HorizontalBlurShader::HorizontalBlurShader(ID3D11Device* device, HWND hwnd, int radius) : BaseShader(device, hwnd)
 {
-	initShader(L"horizontalBlur_vs.cso", L"horizontalBlur_ps.cso");
+	// horizontalBlur_ps is radius 5, the wrappers compile it for the other radii
+	wchar_t pixelShader[64];
+	if (radius == 5)
+		swprintf_s(pixelShader, L"horizontalBlur_ps.cso");
+	else
+		swprintf_s(pixelShader, L"horizontalBlur%d_ps.cso", radius);
+	initShader(L"horizontalBlur_vs.cso", pixelShader);
 }
 
 
@@ -83,7 +89,8 @@ void HorizontalBlurShader::initShader(const wchar_t* vsFilename, const wchar_t*
 }
 
 
-void HorizontalBlurShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, float width)
+void HorizontalBlurShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, float width,
+	bool thresholdEnabled, float threshold)
 {
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	MatrixBufferType* dataPtr;
@@ -108,7 +115,9 @@ void HorizontalBlurShader::setShaderParameters(ID3D11DeviceContext* deviceContex
 	deviceContext->Map(screenSizeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	widthPtr = (ScreenSizeBufferType*)mappedResource.pData;
 	widthPtr->screenWidth = width;
-	widthPtr->padding = XMFLOAT3(1.0f, 1.f, 1.f);
+	widthPtr->threshold = threshold;
+	widthPtr->thresholdEnabled = thresholdEnabled ? 1 : 0;
+	widthPtr->padding = 1.0f;
 	deviceContext->Unmap(screenSizeBuffer, 0);
 	deviceContext->PSSetConstantBuffers(0, 1, &screenSizeBuffer);
 
@@ -14,15 +14,18 @@ private:
 	struct ScreenSizeBufferType
 	{
 		float screenWidth;
-		XMFLOAT3 padding;
+		float threshold;
+		int thresholdEnabled;
+		float padding;
 	};
 
 public:
 
-	HorizontalBlurShader(ID3D11Device* device, HWND hwnd);
+	HorizontalBlurShader(ID3D11Device* device, HWND hwnd, int radius = 5); // one of GAUSSIAN_RADII
 	~HorizontalBlurShader();
 
-	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, float width);
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, float width,
+		bool thresholdEnabled = false, float threshold = 0.0f); // bloom thresholds the scene in its first pass
 
 private:
 	void initShader(const wchar_t* vs, const wchar_t* ps);
@@ -0,0 +1,120 @@
+// Dual kawase downsample shader
+#include "KawaseDownShader.h"
+
+
+KawaseDownShader::KawaseDownShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	initShader(L"kawase_vs.cso", L"kawaseDown_ps.cso");
+}
+
+
+KawaseDownShader::~KawaseDownShader()
+{
+	if (sampleState)
+	{
+		sampleState->Release();
+		sampleState = 0;
+	}
+	if (matrixBuffer)
+	{
+		matrixBuffer->Release();
+		matrixBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+	if (kawaseBuffer)
+	{
+		kawaseBuffer->Release();
+		kawaseBuffer = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+
+void KawaseDownShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	D3D11_BUFFER_DESC matrixBufferDesc;
+	D3D11_SAMPLER_DESC samplerDesc;
+	D3D11_BUFFER_DESC kawaseBufferDesc;
+
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+	loadPixelShader(psFilename);
+
+	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
+	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	matrixBufferDesc.MiscFlags = 0;
+	matrixBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
+
+	// Create a texture sampler state description.
+	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.BorderColor[0] = 0;
+	samplerDesc.BorderColor[1] = 0;
+	samplerDesc.BorderColor[2] = 0;
+	samplerDesc.BorderColor[3] = 0;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	renderer->CreateSamplerState(&samplerDesc, &sampleState);
+
+	// Setup the description of the kawase buffer.
+	kawaseBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	kawaseBufferDesc.ByteWidth = sizeof(KawaseBufferType);
+	kawaseBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	kawaseBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	kawaseBufferDesc.MiscFlags = 0;
+	kawaseBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&kawaseBufferDesc, NULL, &kawaseBuffer);
+
+}
+
+void KawaseDownShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, float width, float height, float offset,
+		bool thresholdEnabled, float threshold)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	MatrixBufferType* dataPtr;
+	XMMATRIX tworld, tview, tproj;
+
+	// Transpose the matrices to prepare them for the shader.
+	tworld = XMMatrixTranspose(worldMatrix);
+	tview = XMMatrixTranspose(viewMatrix);
+	tproj = XMMatrixTranspose(projectionMatrix);
+
+	deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr->world = tworld;
+	dataPtr->view = tview;
+	dataPtr->projection = tproj;
+	deviceContext->Unmap(matrixBuffer, 0);
+	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	// the taps are spread in the source texture's texels
+	KawaseBufferType* kawasePtr;
+	deviceContext->Map(kawaseBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	kawasePtr = (KawaseBufferType*)mappedResource.pData;
+	kawasePtr->texelSize = XMFLOAT2(1.0f / width, 1.0f / height);
+	kawasePtr->offset = offset;
+	kawasePtr->threshold = threshold;
+	kawasePtr->thresholdEnabled = thresholdEnabled ? 1 : 0;
+	kawasePtr->padding = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	deviceContext->Unmap(kawaseBuffer, 0);
+	deviceContext->PSSetConstantBuffers(0, 1, &kawaseBuffer);
+
+	// Set shader texture resource in the pixel shader.
+	deviceContext->PSSetShaderResources(0, 1, &texture);
+	deviceContext->PSSetSamplers(0, 1, &sampleState);
+}
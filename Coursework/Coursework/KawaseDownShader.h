@@ -0,0 +1,39 @@
+// Dual kawase downsample shader handler
+// Loads the kawase downsample shaders (vs and ps)
+// Passes the source texture's texel size and the tap offset, the first bloom pass also thresholds
+#pragma once
+
+#include "DXF.h"
+
+using namespace std;
+using namespace DirectX;
+
+class KawaseDownShader : public BaseShader
+{
+private:
+	struct KawaseBufferType
+	{
+		XMFLOAT2 texelSize;
+		float offset;
+		float threshold;
+		int thresholdEnabled;
+		XMFLOAT3 padding;
+	};
+
+public:
+
+	KawaseDownShader(ID3D11Device* device, HWND hwnd);
+	~KawaseDownShader();
+
+	// width and height are the source texture's, bloom thresholds the scene in its first pass
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, float width, float height, float offset,
+		bool thresholdEnabled = false, float threshold = 0.0f);
+
+private:
+	void initShader(const wchar_t* vs, const wchar_t* ps);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11SamplerState* sampleState;
+	ID3D11Buffer* kawaseBuffer;
+};
@@ -0,0 +1,36 @@
+// Dual kawase upsample shader handler
+// Loads the kawase upsample shaders (vs and ps)
+// Passes the source texture's texel size and the tap offset, bloom adds the level being upsampled to
+#pragma once
+
+#include "DXF.h"
+
+using namespace std;
+using namespace DirectX;
+
+class KawaseUpShader : public BaseShader
+{
+private:
+	struct KawaseBufferType
+	{
+		XMFLOAT2 texelSize;
+		float offset;
+		float levelWeight;
+	};
+
+public:
+
+	KawaseUpShader(ID3D11Device* device, HWND hwnd);
+	~KawaseUpShader();
+
+	// width and height are the source texture's, level is added to the result with levelWeight
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* level, float width, float height, float offset, float levelWeight);
+
+private:
+	void initShader(const wchar_t* vs, const wchar_t* ps);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11SamplerState* sampleState;
+	ID3D11Buffer* kawaseBuffer;
+};
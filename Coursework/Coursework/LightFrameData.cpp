@@ -0,0 +1,94 @@
+// Light frame data
+#include "LightFrameData.h"
+
+LightFrameData::LightFrameData(ID3D11Device* device)
+{
+	lightBuffer = 0;
+	lightMatrixBuffer = 0;
+	atlasSRV = 0;
+	cubeSRV = 0;
+
+	D3D11_BUFFER_DESC bufferDesc;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = sizeof(LightBufferType);
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+	device->CreateBuffer(&bufferDesc, NULL, &lightBuffer);
+
+	bufferDesc.ByteWidth = sizeof(LightMatrixBufferType);
+	device->CreateBuffer(&bufferDesc, NULL, &lightMatrixBuffer);
+}
+
+LightFrameData::~LightFrameData()
+{
+	if (lightBuffer)
+	{
+		lightBuffer->Release();
+		lightBuffer = 0;
+	}
+	if (lightMatrixBuffer)
+	{
+		lightMatrixBuffer->Release();
+		lightMatrixBuffer = 0;
+	}
+}
+
+void LightFrameData::update(ID3D11DeviceContext* deviceContext, ShadowAtlas* atlas, int tiles[4][4], ShadowMap* pointMaps, int cubes[4], int pointMode[4], CascadedShadows* cascades,
+	float mapBias[4], float nearPlane[4], float farPlane[4], Light* light[4], float atten[4], int lType[4], float oAngle[4], float iAngle[4], float falloff[4])
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	// combine each light view with its projection, the pixel shaders rebuild light space positions from the world position
+	deviceContext->Map(lightMatrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	LightMatrixBufferType* lightMatrixPtr = (LightMatrixBufferType*)mappedResource.pData;
+	LightMatrices::build(light, lType, pointMode, cascades, lightMatrixPtr->lightViewProjection);
+	deviceContext->Unmap(lightMatrixBuffer, 0);
+
+	deviceContext->Map(lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	LightBufferType* lightPtr = (LightBufferType*)mappedResource.pData;
+	for (int i = 0; i < 4; i++) {
+		lightPtr->ambient[i] = light[i]->getAmbientColour();
+		lightPtr->diffuse[i] = light[i]->getDiffuseColour();
+		lightPtr->position[i] = XMFLOAT4(light[i]->getPosition().x, light[i]->getPosition().y, light[i]->getPosition().z, 1.0f);
+		lightPtr->direction[i] = XMFLOAT4(light[i]->getDirection().x, light[i]->getDirection().y, light[i]->getDirection().z, 1.0f);
+
+		lightPtr->specularColour[i] = light[i]->getSpecularColour();
+		lightPtr->specularPower[i] = light[i]->getSpecularPower();
+		lightPtr->outerAngle[i] = cos(XMConvertToRadians(oAngle[i]));
+		lightPtr->innerAngle[i] = cos(XMConvertToRadians(iAngle[i]));
+		lightPtr->fall[i] = falloff[i];
+		lightPtr->type[i] = lType[i];
+		lightPtr->attenuation[i] = atten[i];
+		lightPtr->bias[i] = mapBias[i];
+
+		lightPtr->cascadeCount[i] = (lType[i] == 1) ? max(cascades[i].getCascadeCount(), 1) : 1;
+		lightPtr->cascadeBlend[i] = cascades[i].getBlendRange();
+		for (int c = 0; c < 4; c++) {
+			lightPtr->tileRect[i][c] = atlas->getTileRect(tiles[i][c]);
+		}
+		lightPtr->cubeIndex[i] = max(cubes[i], 0);
+		lightPtr->paraboloid[i] = (lType[i] == 0 && pointMode[i] == 1);
+		lightPtr->paraboloidNear[i] = nearPlane[i];
+		lightPtr->paraboloidFar[i] = farPlane[i];
+	}
+	lightPtr->atlasTexelSize = atlas->getTexelSize();
+	lightPtr->cubeTexelSize = pointMaps ? 1.0f / pointMaps->getWidth() : 0.0f;
+	lightPtr->shadowPadding = 0.0f;
+	deviceContext->Unmap(lightBuffer, 0);
+
+	// the shadow maps can be reallocated between frames, so hold on to this frame's views
+	atlasSRV = atlas->getDepthMapSRV();
+	cubeSRV = pointMaps ? pointMaps->getDepthMapSRV() : 0;
+}
+
+void LightFrameData::bind(ID3D11DeviceContext* deviceContext)
+{
+	ID3D11Buffer* buffers[2] = { lightBuffer, lightMatrixBuffer };
+	deviceContext->PSSetConstantBuffers(0, 2, buffers);
+
+	// every spot/directional light's depth view lives in the atlas, point lights read their cube faces as slices of one array
+	deviceContext->PSSetShaderResources(1, 1, &atlasSRV);
+	deviceContext->PSSetShaderResources(2, 1, &cubeSRV);
+}
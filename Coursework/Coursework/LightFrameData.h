@@ -0,0 +1,66 @@
+// Light frame data
+// Light and shadow constants shared by every lit shader.
+// Built and uploaded once a frame after the depth passes, each lit draw then only binds it.
+#pragma once
+
+#include "DXF.h"
+#include "ShadowAtlas.h"
+#include "CascadedShadows.h"
+#include "LightMatrices.h"
+
+using namespace DirectX;
+
+class LightFrameData
+{
+public:
+	// pixel shader b0, must match LightBuffer in the lit pixel shaders
+	struct LightBufferType
+	{
+		XMFLOAT4 ambient[4];
+		XMFLOAT4 diffuse[4];
+		XMFLOAT4 position[4];
+		XMFLOAT4 direction[4];
+		XMFLOAT4 specularColour[4];
+		float specularPower[4];
+
+		int type[4];
+		float outerAngle[4];
+		float innerAngle[4];
+		float fall[4];
+		float attenuation[4];
+		float bias[4];
+
+		XMFLOAT4 tileRect[4][4]; // uv scale/offset in the shadow atlas for each spot light, or each directional light cascade
+		XMFLOAT2 atlasTexelSize;
+		float cubeTexelSize;
+		float shadowPadding;
+		int cubeIndex[4]; // each point light's cube in the cube array
+		int cascadeCount[4];
+		float cascadeBlend[4]; // fraction of a cascade's edge that fades into the next cascade
+		int paraboloid[4]; // 1 if a point light uses dual paraboloid shadows instead of a cube
+		float paraboloidNear[4];
+		float paraboloidFar[4];
+	};
+
+	// pixel shader b1
+	struct LightMatrixBufferType
+	{
+		XMMATRIX lightViewProjection[4][6]; // each light view combined with its light's projection
+	};
+
+	LightFrameData(ID3D11Device* device);
+	~LightFrameData();
+
+	// rebuilds the light matrices and uploads both buffers. call once a frame, after the depth passes have generated each light's matrices
+	void update(ID3D11DeviceContext* deviceContext, ShadowAtlas* atlas, int tiles[4][4], ShadowMap* pointMaps, int cubes[4], int pointMode[4], CascadedShadows* cascades,
+		float mapBias[4], float nearPlane[4], float farPlane[4], Light* light[4], float atten[4], int lType[4], float oAngle[4], float iAngle[4], float falloff[4]);
+
+	// binds the buffers and shadow maps to the pixel shader, cheap enough to call for every lit draw
+	void bind(ID3D11DeviceContext* deviceContext);
+
+private:
+	ID3D11Buffer* lightBuffer;
+	ID3D11Buffer* lightMatrixBuffer;
+	ID3D11ShaderResourceView* atlasSRV;
+	ID3D11ShaderResourceView* cubeSRV;
+};
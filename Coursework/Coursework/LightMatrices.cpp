@@ -0,0 +1,47 @@
+// Light matrices
+#include "LightMatrices.h"
+
+const XMFLOAT3 LightMatrices::cubeDirections[6] = {
+	XMFLOAT3(0.0f, -1.0f, 0.0f),
+	XMFLOAT3(0.0f, 1.0f, 0.0f),
+	XMFLOAT3(1.0f, 0.0f, 0.0f),
+	XMFLOAT3(-1.0f, 0.0f, 0.0f),
+	XMFLOAT3(0.0f, 0.0f, 1.0f),
+	XMFLOAT3(0.0f, 0.0f, -1.0f)
+};
+
+void LightMatrices::build(Light* light[4], int lType[4], int pointMode[4], CascadedShadows* cascades, XMMATRIX out[4][6])
+{
+	for (int i = 0; i < 4; i++) {
+		XMMATRIX lightProjection;
+		if (lType[i] == 1) {
+			// if it's a directional light, use an ortho matrix
+			lightProjection = light[i]->getOrthoMatrix();
+		}
+		else if (lType[i] == 0 && pointMode[i] == 1) {
+			// dual paraboloid lights project in the pixel shader, the first two views are the down and up hemispheres
+			lightProjection = XMMatrixIdentity();
+		}
+		else {
+			// else use the light's projection matrix
+			lightProjection = light[i]->getProjectionMatrix();
+		}
+
+		for (int j = 0; j < 6; j++) {
+			if (lType[i] == 0) {
+				// if it's a point light, generate a new view matrix
+				light[i]->setDirection(cubeDirections[j].x, cubeDirections[j].y, cubeDirections[j].z);
+				light[i]->generateViewMatrix();
+			}
+
+			out[i][j] = XMMatrixTranspose(light[i]->getViewMatrix() * lightProjection);
+		}
+
+		if (lType[i] == 1 && cascades[i].getCascadeCount() > 0) {
+			// cascades have their own view and projection for each cascade
+			for (int c = 0; c < cascades[i].getCascadeCount(); c++) {
+				out[i][c] = XMMatrixTranspose(cascades[i].getViewMatrix(c) * cascades[i].getProjectionMatrix(c));
+			}
+		}
+	}
+}
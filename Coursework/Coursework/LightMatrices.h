@@ -0,0 +1,22 @@
+// Light matrices
+// Each light view combined with its light's projection, the matrices the lit pixel shaders rebuild light space positions with.
+// Split out of LightFrameData so the tests can check them against the old per vertex transform.
+// Doesn't depend on D3D
+#pragma once
+
+#include <directxmath.h>
+#include "Light.h"
+#include "CascadedShadows.h"
+
+using namespace DirectX;
+
+class LightMatrices
+{
+public:
+	// point light depth cube face normals, in the order the faces are stored
+	static const XMFLOAT3 cubeDirections[6];
+
+	// fills out with every light's six views, transposed ready for a constant buffer.
+	// point lights are left facing the last cube face, like the depth pass leaves them
+	static void build(Light* light[4], int lType[4], int pointMode[4], CascadedShadows* cascades, XMMATRIX out[4][6]);
+};
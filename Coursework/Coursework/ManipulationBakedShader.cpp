@@ -0,0 +1,138 @@
+// Baked manipulation shader
+#include "ManipulationBakedShader.h"
+
+
+ManipulationBakedShader::ManipulationBakedShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	initShader(L"manipulationBaked_vs.cso", L"manipulationTess_ps.cso");
+}
+
+
+ManipulationBakedShader::~ManipulationBakedShader()
+{
+	if (normalBuffer)
+	{
+		normalBuffer->Release();
+		normalBuffer = 0;
+	}
+	if (camBuffer)
+	{
+		camBuffer->Release();
+		camBuffer = 0;
+	}
+	if (sampleState)
+	{
+		sampleState->Release();
+		sampleState = 0;
+	}
+	if (sampleStateShadow)
+	{
+		sampleStateShadow->Release();
+		sampleStateShadow = 0;
+	}
+	if (matrixBuffer)
+	{
+		matrixBuffer->Release();
+		matrixBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+void ManipulationBakedShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+	loadPixelShader(psFilename);
+
+	D3D11_BUFFER_DESC matrixBufferDesc;
+	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	matrixBufferDesc.MiscFlags = 0;
+	matrixBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
+
+	D3D11_SAMPLER_DESC samplerDesc;
+	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	renderer->CreateSamplerState(&samplerDesc, &sampleState);
+
+	// Sampler for shadow map sampling.
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	renderer->CreateSamplerState(&samplerDesc, &sampleStateShadow);
+
+	D3D11_BUFFER_DESC normalBufferDesc;
+	normalBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	normalBufferDesc.ByteWidth = sizeof(NormalBufferType);
+	normalBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	normalBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	normalBufferDesc.MiscFlags = 0;
+	normalBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&normalBufferDesc, NULL, &normalBuffer);
+
+	D3D11_BUFFER_DESC cameraBufferDesc;
+	cameraBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	cameraBufferDesc.ByteWidth = sizeof(CameraBufferType);
+	cameraBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cameraBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cameraBufferDesc.MiscFlags = 0;
+	cameraBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&cameraBufferDesc, NULL, &camBuffer);
+}
+
+void ManipulationBakedShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture,
+	LightFrameData* lightFrame, bool showNorms, FPCamera* cam)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	MatrixBufferType* dataPtr;
+	deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr->world = XMMatrixIdentity();
+	dataPtr->view = XMMatrixTranspose(viewMatrix);
+	dataPtr->projection = XMMatrixTranspose(projectionMatrix);
+	deviceContext->Unmap(matrixBuffer, 0);
+	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	CameraBufferType* camPtr;
+	deviceContext->Map(camBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	camPtr = (CameraBufferType*)mappedResource.pData;
+	camPtr->camPos = cam->getPosition();
+	camPtr->pad = 0.0f;
+	deviceContext->Unmap(camBuffer, 0);
+	deviceContext->VSSetConstantBuffers(1, 1, &camBuffer);
+
+	// light data is built once a frame, each draw only binds it
+	lightFrame->bind(deviceContext);
+
+	NormalBufferType* normalPtr;
+	deviceContext->Map(normalBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	normalPtr = (NormalBufferType*)mappedResource.pData;
+	normalPtr->showNormals = showNorms;
+	normalPtr->pad = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	deviceContext->Unmap(normalBuffer, 0);
+	deviceContext->PSSetConstantBuffers(2, 1, &normalBuffer);
+
+	// Set shader texture resource in the pixel shader.
+	deviceContext->PSSetShaderResources(0, 1, &texture);
+	deviceContext->PSSetSamplers(0, 1, &sampleState);
+	deviceContext->PSSetSamplers(1, 1, &sampleStateShadow);
+}
@@ -0,0 +1,43 @@
+// Baked manipulation shader
+// Lights the plane baked by ManipulationTessBakeShader with the same pixel shader as ManipulationTessShader
+#pragma once
+
+#include "DXF.h"
+#include "LightFrameData.h"
+
+using namespace std;
+using namespace DirectX;
+
+
+class ManipulationBakedShader : public BaseShader
+{
+
+public:
+	struct NormalBufferType
+	{
+		bool showNormals;
+		XMFLOAT3 pad;
+	};
+
+	struct CameraBufferType {
+		XMFLOAT3 camPos;
+		float pad;
+	};
+
+	ManipulationBakedShader(ID3D11Device* device, HWND hwnd);
+	~ManipulationBakedShader();
+
+	// the baked vertices are already in world space, so there's no world matrix
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture,
+		LightFrameData* lightFrame, bool showNorms, FPCamera* cam);
+
+private:
+	void initShader(const wchar_t* vsFilename, const wchar_t* psFilename);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11SamplerState* sampleState;
+	ID3D11SamplerState* sampleStateShadow;
+	ID3D11Buffer* normalBuffer;
+	ID3D11Buffer* camBuffer;
+};
@@ -6,24 +6,11 @@ ManipulationGeometryShader::ManipulationGeometryShader(ID3D11Device* device, HWN
 {
 	initShader(L"manipulationGeometry_vs.cso", L"manipulationGeometry_hs.cso", L"manipulationGeometry_ds.cso", 
 		L"manipulationGeometry_gs.cso", L"manipulationGeometry_ps.cso");
-
-	// initialise the point light faces
-	dirs[0] = XMFLOAT3(0.0f, -1.0f, 0.0f);
-	dirs[1] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-	dirs[2] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-	dirs[3] = XMFLOAT3(-1.0f, 0.0f, 0.0f);
-	dirs[4] = XMFLOAT3(0.0f, 0.0f, 1.0f);
-	dirs[5] = XMFLOAT3(0.0f, 0.0f, -1.0f);
 }
 
 
 ManipulationGeometryShader::~ManipulationGeometryShader()
 {
-	if (lightBuffer)
-	{
-		lightBuffer->Release();
-		lightBuffer = 0;
-	}
 	if (windBuffer)
 	{
 		windBuffer->Release();
@@ -119,16 +106,6 @@ void ManipulationGeometryShader::initShader(const wchar_t* vsFilename, const wch
 	windBufferDesc.StructureByteStride = 0;
 	renderer->CreateBuffer(&windBufferDesc, NULL, &windBuffer);
 
-	// Setup light buffer
-	D3D11_BUFFER_DESC lightBufferDesc;
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-	renderer->CreateBuffer(&lightBufferDesc, NULL, &lightBuffer);
-
 	D3D11_BUFFER_DESC cameraBufferDesc;
 	cameraBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 	cameraBufferDesc.ByteWidth = sizeof(CameraBufferType);
@@ -152,8 +129,7 @@ void ManipulationGeometryShader::initShader(const wchar_t* vsFilename, const wch
 }
 
 
-void ManipulationGeometryShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* texture2, ShadowMap* depthMap[4][6], float mapBias[4], Light* light[4],
-	float atten[4], int lType[4], float oAngle[4], float iAngle[4], float falloff[4], float time, XMFLOAT3 waveSettings[2], XMFLOAT3 windSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, bool surfaceLight, FPCamera* cam)
+void ManipulationGeometryShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* texture2, LightFrameData* lightFrame, float time, XMFLOAT3 waveSettings[2], XMFLOAT3 windSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, bool surfaceLight, FPCamera* cam)
 {
 	HRESULT result;
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
@@ -173,27 +149,6 @@ void ManipulationGeometryShader::setShaderParameters(ID3D11DeviceContext* device
 	dataPtr->view = tview;
 	dataPtr->projection = tproj;
 
-	// loop through all the lights
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			if (lType[i] == 0) {
-				// if it's a point light, generate a new view matrix
-				light[i]->setDirection(dirs[j].x, dirs[j].y, dirs[j].z);
-				light[i]->generateViewMatrix();
-			}
-			// initialise the view matrices
-			dataPtr->lightView[i][j] = XMMatrixTranspose(light[i]->getViewMatrix());
-		}
-
-		if (lType[i] == 1) {
-			// if it's a directional light, use an ortho matrix
-			dataPtr->lightProjection[i] = XMMatrixTranspose(light[i]->getOrthoMatrix());
-		}
-		else {
-			// else create a projection matrix
-			dataPtr->lightProjection[i] = XMMatrixTranspose(light[i]->getProjectionMatrix());
-		}
-	}
 	// give the matrix buffer to the geometry and domain shader
 	deviceContext->Unmap(matrixBuffer, 0);
 	deviceContext->GSSetConstantBuffers(0, 1, &matrixBuffer);
@@ -230,7 +185,7 @@ void ManipulationGeometryShader::setShaderParameters(ID3D11DeviceContext* device
 	deviceContext->Unmap(camBuffer, 0);
 	// send buffer to geometry and hull shader
 	deviceContext->GSSetConstantBuffers(1, 1, &camBuffer);
-	deviceContext->HSSetConstantBuffers(2, 1, &camBuffer);
+	deviceContext->HSSetConstantBuffers(1, 1, &camBuffer);
 
 	deviceContext->Map(windBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	windPtr = (WindBufferType*)mappedResource.pData;
@@ -248,29 +203,8 @@ void ManipulationGeometryShader::setShaderParameters(ID3D11DeviceContext* device
 	// send buffer to geometry shader
 	deviceContext->GSSetConstantBuffers(2, 1, &windBuffer);
 
-	// Send light data to pixel shader
-	LightBufferType* lightPtr;
-	deviceContext->Map(lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	lightPtr = (LightBufferType*)mappedResource.pData;
-	for (int i = 0; i < 4; i++) {
-		lightPtr->ambient[i] = light[i]->getAmbientColour();
-		lightPtr->diffuse[i] = light[i]->getDiffuseColour();
-		lightPtr->position[i] = XMFLOAT4(light[i]->getPosition().x, light[i]->getPosition().y, light[i]->getPosition().z, 1.0f);
-		lightPtr->direction[i] = XMFLOAT4(light[i]->getDirection().x, light[i]->getDirection().y, light[i]->getDirection().z, 1.0f);
-
-		lightPtr->specularColour[i] = light[i]->getSpecularColour();
-		lightPtr->specularPower[i] = light[i]->getSpecularPower();
-		lightPtr->outerAngle[i] = cos(XMConvertToRadians(oAngle[i]));
-		lightPtr->innerAngle[i] = cos(XMConvertToRadians(iAngle[i]));
-		lightPtr->fall[i] = falloff[i];
-		lightPtr->type[i] = lType[i];
-		lightPtr->attenuation[i] = 0.0f;
-		lightPtr->attenuation[i] = atten[i];
-		lightPtr->bias[i] = mapBias[i];
-	}
-	deviceContext->Unmap(lightBuffer, 0);
-	// send buffer to pixel shader
-	deviceContext->PSSetConstantBuffers(0, 1, &lightBuffer);
+	// light data is built once a frame, each draw only binds it
+	lightFrame->bind(deviceContext);
 
 	// Set shader texture resource in the domain shader.
 	deviceContext->DSSetShaderResources(0, 1, &texture);
@@ -283,17 +217,6 @@ void ManipulationGeometryShader::setShaderParameters(ID3D11DeviceContext* device
 	// Set shader texture resource in the pixel shader.
 	deviceContext->PSSetShaderResources(0, 1, &texture2);
 
-	// set all the depth maps that the pixel shader will use
-	ID3D11ShaderResourceView* map;
-	int reg = 1;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			map = depthMap[i][j]->getDepthMapSRV();
-			deviceContext->PSSetShaderResources(reg, 1, &map);
-			reg++;
-		}
-	}
-
 	deviceContext->PSSetSamplers(0, 1, &sampleState);
 	deviceContext->PSSetSamplers(1, 1, &sampleStateShadow);
 }
@@ -0,0 +1,255 @@
+// Manipulation tessellation bake shader
+#include "ManipulationTessBakeShader.h"
+
+// the hull shader's dynamic tessellation lerps between 10 and 1
+static const int MAX_DYNAMIC_TESSELLATION = 10;
+
+
+ManipulationTessBakeShader::ManipulationTessBakeShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	streamBuffer = 0;
+	positionStreamBuffer = 0;
+	capacity = 0;
+	// nothing is rasterised, so the pixel shader is never loaded
+	pixelShader = 0;
+	initShader(L"manipulationTess_vs.cso", L"manipulationTess_hs.cso", L"manipulationTessBake_ds.cso");
+}
+
+
+ManipulationTessBakeShader::~ManipulationTessBakeShader()
+{
+	if (streamBuffer)
+	{
+		streamBuffer->Release();
+		streamBuffer = 0;
+	}
+	if (positionStreamBuffer)
+	{
+		positionStreamBuffer->Release();
+		positionStreamBuffer = 0;
+	}
+	if (camBuffer)
+	{
+		camBuffer->Release();
+		camBuffer = 0;
+	}
+	if (timeBuffer)
+	{
+		timeBuffer->Release();
+		timeBuffer = 0;
+	}
+	if (sampleState)
+	{
+		sampleState->Release();
+		sampleState = 0;
+	}
+	if (worldBuffer)
+	{
+		worldBuffer->Release();
+		worldBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+void ManipulationTessBakeShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+
+	D3D11_BUFFER_DESC worldBufferDesc;
+	worldBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	worldBufferDesc.ByteWidth = sizeof(WorldBufferType);
+	worldBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	worldBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	worldBufferDesc.MiscFlags = 0;
+	worldBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&worldBufferDesc, NULL, &worldBuffer);
+
+	D3D11_SAMPLER_DESC samplerDesc;
+	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	renderer->CreateSamplerState(&samplerDesc, &sampleState);
+
+	D3D11_BUFFER_DESC timeBufferDesc;
+	timeBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	timeBufferDesc.ByteWidth = sizeof(TimeBufferType);
+	timeBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	timeBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	timeBufferDesc.MiscFlags = 0;
+	timeBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&timeBufferDesc, NULL, &timeBuffer);
+
+	D3D11_BUFFER_DESC cameraBufferDesc;
+	cameraBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	cameraBufferDesc.ByteWidth = sizeof(CameraBufferType);
+	cameraBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cameraBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cameraBufferDesc.MiscFlags = 0;
+	cameraBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&cameraBufferDesc, NULL, &camBuffer);
+}
+
+void ManipulationTessBakeShader::initShader(const wchar_t* vsFilename, const wchar_t* hsFilename, const wchar_t* dsFilename)
+{
+	initShader(vsFilename, NULL);
+
+	// Load other required shaders.
+	loadHullShader(hsFilename);
+	loadDomainShader(dsFilename);
+	createStreamOutput(dsFilename);
+}
+
+void ManipulationTessBakeShader::createStreamOutput(const wchar_t* dsFilename)
+{
+	// stream output doesn't need a real geometry shader, it can be created straight from the domain shader's output signature
+	ID3DBlob* domainShaderBuffer = 0;
+	HRESULT result = D3DReadFileToBlob(dsFilename, &domainShaderBuffer);
+	if (result != S_OK)
+	{
+		MessageBox(NULL, dsFilename, L"File not found", MB_OK);
+		exit(0);
+	}
+
+	// slot 0 is the same order as VertexType, slot 1 is the domain shader's copy of the position for the depth passes
+	D3D11_SO_DECLARATION_ENTRY declaration[] = {
+		{ 0, "POSITION", 0, 0, 3, 0 },
+		{ 0, "TEXCOORD", 0, 0, 2, 0 },
+		{ 0, "NORMAL", 0, 0, 3, 0 },
+		{ 0, "POSITION", 1, 0, 3, 1 }
+	};
+	UINT strides[2] = { sizeof(VertexType), sizeof(XMFLOAT3) };
+
+	renderer->CreateGeometryShaderWithStreamOutput(domainShaderBuffer->GetBufferPointer(), domainShaderBuffer->GetBufferSize(), declaration,
+		sizeof(declaration) / sizeof(declaration[0]), strides, 2, D3D11_SO_NO_RASTERIZED_STREAM, NULL, &geometryShader);
+
+	domainShaderBuffer->Release();
+	domainShaderBuffer = 0;
+}
+
+void ManipulationTessBakeShader::reserve(int vertexCount)
+{
+	if (vertexCount <= capacity)
+		return;
+
+	if (streamBuffer)
+	{
+		streamBuffer->Release();
+		streamBuffer = 0;
+	}
+	if (positionStreamBuffer)
+	{
+		positionStreamBuffer->Release();
+		positionStreamBuffer = 0;
+	}
+
+	D3D11_BUFFER_DESC streamBufferDesc;
+	streamBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	streamBufferDesc.ByteWidth = vertexCount * sizeof(VertexType);
+	streamBufferDesc.BindFlags = D3D11_BIND_STREAM_OUTPUT | D3D11_BIND_VERTEX_BUFFER;
+	streamBufferDesc.CPUAccessFlags = 0;
+	streamBufferDesc.MiscFlags = 0;
+	streamBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&streamBufferDesc, NULL, &streamBuffer);
+	streamBufferDesc.ByteWidth = vertexCount * sizeof(XMFLOAT3);
+	renderer->CreateBuffer(&streamBufferDesc, NULL, &positionStreamBuffer);
+	capacity = vertexCount;
+}
+
+void ManipulationTessBakeShader::bake(ID3D11DeviceContext* deviceContext, BaseMesh* mesh, const XMMATRIX &worldMatrix, ID3D11ShaderResourceView* texture, float time, XMFLOAT3 waveSettings[2],
+	float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, FPCamera* cam)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	// a quad patch with factors up to n never produces more than 2(n + 1)^2 triangles
+	int factor = dynamicTessellation ? MAX_DYNAMIC_TESSELLATION : max(tessFactor, edgeTess);
+	int patches = mesh->getIndexCount() / 4;
+	reserve(patches * 2 * (factor + 1) * (factor + 1) * 3);
+
+	WorldBufferType* worldPtr;
+	deviceContext->Map(worldBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	worldPtr = (WorldBufferType*)mappedResource.pData;
+	worldPtr->world = XMMatrixTranspose(worldMatrix);
+	deviceContext->Unmap(worldBuffer, 0);
+	deviceContext->DSSetConstantBuffers(0, 1, &worldBuffer);
+
+	TimeBufferType* timePtr;
+	deviceContext->Map(timeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	timePtr = (TimeBufferType*)mappedResource.pData;
+	timePtr->time = time;
+	timePtr->planeSphere = planeToSphere;
+	timePtr->height = mapHeight;
+	timePtr->tessellationFactor = tessFactor;
+	timePtr->dynamicTess = dynamicTessellation;
+	timePtr->amplitude.x = waveSettings[0].x;
+	timePtr->amplitude.y = waveSettings[1].x;
+	timePtr->frequency.x = waveSettings[0].y;
+	timePtr->frequency.y = waveSettings[1].y;
+	timePtr->speed.x = waveSettings[0].z;
+	timePtr->speed.y = waveSettings[1].z;
+	timePtr->pad = XMFLOAT2(1.0f, 1.0f);
+	timePtr->spherePosition = spherePos;
+	timePtr->nearBound = tessNear;
+	timePtr->farBound = tessFar;
+	timePtr->edgeTessellationFactor = edgeTess;
+	deviceContext->Unmap(timeBuffer, 0);
+	// send buffer to domain and hull shader
+	deviceContext->DSSetConstantBuffers(1, 1, &timeBuffer);
+	deviceContext->HSSetConstantBuffers(0, 1, &timeBuffer);
+
+	// dynamic tessellation is always based on the camera, so the bake matches what the camera pass used to tessellate
+	CameraBufferType* camPtr;
+	deviceContext->Map(camBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	camPtr = (CameraBufferType*)mappedResource.pData;
+	camPtr->camPos = cam->getPosition();
+	camPtr->pad = 0.0f;
+	deviceContext->Unmap(camBuffer, 0);
+	deviceContext->HSSetConstantBuffers(1, 1, &camBuffer);
+
+	// Set shader texture resource in the domain and hull shader.
+	deviceContext->DSSetShaderResources(0, 1, &texture);
+	deviceContext->DSSetSamplers(0, 1, &sampleState);
+	deviceContext->HSSetShaderResources(0, 1, &texture);
+	deviceContext->HSSetSamplers(0, 1, &sampleState);
+
+	// send the control points before binding the stream target, last frame's bake may still be bound as the vertex buffer
+	mesh->sendData(deviceContext, D3D11_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+
+	ID3D11Buffer* targets[2] = { streamBuffer, positionStreamBuffer };
+	UINT offsets[2] = { 0, 0 };
+	deviceContext->SOSetTargets(2, targets, offsets);
+	render(deviceContext, mesh->getIndexCount());
+
+	// unbind the stream targets so the baked buffers can be read as vertex buffers
+	ID3D11Buffer* nullBuffers[2] = { 0, 0 };
+	deviceContext->SOSetTargets(2, nullBuffers, offsets);
+}
+
+void ManipulationTessBakeShader::sendData(ID3D11DeviceContext* deviceContext)
+{
+	UINT stride = sizeof(VertexType);
+	UINT offset = 0;
+	deviceContext->IASetVertexBuffers(0, 1, &streamBuffer, &stride, &offset);
+	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void ManipulationTessBakeShader::sendDepthData(ID3D11DeviceContext* deviceContext)
+{
+	UINT stride = sizeof(XMFLOAT3);
+	UINT offset = 0;
+	deviceContext->IASetVertexBuffers(0, 1, &positionStreamBuffer, &stride, &offset);
+	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
@@ -0,0 +1,81 @@
+// Manipulation tessellation bake shader
+// Tessellates and displaces the manipulation plane once a frame and streams the world space triangles into a vertex buffer.
+// Every depth view and the camera pass then draw the baked buffer, so the displacement cost doesn't grow with the number of shadow views
+#pragma once
+
+#include "DXF.h"
+
+using namespace std;
+using namespace DirectX;
+
+
+class ManipulationTessBakeShader : public BaseShader
+{
+
+public:
+	// matches the default input layout, so any standard vertex shader can draw the baked plane
+	struct VertexType
+	{
+		XMFLOAT3 position;
+		XMFLOAT2 texture;
+		XMFLOAT3 normal;
+	};
+
+	struct WorldBufferType
+	{
+		XMMATRIX world;
+	};
+
+	struct TimeBufferType
+	{
+		float time;
+		float planeSphere;
+		float height;
+		int tessellationFactor;
+
+		XMFLOAT2 amplitude;
+		XMFLOAT2 frequency;
+		XMFLOAT2 speed;
+		XMFLOAT2 pad;
+		XMFLOAT4 spherePosition;
+
+		bool dynamicTess;
+		int edgeTessellationFactor;
+		float nearBound;
+		float farBound;
+	};
+
+	struct CameraBufferType {
+		XMFLOAT3 camPos;
+		float pad;
+	};
+
+	ManipulationTessBakeShader(ID3D11Device* device, HWND hwnd);
+	~ManipulationTessBakeShader();
+
+	// tessellates the plane into the baked vertex buffer, growing the buffer first if the tessellation factors need more room
+	void bake(ID3D11DeviceContext* deviceContext, BaseMesh* mesh, const XMMATRIX &world, ID3D11ShaderResourceView* texture, float time, XMFLOAT3 waveSettings[2],
+		float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, FPCamera* cam);
+
+	// binds the baked triangles as a triangle list, draw them with renderAuto
+	void sendData(ID3D11DeviceContext* deviceContext);
+	// same triangles with positions only, for depth shaders using a position only layout
+	void sendDepthData(ID3D11DeviceContext* deviceContext);
+
+	size_t getMemorySize() { return (size_t)capacity * (sizeof(VertexType) + sizeof(XMFLOAT3)); };
+
+private:
+	void initShader(const wchar_t* vsFilename, const wchar_t* psFilename); // there's no pixel stage, psFilename is ignored
+	void initShader(const wchar_t* vsFilename, const wchar_t* hsFilename, const wchar_t* dsFilename);
+	void createStreamOutput(const wchar_t* dsFilename);
+	void reserve(int vertexCount);
+
+private:
+	ID3D11Buffer* worldBuffer;
+	ID3D11SamplerState* sampleState;
+	ID3D11Buffer* timeBuffer;
+	ID3D11Buffer* camBuffer;
+	ID3D11Buffer* streamBuffer; // written by stream output, read as a vertex buffer
+	ID3D11Buffer* positionStreamBuffer; // the same vertices' positions, written alongside streamBuffer
+	int capacity; // vertices each stream buffer can hold
+};
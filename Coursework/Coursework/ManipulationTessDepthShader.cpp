@@ -11,6 +11,11 @@ ManipulationTessDepthShader::ManipulationTessDepthShader(ID3D11Device* device, H
 
 ManipulationTessDepthShader::~ManipulationTessDepthShader()
 {
+	if (paraboloidBuffer)
+	{
+		paraboloidBuffer->Release();
+		paraboloidBuffer = 0;
+	}
 	if (camBuffer)
 	{
 		camBuffer->Release();
@@ -43,8 +48,8 @@ ManipulationTessDepthShader::~ManipulationTessDepthShader()
 
 void ManipulationTessDepthShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
 {
-	// Load (+ compile) shader files
-	loadVertexShader(vsFilename);
+	// Load (+ compile) shader files, the displacement needs texture coordinates as well as the position
+	loadTextureVertexShader(vsFilename);
 	loadPixelShader(psFilename);
 
 	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
@@ -89,6 +94,15 @@ void ManipulationTessDepthShader::initShader(const wchar_t* vsFilename, const wc
 	cameraBufferDesc.StructureByteStride = 0;
 
 	renderer->CreateBuffer(&cameraBufferDesc, NULL, &camBuffer);
+
+	D3D11_BUFFER_DESC paraboloidBufferDesc;
+	paraboloidBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	paraboloidBufferDesc.ByteWidth = sizeof(ParaboloidBufferType);
+	paraboloidBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	paraboloidBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	paraboloidBufferDesc.MiscFlags = 0;
+	paraboloidBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&paraboloidBufferDesc, NULL, &paraboloidBuffer);
 }
 
 void ManipulationTessDepthShader::initShader(const wchar_t* vsFilename, const wchar_t* hsFilename, const wchar_t* dsFilename, const wchar_t* psFilename)
@@ -102,7 +116,8 @@ void ManipulationTessDepthShader::initShader(const wchar_t* vsFilename, const wc
 }
 
 
-void ManipulationTessDepthShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, float time, XMFLOAT3 waveSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, FPCamera* cam)
+void ManipulationTessDepthShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, float time, XMFLOAT3 waveSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, FPCamera* cam,
+	bool paraboloid, float nearPlane, float farPlane)
 {
 	HRESULT result;
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
@@ -155,6 +170,17 @@ void ManipulationTessDepthShader::setShaderParameters(ID3D11DeviceContext* devic
 	deviceContext->DSSetConstantBuffers(1, 1, &timeBuffer);
 	deviceContext->HSSetConstantBuffers(0, 1, &timeBuffer);
 
+	// dual paraboloid point lights skip the projection matrix
+	ParaboloidBufferType* paraboloidPtr;
+	deviceContext->Map(paraboloidBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	paraboloidPtr = (ParaboloidBufferType*)mappedResource.pData;
+	paraboloidPtr->paraboloid = paraboloid;
+	paraboloidPtr->nearPlane = nearPlane;
+	paraboloidPtr->farPlane = farPlane;
+	paraboloidPtr->padding = 0.0f;
+	deviceContext->Unmap(paraboloidBuffer, 0);
+	deviceContext->DSSetConstantBuffers(3, 1, &paraboloidBuffer);
+
 	// Set shader texture resource in the domain shader.
 	deviceContext->DSSetShaderResources(0, 1, &texture);
 	deviceContext->DSSetSamplers(0, 1, &sampleState);
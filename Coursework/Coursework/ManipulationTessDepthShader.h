@@ -36,12 +36,21 @@ public:
 		float pad;
 	};
 
+	struct ParaboloidBufferType
+	{
+		int paraboloid; // 1 warps the view space position onto a paraboloid instead of using the projection matrix
+		float nearPlane;
+		float farPlane;
+		float padding;
+	};
+
 	ManipulationTessDepthShader(ID3D11Device* device, HWND hwnd);
 	~ManipulationTessDepthShader();
 
 	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, 
 		ID3D11ShaderResourceView* texture, float time, XMFLOAT3 waveSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, 
-		int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, FPCamera* cam);
+		int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, FPCamera* cam,
+		bool paraboloid = false, float nearPlane = 0.0f, float farPlane = 1.0f);
 
 private:
 	void initShader(const wchar_t* vsFilename, const wchar_t* psFilename);
@@ -52,4 +61,5 @@ private:
 	ID3D11SamplerState* sampleState;
 	ID3D11Buffer* timeBuffer;
 	ID3D11Buffer* camBuffer;
+	ID3D11Buffer* paraboloidBuffer;
 };
@@ -5,22 +5,15 @@
 ManipulationTessShader::ManipulationTessShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
 {
 	initShader(L"manipulationTess_vs.cso", L"manipulationTess_hs.cso", L"manipulationTess_ds.cso", L"manipulationTess_ps.cso");
-
-	dirs[0] = XMFLOAT3(0.0f, -1.0f, 0.0f);
-	dirs[1] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-	dirs[2] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-	dirs[3] = XMFLOAT3(-1.0f, 0.0f, 0.0f);
-	dirs[4] = XMFLOAT3(0.0f, 0.0f, 1.0f);
-	dirs[5] = XMFLOAT3(0.0f, 0.0f, -1.0f);
 }
 
 
 ManipulationTessShader::~ManipulationTessShader()
 {
-	if (lightBuffer)
+	if (normalBuffer)
 	{
-		lightBuffer->Release();
-		lightBuffer = 0;
+		normalBuffer->Release();
+		normalBuffer = 0;
 	}
 	if (timeBuffer)
 	{
@@ -98,15 +91,15 @@ void ManipulationTessShader::initShader(const wchar_t* vsFilename, const wchar_t
 	timeBufferDesc.StructureByteStride = 0;
 	renderer->CreateBuffer(&timeBufferDesc, NULL, &timeBuffer);
 
-	// Setup light buffer
-	D3D11_BUFFER_DESC lightBufferDesc;
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-	renderer->CreateBuffer(&lightBufferDesc, NULL, &lightBuffer);
+	// Setup normal buffer
+	D3D11_BUFFER_DESC normalBufferDesc;
+	normalBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	normalBufferDesc.ByteWidth = sizeof(NormalBufferType);
+	normalBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	normalBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	normalBufferDesc.MiscFlags = 0;
+	normalBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&normalBufferDesc, NULL, &normalBuffer);
 
 	D3D11_BUFFER_DESC cameraBufferDesc;
 	cameraBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
@@ -130,8 +123,7 @@ void ManipulationTessShader::initShader(const wchar_t* vsFilename, const wchar_t
 }
 
 
-void ManipulationTessShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* texture2, ShadowMap* depthMap[4][6], float mapBias[4], Light* light[4],
-	float atten[4], int lType[4], float oAngle[4], float iAngle[4], float falloff[4], float time, XMFLOAT3 waveSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, bool showNorms, FPCamera* cam)
+void ManipulationTessShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* texture2, LightFrameData* lightFrame, float time, XMFLOAT3 waveSettings[2], float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, bool dynamicTessellation, bool showNorms, FPCamera* cam)
 {
 	HRESULT result;
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
@@ -150,32 +142,10 @@ void ManipulationTessShader::setShaderParameters(ID3D11DeviceContext* deviceCont
 	dataPtr->view = tview;
 	dataPtr->projection = tproj;
 
-	// loop through all the lights
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			if (lType[i] == 0) {
-				// if it's a point light, generate a new view matrix
-				light[i]->setDirection(dirs[j].x, dirs[j].y, dirs[j].z);
-				light[i]->generateViewMatrix();
-			}
-
-			dataPtr->lightView[i][j] = XMMatrixTranspose(light[i]->getViewMatrix());
-		}
-
-		if (lType[i] == 1) {
-			// if it's a directional light, use an ortho matrix
-			dataPtr->lightProjection[i] = XMMatrixTranspose(light[i]->getOrthoMatrix());
-		}
-		else {
-			// else set it to a projection matrix
-			dataPtr->lightProjection[i] = XMMatrixTranspose(light[i]->getProjectionMatrix());
-		}
-	}
 	// send the matrix buffer to the domain shader
 	deviceContext->Unmap(matrixBuffer, 0);
 	deviceContext->DSSetConstantBuffers(0, 1, &matrixBuffer);
 
-
 	TimeBufferType* timePtr;
 	deviceContext->Map(timeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	timePtr = (TimeBufferType*)mappedResource.pData;
@@ -209,31 +179,17 @@ void ManipulationTessShader::setShaderParameters(ID3D11DeviceContext* deviceCont
 	deviceContext->DSSetConstantBuffers(2, 1, &camBuffer);
 	deviceContext->HSSetConstantBuffers(1, 1, &camBuffer);
 
-	// Send light data to pixel shader
-	LightBufferType* lightPtr;
-	deviceContext->Map(lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	lightPtr = (LightBufferType*)mappedResource.pData;
+	// light data is built once a frame, each draw only binds it
+	lightFrame->bind(deviceContext);
 
-	for (int i = 0; i < 4; i++) {
-		lightPtr->ambient[i] = light[i]->getAmbientColour();
-		lightPtr->diffuse[i] = light[i]->getDiffuseColour();
-		lightPtr->position[i] = XMFLOAT4(light[i]->getPosition().x, light[i]->getPosition().y, light[i]->getPosition().z, 1.0f);
-		lightPtr->direction[i] = XMFLOAT4(light[i]->getDirection().x, light[i]->getDirection().y, light[i]->getDirection().z, 1.0f);
-
-		lightPtr->specularColour[i] = light[i]->getSpecularColour();
-		lightPtr->specularPower[i] = light[i]->getSpecularPower();
-		lightPtr->outerAngle[i] = cos(XMConvertToRadians(oAngle[i]));
-		lightPtr->innerAngle[i] = cos(XMConvertToRadians(iAngle[i]));
-		lightPtr->fall[i] = falloff[i];
-		lightPtr->type[i] = lType[i];
-		lightPtr->attenuation[i] = atten[i];
-		lightPtr->bias[i] = mapBias[i];
-	}
-	lightPtr->showNormals = showNorms;
-	lightPtr->pad = XMFLOAT3(1.0f, 1.0f, 1.0f);
-	deviceContext->Unmap(lightBuffer, 0);
+	NormalBufferType* normalPtr;
+	deviceContext->Map(normalBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	normalPtr = (NormalBufferType*)mappedResource.pData;
+	normalPtr->showNormals = showNorms;
+	normalPtr->pad = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	deviceContext->Unmap(normalBuffer, 0);
 	// send buffer to pixel shader
-	deviceContext->PSSetConstantBuffers(0, 1, &lightBuffer);
+	deviceContext->PSSetConstantBuffers(2, 1, &normalBuffer);
 
 	// Set shader texture resource in the domain shader.
 	deviceContext->DSSetShaderResources(0, 1, &texture);
@@ -245,17 +201,6 @@ void ManipulationTessShader::setShaderParameters(ID3D11DeviceContext* deviceCont
 	// Set shader texture resource in the pixel shader.
 	deviceContext->PSSetShaderResources(0, 1, &texture2);
 
-	// set the depth maps
-	ID3D11ShaderResourceView* map;
-	int reg = 1;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			map = depthMap[i][j]->getDepthMapSRV();
-			deviceContext->PSSetShaderResources(reg, 1, &map);
-			reg++;
-		}
-	}
-
 	deviceContext->PSSetSamplers(0, 1, &sampleState);
 	deviceContext->PSSetSamplers(1, 1, &sampleStateShadow);
 }
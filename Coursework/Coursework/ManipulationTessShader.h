@@ -3,6 +3,7 @@
 #pragma once
 
 #include "DXF.h"
+#include "LightFrameData.h"
 
 using namespace std;
 using namespace DirectX;
@@ -17,26 +18,10 @@ public:
 		XMMATRIX world;
 		XMMATRIX view;
 		XMMATRIX projection;
-		XMMATRIX lightView[4][6];
-		XMMATRIX lightProjection[4];
 	};
 
-	struct LightBufferType
+	struct NormalBufferType
 	{
-		XMFLOAT4 ambient[4];
-		XMFLOAT4 diffuse[4];
-		XMFLOAT4 position[4];
-		XMFLOAT4 direction[4];
-		XMFLOAT4 specularColour[4];
-		float specularPower[4];
-
-		int type[4];
-		float outerAngle[4];
-		float innerAngle[4];
-		float fall[4];
-		float attenuation[4];
-		float bias[4];
-
 		bool showNormals;
 		XMFLOAT3 pad;
 	};
@@ -69,8 +54,7 @@ public:
 	~ManipulationTessShader();
 
 	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, 
-		ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* texture2, ShadowMap* depthMap[4][6], float mapBias[4], Light* light[4],
-		float atten[4], int lType[4], float oAngle[4], float iAngle[4], float falloff[4], float time, XMFLOAT3 waveSettings[2], 
+		ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* texture2, LightFrameData* lightFrame, float time, XMFLOAT3 waveSettings[2], 
 		float planeToSphere, float mapHeight, XMFLOAT4 spherePos, int tessFactor, int edgeTess, float tessNear, float tessFar, 
 		bool dynamicTessellation, bool showNorms, FPCamera* cam);
 
@@ -82,9 +66,7 @@ private:
 	ID3D11Buffer* matrixBuffer;
 	ID3D11SamplerState* sampleState;
 	ID3D11SamplerState* sampleStateShadow;
-	ID3D11Buffer* lightBuffer;
+	ID3D11Buffer* normalBuffer;
 	ID3D11Buffer* camBuffer;
 	ID3D11Buffer* timeBuffer;
-	// point light depth cube face normals
-	XMFLOAT3 dirs[6];
 };
@@ -0,0 +1,81 @@
+// Patch cull data
+#include "PatchCullData.h"
+
+PatchCullData::PatchCullData(ID3D11Device* device)
+{
+	cullBuffer = 0;
+	margin = 0.0f;
+	occluder = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	D3D11_BUFFER_DESC cullBufferDesc;
+	cullBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	cullBufferDesc.ByteWidth = sizeof(CullBufferType);
+	cullBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cullBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cullBufferDesc.MiscFlags = 0;
+	cullBufferDesc.StructureByteStride = 0;
+	device->CreateBuffer(&cullBufferDesc, NULL, &cullBuffer);
+}
+
+PatchCullData::~PatchCullData()
+{
+	if (cullBuffer)
+	{
+		cullBuffer->Release();
+		cullBuffer = 0;
+	}
+}
+
+void PatchCullData::setSurface(float heightMin, float heightMax, float heightAmplitude, XMFLOAT3 waveSettings[2], float planeToSphere, XMFLOAT4 spherePos,
+	float planeResolution)
+{
+	float2 waveAmplitude(waveSettings[0].x, waveSettings[1].x);
+	margin = getPatchMargin(heightMin, heightMax, heightAmplitude, waveAmplitude, spherePos.w, planeResolution);
+
+	// the lowest the wrapped surface gets, everything inside it is solid from the outside
+	float wave = (fabsf(waveAmplitude.x) + fabsf(waveAmplitude.y)) / 2.0f;
+	float lowest = (heightAmplitude < 0.0f ? heightMax : heightMin) * heightAmplitude - wave;
+	float radius = spherePos.w + lowest;
+	if (planeToSphere >= 1.0f && radius > 0.0f)
+		occluder = XMFLOAT4(spherePos.x, spherePos.y, spherePos.z, radius);
+	else
+		occluder = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+void PatchCullData::setView(ID3D11DeviceContext* deviceContext, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection, XMFLOAT3 viewer,
+	bool horizon, float reach)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	// the hull shaders work before the world matrix, so cull in object space
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, world * view * projection);
+	float4 planes[6];
+	getFrustumPlanes(viewProjection.m, planes);
+
+	XMFLOAT3 objectViewer;
+	XMStoreFloat3(&objectViewer, XMVector3TransformCoord(XMLoadFloat3(&viewer), XMMatrixInverse(NULL, world)));
+
+	deviceContext->Map(cullBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	CullBufferType* cullPtr = (CullBufferType*)mappedResource.pData;
+	for (int i = 0; i < 6; i++)
+		cullPtr->frustumPlanes[i] = XMFLOAT4(planes[i].x, planes[i].y, planes[i].z, planes[i].w);
+	cullPtr->occluder = horizon ? occluder : XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	cullPtr->viewer = objectViewer;
+	cullPtr->margin = margin + reach;
+	cullPtr->frustumCull = 1;
+	cullPtr->pad = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	deviceContext->Unmap(cullBuffer, 0);
+	deviceContext->HSSetConstantBuffers(2, 1, &cullBuffer);
+}
+
+void PatchCullData::disable(ID3D11DeviceContext* deviceContext)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	deviceContext->Map(cullBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	CullBufferType* cullPtr = (CullBufferType*)mappedResource.pData;
+	ZeroMemory(cullPtr, sizeof(CullBufferType));
+	deviceContext->Unmap(cullBuffer, 0);
+	deviceContext->HSSetConstantBuffers(2, 1, &cullBuffer);
+}
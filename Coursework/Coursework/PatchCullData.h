@@ -0,0 +1,46 @@
+// Patch cull data
+// Per view culling constants for the manipulation hull shaders, see PatchCulling.h.
+// The surface's margin and occluder are set once a frame, then each view uploads its planes and binds them.
+#pragma once
+
+#include "DXF.h"
+#include "PatchCulling.h"
+
+using namespace DirectX;
+
+class PatchCullData
+{
+public:
+	// hull shader b2, must match CullBuffer in the manipulation hull shaders
+	struct CullBufferType
+	{
+		XMFLOAT4 frustumPlanes[6];
+		XMFLOAT4 occluder; // xyz = centre, w = radius, 0 turns horizon culling off
+		XMFLOAT3 viewer;
+		float margin;
+		int frustumCull;
+		XMFLOAT3 pad;
+	};
+
+	PatchCullData(ID3D11Device* device);
+	~PatchCullData();
+
+	// call once a frame with the same ranges as SurfaceBounds. the horizon is only used once the plane is fully wrapped
+	// around the sphere, anything less leaves holes to see through
+	void setSurface(float heightMin, float heightMax, float heightAmplitude, XMFLOAT3 waveSettings[2], float planeToSphere, XMFLOAT4 spherePos,
+		float planeResolution);
+
+	// uploads one view's planes and binds them. world is the plane's world matrix, viewer is in world space.
+	// horizon is false for views without a single viewpoint, like ortho light views.
+	// reach is how far above the surface the drawn geometry goes, like grass blades
+	void setView(ID3D11DeviceContext* deviceContext, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection, XMFLOAT3 viewer,
+		bool horizon, float reach = 0.0f);
+
+	// binds constants that never cull, for draws every view reuses like the tessellation bake
+	void disable(ID3D11DeviceContext* deviceContext);
+
+private:
+	ID3D11Buffer* cullBuffer;
+	float margin;
+	XMFLOAT4 occluder;
+};
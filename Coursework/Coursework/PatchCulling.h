@@ -0,0 +1,115 @@
+// Patch culling
+// Shared by the C++ code and the manipulation hull shaders, decides which tessellation patches can't be seen.
+// A patch is bounded by a sphere around its displaced corners, grown by a margin for anything the tessellated
+// vertices can do between the corners. It's culled if that sphere is outside the frustum, or hidden behind the
+// horizon of the sphere the plane is wrapped around.
+// Only use the small part of HLSL that HlslShim.h provides.
+#ifndef _PATCHCULLING_H
+#define _PATCHCULLING_H
+
+#ifdef __cplusplus
+#include "HlslShim.h"
+#endif
+
+// PATCH BOUNDS
+// how far a tessellated vertex can be from the patch its corners span. between the corners the height can take
+// any value the heightmap and waves allow, and on the sphere the patch bulges out from its corners.
+// heightMin and heightMax are the heightmap's range in [0, 1], the same inputs as SurfaceBounds
+inline float getPatchMargin(float heightMin, float heightMax, float heightAmplitude, float2 waveAmplitude, float sphereRadius, float planeResolution)
+{
+	float pi = 3.14159265359f;
+	float waveRange = abs(waveAmplitude.x) + abs(waveAmplitude.y);
+	float heightRange = (heightMax - heightMin) * abs(heightAmplitude);
+
+	// a patch covers one step of longitude and one of latitude, their sum is more than any angle across it
+	float span = pi * 3.0f / (planeResolution - 1.0f);
+	float reach = abs(sphereRadius) + abs(heightAmplitude) + waveRange / 2.0f;
+	float bulge = reach * (1.0f - cos(span));
+
+	return heightRange + waveRange + bulge;
+}
+
+// sphere around a patch's four displaced corners, xyz = centre, w = radius
+inline float4 getPatchSphere(float3 a, float3 b, float3 c, float3 d, float margin)
+{
+	float3 centre = (a + b + c + d) / 4.0f;
+	float radius = length(a - centre);
+	float cornerDistance = length(b - centre);
+	radius = cornerDistance > radius ? cornerDistance : radius;
+	cornerDistance = length(c - centre);
+	radius = cornerDistance > radius ? cornerDistance : radius;
+	cornerDistance = length(d - centre);
+	radius = cornerDistance > radius ? cornerDistance : radius;
+	return float4(centre.x, centre.y, centre.z, radius + margin);
+}
+
+// FRUSTUM
+// planes are xyz = normal pointing into the frustum, w = distance, normalised
+inline bool sphereOutsideFrustum(float4 bounds, float4 planes[6])
+{
+	float3 centre = float3(bounds.x, bounds.y, bounds.z);
+	for (int i = 0; i < 6; i++) {
+		if (dot(float3(planes[i].x, planes[i].y, planes[i].z), centre) + planes[i].w < -bounds.w)
+			return true;
+	}
+	return false;
+}
+
+// HORIZON
+// true if every point in bounds is hidden from the viewer behind the occluder sphere (xyz = centre, w = radius).
+// hidden points are past the plane through the occluder's horizon circle and inside the cone from the viewer that
+// touches that circle. only valid while the surface fully wraps the occluder, and never culls if the viewer is inside it
+inline bool sphereBehindHorizon(float4 bounds, float3 viewer, float4 occluder)
+{
+	float3 centre = float3(bounds.x, bounds.y, bounds.z);
+	float3 occluderCentre = float3(occluder.x, occluder.y, occluder.z);
+	float r = occluder.w;
+	float3 toViewer = viewer - occluderCentre;
+	float d = length(toViewer);
+	if (r <= 0.0f || d <= r)
+		return false;
+
+	float3 axis = toViewer / d;
+	if (dot(centre - occluderCentre, axis) > r * r / d - bounds.w)
+		return false;
+
+	// distance from the bounds' centre to the side of the cone, in the plane through the cone's axis
+	float3 fromViewer = centre - viewer;
+	float along = -dot(fromViewer, axis);
+	float across = sqrt(abs(dot(fromViewer, fromViewer) - along * along));
+	float sinAngle = r / d;
+	float cosAngle = sqrt(d * d - r * r) / d;
+	return along * sinAngle - across * cosAngle >= bounds.w;
+}
+
+// PATCH
+// frustum culling is skipped if frustumCull is false, horizon culling if occluder.w is 0
+inline bool cullPatch(float3 a, float3 b, float3 c, float3 d, float margin, float4 planes[6], bool frustumCull, float3 viewer, float4 occluder)
+{
+	float4 bounds = getPatchSphere(a, b, c, d, margin);
+	if (frustumCull && sphereOutsideFrustum(bounds, planes))
+		return true;
+	return sphereBehindHorizon(bounds, viewer, occluder);
+}
+
+#ifdef __cplusplus
+// the six planes of a view projection, row major for row vectors like DirectXMath's XMFLOAT4X4.
+// works for perspective and ortho projections with 0 < z < w
+inline void getFrustumPlanes(const float viewProjection[4][4], float4 planes[6])
+{
+	const float (*m)[4] = viewProjection;
+	planes[0] = float4(m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0]); // left
+	planes[1] = float4(m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0]); // right
+	planes[2] = float4(m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1]); // bottom
+	planes[3] = float4(m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1]); // top
+	planes[4] = float4(m[0][2], m[1][2], m[2][2], m[3][2]); // near
+	planes[5] = float4(m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2]); // far
+
+	for (int i = 0; i < 6; i++) {
+		float scale = 1.0f / length(float3(planes[i].x, planes[i].y, planes[i].z));
+		planes[i] = float4(planes[i].x * scale, planes[i].y * scale, planes[i].z * scale, planes[i].w * scale);
+	}
+}
+#endif
+
+#endif
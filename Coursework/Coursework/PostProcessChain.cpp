@@ -0,0 +1,736 @@
+// Post process chain
+#include "PostProcessChain.h"
+#include "GaussianKernel.h"
+#include <math.h>
+#include <thread>
+#include <emmintrin.h>
+
+// the two texels a texture coordinate falls between and how far it is towards the second, clamped like the samplers
+struct Texel
+{
+	int first;
+	int second;
+	float weight;
+};
+
+static Texel texelAt(float uv, int size)
+{
+	float x = uv * size - 0.5f;
+	x = x < 0.0f ? 0.0f : (x > size - 1 ? (float)(size - 1) : x);
+
+	Texel texel;
+	texel.first = (int)x;
+	texel.second = texel.first + 1 < size ? texel.first + 1 : texel.first;
+	texel.weight = x - texel.first;
+	return texel;
+}
+
+static inline __m128 lerp(__m128 a, __m128 b, float t)
+{
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+}
+
+static inline __m128 sample(const float* firstRow, const float* secondRow, const Texel& column, float rowWeight)
+{
+	__m128 top = lerp(_mm_loadu_ps(firstRow + column.first * 4), _mm_loadu_ps(firstRow + column.second * 4), column.weight);
+	__m128 bottom = lerp(_mm_loadu_ps(secondRow + column.first * 4), _mm_loadu_ps(secondRow + column.second * 4), column.weight);
+	return lerp(top, bottom, rowWeight);
+}
+
+// the shaders set alpha to one after blurring and blending
+static inline __m128 opaque(__m128 colour)
+{
+	const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	return _mm_or_ps(_mm_and_ps(colour, rgbMask), _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+}
+
+// the colour if r + g + b is over the threshold, otherwise opaque black like horizontalBlur_ps
+static inline __m128 applyThreshold(__m128 colour, __m128 limit)
+{
+	const __m128 black = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	__m128 level = _mm_add_ps(_mm_add_ps(_mm_shuffle_ps(colour, colour, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(colour, colour, _MM_SHUFFLE(1, 1, 1, 1))),
+		_mm_shuffle_ps(colour, colour, _MM_SHUFFLE(2, 2, 2, 2)));
+	__m128 bright = _mm_cmpgt_ps(level, limit);
+	return _mm_or_ps(_mm_and_ps(bright, colour), _mm_andnot_ps(bright, black));
+}
+
+// bilinear sample of the thresholded texels, the same as sampling a thresholded copy of the image
+static inline __m128 sampleThresholded(const float* firstRow, const float* secondRow, const Texel& column, float rowWeight, __m128 limit)
+{
+	__m128 top = lerp(applyThreshold(_mm_loadu_ps(firstRow + column.first * 4), limit), applyThreshold(_mm_loadu_ps(firstRow + column.second * 4), limit), column.weight);
+	__m128 bottom = lerp(applyThreshold(_mm_loadu_ps(secondRow + column.first * 4), limit), applyThreshold(_mm_loadu_ps(secondRow + column.second * 4), limit), column.weight);
+	return lerp(top, bottom, rowWeight);
+}
+
+// horizontalBlur_ps and verticalBlur_ps's samples as offsets and weights from the centre, both sides of each pair
+static void kernelSamples(int radius, std::vector<float>& offsets, std::vector<float>& weights)
+{
+	GaussianKernel kernel = makeGaussianKernel(radius);
+	offsets.assign(1, 0.0f);
+	weights.assign(1, kernel.sampleWeights[0]);
+	for (int i = 1; i < kernel.samples; i++) {
+		offsets.push_back(-kernel.offsets[i]);
+		weights.push_back(kernel.sampleWeights[i]);
+		offsets.push_back(kernel.offsets[i]);
+		weights.push_back(kernel.sampleWeights[i]);
+	}
+}
+
+// texels under each target column's centre, the same for every row
+static std::vector<Texel> columnTexels(int sourceWidth, int targetWidth)
+{
+	std::vector<Texel> columns(targetWidth);
+	for (int x = 0; x < targetWidth; x++)
+		columns[x] = texelAt((x + 0.5f) / targetWidth, sourceWidth);
+	return columns;
+}
+
+PostProcessChain::Settings::Settings()
+{
+	enableBloom = false;
+	bloomThreshold = 1.4f;
+	bloomIntensity = 1.0f;
+	blurPasses = 9;
+	blurRadius = 5;
+	blurMethod = GAUSSIAN_BLUR;
+	kawasePasses = 5;
+	kawaseOffset = 1.0f;
+	summedAreaRadius = 200.0f;
+	enableHDR = false;
+	exposure = 1.0f;
+	gammaCorrection = false;
+	resolutionScale = 1;
+	upsampleDepthSigma = 0.1f;
+	upsampleLuminanceSigma = 2.0f;
+	toneCurve = ColourGrade::REINHARD;
+	colourBalance[0] = 1.0f;
+	colourBalance[1] = 1.0f;
+	colourBalance[2] = 1.0f;
+	saturation = 1.0f;
+
+	// App1's aspectRatios
+	const int widths[MAX_LEVELS] = { 1200 - 16, 1024, 896, 512, 256, 128, 64, 32, 16 };
+	const int heights[MAX_LEVELS] = { 675 - 9, 576, 504, 288, 144, 72, 36, 18, 9 };
+	for (int i = 0; i < MAX_LEVELS; i++) {
+		levelWidth[i] = widths[i];
+		levelHeight[i] = heights[i];
+	}
+}
+
+PostProcessChain::PostProcessChain(int lthreadCount) : grade(lthreadCount)
+{
+	threadCount = lthreadCount;
+}
+
+template <typename F>
+void PostProcessChain::parallelRows(int rows, F rowFunction) const
+{
+	int threads = threadCount;
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads > rows)
+		threads = rows;
+	if (threads < 1)
+		threads = 1;
+
+	// contiguous bands of rows, the calling thread takes the last band
+	std::vector<std::thread> workers;
+	int rowsPerThread = (rows + threads - 1) / threads;
+	for (int t = 0; t < threads; t++) {
+		int first = t * rowsPerThread;
+		int last = first + rowsPerThread < rows ? first + rowsPerThread : rows;
+		if (first >= last)
+			break;
+
+		auto band = [first, last, &rowFunction]() {
+			for (int y = first; y < last; y++)
+				rowFunction(y);
+		};
+		if (t == threads - 1 || last == rows)
+			band();
+		else
+			workers.push_back(std::thread(band));
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void PostProcessChain::horizontalBlur(const Image& source, Image& target, int radius, bool thresholdEnabled, float threshold) const
+{
+	// the offsets are in target texels, so when the target is smaller this also downsamples
+	std::vector<float> offsets;
+	std::vector<float> weights;
+	kernelSamples(radius, offsets, weights);
+	int count = (int)offsets.size();
+	std::vector<Texel> taps(target.width * count);
+	for (int x = 0; x < target.width; x++) {
+		for (int i = 0; i < count; i++)
+			taps[x * count + i] = texelAt((x + 0.5f + offsets[i]) / target.width, source.width);
+	}
+
+	parallelRows(target.height, [&](int y) {
+		// every tap in a row has the same v, so blend the two source rows once and only lerp along it per tap.
+		// thresholding the texels before blending them is the same as blurring a full size thresholded copy
+		Texel row = texelAt((y + 0.5f) / target.height, source.height);
+		const float* firstRow = source.row(row.first);
+		const float* secondRow = source.row(row.second);
+		__m128 limit = _mm_set1_ps(threshold);
+		std::vector<float> line(source.width * 4);
+		for (int x = 0; x < source.width; x++) {
+			__m128 first = _mm_loadu_ps(firstRow + x * 4);
+			__m128 second = _mm_loadu_ps(secondRow + x * 4);
+			if (thresholdEnabled) {
+				first = applyThreshold(first, limit);
+				second = applyThreshold(second, limit);
+			}
+			_mm_storeu_ps(&line[x * 4], lerp(first, second, row.weight));
+		}
+
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 colour = _mm_setzero_ps();
+			for (int i = 0; i < count; i++) {
+				const Texel& tap = taps[x * count + i];
+				__m128 texel = lerp(_mm_loadu_ps(&line[tap.first * 4]), _mm_loadu_ps(&line[tap.second * 4]), tap.weight);
+				colour = _mm_add_ps(colour, _mm_mul_ps(texel, _mm_set1_ps(weights[i])));
+			}
+			_mm_storeu_ps(out + x * 4, opaque(colour));
+		}
+	});
+}
+
+void PostProcessChain::verticalBlur(const Image& source, Image& target, int radius) const
+{
+	std::vector<float> offsets;
+	std::vector<float> weights;
+	kernelSamples(radius, offsets, weights);
+	std::vector<Texel> columns = columnTexels(source.width, target.width);
+
+	parallelRows(target.height, [&](int y) {
+		// the horizontal lerp is the same for every tap, so sum the weighted rows first and lerp once
+		std::vector<float> line(source.width * 4, 0.0f);
+		for (size_t i = 0; i < offsets.size(); i++) {
+			Texel row = texelAt((y + 0.5f + offsets[i]) / target.height, source.height);
+			float weight = weights[i];
+			__m128 firstWeight = _mm_set1_ps(weight * (1.0f - row.weight));
+			__m128 secondWeight = _mm_set1_ps(weight * row.weight);
+			const float* firstRow = source.row(row.first);
+			const float* secondRow = source.row(row.second);
+			for (int x = 0; x < source.width; x++) {
+				__m128 sum = _mm_loadu_ps(&line[x * 4]);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(firstRow + x * 4), firstWeight));
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(secondRow + x * 4), secondWeight));
+				_mm_storeu_ps(&line[x * 4], sum);
+			}
+		}
+
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			const Texel& column = columns[x];
+			_mm_storeu_ps(out + x * 4, opaque(lerp(_mm_loadu_ps(&line[column.first * 4]), _mm_loadu_ps(&line[column.second * 4]), column.weight)));
+		}
+	});
+}
+
+void PostProcessChain::additiveBlend(const Image& first, const Image& second, Image& target, float intensity) const
+{
+	std::vector<Texel> firstColumns = columnTexels(first.width, target.width);
+	std::vector<Texel> secondColumns = columnTexels(second.width, target.width);
+	__m128 scale = _mm_set1_ps(intensity);
+
+	parallelRows(target.height, [&](int y) {
+		Texel firstRow = texelAt((y + 0.5f) / target.height, first.height);
+		Texel secondRow = texelAt((y + 0.5f) / target.height, second.height);
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 a = sample(first.row(firstRow.first), first.row(firstRow.second), firstColumns[x], firstRow.weight);
+			__m128 b = sample(second.row(secondRow.first), second.row(secondRow.second), secondColumns[x], secondRow.weight);
+			_mm_storeu_ps(out + x * 4, opaque(_mm_add_ps(a, _mm_mul_ps(b, scale))));
+		}
+	});
+}
+
+void PostProcessChain::kawaseDown(const Image& source, Image& target, float offset, bool thresholdEnabled, float threshold) const
+{
+	// the centre and the four diagonals, columns and rows at -offset, 0 and +offset source texels
+	std::vector<Texel> columns(target.width * 3);
+	for (int x = 0; x < target.width; x++) {
+		for (int i = 0; i < 3; i++)
+			columns[x * 3 + i] = texelAt((x + 0.5f) / target.width + (i - 1) * offset / source.width, source.width);
+	}
+	__m128 limit = _mm_set1_ps(threshold);
+	__m128 centreWeight = _mm_set1_ps(4.0f / 8.0f);
+	__m128 cornerWeight = _mm_set1_ps(1.0f / 8.0f);
+
+	parallelRows(target.height, [&](int y) {
+		Texel rows[3];
+		for (int i = 0; i < 3; i++)
+			rows[i] = texelAt((y + 0.5f) / target.height + (i - 1) * offset / source.height, source.height);
+
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 colour = _mm_setzero_ps();
+			for (int tap = 0; tap < 5; tap++) {
+				// tap 0 is the centre, then the corners
+				int column = tap == 0 ? 1 : ((tap & 1) ? 0 : 2);
+				int row = tap == 0 ? 1 : (tap < 3 ? 0 : 2);
+				const Texel& u = columns[x * 3 + column];
+				const Texel& v = rows[row];
+				__m128 texel = thresholdEnabled ? sampleThresholded(source.row(v.first), source.row(v.second), u, v.weight, limit) :
+					sample(source.row(v.first), source.row(v.second), u, v.weight);
+				colour = _mm_add_ps(colour, _mm_mul_ps(texel, tap == 0 ? centreWeight : cornerWeight));
+			}
+			_mm_storeu_ps(out + x * 4, opaque(colour));
+		}
+	});
+}
+
+void PostProcessChain::kawaseUp(const Image& source, const Image& level, Image& target, float offset, float levelWeight) const
+{
+	// columns and rows at -1, -0.5, 0, 0.5 and 1 times the offset in source texels
+	std::vector<Texel> columns(target.width * 5);
+	for (int x = 0; x < target.width; x++) {
+		for (int i = 0; i < 5; i++)
+			columns[x * 5 + i] = texelAt((x + 0.5f) / target.width + (i - 2) * 0.5f * offset / source.width, source.width);
+	}
+	std::vector<Texel> levelColumns = columnTexels(level.width, target.width);
+
+	// the axis taps count once and the diagonals twice
+	static const int TAPS[8][3] = { { 0, 2, 1 }, { 4, 2, 1 }, { 2, 0, 1 }, { 2, 4, 1 }, { 1, 1, 2 }, { 3, 1, 2 }, { 1, 3, 2 }, { 3, 3, 2 } };
+	__m128 levelScale = _mm_set1_ps(levelWeight);
+
+	parallelRows(target.height, [&](int y) {
+		Texel rows[5];
+		for (int i = 0; i < 5; i++)
+			rows[i] = texelAt((y + 0.5f) / target.height + (i - 2) * 0.5f * offset / source.height, source.height);
+		Texel levelRow = texelAt((y + 0.5f) / target.height, level.height);
+
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 colour = _mm_setzero_ps();
+			for (int tap = 0; tap < 8; tap++) {
+				const Texel& u = columns[x * 5 + TAPS[tap][0]];
+				const Texel& v = rows[TAPS[tap][1]];
+				colour = _mm_add_ps(colour, _mm_mul_ps(sample(source.row(v.first), source.row(v.second), u, v.weight), _mm_set1_ps(TAPS[tap][2] / 12.0f)));
+			}
+			if (levelWeight > 0.0f)
+				colour = _mm_add_ps(colour, _mm_mul_ps(sample(level.row(levelRow.first), level.row(levelRow.second), levelColumns[x], levelRow.weight), levelScale));
+			_mm_storeu_ps(out + x * 4, opaque(colour));
+		}
+	});
+}
+
+void PostProcessChain::summedAreaDownsample(const Image& source, Image& target, bool thresholdEnabled, float threshold) const
+{
+	// table texel (x, y) is image texel (x - 1, y - 1), its 4 taps are a quarter of an image texel either side of its centre
+	int width = target.width - 1;
+	int height = target.height - 1;
+	std::vector<Texel> columns(target.width * 2);
+	for (int x = 1; x < target.width; x++) {
+		columns[x * 2] = texelAt((x - 0.75f) / width, source.width);
+		columns[x * 2 + 1] = texelAt((x - 0.25f) / width, source.width);
+	}
+	__m128 limit = _mm_set1_ps(threshold);
+	__m128 quarter = _mm_set1_ps(0.25f);
+
+	parallelRows(target.height, [&](int y) {
+		float* out = target.row(y);
+		if (y == 0) {
+			for (int x = 0; x < target.width * 4; x++)
+				out[x] = 0.0f;
+			return;
+		}
+
+		Texel rows[2] = { texelAt((y - 0.75f) / height, source.height), texelAt((y - 0.25f) / height, source.height) };
+		_mm_storeu_ps(out, _mm_setzero_ps());
+		for (int x = 1; x < target.width; x++) {
+			__m128 colour = _mm_setzero_ps();
+			for (int j = 0; j < 2; j++) {
+				const float* firstRow = source.row(rows[j].first);
+				const float* secondRow = source.row(rows[j].second);
+				for (int i = 0; i < 2; i++) {
+					if (thresholdEnabled)
+						colour = _mm_add_ps(colour, sampleThresholded(firstRow, secondRow, columns[x * 2 + i], rows[j].weight, limit));
+					else
+						colour = _mm_add_ps(colour, sample(firstRow, secondRow, columns[x * 2 + i], rows[j].weight));
+				}
+			}
+			_mm_storeu_ps(out + x * 4, opaque(_mm_mul_ps(colour, quarter)));
+		}
+	});
+}
+
+// the two halves of an RGBA pixel as doubles, and back
+static inline void widen(__m128 colour, __m128d& low, __m128d& high)
+{
+	low = _mm_cvtps_pd(colour);
+	high = _mm_cvtps_pd(_mm_movehl_ps(colour, colour));
+}
+
+static inline __m128 narrow(__m128d low, __m128d high)
+{
+	return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+}
+
+void PostProcessChain::summedAreaScan(Image& table, float mean[4]) const
+{
+	// a small box is the difference of two big sums, and a float sum of a hundred thousand texels has lost the low bits
+	// the difference needs. so the texels' mean is taken off first, keeping the sums near zero, and every running sum
+	// is a double that's only rounded to a float when it's stored
+	int width = table.width;
+	int height = table.height;
+
+	// each row's total, then the mean of the image without the zero row and column
+	std::vector<double> rowTotals((size_t)height * 4, 0.0);
+	parallelRows(height, [&](int y) {
+		const float* row = table.row(y);
+		__m128d low = _mm_setzero_pd();
+		__m128d high = _mm_setzero_pd();
+		for (int x = 1; x < width; x++) {
+			__m128d texelLow, texelHigh;
+			widen(_mm_loadu_ps(row + x * 4), texelLow, texelHigh);
+			low = _mm_add_pd(low, texelLow);
+			high = _mm_add_pd(high, texelHigh);
+		}
+		_mm_storeu_pd(&rowTotals[(size_t)y * 4], low);
+		_mm_storeu_pd(&rowTotals[(size_t)y * 4 + 2], high);
+	});
+	double texels = (double)(width - 1) * (height - 1);
+	for (int c = 0; c < 4; c++) {
+		double total = 0.0;
+		for (int y = 1; y < height; y++)
+			total += rowTotals[(size_t)y * 4 + c];
+		mean[c] = texels > 0.0 ? (float)(total / texels) : 0.0f;
+	}
+	__m128d meanLow = _mm_set_pd(mean[1], mean[0]);
+	__m128d meanHigh = _mm_set_pd(mean[3], mean[2]);
+
+	// sum along each row, the zero row and column stay zero
+	parallelRows(height - 1, [&](int y) {
+		float* row = table.row(y + 1);
+		__m128d low = _mm_setzero_pd();
+		__m128d high = _mm_setzero_pd();
+		for (int x = 1; x < width; x++) {
+			__m128d texelLow, texelHigh;
+			widen(_mm_loadu_ps(row + x * 4), texelLow, texelHigh);
+			low = _mm_add_pd(low, _mm_sub_pd(texelLow, meanLow));
+			high = _mm_add_pd(high, _mm_sub_pd(texelHigh, meanHigh));
+			_mm_storeu_ps(row + x * 4, narrow(low, high));
+		}
+	});
+
+	// then down the columns, each thread taking a band of columns so it walks along rows rather than down them
+	const int bandWidth = 16;
+	int bands = (width + bandWidth - 1) / bandWidth;
+	parallelRows(bands, [&](int band) {
+		int first = band * bandWidth;
+		int last = first + bandWidth < width ? first + bandWidth : width;
+		__m128d running[bandWidth * 2];
+		for (int i = 0; i < bandWidth * 2; i++)
+			running[i] = _mm_setzero_pd();
+
+		for (int y = 1; y < height; y++) {
+			float* row = table.row(y);
+			for (int x = first; x < last; x++) {
+				__m128d texelLow, texelHigh;
+				widen(_mm_loadu_ps(row + x * 4), texelLow, texelHigh);
+				__m128d& low = running[(x - first) * 2];
+				__m128d& high = running[(x - first) * 2 + 1];
+				low = _mm_add_pd(low, texelLow);
+				high = _mm_add_pd(high, texelHigh);
+				_mm_storeu_ps(row + x * 4, narrow(low, high));
+			}
+		}
+	});
+}
+
+void PostProcessChain::summedAreaBox(const Image& table, const float mean[4], Image& target, const StackedBoxes& boxes) const
+{
+	// table texel (x, y) is the sum of the image texels before x and y, boxes are cut off at the image's edges
+	int width = table.width - 1;
+	int height = table.height - 1;
+	float weightTotal = 0.0f;
+	for (int i = 0; i < boxes.count; i++)
+		weightTotal += boxes.weights[i];
+	__m128 offset = _mm_mul_ps(_mm_loadu_ps(mean), _mm_set1_ps(weightTotal));
+
+	parallelRows(target.height, [&](int y) {
+		int firstRows[MAX_STACKED_BOXES];
+		int lastRows[MAX_STACKED_BOXES];
+		for (int i = 0; i < boxes.count; i++) {
+			firstRows[i] = y - boxes.radii[i] > 0 ? y - boxes.radii[i] : 0;
+			lastRows[i] = y + boxes.radii[i] + 1 < height ? y + boxes.radii[i] + 1 : height;
+		}
+
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 colour = offset;
+			for (int i = 0; i < boxes.count; i++) {
+				int first = x - boxes.radii[i] > 0 ? x - boxes.radii[i] : 0;
+				int last = x + boxes.radii[i] + 1 < width ? x + boxes.radii[i] + 1 : width;
+				const float* top = table.row(firstRows[i]);
+				const float* bottom = table.row(lastRows[i]);
+				__m128 sum = _mm_sub_ps(_mm_loadu_ps(bottom + last * 4), _mm_loadu_ps(bottom + first * 4));
+				sum = _mm_add_ps(sum, _mm_sub_ps(_mm_loadu_ps(top + first * 4), _mm_loadu_ps(top + last * 4)));
+				float area = (float)((last - first) * (lastRows[i] - firstRows[i]));
+				colour = _mm_add_ps(colour, _mm_mul_ps(sum, _mm_set1_ps(boxes.weights[i] / area)));
+			}
+			_mm_storeu_ps(out + x * 4, opaque(colour));
+		}
+	});
+}
+
+void PostProcessChain::composite(const Image& scene, const Image& bloom, Image& target, float sceneWeight, float bloomWeight, const ColourGrade* grade, float exposure) const
+{
+	std::vector<Texel> sceneColumns = columnTexels(scene.width, target.width);
+	std::vector<Texel> bloomColumns = columnTexels(bloom.width, target.width);
+	__m128 sceneScale = _mm_set1_ps(sceneWeight);
+	__m128 bloomScale = _mm_set1_ps(bloomWeight);
+
+	parallelRows(target.height, [&](int y) {
+		Texel sceneRow = texelAt((y + 0.5f) / target.height, scene.height);
+		Texel bloomRow = texelAt((y + 0.5f) / target.height, bloom.height);
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 colour = _mm_mul_ps(sample(bloom.row(bloomRow.first), bloom.row(bloomRow.second), bloomColumns[x], bloomRow.weight), bloomScale);
+			if (sceneWeight > 0.0f)
+				colour = _mm_add_ps(colour, _mm_mul_ps(sample(scene.row(sceneRow.first), scene.row(sceneRow.second), sceneColumns[x], sceneRow.weight), sceneScale));
+
+			_mm_storeu_ps(out + x * 4, opaque(colour));
+			if (grade)
+				grade->lookup(out + x * 4, exposure, out + x * 4);
+		}
+	});
+}
+
+void PostProcessChain::reduce(const Image& scene, Image& target, int scale) const
+{
+	// every scene texel in the block, clamped at the edges like bilateralDownsample_ps's loads. alpha is depth, averaged too
+	float area = 1.0f / (scale * scale);
+	parallelRows(target.height, [&](int y) {
+		float* out = target.row(y);
+		for (int x = 0; x < target.width; x++) {
+			__m128 sum = _mm_setzero_ps();
+			for (int j = 0; j < scale; j++) {
+				int row = y * scale + j < scene.height ? y * scale + j : scene.height - 1;
+				const float* in = scene.row(row);
+				for (int i = 0; i < scale; i++) {
+					int column = x * scale + i < scene.width ? x * scale + i : scene.width - 1;
+					sum = _mm_add_ps(sum, _mm_loadu_ps(in + column * 4));
+				}
+			}
+			_mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(area)));
+		}
+	});
+}
+
+static inline float logLuminance(const float* colour)
+{
+	float luminance = colour[0] * 0.2126f + colour[1] * 0.7152f + colour[2] * 0.0722f;
+	return log2f(luminance > 1e-6f ? luminance : 1e-6f);
+}
+
+void PostProcessChain::jointBilateralUpsample(const Image& source, const Image& guide, const Image& scene, Image& target, float depthSigma, float luminanceSigma) const
+{
+	// the source is sampled at each guide texel's centre, the same for every row
+	std::vector<Texel> sourceColumns = columnTexels(source.width, guide.width);
+	std::vector<float> guideLuminance((size_t)guide.width * guide.height);
+	for (int y = 0; y < guide.height; y++) {
+		for (int x = 0; x < guide.width; x++)
+			guideLuminance[(size_t)y * guide.width + x] = logLuminance(guide.row(y) + x * 4);
+	}
+	float depthWeight = depthSigma > 0.0f ? 1.0f / depthSigma : 0.0f;
+	float luminanceWeight = luminanceSigma > 0.0f ? 1.0f / luminanceSigma : 0.0f;
+
+	parallelRows(target.height, [&](int y) {
+		const float* sceneRow = scene.row(y);
+		float* out = target.row(y);
+
+		// the 2x2 guide texels around this row, unclamped so the edges weigh like toneMap_ps's
+		float gy = (y + 0.5f) / target.height * guide.height - 0.5f;
+		int baseY = (int)floorf(gy);
+		float fy = gy - baseY;
+		int guideRows[2];
+		Texel sourceRows[2];
+		for (int j = 0; j < 2; j++) {
+			guideRows[j] = baseY + j < 0 ? 0 : (baseY + j > guide.height - 1 ? guide.height - 1 : baseY + j);
+			sourceRows[j] = texelAt((guideRows[j] + 0.5f) / guide.height, source.height);
+		}
+
+		for (int x = 0; x < target.width; x++) {
+			float depth = sceneRow[x * 4 + 3] > 1e-6f ? sceneRow[x * 4 + 3] : 1e-6f;
+			float luminance = logLuminance(sceneRow + x * 4);
+
+			float gx = (x + 0.5f) / target.width * guide.width - 0.5f;
+			int baseX = (int)floorf(gx);
+			float fx = gx - baseX;
+
+			// bilinear weights cut down by how far each guide texel's depth and luminance are from this pixel's, texels that
+			// are all too far apart fall back to bilinear
+			__m128 sum = _mm_setzero_ps();
+			float weightSum = 0.0f;
+			for (int j = 0; j < 2; j++) {
+				const float* guideRow = guide.row(guideRows[j]);
+				for (int i = 0; i < 2; i++) {
+					int column = baseX + i < 0 ? 0 : (baseX + i > guide.width - 1 ? guide.width - 1 : baseX + i);
+					const float* texel = guideRow + column * 4;
+					float depthDifference = (texel[3] - depth) / depth * depthWeight;
+					float luminanceDifference = (guideLuminance[(size_t)guideRows[j] * guide.width + column] - luminance) * luminanceWeight;
+					float edge = expf(-(depthDifference * depthDifference + luminanceDifference * luminanceDifference));
+					float weight = (i ? fx : 1.0f - fx) * (j ? fy : 1.0f - fy) * (edge > 1e-4f ? edge : 1e-4f);
+
+					const Texel& sourceRow = sourceRows[j];
+					__m128 colour = sample(source.row(sourceRow.first), source.row(sourceRow.second), sourceColumns[column], sourceRow.weight);
+					sum = _mm_add_ps(sum, _mm_mul_ps(colour, _mm_set1_ps(weight)));
+					weightSum += weight;
+				}
+			}
+			_mm_storeu_ps(out + x * 4, opaque(_mm_div_ps(sum, _mm_set1_ps(weightSum))));
+		}
+	});
+}
+
+const ColourGrade* PostProcessChain::bakeGrade(const Settings& settings)
+{
+	if (!settings.enableHDR)
+		return NULL;
+
+	ColourGrade::Settings gradeSettings;
+	gradeSettings.toneCurve = settings.toneCurve;
+	for (int c = 0; c < 3; c++)
+		gradeSettings.balance[c] = settings.colourBalance[c];
+	gradeSettings.saturation = settings.saturation;
+	gradeSettings.gamma = settings.gammaCorrection ? 2.2f : 1.0f;
+	grade.bake(gradeSettings);
+	return &grade;
+}
+
+void PostProcessChain::process(const Image& scene, const Settings& settings, Image& output)
+{
+	// a reduced resolution chain starts from a smaller copy of the scene, which guides the upsample back to full size
+	int scale = settings.resolutionScale > 1 ? settings.resolutionScale : 1;
+	const Image* source = &scene;
+	if (scale > 1) {
+		int width, height;
+		reducedSize(scene.width, scene.height, scale, width, height);
+		reduced.resize(width, height);
+		reduce(scene, reduced, scale);
+		source = &reduced;
+	}
+
+	const Image* filtered;
+	if (settings.blurMethod == KAWASE_BLUR)
+		filtered = blurKawase(*source, settings);
+	else if (settings.blurMethod == SUMMED_AREA_BLUR)
+		filtered = blurSummedArea(*source, settings, scene.width);
+	else
+		filtered = blurGaussian(*source, settings, scale);
+
+	// toneMap_ps upsamples as it composites, here it's a full size image first
+	if (scale > 1) {
+		upsampled.resize(scene.width, scene.height);
+		jointBilateralUpsample(*filtered, reduced, scene, upsampled, settings.upsampleDepthSigma, settings.upsampleLuminanceSigma);
+		filtered = &upsampled;
+	}
+
+	// blur only shows the blurred image, bloom adds it to the scene
+	output.resize(scene.width, scene.height);
+	if (settings.enableBloom)
+		composite(scene, *filtered, output, 1.0f, settings.bloomIntensity, bakeGrade(settings), settings.exposure);
+	else
+		composite(scene, *filtered, output, 0.0f, 1.0f, bakeGrade(settings), settings.exposure);
+}
+
+const PostProcessChain::Image* PostProcessChain::blurGaussian(const Image& source, const Settings& settings, int scale)
+{
+	int passes = settings.blurPasses < 1 ? 1 : (settings.blurPasses > MAX_LEVELS ? MAX_LEVELS : settings.blurPasses);
+
+	// blur each level, each one downsampling the last. bloom thresholds the source in the first pass
+	for (int i = 0; i < passes; i++) {
+		int width, height;
+		reducedSize(settings.levelWidth[i], settings.levelHeight[i], scale, width, height);
+		horizontal[i].resize(width, height);
+		vertical[i].resize(width, height);
+		if (i == 0)
+			horizontalBlur(source, horizontal[i], settings.blurRadius, settings.enableBloom, settings.bloomThreshold);
+		else
+			horizontalBlur(vertical[i - 1], horizontal[i], settings.blurRadius);
+		verticalBlur(horizontal[i], vertical[i], settings.blurRadius);
+	}
+
+	// blur only shows the last level
+	if (!settings.enableBloom)
+		return &vertical[passes - 1];
+
+	// bloom adds each level to the one below it on the way back up, sampling the smaller level bilinearly
+	const Image* filtered = &vertical[passes - 1];
+	for (int i = passes - 2; i >= 0; i--) {
+		combined[i].resize(vertical[i].width, vertical[i].height);
+		additiveBlend(vertical[i], *filtered, combined[i], 1.0f);
+		filtered = &combined[i];
+	}
+	return filtered;
+}
+
+const PostProcessChain::Image* PostProcessChain::blurKawase(const Image& source, const Settings& settings)
+{
+	int passes = settings.kawasePasses < 1 ? 1 : (settings.kawasePasses > MAX_KAWASE_LEVELS ? MAX_KAWASE_LEVELS : settings.kawasePasses);
+
+	// halve the image each pass, bloom thresholds the source in the first
+	for (int i = 0; i < passes; i++) {
+		int width, height;
+		kawaseSize(source.width, source.height, i, width, height);
+		down[i].resize(width, height);
+		kawaseDown(i == 0 ? source : down[i - 1], down[i], settings.kawaseOffset, settings.enableBloom && i == 0, settings.bloomThreshold);
+	}
+
+	// then back up to the first level's size, bloom adding each level on the way
+	const Image* filtered = &down[passes - 1];
+	for (int i = passes - 2; i >= 0; i--) {
+		up[i].resize(down[i].width, down[i].height);
+		kawaseUp(*filtered, down[i], up[i], settings.kawaseOffset, settings.enableBloom ? 1.0f : 0.0f);
+		filtered = &up[i];
+	}
+	return filtered;
+}
+
+const PostProcessChain::Image* PostProcessChain::blurSummedArea(const Image& source, const Settings& settings, int sceneWidth)
+{
+	// the table is made from a quarter size copy, bloom thresholding it on the way down
+	int width, height;
+	summedAreaSize(source.width, source.height, width, height);
+	summedArea.resize(width + 1, height + 1);
+	summedAreaDownsample(source, summedArea, settings.enableBloom, settings.bloomThreshold);
+
+	float mean[4];
+	summedAreaScan(summedArea, mean);
+
+	// the radius is in scene pixels, the boxes are in the table's texels
+	StackedBoxes boxes = makeStackedBoxes(settings.summedAreaRadius / 3.0f * width / sceneWidth);
+	boxBlurred.resize(width, height);
+	summedAreaBox(summedArea, mean, boxBlurred, boxes);
+	return &boxBlurred;
+}
+
+void PostProcessChain::reducedSize(int width, int height, int scale, int& reducedWidth, int& reducedHeight)
+{
+	reducedWidth = (width + scale - 1) / scale;
+	reducedHeight = (height + scale - 1) / scale;
+}
+
+void PostProcessChain::summedAreaSize(int width, int height, int& tableWidth, int& tableHeight)
+{
+	tableWidth = (width + 3) / 4;
+	tableHeight = (height + 3) / 4;
+}
+
+void PostProcessChain::kawaseSize(int width, int height, int level, int& levelWidth, int& levelHeight)
+{
+	levelWidth = width;
+	levelHeight = height;
+	for (int i = 0; i <= level; i++) {
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
@@ -0,0 +1,126 @@
+// Post process chain
+// CPU copy of App1's post processing: the separable gaussian blur with the bloom threshold in its first pass, the blur
+// levels' merge on the way back up, the dual kawase down and upsampling blur, the summed area table's stacked box blur,
+// the reduced resolution scene and its depth guided upsample, and the composite that adds the result to
+// the scene and tone maps it. Each pass samples like its shader, bilinear and clamped at each target pixel's centre,
+// so images can be post processed headless without a GPU. Rows are split across threads, each pixel is one SSE vector.
+// Doesn't depend on D3D
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "StackedBoxes.h"
+#include "ColourGrade.h"
+
+class PostProcessChain
+{
+public:
+	// RGBA float pixels, rows top to bottom
+	struct Image
+	{
+		int width;
+		int height;
+		std::vector<float> pixels;
+
+		Image() : width(0), height(0) {}
+		void resize(int lwidth, int lheight) { width = lwidth; height = lheight; pixels.resize((size_t)width * height * 4); }
+		float* row(int y) { return &pixels[(size_t)y * width * 4]; }
+		const float* row(int y) const { return &pixels[(size_t)y * width * 4]; }
+	};
+
+	static const int MAX_LEVELS = 9;
+	static const int MAX_KAWASE_LEVELS = 6;
+
+	// App1's BlurMethod
+	enum BlurMethod { GAUSSIAN_BLUR = 0, KAWASE_BLUR, SUMMED_AREA_BLUR };
+
+	// the same switches and values as App1's post processing GUI, the defaults match initVariables
+	struct Settings
+	{
+		bool enableBloom;
+		float bloomThreshold;
+		float bloomIntensity;
+		int blurPasses; // 1 to MAX_LEVELS
+		int blurRadius; // one of GAUSSIAN_RADII
+		int levelWidth[MAX_LEVELS]; // each blur level's size, App1's aspectRatios
+		int levelHeight[MAX_LEVELS];
+		int blurMethod;
+		int kawasePasses; // 1 to MAX_KAWASE_LEVELS, each one halving the image
+		float kawaseOffset;
+		float summedAreaRadius; // in scene pixels, three standard deviations
+		bool enableHDR;
+		float exposure;
+		bool gammaCorrection;
+		int toneCurve; // ColourGrade::ToneCurve
+		float colourBalance[3];
+		float saturation;
+		int resolutionScale; // 1, 2 or 4, the blur or bloom runs on the scene reduced this many times each way
+		float upsampleDepthSigma; // the reduced result's upsample, depth differences as a fraction of the pixel's depth
+		float upsampleLuminanceSigma; // and luminance differences in stops, 0 ignores either
+
+		Settings();
+	};
+
+	// threadCount 0 uses one per core
+	PostProcessChain(int threadCount = 0);
+
+	// runs the passes addPostProcessing would for these settings, output is the image composite draws. the scene's alpha is
+	// its linear depth, only used to guide a reduced resolution chain's upsample
+	void process(const Image& scene, const Settings& settings, Image& output);
+
+	// App1's kawase level sizes, each half the last rounded up
+	static void kawaseSize(int width, int height, int level, int& levelWidth, int& levelHeight);
+	// the image the summed area table is made from, a quarter of the size rounded up
+	static void summedAreaSize(int width, int height, int& tableWidth, int& tableHeight);
+	// App1's reduced resolution sizes, divided by scale rounded up
+	static void reducedSize(int width, int height, int scale, int& reducedWidth, int& reducedHeight);
+
+	// the single passes, the target has to be sized already. the sources can be any size
+	// samples are at the kernel's paired offsets in target texels, like horizontalBlur_ps. thresholdEnabled blurs the source's
+	// texels over the threshold only
+	void horizontalBlur(const Image& source, Image& target, int radius = 5, bool thresholdEnabled = false, float threshold = 0.0f) const;
+	void verticalBlur(const Image& source, Image& target, int radius = 5) const;
+	void additiveBlend(const Image& first, const Image& second, Image& target, float intensity) const;
+	// like kawaseDown_ps and kawaseUp_ps, the offset is in the source's texels. the upsample adds level * levelWeight
+	void kawaseDown(const Image& source, Image& target, float offset, bool thresholdEnabled = false, float threshold = 0.0f) const;
+	void kawaseUp(const Image& source, const Image& level, Image& target, float offset, float levelWeight) const;
+	// like the summed area shaders. the downsample's target is a texel bigger each way than summedAreaSize for the table's
+	// zero row and column, the scan turns it into the table in place and the box blur's target is summedAreaSize.
+	// the CPU table holds the sums of each texel less the mean, which the scan returns and the box blur adds back
+	void summedAreaDownsample(const Image& source, Image& target, bool thresholdEnabled = false, float threshold = 0.0f) const;
+	void summedAreaScan(Image& table, float mean[4]) const;
+	void summedAreaBox(const Image& table, const float mean[4], Image& target, const StackedBoxes& boxes) const;
+	// averages each scale x scale block of the scene, depth included, like bilateralDownsample_ps
+	void reduce(const Image& scene, Image& target, int scale) const;
+	// upsamples source to the size of scene the way toneMap_ps does before compositing: source is sampled at the reduced
+	// guide's 2x2 texels around each pixel, weighted bilinearly and by how close each texel's depth and luminance are to
+	// the scene pixel's. the sigmas are the same as Settings'
+	void jointBilateralUpsample(const Image& source, const Image& guide, const Image& scene, Image& target, float depthSigma, float luminanceSigma) const;
+	// scene * sceneWeight + bloom * bloomWeight like toneMap_ps, graded with grade's LUT unless it's NULL
+	void composite(const Image& scene, const Image& bloom, Image& target, float sceneWeight, float bloomWeight, const ColourGrade* grade, float exposure) const;
+
+private:
+	// each blur method's passes, returning the blurred image
+	const Image* blurGaussian(const Image& source, const Settings& settings, int scale);
+	const Image* blurKawase(const Image& source, const Settings& settings);
+	const Image* blurSummedArea(const Image& source, const Settings& settings, int sceneWidth);
+	const ColourGrade* bakeGrade(const Settings& settings); // App1's gradeSettings, NULL without HDR
+
+	template <typename F>
+	void parallelRows(int rows, F rowFunction) const;
+
+private:
+	int threadCount;
+
+	// intermediate targets, kept between calls so a batch doesn't reallocate them for every image
+	Image horizontal[MAX_LEVELS];
+	Image vertical[MAX_LEVELS];
+	Image combined[MAX_LEVELS - 1];
+	Image down[MAX_KAWASE_LEVELS];
+	Image up[MAX_KAWASE_LEVELS - 1];
+	Image summedArea;
+	Image boxBlurred;
+	Image reduced; // the reduced scene, also the upsample's guide
+	Image upsampled;
+	ColourGrade grade;
+};
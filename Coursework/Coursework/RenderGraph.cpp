@@ -0,0 +1,285 @@
+// Render graph
+#include "RenderGraph.h"
+
+RenderGraph::RenderGraph()
+{
+	reset();
+}
+
+void RenderGraph::reset()
+{
+	resources.clear();
+	passes.clear();
+	steps.clear();
+	physicalDescs.clear();
+	stats = Stats();
+}
+
+int RenderGraph::createTarget(const char* name, int width, int height, unsigned int format)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc.width = width;
+	resource.desc.height = height;
+	resource.desc.format = format;
+	resource.imported = false;
+	resource.output = false;
+	resource.physical = -1;
+	resource.firstStep = -1;
+	resource.lastStep = -1;
+	resources.push_back(resource);
+	return (int)resources.size() - 1;
+}
+
+int RenderGraph::importResource(const char* name, bool output)
+{
+	int index = createTarget(name, 0, 0, 0);
+	resources[index].imported = true;
+	resources[index].output = output;
+	return index;
+}
+
+int RenderGraph::addPass(const char* name, function<void()> execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.live = false;
+	passes.push_back(pass);
+	return (int)passes.size() - 1;
+}
+
+void RenderGraph::read(int pass, int resource)
+{
+	passes[pass].reads.push_back(resource);
+}
+
+void RenderGraph::write(int pass, int resource, WriteMode mode)
+{
+	Write write;
+	write.resource = resource;
+	write.mode = mode;
+	write.bound = true;
+	passes[pass].writes.push_back(write);
+}
+
+void RenderGraph::writeExternal(int pass, int resource)
+{
+	Write write;
+	write.resource = resource;
+	write.mode = WRITE_LOAD;
+	write.bound = false;
+	passes[pass].writes.push_back(write);
+}
+
+bool RenderGraph::compile()
+{
+	steps.clear();
+	physicalDescs.clear();
+	stats = Stats();
+	stats.passes = (int)passes.size();
+	for (size_t i = 0; i < resources.size(); i++) {
+		resources[i].physical = -1;
+		resources[i].firstStep = -1;
+		resources[i].lastStep = -1;
+	}
+
+	vector<int> order;
+	if (!sortPasses(order))
+		return false;
+
+	cullPasses(order);
+	buildSteps(order);
+	aliasTargets();
+	return true;
+}
+
+bool RenderGraph::sortPasses(vector<int>& order)
+{
+	// each target holds one image a frame. whatever writes it comes before whatever reads it, and passes that draw
+	// over it (WRITE_LOAD) come after the one that fills it, in the order they were added
+	int count = (int)passes.size();
+	vector<vector<int> > after(count);
+	vector<int> waitingOn(count, 0);
+
+	for (int r = 0; r < (int)resources.size(); r++) {
+		vector<int> writers;
+		vector<int> readers;
+		for (int mode = 0; mode < 2; mode++) {
+			for (int p = 0; p < count; p++) {
+				for (size_t w = 0; w < passes[p].writes.size(); w++) {
+					const Write& write = passes[p].writes[w];
+					if (write.resource == r && (write.mode == WRITE_LOAD) == (mode == 1))
+						writers.push_back(p);
+				}
+			}
+		}
+		for (int p = 0; p < count; p++) {
+			for (size_t i = 0; i < passes[p].reads.size(); i++) {
+				if (passes[p].reads[i] == r)
+					readers.push_back(p);
+			}
+		}
+
+		for (size_t w = 0; w + 1 < writers.size(); w++) {
+			if (writers[w] != writers[w + 1]) {
+				after[writers[w]].push_back(writers[w + 1]);
+				waitingOn[writers[w + 1]]++;
+			}
+		}
+		for (size_t w = 0; w < writers.size(); w++) {
+			for (size_t i = 0; i < readers.size(); i++) {
+				if (writers[w] != readers[i]) {
+					after[writers[w]].push_back(readers[i]);
+					waitingOn[readers[i]]++;
+				}
+			}
+		}
+	}
+
+	// of the passes that are ready, always run the one added first so independent passes keep their declared order
+	vector<bool> done(count, false);
+	order.clear();
+	while ((int)order.size() < count) {
+		int next = -1;
+		for (int p = 0; p < count && next < 0; p++) {
+			if (!done[p] && waitingOn[p] == 0)
+				next = p;
+		}
+		if (next < 0)
+			return false;
+
+		done[next] = true;
+		order.push_back(next);
+		for (size_t i = 0; i < after[next].size(); i++)
+			waitingOn[after[next][i]]--;
+	}
+	return true;
+}
+
+void RenderGraph::cullPasses(const vector<int>& order)
+{
+	// walk back from the outputs. a pass is needed if it writes something a later needed pass reads,
+	// and a pass that replaces a target's contents means nothing before it needs to fill that target
+	vector<bool> needed(resources.size());
+	for (size_t i = 0; i < resources.size(); i++)
+		needed[i] = resources[i].output;
+
+	for (int i = (int)order.size() - 1; i >= 0; i--) {
+		Pass& pass = passes[order[i]];
+		pass.live = false;
+		for (size_t w = 0; w < pass.writes.size(); w++) {
+			if (needed[pass.writes[w].resource])
+				pass.live = true;
+		}
+		if (!pass.live) {
+			stats.culled++;
+			continue;
+		}
+
+		for (size_t w = 0; w < pass.writes.size(); w++) {
+			if (pass.writes[w].mode != WRITE_LOAD)
+				needed[pass.writes[w].resource] = false;
+		}
+		for (size_t r = 0; r < pass.reads.size(); r++)
+			needed[pass.reads[r]] = true;
+	}
+}
+
+void RenderGraph::buildSteps(const vector<int>& order)
+{
+	int bound = -1; // nothing is known to be bound before the first pass
+	for (size_t i = 0; i < order.size(); i++) {
+		const Pass& pass = passes[order[i]];
+		if (!pass.live)
+			continue;
+
+		Step step;
+		step.pass = order[i];
+		step.target = -1;
+		step.bind = false;
+		step.clear = false;
+		for (size_t w = 0; w < pass.writes.size(); w++) {
+			const Write& write = pass.writes[w];
+			if (write.bound) {
+				step.target = write.resource;
+				step.clear = write.mode == WRITE_CLEAR;
+				if (write.mode == WRITE_COVER)
+					stats.skippedClears++;
+			}
+		}
+
+		if (step.target >= 0) {
+			step.bind = step.target != bound;
+			bound = step.target;
+			if (step.bind)
+				stats.binds++;
+			else
+				stats.skippedBinds++;
+			if (step.clear)
+				stats.clears++;
+		}
+		else {
+			// the pass binds its own targets, so whatever was bound isn't any more
+			bound = -1;
+		}
+
+		// lifetimes of the targets this step touches
+		int index = (int)steps.size();
+		for (size_t w = 0; w < pass.writes.size(); w++) {
+			Resource& resource = resources[pass.writes[w].resource];
+			if (resource.firstStep < 0)
+				resource.firstStep = index;
+			resource.lastStep = index;
+		}
+		for (size_t r = 0; r < pass.reads.size(); r++) {
+			Resource& resource = resources[pass.reads[r]];
+			if (resource.firstStep < 0)
+				resource.firstStep = index;
+			resource.lastStep = index;
+		}
+
+		steps.push_back(step);
+	}
+}
+
+void RenderGraph::aliasTargets()
+{
+	// first fit in the order the targets come alive, a texture is free again once the last step using its target is done
+	vector<int> lastUse;
+	for (size_t s = 0; s < steps.size(); s++) {
+		for (size_t r = 0; r < resources.size(); r++) {
+			Resource& resource = resources[r];
+			if (resource.imported || resource.firstStep != (int)s)
+				continue;
+
+			stats.targets++;
+			for (size_t p = 0; p < physicalDescs.size() && resource.physical < 0; p++) {
+				const TargetDesc& desc = physicalDescs[p];
+				if (lastUse[p] < (int)s && desc.width == resource.desc.width && desc.height == resource.desc.height && desc.format == resource.desc.format)
+					resource.physical = (int)p;
+			}
+			if (resource.physical < 0) {
+				resource.physical = (int)physicalDescs.size();
+				physicalDescs.push_back(resource.desc);
+				lastUse.push_back(0);
+			}
+			lastUse[resource.physical] = resource.lastStep;
+		}
+	}
+	stats.physicalTargets = (int)physicalDescs.size();
+}
+
+void RenderGraph::execute(Executor& executor)
+{
+	executor.allocate(*this);
+	for (size_t i = 0; i < steps.size(); i++) {
+		const Step& step = steps[i];
+		if (step.bind)
+			executor.bind(*this, step.target);
+		if (step.clear)
+			executor.clear(*this, step.target);
+		passes[step.pass].execute();
+	}
+	executor.release(*this);
+}
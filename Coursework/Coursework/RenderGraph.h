@@ -0,0 +1,133 @@
+// Render graph
+// The frame's passes declare the targets they read and write, compile() works out the rest:
+// - the order, from which passes read what others write
+// - which passes can be dropped because nothing that reaches an output reads what they write
+// - which clears are needed, passes that draw every pixel of their target don't need one
+// - which target binds are needed, a pass drawing to the target that's already bound doesn't rebind it
+// - which transient targets can share a texture because their lifetimes don't overlap
+// Compiling doesn't touch the GPU, an Executor does the binding and clearing so the graph can be run against a mock.
+// Doesn't depend on D3D
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class RenderGraph
+{
+public:
+	enum WriteMode
+	{
+		WRITE_CLEAR, // the pass only draws part of its target, so it's cleared first
+		WRITE_COVER, // the pass draws every pixel, a clear would be overwritten
+		WRITE_LOAD, // the pass draws over what's already in the target
+	};
+
+	// format is whatever the executor understands, App1 uses DXGI_FORMAT
+	struct TargetDesc
+	{
+		int width;
+		int height;
+		unsigned int format;
+	};
+
+	// one live pass after compiling, in execution order
+	struct Step
+	{
+		int pass;
+		int target; // resource the pass draws to, -1 if it binds its own targets
+		bool bind; // false if the target is still bound from the step before
+		bool clear;
+	};
+
+	struct Stats
+	{
+		int passes; // declared
+		int culled; // dropped as unused
+		int clears;
+		int skippedClears; // covering writes that would have been cleared
+		int binds;
+		int skippedBinds;
+		int targets; // transient targets declared by live passes
+		int physicalTargets; // textures they need after aliasing
+	};
+
+	// sets up each step's target, App1's binds RenderTextures from the RenderTargetPool
+	class Executor
+	{
+	public:
+		virtual ~Executor() {}
+		virtual void allocate(const RenderGraph& graph) = 0; // before the first step, one texture per physical target
+		virtual void bind(const RenderGraph& graph, int resource) = 0;
+		virtual void clear(const RenderGraph& graph, int resource) = 0;
+		virtual void release(const RenderGraph& graph) = 0; // after the last step
+	};
+
+	RenderGraph();
+
+	void reset(); // removes every pass and resource, ready to declare the next frame
+
+	// transient targets only exist for the passes that use them, imported ones live outside the graph.
+	// anything written to an output, like the back buffer, is kept
+	int createTarget(const char* name, int width, int height, unsigned int format);
+	int importResource(const char* name, bool output);
+
+	int addPass(const char* name, function<void()> execute);
+	void read(int pass, int resource);
+	void write(int pass, int resource, WriteMode mode); // the pass's render target, at most one
+	void writeExternal(int pass, int resource); // written by the pass binding it itself, like the shadow maps
+
+	bool compile(); // false if the passes depend on each other in a loop
+	void execute(Executor& executor);
+
+	const vector<Step>& getSteps() const { return steps; };
+	const Stats& getStats() const { return stats; };
+	const char* getPassName(int pass) const { return passes[pass].name.c_str(); };
+	bool isCulled(int pass) const { return !passes[pass].live; };
+	bool isImported(int resource) const { return resources[resource].imported; };
+	const TargetDesc& getDesc(int resource) const { return resources[resource].desc; };
+	int getPhysical(int resource) const { return resources[resource].physical; }; // -1 for imported or unused targets
+	int getPhysicalCount() const { return (int)physicalDescs.size(); };
+	const TargetDesc& getPhysicalDesc(int physical) const { return physicalDescs[physical]; };
+
+private:
+	struct Resource
+	{
+		string name;
+		TargetDesc desc;
+		bool imported;
+		bool output;
+		int physical;
+		int firstStep; // lifetime over the compiled steps
+		int lastStep;
+	};
+
+	struct Write
+	{
+		int resource;
+		WriteMode mode;
+		bool bound; // false for writeExternal
+	};
+
+	struct Pass
+	{
+		string name;
+		function<void()> execute;
+		vector<int> reads;
+		vector<Write> writes;
+		bool live;
+	};
+
+	bool sortPasses(vector<int>& order);
+	void cullPasses(const vector<int>& order);
+	void buildSteps(const vector<int>& order);
+	void aliasTargets();
+
+	vector<Resource> resources;
+	vector<Pass> passes;
+	vector<Step> steps;
+	vector<TargetDesc> physicalDescs;
+	Stats stats;
+};
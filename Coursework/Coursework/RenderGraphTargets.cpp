@@ -0,0 +1,51 @@
+// Render graph targets
+#include "RenderGraphTargets.h"
+
+RenderGraphTargets::RenderGraphTargets(D3D* lrenderer, RenderTargetPool* lpool)
+{
+	renderer = lrenderer;
+	pool = lpool;
+	graph = 0;
+}
+
+void RenderGraphTargets::allocate(const RenderGraph& lgraph)
+{
+	graph = &lgraph;
+	textures.resize(graph->getPhysicalCount());
+	for (int i = 0; i < graph->getPhysicalCount(); i++) {
+		const RenderGraph::TargetDesc& desc = graph->getPhysicalDesc(i);
+		textures[i] = pool->acquire(desc.width, desc.height, (DXGI_FORMAT)desc.format);
+	}
+}
+
+void RenderGraphTargets::bind(const RenderGraph& lgraph, int resource)
+{
+	if (lgraph.isImported(resource)) {
+		renderer->setBackBufferRenderTarget();
+		renderer->resetViewport();
+	}
+	else {
+		get(resource)->setRenderTarget(renderer->getDeviceContext());
+	}
+}
+
+void RenderGraphTargets::clear(const RenderGraph& lgraph, int resource)
+{
+	if (lgraph.isImported(resource))
+		renderer->beginScene(0.05f, 0.05f, 0.05f, 1.0f);
+	else
+		get(resource)->clearRenderTarget(renderer->getDeviceContext(), 0.05f, 0.05f, 0.05f, 1.0f);
+}
+
+void RenderGraphTargets::release(const RenderGraph& lgraph)
+{
+	for (size_t i = 0; i < textures.size(); i++)
+		pool->release(textures[i]);
+	textures.clear();
+	graph = 0;
+}
+
+RenderTexture* RenderGraphTargets::get(int resource)
+{
+	return textures[graph->getPhysical(resource)];
+}
@@ -0,0 +1,27 @@
+// Render graph targets
+// Runs a RenderGraph with RenderTextures. Each physical target gets a texture from the pool for the frame, and the only
+// imported target a pass can draw to is the back buffer.
+#pragma once
+
+#include "DXF.h"
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+
+class RenderGraphTargets : public RenderGraph::Executor
+{
+public:
+	RenderGraphTargets(D3D* renderer, RenderTargetPool* pool);
+
+	void allocate(const RenderGraph& graph);
+	void bind(const RenderGraph& graph, int resource);
+	void clear(const RenderGraph& graph, int resource);
+	void release(const RenderGraph& graph);
+
+	RenderTexture* get(int resource); // the texture behind a transient target, only valid while the graph is executing
+
+private:
+	D3D* renderer;
+	RenderTargetPool* pool;
+	const RenderGraph* graph;
+	vector<RenderTexture*> textures;
+};
@@ -0,0 +1,98 @@
+// Render target pool
+#include "RenderTargetPool.h"
+
+RenderTargetPool::RenderTargetPool(ID3D11Device* ldevice, float lscreenNear, float lscreenDepth, int lidleFrames)
+{
+	device = ldevice;
+	screenNear = lscreenNear;
+	screenDepth = lscreenDepth;
+	idleFrames = lidleFrames;
+	frame = 0;
+	liveCount = 0;
+	liveMemory = 0;
+	ZeroMemory(&current, sizeof(Stats));
+	ZeroMemory(&stats, sizeof(Stats));
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	for (size_t i = 0; i < entries.size(); i++)
+		delete entries[i].texture;
+	entries.clear();
+}
+
+void RenderTargetPool::beginFrame()
+{
+	frame++;
+
+	// drop targets no pass has asked for recently, swapping with the back keeps the vector packed
+	for (size_t i = 0; i < entries.size();) {
+		if (!entries[i].inUse && frame - entries[i].lastUsed > idleFrames) {
+			delete entries[i].texture;
+			entries[i] = entries.back();
+			entries.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+
+	current.textures = (int)entries.size();
+	current.memory = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+		current.memory += entries[i].texture->getMemorySize();
+
+	stats = current;
+	ZeroMemory(&current, sizeof(Stats));
+	current.peakLive = liveCount;
+	current.peakLiveMemory = liveMemory;
+}
+
+RenderTexture* RenderTargetPool::acquire(int width, int height, DXGI_FORMAT format)
+{
+	current.requests++;
+
+	Entry* found = 0;
+	for (size_t i = 0; i < entries.size(); i++) {
+		RenderTexture* texture = entries[i].texture;
+		if (!entries[i].inUse && texture->getTextureWidth() == width && texture->getTextureHeight() == height && texture->getFormat() == format) {
+			found = &entries[i];
+			break;
+		}
+	}
+
+	if (found) {
+		current.reuses++;
+	}
+	else {
+		Entry entry;
+		entry.texture = new RenderTexture(device, width, height, screenNear, screenDepth, format);
+		entries.push_back(entry);
+		found = &entries.back();
+		current.allocations++;
+	}
+
+	found->inUse = true;
+	found->lastUsed = frame;
+
+	liveCount++;
+	liveMemory += found->texture->getMemorySize();
+	if (liveCount > current.peakLive)
+		current.peakLive = liveCount;
+	if (liveMemory > current.peakLiveMemory)
+		current.peakLiveMemory = liveMemory;
+
+	return found->texture;
+}
+
+void RenderTargetPool::release(RenderTexture* target)
+{
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].texture == target && entries[i].inUse) {
+			entries[i].inUse = false;
+			liveCount--;
+			liveMemory -= target->getMemorySize();
+			return;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+// Render target pool
+// Hands out transient render textures by size and format for the span of a pass. A released target goes back to the
+// pool and the next pass asking for the same size and format reuses it, so targets whose lifetimes don't overlap
+// share one texture and only the frame's peak working set is ever allocated.
+// Targets left unused for a while are freed, so switching to a lighter post process mode gives the memory back.
+#pragma once
+
+#include "DXF.h"
+#include <vector>
+
+using namespace std;
+
+class RenderTargetPool
+{
+public:
+	// counts for the last finished frame, memory is the pool's current total
+	struct Stats
+	{
+		int requests; // acquire calls
+		int reuses; // acquires served by a texture already in the pool
+		int allocations; // acquires that had to create a texture
+		int peakLive; // most targets in use at once
+		size_t peakLiveMemory; // most bytes in use at once
+		int textures; // textures the pool holds, in use or free
+		size_t memory;
+	};
+
+	RenderTargetPool(ID3D11Device* device, float screenNear, float screenDepth, int idleFrames = 120);
+	~RenderTargetPool();
+
+	void beginFrame(); // finishes the last frame's stats and frees targets that have been idle for idleFrames
+	RenderTexture* acquire(int width, int height, DXGI_FORMAT format = DXGI_FORMAT_R32G32B32A32_FLOAT);
+	void release(RenderTexture* target); // the target's contents can be overwritten by the next acquire after this
+
+	const Stats& getStats() { return stats; };
+	int getLiveCount() { return liveCount; };
+
+private:
+	struct Entry
+	{
+		RenderTexture* texture;
+		bool inUse;
+		int lastUsed; // frame it was last acquired
+	};
+
+	ID3D11Device* device;
+	float screenNear;
+	float screenDepth;
+	int idleFrames;
+	int frame;
+
+	vector<Entry> entries;
+	int liveCount;
+	size_t liveMemory;
+	Stats current; // being counted this frame
+	Stats stats;
+};
@@ -0,0 +1,139 @@
+// Shadow atlas
+#include "ShadowAtlas.h"
+
+ShadowAtlas::ShadowAtlas(int maxAtlasSize, DXGI_FORMAT format) : packer(maxAtlasSize)
+{
+	map = 0;
+	width = 0;
+	height = 0;
+	failed = false;
+	depthFormat = format;
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	if (map)
+	{
+		delete map;
+		map = 0;
+	}
+}
+
+void ShadowAtlas::clearRequests()
+{
+	requests.clear();
+}
+
+int ShadowAtlas::requestTile(int size)
+{
+	requests.push_back(size);
+	return (int)requests.size() - 1;
+}
+
+bool ShadowAtlas::pack(ID3D11Device* device)
+{
+	// nothing to do if the lights want the same tiles as last frame
+	bool formatChanged = map && map->getFormat() != depthFormat;
+	// or they still don't fit
+	if (requests == packedRequests && !formatChanged && (map || requests.empty() || failed))
+		return false;
+
+	packedRequests = requests;
+	tiles.clear();
+	width = 0;
+	height = 0;
+
+	if (map)
+	{
+		delete map;
+		map = 0;
+	}
+
+	failed = !packer.pack(requests);
+	if (failed || requests.empty())
+		return true;
+
+	// work out where each tile lives in uv space now the final size is known
+	width = packer.getWidth();
+	height = packer.getHeight();
+	const vector<AtlasPacker::Rect>& rects = packer.getRects();
+	tiles.resize(rects.size());
+	for (int i = 0; i < (int)rects.size(); i++) {
+		Tile& tile = tiles[i];
+		tile.size = rects[i].size;
+		tile.viewport.TopLeftX = (float)rects[i].x;
+		tile.viewport.TopLeftY = (float)rects[i].y;
+		tile.viewport.Width = (float)rects[i].size;
+		tile.viewport.Height = (float)rects[i].size;
+		tile.viewport.MinDepth = 0.0f;
+		tile.viewport.MaxDepth = 1.0f;
+		tile.uvRect.x = rects[i].size / (float)width;
+		tile.uvRect.y = rects[i].size / (float)height;
+		tile.uvRect.z = rects[i].x / (float)width;
+		tile.uvRect.w = rects[i].y / (float)height;
+	}
+
+	map = new ShadowMap(device, width, height, 1, false, depthFormat);
+	return true;
+}
+
+void ShadowAtlas::bindAndClear(ID3D11DeviceContext* dc)
+{
+	// clears the whole atlas once, each light then only sets its own viewport
+	if (map)
+		map->BindDsvAndSetNullRenderTarget(dc);
+}
+
+void ShadowAtlas::setTileViewport(ID3D11DeviceContext* dc, int tile)
+{
+	if (tile >= 0 && tile < (int)tiles.size())
+		dc->RSSetViewports(1, &tiles[tile].viewport);
+}
+
+XMFLOAT4 ShadowAtlas::getTileRect(int tile)
+{
+	if (tile < 0 || tile >= (int)tiles.size())
+		return XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	return tiles[tile].uvRect;
+}
+
+int ShadowAtlas::getTileSize(int tile)
+{
+	if (tile < 0 || tile >= (int)tiles.size())
+		return 0;
+
+	return tiles[tile].size;
+}
+
+XMFLOAT2 ShadowAtlas::getTexelSize()
+{
+	if (!map)
+		return XMFLOAT2(0.0f, 0.0f);
+
+	return XMFLOAT2(1.0f / width, 1.0f / height);
+}
+
+ID3D11ShaderResourceView* ShadowAtlas::getDepthMapSRV()
+{
+	if (!map)
+		return 0;
+
+	return map->getDepthMapSRV();
+}
+
+size_t ShadowAtlas::getMemorySize()
+{
+	if (!map)
+		return 0;
+
+	return map->getMemorySize();
+}
+
+size_t ShadowAtlas::getTileMemorySize(int tile)
+{
+	if (!map || tile < 0 || tile >= (int)tiles.size())
+		return 0;
+
+	return (size_t)tiles[tile].size * tiles[tile].size * map->getBytesPerTexel();
+}
@@ -0,0 +1,62 @@
+// Shadow atlas
+// Packs every light's depth views into a single shared depth texture.
+// Lights request square tiles each frame, the layout is only rebuilt when the requests change.
+// The layout itself comes from AtlasPacker.
+#pragma once
+
+#include "DXF.h"
+#include "AtlasPacker.h"
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+class ShadowAtlas
+{
+public:
+	struct Tile
+	{
+		D3D11_VIEWPORT viewport; // region of the atlas rendered to by the depth pass
+		XMFLOAT4 uvRect; // xy = uv scale, zw = uv offset. maps a light's projected coords into the atlas
+		int size;
+	};
+
+	ShadowAtlas(int maxAtlasSize = 8192, DXGI_FORMAT format = DXGI_FORMAT_D32_FLOAT);
+	~ShadowAtlas();
+
+	void clearRequests(); // call before requesting this frame's tiles
+	int requestTile(int size); // returns the tile's index, the tile is valid after pack()
+	// repacks and reallocates if the requests or format changed, returns true if the layout changed. if the requests
+	// don't fit the atlas is released and hasFailed() is true until a later pack fits
+	bool pack(ID3D11Device* device);
+	bool hasFailed() { return failed; };
+	void setFormat(DXGI_FORMAT format) { depthFormat = format; }; // takes effect on the next pack()
+
+	void bindAndClear(ID3D11DeviceContext* dc); // binds the atlas as the depth target and clears every tile
+	void setTileViewport(ID3D11DeviceContext* dc, int tile); // restricts the depth pass to a single tile
+
+	XMFLOAT4 getTileRect(int tile);
+	int getTileSize(int tile); // size after any scaling to fit the atlas
+	XMFLOAT2 getTexelSize();
+	ID3D11ShaderResourceView* getDepthMapSRV();
+
+	int getWidth() { return width; };
+	int getHeight() { return height; };
+	int getTileCount() { return (int)tiles.size(); };
+	int getScaleShift() { return packer.getScaleShift(); };
+	int getMaxSize() { return packer.getMaxSize(); };
+	DXGI_FORMAT getFormat() { return depthFormat; };
+	size_t getMemorySize(); // bytes used by the whole atlas, including unused space
+	size_t getTileMemorySize(int tile); // bytes used by a single tile
+
+private:
+	ShadowMap* map;
+	AtlasPacker packer;
+	vector<int> requests;
+	vector<int> packedRequests; // the requests the current layout was built from
+	vector<Tile> tiles;
+	int width;
+	int height;
+	bool failed;
+	DXGI_FORMAT depthFormat;
+};
@@ -0,0 +1,67 @@
+// Shadow math
+// Shared by the C++ code and the HLSL shaders so the CPU has a reference copy of the shadow lookups.
+// Only use the small part of HLSL that HlslShim.h provides.
+#ifndef _SHADOWMATH_H
+#define _SHADOWMATH_H
+
+#ifdef __cplusplus
+#include "HlslShim.h"
+#endif
+
+// PROJECTION
+// clip space position from a light's view and projection matrices to shadow map texture coordinates
+inline float2 getProjectiveCoords(float4 lightViewPosition)
+{
+	return float2(lightViewPosition.x / lightViewPosition.w * 0.5f + 0.5f, lightViewPosition.y / lightViewPosition.w * -0.5f + 0.5f);
+}
+
+// PCF
+// shadow lookups average a square of (PCF_RADIUS * 2 + 1)^2 depth comparisons, each weighted equally
+static const int PCF_RADIUS = 2;
+
+inline float pcfWeight(int radius)
+{
+	return 1.0f / (float)((radius * 2 + 1) * (radius * 2 + 1));
+}
+
+// CUBE FACES
+// the face a point light's cube stores a pixel in, from the dominant axis of the light to pixel vector.
+// faces are in the same order as App1's dirs: -y, +y, +x, -x, +z, -z
+inline int cubeFaceIndex(float3 lightToPixel)
+{
+	float x = lightToPixel.x < 0.0f ? -lightToPixel.x : lightToPixel.x;
+	float y = lightToPixel.y < 0.0f ? -lightToPixel.y : lightToPixel.y;
+	float z = lightToPixel.z < 0.0f ? -lightToPixel.z : lightToPixel.z;
+
+	if (y >= x && y >= z)
+		return lightToPixel.y < 0.0f ? 0 : 1;
+	if (x >= z)
+		return lightToPixel.x > 0.0f ? 2 : 3;
+	return lightToPixel.z > 0.0f ? 4 : 5;
+}
+
+// DUAL PARABOLOID
+// a paraboloid faces down +z of its view space and covers that whole hemisphere.
+// projected xy is the position on the paraboloid's disc in [-1, 1], z is the linear depth between the near and far planes
+inline float3 paraboloidProject(float3 viewPosition, float nearPlane, float farPlane)
+{
+	float dist = length(viewPosition);
+	float3 direction = viewPosition / dist;
+	return float3(direction.x / (1.0f + direction.z), direction.y / (1.0f + direction.z), (dist - nearPlane) / (farPlane - nearPlane));
+}
+
+// inverse of paraboloidProject, returns the view space position
+inline float3 paraboloidUnproject(float3 projected, float nearPlane, float farPlane)
+{
+	float r2 = projected.x * projected.x + projected.y * projected.y;
+	float3 direction = float3(2.0f * projected.x, 2.0f * projected.y, 1.0f - r2) / (1.0f + r2);
+	return direction * (nearPlane + projected.z * (farPlane - nearPlane));
+}
+
+// disc coordinates to texture coordinates, matching getProjectiveCoords in the pixel shaders
+inline float2 paraboloidToUV(float3 projected)
+{
+	return float2(projected.x * 0.5f + 0.5f, projected.y * -0.5f + 0.5f);
+}
+
+#endif
@@ -5,14 +5,6 @@
 ShadowShader::ShadowShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
 {
 	initShader(L"shadow_vs.cso", L"shadow_ps.cso");
-
-	// initialise the point light faces
-	dirs[0] = XMFLOAT3(0.0f, -1.0f, 0.0f);
-	dirs[1] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-	dirs[2] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-	dirs[3] = XMFLOAT3(-1.0f, 0.0f, 0.0f);
-	dirs[4] = XMFLOAT3(0.0f, 0.0f, 1.0f);
-	dirs[5] = XMFLOAT3(0.0f, 0.0f, -1.0f);
 }
 
 
@@ -33,11 +25,6 @@ ShadowShader::~ShadowShader()
 		layout->Release();
 		layout = 0;
 	}
-	if (lightBuffer)
-	{	
-		lightBuffer->Release();
-		lightBuffer = 0;
-	}
 
 	//Release base shader components
 	BaseShader::~BaseShader();
@@ -48,7 +35,6 @@ void ShadowShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilena
 {
 	D3D11_BUFFER_DESC matrixBufferDesc;
 	D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
 	D3D11_BUFFER_DESC cameraBufferDesc;
 
 	// Load (+ compile) shader files
@@ -87,15 +73,6 @@ void ShadowShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilena
 	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
 	renderer->CreateSamplerState(&samplerDesc, &sampleStateShadow);
 
-	// Setup light buffer
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-	renderer->CreateBuffer(&lightBufferDesc, NULL, &lightBuffer);
-
 	cameraBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 	cameraBufferDesc.ByteWidth = sizeof(CameraBufferType);
 	cameraBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
@@ -107,8 +84,7 @@ void ShadowShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilena
 }
 
 void ShadowShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, 
-	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, ShadowMap* depthMap[4][6], float mapBias[4], Light* light[4],
-	float atten[4], int lType[4], float oAngle[4], float iAngle[4], float falloff[4], Camera* cam)
+	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, LightFrameData* lightFrame, Camera* cam)
 {
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	MatrixBufferType* dataPtr;
@@ -125,30 +101,6 @@ void ShadowShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const
 	dataPtr->view = tview;
 	dataPtr->projection = tproj;
 
-	// loop through all the lights
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			if (lType[i] == 0) {
-				// if it's a point light, generate a new view matrix
-				light[i]->setDirection(dirs[j].x, dirs[j].y, dirs[j].z);
-				light[i]->generateViewMatrix();
-			}
-
-			// set the view matrices
-			dataPtr->lightView[i][j] = XMMatrixTranspose(light[i]->getViewMatrix());
-		}
-
-		if (lType[i] == 1) {
-			// if it's a directional light, use an ortho matrix
-			dataPtr->lightProjection[i] = XMMatrixTranspose(light[i]->getOrthoMatrix());
-		}
-		else {
-			// else set it to the projection matrix
-			dataPtr->lightProjection[i] = XMMatrixTranspose(light[i]->getProjectionMatrix());
-		}
-	}	
-
-
 	deviceContext->Unmap(matrixBuffer, 0);
 	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
 
@@ -163,46 +115,13 @@ void ShadowShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const
 	deviceContext->Unmap(cameraBuffer, 0);
 	deviceContext->VSSetConstantBuffers(2, 1, &cameraBuffer);
 
-	//Additional
-	// Send light data to pixel shader
-	LightBufferType* lightPtr;
-	deviceContext->Map(lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	lightPtr = (LightBufferType*)mappedResource.pData;
-
-	for (int i = 0; i < 4; i++) {
-		lightPtr->ambient[i] = light[i]->getAmbientColour();
-		lightPtr->diffuse[i] = light[i]->getDiffuseColour();
-		lightPtr->position[i] = XMFLOAT4(light[i]->getPosition().x, light[i]->getPosition().y, light[i]->getPosition().z, 1.0f);
-		lightPtr->direction[i] = XMFLOAT4(light[i]->getDirection().x, light[i]->getDirection().y, light[i]->getDirection().z, 1.0f);
-
-		lightPtr->specularColour[i] = light[i]->getSpecularColour();
-		lightPtr->specularPower[i] = light[i]->getSpecularPower();
-		lightPtr->outerAngle[i] = cos(XMConvertToRadians(oAngle[i]));
-		lightPtr->innerAngle[i] = cos(XMConvertToRadians(iAngle[i]));
-		lightPtr->fall[i] = falloff[i];
-		lightPtr->type[i] = lType[i];
-		lightPtr->attenuation[i] = atten[i];
-		lightPtr->bias[i] = mapBias[i];
-	}
-
-	deviceContext->Unmap(lightBuffer, 0);
-	deviceContext->PSSetConstantBuffers(0, 1, &lightBuffer);
+	// light data is built once a frame, each draw only binds it
+	lightFrame->bind(deviceContext);
 
 	// Set shader texture resource in the pixel shader.
 
 	deviceContext->PSSetShaderResources(0, 1, &texture);
 
-	// set the depthMaps
-	ID3D11ShaderResourceView* map;
-	int reg = 1;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 6; j++) {
-			map = depthMap[i][j]->getDepthMapSRV();
-			deviceContext->PSSetShaderResources(reg, 1, &map);
-			reg++;
-		}
-	}
-
 	deviceContext->PSSetSamplers(0, 1, &sampleState);
 	deviceContext->PSSetSamplers(1, 1, &sampleStateShadow);
 }
@@ -0,0 +1,55 @@
+// Stacked boxes
+#include "StackedBoxes.h"
+#include <math.h>
+
+// each box's half width in standard deviations for 1 to MAX_STACKED_BOXES boxes, the sizes with the least total
+// difference from a gaussian kernel. the gaussian past the largest box is dropped
+static const float BOX_EXTENTS[MAX_STACKED_BOXES][MAX_STACKED_BOXES] = {
+	{ 1.64f },
+	{ 1.16f, 2.0f },
+	{ 0.92f, 1.52f, 2.24f },
+	{ 0.68f, 1.16f, 1.64f, 2.24f },
+};
+
+// how much of a 2D gaussian lies inside a square reaching extent out from the centre
+static double massInside(double extent, double sigma)
+{
+	double edge = erf(extent / (sigma * sqrt(2.0)));
+	return edge * edge;
+}
+
+StackedBoxes makeStackedBoxes(float sigma, int count)
+{
+	StackedBoxes boxes = {};
+	count = count < 1 ? 1 : (count > MAX_STACKED_BOXES ? MAX_STACKED_BOXES : count);
+	sigma = sigma < 0.1f ? 0.1f : sigma;
+	boxes.count = count;
+
+	// whole texel radii, each box at least a texel bigger than the one inside it
+	for (int i = 0; i < count; i++) {
+		int radius = (int)floor(BOX_EXTENTS[count - 1][i] * sigma + 0.5);
+		int smallest = (i == 0) ? 0 : boxes.radii[i - 1] + 1;
+		boxes.radii[i] = radius < smallest ? smallest : radius;
+	}
+
+	// the height of each ring is the gaussian's mass in it over the ring's area. a box covers texels -r to r, so its edge
+	// is r + 0.5 out
+	double heights[MAX_STACKED_BOXES + 1] = {};
+	double areas[MAX_STACKED_BOXES] = {};
+	double innerMass = 0.0;
+	double innerArea = 0.0;
+	double total = massInside(boxes.radii[count - 1] + 0.5, sigma);
+	for (int i = 0; i < count; i++) {
+		double extent = boxes.radii[i] + 0.5;
+		double mass = massInside(extent, sigma) / total;
+		areas[i] = 4.0 * extent * extent;
+		heights[i] = (mass - innerMass) / (areas[i] - innerArea);
+		innerMass = mass;
+		innerArea = areas[i];
+	}
+
+	// each box adds the step down from its ring to the next one out across its whole area
+	for (int i = 0; i < count; i++)
+		boxes.weights[i] = (float)((heights[i] - heights[i + 1]) * areas[i]);
+	return boxes;
+}
@@ -0,0 +1,18 @@
+// Stacked boxes
+// A gaussian approximated by a few concentric box averages added together, so a summed area table can blur with the
+// same handful of lookups whatever the radius. Each ring between two boxes gets the gaussian's average over it, which
+// makes a stepped pyramid with square rings, and the boxes' sizes are the ones that fit the gaussian closest.
+// Doesn't depend on D3D
+#pragma once
+
+static const int MAX_STACKED_BOXES = 4;
+
+struct StackedBoxes
+{
+	int count;
+	int radii[MAX_STACKED_BOXES]; // texels either side of the centre, smallest first
+	float weights[MAX_STACKED_BOXES]; // of each box's average, they add up to one
+};
+
+// sigma is in texels, count is 1 to MAX_STACKED_BOXES
+StackedBoxes makeStackedBoxes(float sigma, int count = 3);
@@ -0,0 +1,101 @@
+// Summed area table box shader
+#include "SummedAreaBoxShader.h"
+
+
+SummedAreaBoxShader::SummedAreaBoxShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	initShader(L"summedArea_vs.cso", L"summedAreaBox_ps.cso");
+}
+
+
+SummedAreaBoxShader::~SummedAreaBoxShader()
+{
+	if (matrixBuffer)
+	{
+		matrixBuffer->Release();
+		matrixBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+	if (boxBuffer)
+	{
+		boxBuffer->Release();
+		boxBuffer = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+
+void SummedAreaBoxShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	D3D11_BUFFER_DESC matrixBufferDesc;
+	D3D11_BUFFER_DESC boxBufferDesc;
+
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+	loadPixelShader(psFilename);
+
+	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
+	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	matrixBufferDesc.MiscFlags = 0;
+	matrixBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
+
+	// Setup the description of the box buffer.
+	boxBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	boxBufferDesc.ByteWidth = sizeof(BoxBufferType);
+	boxBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	boxBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	boxBufferDesc.MiscFlags = 0;
+	boxBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&boxBufferDesc, NULL, &boxBuffer);
+
+}
+
+void SummedAreaBoxShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* table, const StackedBoxes& boxes)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	MatrixBufferType* dataPtr;
+	XMMATRIX tworld, tview, tproj;
+
+	// Transpose the matrices to prepare them for the shader.
+	tworld = XMMatrixTranspose(worldMatrix);
+	tview = XMMatrixTranspose(viewMatrix);
+	tproj = XMMatrixTranspose(projectionMatrix);
+
+	deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr->world = tworld;
+	dataPtr->view = tview;
+	dataPtr->projection = tproj;
+	deviceContext->Unmap(matrixBuffer, 0);
+	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	// boxes past the count weigh nothing
+	BoxBufferType* boxPtr;
+	deviceContext->Map(boxBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	boxPtr = (BoxBufferType*)mappedResource.pData;
+	int radii[MAX_STACKED_BOXES] = {};
+	float weights[MAX_STACKED_BOXES] = {};
+	for (int i = 0; i < boxes.count; i++) {
+		radii[i] = boxes.radii[i];
+		weights[i] = boxes.weights[i];
+	}
+	boxPtr->radii = XMINT4(radii[0], radii[1], radii[2], radii[3]);
+	boxPtr->weights = XMFLOAT4(weights[0], weights[1], weights[2], weights[3]);
+	boxPtr->boxCount = boxes.count;
+	boxPtr->padding = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	deviceContext->Unmap(boxBuffer, 0);
+	deviceContext->PSSetConstantBuffers(0, 1, &boxBuffer);
+
+	// Set shader texture resource in the pixel shader.
+	deviceContext->PSSetShaderResources(0, 1, &table);
+}
@@ -0,0 +1,37 @@
+// Summed area table box shader handler
+// Loads the summed area box shaders (vs and ps)
+// Passes the stacked boxes' radii and weights, the shader only loads texels so there's no sampler
+#pragma once
+
+#include "DXF.h"
+#include "StackedBoxes.h"
+
+using namespace std;
+using namespace DirectX;
+
+class SummedAreaBoxShader : public BaseShader
+{
+private:
+	struct BoxBufferType
+	{
+		XMINT4 radii;
+		XMFLOAT4 weights;
+		int boxCount;
+		XMFLOAT3 padding;
+	};
+
+public:
+
+	SummedAreaBoxShader(ID3D11Device* device, HWND hwnd);
+	~SummedAreaBoxShader();
+
+	// table is the summed area table, a texel bigger each way than the target
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* table, const StackedBoxes& boxes);
+
+private:
+	void initShader(const wchar_t* vs, const wchar_t* ps);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11Buffer* boxBuffer;
+};
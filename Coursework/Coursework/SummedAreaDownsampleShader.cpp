@@ -0,0 +1,117 @@
+// Summed area table downsample shader
+#include "SummedAreaDownsampleShader.h"
+
+
+SummedAreaDownsampleShader::SummedAreaDownsampleShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	initShader(L"summedArea_vs.cso", L"summedAreaDownsample_ps.cso");
+}
+
+
+SummedAreaDownsampleShader::~SummedAreaDownsampleShader()
+{
+	if (sampleState)
+	{
+		sampleState->Release();
+		sampleState = 0;
+	}
+	if (matrixBuffer)
+	{
+		matrixBuffer->Release();
+		matrixBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+	if (downsampleBuffer)
+	{
+		downsampleBuffer->Release();
+		downsampleBuffer = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+
+void SummedAreaDownsampleShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	D3D11_BUFFER_DESC matrixBufferDesc;
+	D3D11_SAMPLER_DESC samplerDesc;
+	D3D11_BUFFER_DESC downsampleBufferDesc;
+
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+	loadPixelShader(psFilename);
+
+	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
+	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	matrixBufferDesc.MiscFlags = 0;
+	matrixBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
+
+	// Create a texture sampler state description.
+	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.BorderColor[0] = 0;
+	samplerDesc.BorderColor[1] = 0;
+	samplerDesc.BorderColor[2] = 0;
+	samplerDesc.BorderColor[3] = 0;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	renderer->CreateSamplerState(&samplerDesc, &sampleState);
+
+	// Setup the description of the downsample buffer.
+	downsampleBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	downsampleBufferDesc.ByteWidth = sizeof(DownsampleBufferType);
+	downsampleBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	downsampleBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	downsampleBufferDesc.MiscFlags = 0;
+	downsampleBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&downsampleBufferDesc, NULL, &downsampleBuffer);
+
+}
+
+void SummedAreaDownsampleShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, int width, int height,
+		bool thresholdEnabled, float threshold)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	MatrixBufferType* dataPtr;
+	XMMATRIX tworld, tview, tproj;
+
+	// Transpose the matrices to prepare them for the shader.
+	tworld = XMMatrixTranspose(worldMatrix);
+	tview = XMMatrixTranspose(viewMatrix);
+	tproj = XMMatrixTranspose(projectionMatrix);
+
+	deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr->world = tworld;
+	dataPtr->view = tview;
+	dataPtr->projection = tproj;
+	deviceContext->Unmap(matrixBuffer, 0);
+	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	DownsampleBufferType* downsamplePtr;
+	deviceContext->Map(downsampleBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	downsamplePtr = (DownsampleBufferType*)mappedResource.pData;
+	downsamplePtr->cellSize = XMFLOAT2(1.0f / width, 1.0f / height);
+	downsamplePtr->threshold = threshold;
+	downsamplePtr->thresholdEnabled = thresholdEnabled ? 1 : 0;
+	deviceContext->Unmap(downsampleBuffer, 0);
+	deviceContext->PSSetConstantBuffers(0, 1, &downsampleBuffer);
+
+	// Set shader texture resource in the pixel shader.
+	deviceContext->PSSetShaderResources(0, 1, &texture);
+	deviceContext->PSSetSamplers(0, 1, &sampleState);
+}
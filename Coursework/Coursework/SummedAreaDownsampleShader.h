@@ -0,0 +1,37 @@
+// Summed area table downsample shader handler
+// Loads the summed area downsample shaders (vs and ps)
+// Passes the downsampled image's texel size, bloom also thresholds
+#pragma once
+
+#include "DXF.h"
+
+using namespace std;
+using namespace DirectX;
+
+class SummedAreaDownsampleShader : public BaseShader
+{
+private:
+	struct DownsampleBufferType
+	{
+		XMFLOAT2 cellSize;
+		float threshold;
+		int thresholdEnabled;
+	};
+
+public:
+
+	SummedAreaDownsampleShader(ID3D11Device* device, HWND hwnd);
+	~SummedAreaDownsampleShader();
+
+	// width and height are the downsampled image's, the target is a texel bigger each way for the table's zero edges
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, int width, int height,
+		bool thresholdEnabled = false, float threshold = 0.0f);
+
+private:
+	void initShader(const wchar_t* vs, const wchar_t* ps);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11SamplerState* sampleState;
+	ID3D11Buffer* downsampleBuffer;
+};
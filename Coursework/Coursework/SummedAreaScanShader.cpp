@@ -0,0 +1,93 @@
+// Summed area table scan shader
+#include "SummedAreaScanShader.h"
+
+
+SummedAreaScanShader::SummedAreaScanShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+{
+	initShader(L"summedArea_vs.cso", L"summedAreaScan_ps.cso");
+}
+
+
+SummedAreaScanShader::~SummedAreaScanShader()
+{
+	if (matrixBuffer)
+	{
+		matrixBuffer->Release();
+		matrixBuffer = 0;
+	}
+	if (layout)
+	{
+		layout->Release();
+		layout = 0;
+	}
+	if (scanBuffer)
+	{
+		scanBuffer->Release();
+		scanBuffer = 0;
+	}
+
+	//Release base shader components
+	BaseShader::~BaseShader();
+}
+
+
+void SummedAreaScanShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	D3D11_BUFFER_DESC matrixBufferDesc;
+	D3D11_BUFFER_DESC scanBufferDesc;
+
+	// Load (+ compile) shader files
+	loadVertexShader(vsFilename);
+	loadPixelShader(psFilename);
+
+	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
+	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	matrixBufferDesc.MiscFlags = 0;
+	matrixBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&matrixBufferDesc, NULL, &matrixBuffer);
+
+	// Setup the description of the scan buffer.
+	scanBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	scanBufferDesc.ByteWidth = sizeof(ScanBufferType);
+	scanBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	scanBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	scanBufferDesc.MiscFlags = 0;
+	scanBufferDesc.StructureByteStride = 0;
+	renderer->CreateBuffer(&scanBufferDesc, NULL, &scanBuffer);
+
+}
+
+void SummedAreaScanShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, XMINT2 direction, int stride)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	MatrixBufferType* dataPtr;
+	XMMATRIX tworld, tview, tproj;
+
+	// Transpose the matrices to prepare them for the shader.
+	tworld = XMMatrixTranspose(worldMatrix);
+	tview = XMMatrixTranspose(viewMatrix);
+	tproj = XMMatrixTranspose(projectionMatrix);
+
+	deviceContext->Map(matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr->world = tworld;
+	dataPtr->view = tview;
+	dataPtr->projection = tproj;
+	deviceContext->Unmap(matrixBuffer, 0);
+	deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
+
+	ScanBufferType* scanPtr;
+	deviceContext->Map(scanBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	scanPtr = (ScanBufferType*)mappedResource.pData;
+	scanPtr->direction = direction;
+	scanPtr->stride = stride;
+	scanPtr->padding = 0;
+	deviceContext->Unmap(scanBuffer, 0);
+	deviceContext->PSSetConstantBuffers(0, 1, &scanBuffer);
+
+	// Set shader texture resource in the pixel shader.
+	deviceContext->PSSetShaderResources(0, 1, &texture);
+}
@@ -0,0 +1,35 @@
+// Summed area table scan shader handler
+// Loads the summed area scan shaders (vs and ps)
+// Passes the direction and stride of one prefix sum pass, the shader only loads texels so there's no sampler
+#pragma once
+
+#include "DXF.h"
+
+using namespace std;
+using namespace DirectX;
+
+class SummedAreaScanShader : public BaseShader
+{
+private:
+	struct ScanBufferType
+	{
+		XMINT2 direction;
+		int stride;
+		int padding;
+	};
+
+public:
+
+	SummedAreaScanShader(ID3D11Device* device, HWND hwnd);
+	~SummedAreaScanShader();
+
+	// direction is (1, 0) along the rows or (0, 1) down the columns, stride is 1 for the first pass then 4 times the last
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, XMINT2 direction, int stride);
+
+private:
+	void initShader(const wchar_t* vs, const wchar_t* ps);
+
+private:
+	ID3D11Buffer* matrixBuffer;
+	ID3D11Buffer* scanBuffer;
+};
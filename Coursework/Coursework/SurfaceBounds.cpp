@@ -0,0 +1,81 @@
+// Surface bounds
+#include "SurfaceBounds.h"
+
+SurfaceBounds::SurfaceBounds()
+{
+	sphereRadius = 0.0f;
+}
+
+void SurfaceBounds::update(float heightMin, float heightMax, float heightAmplitude, float2 waveAmplitude, float planeToSphere, float4 sphere,
+	float planeExtent, float3 worldOffset)
+{
+	// the waves are averaged, so they move a vertex at most half their combined amplitude either way
+	float wave = (fabsf(waveAmplitude.x) + fabsf(waveAmplitude.y)) / 2.0f;
+	float lowest = (heightAmplitude < 0.0f ? heightMax : heightMin) * heightAmplitude - wave;
+	float highest = (heightAmplitude < 0.0f ? heightMin : heightMax) * heightAmplitude + wave;
+
+	// flat plane, the heights only move vertices along y
+	float3 flatMin(0.0f, lowest, 0.0f);
+	float3 flatMax(planeExtent, highest, planeExtent);
+	float3 flatCentre = (flatMin + flatMax) / 2.0f;
+	float flatRadius = length(flatMax - flatCentre);
+
+	// on the sphere the height is added to the radius, so every vertex is within the larger of the two radii
+	float sphereReach = fmaxf(fabsf(sphere.w + lowest), fabsf(sphere.w + highest));
+	float3 centre(sphere.x, sphere.y, sphere.z);
+	float3 reach(sphereReach, sphereReach, sphereReach);
+
+	// a vertex is lerp(flat, onSphere, t), so it's within the same lerp of the two boxes, and of the two spheres
+	float t = saturate(planeToSphere);
+	boxMin = lerp(flatMin, centre - reach, t) + worldOffset;
+	boxMax = lerp(flatMax, centre + reach, t) + worldOffset;
+
+	// use whichever sphere is tighter, the lerp'd one or the one around the box
+	float3 boxCentre = (boxMin + boxMax) / 2.0f;
+	float boxRadius = length(boxMax - boxCentre);
+	float lerpRadius = flatRadius * (1.0f - t) + sphereReach * t;
+	if (lerpRadius < boxRadius) {
+		sphereCentre = lerp(flatCentre, centre, t) + worldOffset;
+		sphereRadius = lerpRadius;
+	}
+	else {
+		sphereCentre = boxCentre;
+		sphereRadius = boxRadius;
+	}
+}
+
+bool SurfaceBounds::contains(float3 point) const
+{
+	// small tolerance for float error at the edges
+	float epsilon = 1e-3f;
+	if (point.x < boxMin.x - epsilon || point.y < boxMin.y - epsilon || point.z < boxMin.z - epsilon)
+		return false;
+	if (point.x > boxMax.x + epsilon || point.y > boxMax.y + epsilon || point.z > boxMax.z + epsilon)
+		return false;
+	return length(point - sphereCentre) <= sphereRadius + epsilon;
+}
+
+bool SurfaceBounds::intersects(const float viewProjection[4][4]) const
+{
+	// count the box's corners outside each clip plane: -w < x < w, -w < y < w, 0 < z < w
+	int outside[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 8; i++) {
+		float3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+		float clip[4];
+		for (int c = 0; c < 4; c++)
+			clip[c] = corner.x * viewProjection[0][c] + corner.y * viewProjection[1][c] + corner.z * viewProjection[2][c] + viewProjection[3][c];
+
+		outside[0] += clip[0] < -clip[3];
+		outside[1] += clip[0] > clip[3];
+		outside[2] += clip[1] < -clip[3];
+		outside[3] += clip[1] > clip[3];
+		outside[4] += clip[2] < 0.0f;
+		outside[5] += clip[2] > clip[3];
+	}
+
+	for (int p = 0; p < 6; p++) {
+		if (outside[p] == 8)
+			return false;
+	}
+	return true;
+}
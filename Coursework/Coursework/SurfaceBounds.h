@@ -0,0 +1,34 @@
+// Surface bounds
+// Conservative box and sphere around the manipulation plane, from the ranges of everything that moves it:
+// the heightmap, the wave amplitudes and the lerp onto the sphere. Cheap enough to rebuild every frame.
+// Doesn't depend on D3D, matrices are row major for row vectors like DirectXMath's XMFLOAT4X4
+#pragma once
+
+#include "HlslShim.h"
+
+class SurfaceBounds
+{
+public:
+	SurfaceBounds();
+
+	// heightMin and heightMax are the heightmap's range in [0, 1], before heightAmplitude.
+	// waveAmplitude is the x and z wave's amplitude, sphere.w is the sphere's radius.
+	// planeExtent is the flat plane's size in object space, worldOffset is the plane's world translation
+	void update(float heightMin, float heightMax, float heightAmplitude, float2 waveAmplitude, float planeToSphere, float4 sphere,
+		float planeExtent, float3 worldOffset);
+
+	float3 getMin() const { return boxMin; };
+	float3 getMax() const { return boxMax; };
+	float3 getCentre() const { return sphereCentre; };
+	float getRadius() const { return sphereRadius; };
+
+	bool contains(float3 point) const; // inside both the box and the sphere
+	// false only if the whole box is outside one of the clip planes, works for perspective and ortho projections
+	bool intersects(const float viewProjection[4][4]) const;
+
+private:
+	float3 boxMin;
+	float3 boxMax;
+	float3 sphereCentre;
+	float sphereRadius;
+};
@@ -0,0 +1,257 @@
+// Surface query
+#include "SurfaceQuery.h"
+#include "WaveMath.h"
+#include <emmintrin.h>
+
+// four float3s, one per lane
+struct Vector4x3
+{
+	__m128 x, y, z;
+};
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline Vector4x3 cross(const Vector4x3& a, const Vector4x3& b)
+{
+	Vector4x3 result;
+	result.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y));
+	result.y = _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z));
+	result.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x));
+	return result;
+}
+
+static inline __m128 dot(const Vector4x3& a, const Vector4x3& b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+static inline Vector4x3 scale(const Vector4x3& v, __m128 s)
+{
+	Vector4x3 result = { _mm_mul_ps(v.x, s), _mm_mul_ps(v.y, s), _mm_mul_ps(v.z, s) };
+	return result;
+}
+
+static inline Vector4x3 add(const Vector4x3& a, const Vector4x3& b)
+{
+	Vector4x3 result = { _mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y), _mm_add_ps(a.z, b.z) };
+	return result;
+}
+
+static inline Vector4x3 normalize(const Vector4x3& v)
+{
+	return scale(v, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot(v, v))));
+}
+
+// sin and cos of four angles. reduced to [-pi/2, pi/2] then polynomials, accurate to about 1e-7 for angles up to a few thousand
+static inline void sinCos(__m128 x, __m128* sinOut, __m128* cosOut)
+{
+	const __m128 halfPi = _mm_set1_ps(1.57079632679f);
+	const __m128 pi = _mm_set1_ps(3.14159265359f);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	// x - 2pi * round(x / 2pi), 2pi split in two so the reduction keeps its precision
+	__m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.159154943092f))));
+	x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(6.28125f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(0.00193530717958f)));
+
+	// fold [pi/2, pi] back onto [0, pi/2], sin stays the same and cos flips
+	__m128 sign = _mm_and_ps(x, signBit);
+	__m128 folded = _mm_cmpgt_ps(_mm_andnot_ps(signBit, x), halfPi);
+	x = select(folded, _mm_sub_ps(_mm_or_ps(pi, sign), x), x);
+	__m128 cosSign = _mm_and_ps(folded, signBit);
+
+	__m128 x2 = _mm_mul_ps(x, x);
+	__m128 s = _mm_set1_ps(-2.50521083854e-8f);
+	s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(2.75573192240e-6f));
+	s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.98412698413e-4f));
+	s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(8.33333333333e-3f));
+	s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.66666666667e-1f));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+	__m128 c = _mm_set1_ps(2.08767569879e-9f);
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-2.75573192240e-7f));
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(2.48015873016e-5f));
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-1.38888888889e-3f));
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.16666666667e-2f));
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-0.5f));
+	c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f));
+
+	*sinOut = s;
+	*cosOut = _mm_xor_ps(c, cosSign);
+}
+
+SurfaceQuery::SurfaceQuery(const DisplacementField* lfield)
+{
+	field = lfield;
+	settings = Settings();
+	settings.planeResolution = TESSELLATED_PLANE_RESOLUTION;
+}
+
+void SurfaceQuery::setSettings(const Settings& lsettings)
+{
+	settings = lsettings;
+}
+
+void SurfaceQuery::evaluate(float2 uv, float3* position, float3* normal) const
+{
+	float amplitude = settings.heightAmplitude;
+	float3 flat(uv.x * settings.planeResolution, 0.0f, uv.y * settings.planeResolution);
+
+	float h = field->sampleHeightMap(uv.x, uv.y) * amplitude;
+	float hN = field->sampleHeightMap(uv.x, uv.y + HEIGHTMAP_UV_STEP) * amplitude;
+	float hS = field->sampleHeightMap(uv.x, uv.y - HEIGHTMAP_UV_STEP) * amplitude;
+	float hE = field->sampleHeightMap(uv.x + HEIGHTMAP_UV_STEP, uv.y) * amplitude;
+	float hW = field->sampleHeightMap(uv.x - HEIGHTMAP_UV_STEP, uv.y) * amplitude;
+
+	float2 flatXZ(flat.x, flat.z);
+	float height = h + getWaveOffset(flatXZ, settings.waveAmplitude, settings.waveFrequency, settings.waveSpeed, settings.time);
+	float3 vertex = getManipulatedPosition(flat, uv, height, settings.sphere, settings.planeToSphere, settings.planeResolution);
+	*position = vertex + settings.worldOffset;
+
+	if (normal) {
+		float3 waveNormal = getWaveNormal(flatXZ, settings.waveAmplitude, settings.waveFrequency, settings.waveSpeed, settings.time);
+		float3 flatNormal = (waveNormal + getHeightMapNormal(h, hN, hS, hE, hW, HEIGHTMAP_WORLD_STEP)) / 2.0f;
+		float3 sphereNormal = getSphereNormal(flatNormal, vertex - float3(settings.sphere.x, settings.sphere.y, settings.sphere.z));
+		*normal = normalize(lerp(flatNormal, sphereNormal, settings.planeToSphere));
+	}
+}
+
+void SurfaceQuery::evaluateBatch(const float2* uv, int count, float3* positions, float3* normals) const
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+		evaluate4(uv + i, positions + i, normals ? normals + i : 0);
+
+	// pad the last few points out to a full batch
+	if (i < count) {
+		float2 lastUV[4];
+		float3 lastPositions[4];
+		float3 lastNormals[4];
+		for (int j = 0; j < 4; j++)
+			lastUV[j] = uv[i + j < count ? i + j : count - 1];
+
+		evaluate4(lastUV, lastPositions, normals ? lastNormals : 0);
+		for (int j = 0; i + j < count; j++) {
+			positions[i + j] = lastPositions[j];
+			if (normals)
+				normals[i + j] = lastNormals[j];
+		}
+	}
+}
+
+void SurfaceQuery::evaluate4(const float2* uv, float3* positions, float3* normals) const
+{
+	// the heightmap lookups are scattered, so they're scalar. everything after is four points at a time
+	float amplitude = settings.heightAmplitude;
+	float u[4], v[4], h[4], hN[4], hS[4], hE[4], hW[4];
+	for (int i = 0; i < 4; i++) {
+		u[i] = uv[i].x;
+		v[i] = uv[i].y;
+		h[i] = field->sampleHeightMap(u[i], v[i]) * amplitude;
+		if (normals) {
+			hN[i] = field->sampleHeightMap(u[i], v[i] + HEIGHTMAP_UV_STEP) * amplitude;
+			hS[i] = field->sampleHeightMap(u[i], v[i] - HEIGHTMAP_UV_STEP) * amplitude;
+			hE[i] = field->sampleHeightMap(u[i] + HEIGHTMAP_UV_STEP, v[i]) * amplitude;
+			hW[i] = field->sampleHeightMap(u[i] - HEIGHTMAP_UV_STEP, v[i]) * amplitude;
+		}
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 pi = _mm_set1_ps(3.14159265359f);
+	__m128 resolution = _mm_set1_ps(settings.planeResolution);
+	__m128 time = _mm_set1_ps(settings.time);
+	__m128 t = _mm_set1_ps(settings.planeToSphere);
+	__m128 uLanes = _mm_loadu_ps(u);
+	__m128 vLanes = _mm_loadu_ps(v);
+	__m128 flatX = _mm_mul_ps(uLanes, resolution);
+	__m128 flatZ = _mm_mul_ps(vLanes, resolution);
+
+	// getWaveOffset and getWaveSlope
+	__m128 sinX, cosX, sinZ, cosZ;
+	sinCos(_mm_add_ps(_mm_mul_ps(flatX, _mm_set1_ps(settings.waveFrequency.x)), _mm_mul_ps(time, _mm_set1_ps(settings.waveSpeed.x))), &sinX, &cosX);
+	sinCos(_mm_add_ps(_mm_mul_ps(flatZ, _mm_set1_ps(settings.waveFrequency.y)), _mm_mul_ps(time, _mm_set1_ps(settings.waveSpeed.y))), &sinZ, &cosZ);
+	__m128 waveAmplitudeX = _mm_set1_ps(settings.waveAmplitude.x);
+	__m128 waveAmplitudeZ = _mm_set1_ps(settings.waveAmplitude.y);
+	__m128 height = _mm_add_ps(_mm_loadu_ps(h), _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sinX, waveAmplitudeX), _mm_mul_ps(sinZ, waveAmplitudeZ)), half));
+
+	// getSpherePosition
+	__m128 seam = _mm_set1_ps(1.0f + 1.0f / (settings.planeResolution - 1.0f));
+	__m128 lon = _mm_mul_ps(_mm_mul_ps(pi, _mm_sub_ps(_mm_mul_ps(uLanes, seam), _mm_set1_ps(0.25f))), _mm_set1_ps(2.0f));
+	__m128 lat = _mm_mul_ps(pi, _mm_sub_ps(_mm_mul_ps(vLanes, seam), half));
+	__m128 sinLon, cosLon, sinLat, cosLat;
+	sinCos(lon, &sinLon, &cosLon);
+	sinCos(lat, &sinLat, &cosLat);
+	__m128 r = _mm_add_ps(_mm_set1_ps(settings.sphere.w), height);
+	Vector4x3 centre = { _mm_set1_ps(settings.sphere.x), _mm_set1_ps(settings.sphere.y), _mm_set1_ps(settings.sphere.z) };
+	Vector4x3 onSphere;
+	onSphere.x = _mm_sub_ps(centre.x, _mm_mul_ps(_mm_mul_ps(r, cosLat), cosLon));
+	onSphere.y = _mm_add_ps(centre.y, _mm_mul_ps(_mm_mul_ps(r, cosLat), sinLon));
+	onSphere.z = _mm_add_ps(centre.z, _mm_mul_ps(r, sinLat));
+
+	// lerp between the flat plane and the sphere
+	Vector4x3 vertex;
+	vertex.x = _mm_add_ps(flatX, _mm_mul_ps(_mm_sub_ps(onSphere.x, flatX), t));
+	vertex.y = _mm_add_ps(height, _mm_mul_ps(_mm_sub_ps(onSphere.y, height), t));
+	vertex.z = _mm_add_ps(flatZ, _mm_mul_ps(_mm_sub_ps(onSphere.z, flatZ), t));
+
+	float x[4], y[4], z[4];
+	_mm_storeu_ps(x, _mm_add_ps(vertex.x, _mm_set1_ps(settings.worldOffset.x)));
+	_mm_storeu_ps(y, _mm_add_ps(vertex.y, _mm_set1_ps(settings.worldOffset.y)));
+	_mm_storeu_ps(z, _mm_add_ps(vertex.z, _mm_set1_ps(settings.worldOffset.z)));
+	for (int i = 0; i < 4; i++)
+		positions[i] = float3(x[i], y[i], z[i]);
+
+	if (!normals)
+		return;
+
+	// getWaveNormal
+	Vector4x3 waveNormal;
+	waveNormal.x = _mm_mul_ps(_mm_mul_ps(cosX, _mm_mul_ps(waveAmplitudeX, _mm_set1_ps(-settings.waveFrequency.x))), half);
+	waveNormal.y = one;
+	waveNormal.z = _mm_mul_ps(_mm_mul_ps(cosZ, _mm_mul_ps(waveAmplitudeZ, _mm_set1_ps(-settings.waveFrequency.y))), half);
+	waveNormal = normalize(waveNormal);
+
+	// getHeightMapNormal
+	__m128 step = _mm_set1_ps(HEIGHTMAP_WORLD_STEP);
+	__m128 centreHeight = _mm_loadu_ps(h);
+	Vector4x3 tan1 = { step, _mm_sub_ps(_mm_loadu_ps(hE), centreHeight), zero };
+	Vector4x3 tan2 = { _mm_sub_ps(zero, step), _mm_sub_ps(_mm_loadu_ps(hW), centreHeight), zero };
+	Vector4x3 bi1 = { zero, _mm_sub_ps(_mm_loadu_ps(hN), centreHeight), step };
+	Vector4x3 bi2 = { zero, _mm_sub_ps(_mm_loadu_ps(hS), centreHeight), _mm_sub_ps(zero, step) };
+	tan1 = normalize(tan1);
+	tan2 = normalize(tan2);
+	bi1 = normalize(bi1);
+	bi2 = normalize(bi2);
+	Vector4x3 heightMapNormal = add(add(cross(bi1, tan1), cross(tan1, bi2)), add(cross(bi2, tan2), cross(tan2, bi1)));
+	heightMapNormal = scale(heightMapNormal, _mm_set1_ps(0.25f));
+
+	Vector4x3 flatNormal = scale(add(waveNormal, heightMapNormal), half);
+
+	// getSphereNormal, sin(acos(c)) is sqrt(1 - c^2)
+	Vector4x3 fromCentre = { _mm_sub_ps(vertex.x, centre.x), _mm_sub_ps(vertex.y, centre.y), _mm_sub_ps(vertex.z, centre.z) };
+	Vector4x3 up = { zero, one, zero };
+	Vector4x3 axis = normalize(cross(fromCentre, up));
+	__m128 c = normalize(fromCentre).y;
+	__m128 s = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(c, c)), zero));
+	Vector4x3 turned = cross(flatNormal, axis);
+	Vector4x3 sphereNormal = add(add(flatNormal, scale(turned, s)), scale(cross(turned, axis), _mm_div_ps(_mm_sub_ps(one, c), _mm_mul_ps(s, s))));
+	sphereNormal = normalize(sphereNormal);
+
+	// lerp between the flat and sphere normals
+	Vector4x3 normal;
+	normal.x = _mm_add_ps(flatNormal.x, _mm_mul_ps(_mm_sub_ps(sphereNormal.x, flatNormal.x), t));
+	normal.y = _mm_add_ps(flatNormal.y, _mm_mul_ps(_mm_sub_ps(sphereNormal.y, flatNormal.y), t));
+	normal.z = _mm_add_ps(flatNormal.z, _mm_mul_ps(_mm_sub_ps(sphereNormal.z, flatNormal.z), t));
+	normal = normalize(normal);
+
+	_mm_storeu_ps(x, normal.x);
+	_mm_storeu_ps(y, normal.y);
+	_mm_storeu_ps(z, normal.z);
+	for (int i = 0; i < 4; i++)
+		normals[i] = float3(x[i], y[i], z[i]);
+}
@@ -0,0 +1,43 @@
+// Surface query
+// CPU copy of the manipulation plane's animated surface, for picking, placing objects on it and camera collision.
+// Follows the shaders: heightmap plus waves, lerp'd onto the sphere, with the same normals. Points are looked up by
+// the plane's uv. Batches are evaluated four points per SSE instruction.
+// Doesn't depend on D3D
+#pragma once
+
+#include "HlslShim.h"
+#include "DisplacementField.h"
+
+class SurfaceQuery
+{
+public:
+	struct Settings
+	{
+		float time;
+		float2 waveAmplitude; // x wave, z wave
+		float2 waveFrequency;
+		float2 waveSpeed;
+		float heightAmplitude;
+		float planeToSphere;
+		float4 sphere; // xyz = centre, w = radius
+		float planeResolution; // the plane mesh's resolution, flat positions are uv * planeResolution
+		float3 worldOffset; // the plane's world translation
+	};
+
+	// samples the heightmap decoded by the field, which has to outlive the query
+	SurfaceQuery(const DisplacementField* field);
+
+	void setSettings(const Settings& settings);
+
+	// one point, scalar. the reference evaluateBatch should match
+	void evaluate(float2 uv, float3* position, float3* normal) const;
+	// any number of points. normals can be null if only positions are needed
+	void evaluateBatch(const float2* uv, int count, float3* positions, float3* normals) const;
+
+private:
+	void evaluate4(const float2* uv, float3* positions, float3* normals) const;
+
+private:
+	const DisplacementField* field;
+	Settings settings;
+};
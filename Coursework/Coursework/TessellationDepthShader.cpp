@@ -40,8 +40,8 @@ void TessellationDepthShader::initShader(const wchar_t* vsFilename, const wchar_
 {
 
 
-	// Load (+ compile) shader files
-	loadVertexShader(vsFilename);
+	// Load (+ compile) shader files, depth only reads the position stream
+	loadPositionVertexShader(vsFilename);
 	loadPixelShader(psFilename);
 
 	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
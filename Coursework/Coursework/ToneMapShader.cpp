@@ -13,12 +13,22 @@ ToneMapShader::~ToneMapShader()
 		sampleState->Release();
 		sampleState = 0;
 	}
+	if (lutSampleState)
+	{
+		lutSampleState->Release();
+		lutSampleState = 0;
+	}
 
 	if (toneBuffer)
 	{
 		toneBuffer->Release();
 		toneBuffer = 0;
 	}
+	if (upsampleBuffer)
+	{
+		upsampleBuffer->Release();
+		upsampleBuffer = 0;
+	}
 
 	// Release the matrix constant buffer.
 	if (matrixBuffer)
@@ -68,6 +78,9 @@ void ToneMapShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilen
 	toneBufferDesc.StructureByteStride = 0;
 	renderer->CreateBuffer(&toneBufferDesc, NULL, &toneBuffer);
 
+	toneBufferDesc.ByteWidth = sizeof(UpsampleBufferType);
+	renderer->CreateBuffer(&toneBufferDesc, NULL, &upsampleBuffer);
+
 	// Create a texture sampler state description.
 	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
 	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
@@ -81,10 +94,15 @@ void ToneMapShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilen
 
 	// Create the texture sampler state.
 	renderer->CreateSamplerState(&samplerDesc, &sampleState);
+
+	// the LUT is sampled trilinearly, clamping at its edge texels
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	renderer->CreateSamplerState(&samplerDesc, &lutSampleState);
 }
 
 
-void ToneMapShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, ID3D11ShaderResourceView* texture, float exp, bool gamma)
+void ToneMapShader::setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, ID3D11ShaderResourceView* sceneTexture,
+	ID3D11ShaderResourceView* bloomTexture, float sceneWeight, float bloomWeight, bool toneMapping, ID3D11ShaderResourceView* gradeLut, float exp)
 {
 	HRESULT result;
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
@@ -108,16 +126,42 @@ void ToneMapShader::setShaderParameters(ID3D11DeviceContext* deviceContext, cons
 
 	deviceContext->Map(toneBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	tonePtr = (ToneBufferType*)mappedResource.pData;
-	tonePtr->exposure = exp;// worldMatrix;
-	tonePtr->padding = XMFLOAT2(1.0f, 1.0f);
-	tonePtr->gammaCorrection = gamma;
-	tonePtr->pad = false;
+	tonePtr->sceneWeight = sceneWeight;
+	tonePtr->bloomWeight = bloomWeight;
+	ColourGrade::coordinates(exp, tonePtr->lutScale, tonePtr->lutOffset);
+	tonePtr->toneMapping = toneMapping ? 1 : 0;
+	tonePtr->padding = XMFLOAT3(1.0f, 1.0f, 1.0f);
 	deviceContext->Unmap(toneBuffer, 0);
 	deviceContext->PSSetConstantBuffers(0, 1, &toneBuffer);
 
 	// Set shader texture and sampler resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	deviceContext->PSSetShaderResources(0, 1, &sceneTexture);
+	deviceContext->PSSetShaderResources(1, 1, &bloomTexture);
+	deviceContext->PSSetShaderResources(2, 1, &gradeLut);
 	deviceContext->PSSetSamplers(0, 1, &sampleState);
+	deviceContext->PSSetSamplers(1, 1, &lutSampleState);
+}
+
+void ToneMapShader::setUpsampleParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* guide, ID3D11ShaderResourceView* depth, int guideWidth, int guideHeight,
+	float depthSigma, float luminanceSigma, float screenNear, float screenFar)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	UpsampleBufferType* upsamplePtr;
+
+	deviceContext->Map(upsampleBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	upsamplePtr = (UpsampleBufferType*)mappedResource.pData;
+	upsamplePtr->bilateral = guide ? 1 : 0;
+	upsamplePtr->guideSize = XMFLOAT2((float)guideWidth, (float)guideHeight);
+	upsamplePtr->depthWeight = depthSigma > 0.0f ? 1.0f / depthSigma : 0.0f;
+	upsamplePtr->luminanceWeight = luminanceSigma > 0.0f ? 1.0f / luminanceSigma : 0.0f;
+	upsamplePtr->nearPlane = screenNear;
+	upsamplePtr->farPlane = screenFar;
+	upsamplePtr->padding = 0.0f;
+	deviceContext->Unmap(upsampleBuffer, 0);
+	deviceContext->PSSetConstantBuffers(1, 1, &upsampleBuffer);
+
+	deviceContext->PSSetShaderResources(3, 1, &guide);
+	deviceContext->PSSetShaderResources(4, 1, &depth);
 }
 
 
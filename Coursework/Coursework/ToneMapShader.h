@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BaseShader.h"
+#include "ColourGrade.h"
 
 using namespace std;
 using namespace DirectX;
@@ -9,16 +10,34 @@ class ToneMapShader : public BaseShader
 {
 public:
 	struct ToneBufferType {
-		float exposure;
-		bool gammaCorrection;
-		bool pad;
-		XMFLOAT2 padding;
+		float sceneWeight;
+		float bloomWeight;
+		float lutScale;
+		float lutOffset;
+		int toneMapping;
+		XMFLOAT3 padding;
+	};
+
+	struct UpsampleBufferType {
+		int bilateral;
+		XMFLOAT2 guideSize;
+		float depthWeight;
+		float luminanceWeight;
+		float nearPlane;
+		float farPlane;
+		float padding;
 	};
 
 	ToneMapShader(ID3D11Device* device, HWND hwnd);
 	~ToneMapShader();
 
-	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection, ID3D11ShaderResourceView* texture, float exp, bool gamma);
+	// scene * sceneWeight + bloom * bloomWeight, graded with a ColourGradeLut's texture at this exposure if toneMapping is set
+	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& world, const XMMATRIX& view, const XMMATRIX& projection, ID3D11ShaderResourceView* sceneTexture,
+		ID3D11ShaderResourceView* bloomTexture, float sceneWeight, float bloomWeight, bool toneMapping, ID3D11ShaderResourceView* gradeLut, float exp);
+	// a bloom texture made from a reduced scene is upsampled guided by it and the scene's depth buffer, a NULL guide samples
+	// the bloom texture bilinearly. depthSigma is a fraction of the pixel's depth and luminanceSigma is in stops, 0 ignores either
+	void setUpsampleParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* guide, ID3D11ShaderResourceView* depth, int guideWidth, int guideHeight,
+		float depthSigma, float luminanceSigma, float screenNear, float screenFar);
 
 private:
 	void initShader(const wchar_t* vs, const wchar_t* ps);
@@ -26,6 +45,8 @@ private:
 private:
 	ID3D11Buffer* matrixBuffer;
 	ID3D11Buffer* toneBuffer;
+	ID3D11Buffer* upsampleBuffer;
 	ID3D11SamplerState* sampleState;
+	ID3D11SamplerState* lutSampleState;
 };
 
@@ -2,9 +2,15 @@
 #include "verticalblurshader.h"
 
 
-VerticalBlurShader::VerticalBlurShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+VerticalBlurShader::VerticalBlurShader(ID3D11Device* device, HWND hwnd, int radius) : BaseShader(device, hwnd)
 {
-	initShader(L"verticalBlur_vs.cso", L"verticalBlur_ps.cso");
+	// verticalBlur_ps is radius 5, the wrappers compile it for the other radii
+	wchar_t pixelShader[64];
+	if (radius == 5)
+		swprintf_s(pixelShader, L"verticalBlur_ps.cso");
+	else
+		swprintf_s(pixelShader, L"verticalBlur%d_ps.cso", radius);
+	initShader(L"verticalBlur_vs.cso", pixelShader);
 }
 
 
@@ -19,7 +19,7 @@ private:
 
 public:
 
-	VerticalBlurShader(ID3D11Device* device, HWND hwnd);
+	VerticalBlurShader(ID3D11Device* device, HWND hwnd, int radius = 5); // one of GAUSSIAN_RADII
 	~VerticalBlurShader();
 
 	void setShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &world, const XMMATRIX &view, const XMMATRIX &projection, ID3D11ShaderResourceView* texture, float width);
@@ -0,0 +1,89 @@
+// Wave math
+// Shared by the C++ code and the HLSL shaders so the CPU displacement bake and the shaders move the plane the same way.
+// Only use the small part of HLSL that HlslShim.h provides.
+#ifndef _WAVEMATH_H
+#define _WAVEMATH_H
+
+#ifdef __cplusplus
+#include "HlslShim.h"
+#endif
+
+// WAVES
+// the plane is moved by one sine along x and one along z, averaged.
+// the .x of amplitude, frequency and speed is the x wave, .y is the z wave
+inline float getWaveOffset(float2 pos, float2 amplitude, float2 frequency, float2 speed, float time)
+{
+	return (sin(pos.x * frequency.x + time * speed.x) * amplitude.x + sin(pos.y * frequency.y + time * speed.y) * amplitude.y) / 2.0f;
+}
+
+// derivative of getWaveOffset along x and z. each sine only depends on one axis, so each slope is just its cosine
+inline float2 getWaveSlope(float2 pos, float2 amplitude, float2 frequency, float2 speed, float time)
+{
+	return float2(cos(pos.x * frequency.x + time * speed.x) * amplitude.x * frequency.x / 2.0f, cos(pos.y * frequency.y + time * speed.y) * amplitude.y * frequency.y / 2.0f);
+}
+
+// surface normal of the waves, replaces averaging the normals of four finite difference triangles
+inline float3 getWaveNormal(float2 pos, float2 amplitude, float2 frequency, float2 speed, float time)
+{
+	float2 slope = getWaveSlope(pos, amplitude, frequency, speed, time);
+	return normalize(float3(-slope.x, 1.0f, -slope.y));
+}
+
+// PLANE MESHES
+// App1 builds its plane meshes with these resolutions, each shader closes the sphere's seam for the mesh it draws
+static const int PLANE_RESOLUTION = 100;
+static const int TESSELLATED_PLANE_RESOLUTION = 30;
+
+// HEIGHTMAP NORMAL
+// the displacement bake's neighbouring heights are HEIGHTMAP_UV_STEP apart in the heightmap and treated as
+// HEIGHTMAP_WORLD_STEP apart on the plane
+static const float HEIGHTMAP_UV_STEP = 1.0f / 150.0f;
+static const float HEIGHTMAP_WORLD_STEP = 1.0f / 5.0f;
+
+// averages the normals of the four triangles between a height and its neighbours, which are step apart on the plane
+inline float3 getHeightMapNormal(float h, float hN, float hS, float hE, float hW, float step)
+{
+	float3 tan1 = normalize(float3(step, hE - h, 0.0f));
+	float3 tan2 = normalize(float3(-step, hW - h, 0.0f));
+	float3 bi1 = normalize(float3(0.0f, hN - h, step));
+	float3 bi2 = normalize(float3(0.0f, hS - h, -step));
+	return (cross(bi1, tan1) + cross(tan1, bi2) + cross(bi2, tan2) + cross(tan2, bi1)) * 0.25f;
+}
+
+// PLANE TO SPHERE
+// wraps the plane around a sphere by its uv. the height moves the vertex out from the surface. sphere.w is the radius,
+// planeResolution is the resolution the plane mesh was built with
+inline float3 getSpherePosition(float3 pos, float2 uv, float4 sphere, float planeResolution)
+{
+	float pi = 3.14159265359f;
+
+	// remove the gap in the seam where the plane edges meet
+	float seam = 1.0f + 1.0f / (planeResolution - 1.0f);
+	float lon = pi * (uv.x * seam - 0.25f) * 2.0f;
+	float lat = pi * (uv.y * seam - 0.5f);
+
+	float r = sphere.w + pos.y;
+	return float3(-r * cos(lat) * cos(lon) + sphere.x, r * cos(lat) * sin(lon) + sphere.y, r * sin(lat) + sphere.z);
+}
+
+// a displaced plane vertex, between the flat plane and the sphere. height is the heightmap and wave offset combined
+inline float3 getManipulatedPosition(float3 pos, float2 uv, float height, float4 sphere, float planeToSphere, float planeResolution)
+{
+	pos.y = height;
+	return lerp(pos, getSpherePosition(pos, uv, sphere, planeResolution), planeToSphere);
+}
+
+// turns a flat plane normal so its up points away from the sphere's centre. that multiplies the normal as a row vector by
+// I + A * s + A * A * (1 - c) / s^2, where A is the axis' cross product matrix, so it's written with crosses here
+inline float3 getSphereNormal(float3 flatNormal, float3 fromCentre)
+{
+	float3 up = float3(0.0f, 1.0f, 0.0f);
+	float3 axis = normalize(cross(fromCentre, up));
+	float c = dot(up, normalize(fromCentre));
+	float s = sin(acos(c));
+
+	float3 turned = cross(flatNormal, axis);
+	return normalize(flatNormal + turned * s + cross(turned, axis) * ((1.0f - c) / (s * s)));
+}
+
+#endif
@@ -0,0 +1,45 @@
+// Bilateral downsample pixel shader
+// Shrinks the scene for a reduced resolution blur or bloom, averaging each scale x scale block of it. The alpha is the
+// block's average linear depth from the scene's depth buffer, which guides toneMap_ps's upsample back to full size
+Texture2D sceneTexture : register(t0);
+Texture2D<float> depthTexture : register(t1);
+
+cbuffer DownsampleBuffer : register(b0)
+{
+    int scale; // scene texels across each block
+    float nearPlane;
+    float farPlane;
+    float padding;
+    int2 sceneSize;
+    float2 padding2;
+};
+
+struct InputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+};
+
+// the depth buffer's 0 to 1 back to view distance
+float linearDepth(float depth)
+{
+    return nearPlane * farPlane / (farPlane - depth * (farPlane - nearPlane));
+}
+
+float4 main(InputType input) : SV_TARGET
+{
+    // the block's texels, the last row and column clamped to the scene's edge when it doesn't divide by the scale
+    int2 first = (int2)input.position.xy * scale;
+    float3 colour = 0.0f;
+    float depth = 0.0f;
+    for (int j = 0; j < scale; j++) {
+        for (int i = 0; i < scale; i++) {
+            int3 texel = int3(min(first + int2(i, j), sceneSize - 1), 0);
+            colour += sceneTexture.Load(texel).rgb;
+            depth += linearDepth(depthTexture.Load(texel));
+        }
+    }
+
+    float area = 1.0f / (scale * scale);
+    return float4(colour * area, depth * area);
+}
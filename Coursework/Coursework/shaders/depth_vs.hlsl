@@ -1,3 +1,4 @@
+#include "../ShadowMath.h"
 
 cbuffer MatrixBuffer : register(b0)
 {
@@ -6,17 +7,24 @@ cbuffer MatrixBuffer : register(b0)
     matrix projectionMatrix;
 };
 
+cbuffer ParaboloidBuffer : register(b1)
+{
+    int paraboloid; // 1 warps the view space position onto a paraboloid instead of using the projection matrix
+    float paraboloidNear;
+    float paraboloidFar;
+    float paraboloidPadding;
+};
+
 struct InputType
 {
     float4 position : POSITION;
-    float2 tex : TEXCOORD0;
-    float3 normal : NORMAL;
 };
 
 struct OutputType
 {
     float4 position : SV_POSITION;
     float4 depthPosition : TEXCOORD0;
+    float clipDistance : SV_ClipDistance0;
 };
 
 OutputType main(InputType input)
@@ -26,7 +34,17 @@ OutputType main(InputType input)
     // Calculate the position of the vertex against the world, view, and projection matrices.
     output.position = mul(input.position, worldMatrix);
     output.position = mul(output.position, viewMatrix);
-    output.position = mul(output.position, projectionMatrix);
+    output.clipDistance = 1.0f;
+    if (paraboloid)
+    {
+        // only keep the hemisphere in front of the paraboloid
+        output.clipDistance = output.position.z;
+        output.position = float4(paraboloidProject(output.position.xyz, paraboloidNear, paraboloidFar), 1.0f);
+    }
+    else
+    {
+        output.position = mul(output.position, projectionMatrix);
+    }
 
     // Store the position value in a second input value for depth value calculations.
     output.depthPosition = output.position;
@@ -1,6 +1,8 @@
 // Tessellation domain shader
 // After tessellation the domain shader processes the all the vertices
 
+#include "../WaveMath.h"
+
 Texture2D texture0 : register(t0);
 SamplerState sampler0 : register(s0);
 
@@ -58,35 +60,6 @@ float getHeight(float2 uv)
     return offset * height;
 }
 
-float getWaveOffset(float2 pos)
-{
-    float offset = ((sin((pos.x * frequency.x) + (time * speed.x)) * amplitude.x) + (sin((pos.y * frequency.y) + (time * speed.y)) * amplitude.y)) / 2.0f;
-    return offset;
-}
-
-float3 pointToSphere(float3 pos, float2 uv, float3 center)
-{
-    float lon, lat, r;
-    float radius = spherePos.w;
-    
-    float pi = 3.14159265359;
-    
-    // remove the gap in the seam where the plane edges meet
-    float resolution = 1 / (30.0f - 1.0f);
-    uv.x *= 1 + resolution;
-    uv.y *= 1 + resolution;
-    // convert UV space to logitude and latitude
-    lon = pi * (uv.x - 0.25f) * 2; // offset the x by -0.25 change the position of the seam
-    lat = pi * (uv.y - 0.5);
-        
-    r = radius + pos.y;
-    pos.x = -r * cos(lat) * cos(lon) + center.x;
-    pos.y = r * cos(lat) * sin(lon) + center.y;
-    pos.z = r * sin(lat) + center.z;
-    
-    return pos;
-}
-
 [domain("quad")]
 OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, const OutputPatch<InputType, 4> patch)
 {
@@ -105,15 +78,14 @@ OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, c
     texCoord = lerp(t1, t2, uvwCoord.x);
     
     // -- VERTEX MANIPULATION
-    float3 center = spherePos.xyz;
 	// calculate height of vertex
     float4 textureColour = texture0.SampleLevel(sampler0, texCoord, 0);
     // calculate wave offset 
-    float offset = getWaveOffset(vertexPosition.xz);
+    float offset = getWaveOffset(vertexPosition.xz, amplitude, frequency, speed, time);
     // adjust the position by the texture and offset
     vertexPosition.y = height * textureColour.r + offset;
     // get the position of the vertex, lerp'd betweek the flat and spherical plane
-    vertexPosition = lerp(vertexPosition, pointToSphere(vertexPosition, texCoord, center), planeToSphere);
+    vertexPosition = lerp(vertexPosition, getSpherePosition(vertexPosition, texCoord, spherePos, TESSELLATED_PLANE_RESOLUTION), planeToSphere);
     
     // Calculate the position of the new vertex against the world, view, and projection matrices.
     output.position = mul(float4(vertexPosition, 1.0f), worldMatrix);
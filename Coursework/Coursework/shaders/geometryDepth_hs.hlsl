@@ -1,5 +1,8 @@
 // Tessellation Hull Shader
 // Prepares control points for tessellation
+
+#include "../WaveMath.h"
+
 Texture2D texture0 : register(t0);
 SamplerState sampler0 : register(s0);
 
@@ -60,52 +63,19 @@ float getHeight(float2 uv)
     return offset * height;
 }
 
-// calculate the wave offset
-float getWaveOffset(float2 pos)
-{
-    float offset = ((sin((pos.x * frequency.x) + (time * speed.x)) * amplitude.x) + (sin((pos.y * frequency.y) + (time * speed.y)) * amplitude.y)) / 2.0f;
-    return offset;
-}
-
 // calculate the vertex position when projected onto a sphere
-float3 pointToSphere(float3 pos, float2 uv, float3 center)
-{
-    float lon, lat, r;
-    float radius = spherePos.w;
-    
-    float pi = 3.14159265359;
-    
-    // remove the gap in the seam where the plane edges meet
-    float resolution = 1 / (30.0f - 1.0f);
-    uv.x *= 1 + resolution;
-    uv.y *= 1 + resolution;
-    
-    // convert UV space to logitude and latitude
-    lon = pi * (uv.x - 0.25f) * 2; // offset the x by -0.25 change the position of the seam
-    lat = pi * (uv.y - 0.5);
-    
-    // set the radius to the vertex
-    r = radius + pos.y;
-    pos.x = -r * cos(lat) * cos(lon) + center.x;
-    pos.y = r * cos(lat) * sin(lon) + center.y;
-    pos.z = r * sin(lat) + center.z;
-    
-    return pos;
-}
-
 // apply vertex manipulation to the vertex
 float3 manipulateVertex(float3 vertexPosition, float2 texCoords)
 {
     // -- VERTEX MANIPULATION
-    float3 center = spherePos.xyz;
 	// calculate height of vertex
     float4 textureColour = texture0.SampleLevel(sampler0, texCoords, 0);
     // calculate wave offset 
-    float offset = getWaveOffset(vertexPosition.xz);
+    float offset = getWaveOffset(vertexPosition.xz, amplitude, frequency, speed, time);
     // adjust the position by the heightmap and offset
     vertexPosition.y = height * textureColour.r + offset;
     // interpolate between the vertex position and the position of the vertex on the sphere
-    vertexPosition = lerp(vertexPosition, pointToSphere(vertexPosition, texCoords, center), planeToSphere);
+    vertexPosition = lerp(vertexPosition, getSpherePosition(vertexPosition, texCoords, spherePos, TESSELLATED_PLANE_RESOLUTION), planeToSphere);
     return vertexPosition;
 }
 
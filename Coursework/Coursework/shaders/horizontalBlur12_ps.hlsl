@@ -0,0 +1,3 @@
+// Horizontal blur pixel shader, radius 12
+#define BLUR_RADIUS 12
+#include "horizontalBlur_ps.hlsl"
@@ -0,0 +1,3 @@
+// Horizontal blur pixel shader, radius 3
+#define BLUR_RADIUS 3
+#include "horizontalBlur_ps.hlsl"
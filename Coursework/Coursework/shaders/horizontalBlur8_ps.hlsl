@@ -0,0 +1,3 @@
+// Horizontal blur pixel shader, radius 8
+#define BLUR_RADIUS 8
+#include "horizontalBlur_ps.hlsl"
@@ -1,10 +1,24 @@
+// Horizontal blur pixel shader
+// Gaussian blur of radius BLUR_RADIUS, the wrapper shaders (horizontalBlur3_ps...) compile the other radii.
+// Taps come in pairs merged into one bilinear sample, see GaussianKernel.h
+#ifndef BLUR_RADIUS
+#define BLUR_RADIUS 5
+#endif
+#include "../GaussianKernels.h"
+
+static const int SAMPLES = GAUSSIAN_KERNEL(BLUR_RADIUS, SAMPLES);
+static const float WEIGHTS[SAMPLES] = GAUSSIAN_KERNEL(BLUR_RADIUS, WEIGHTS);
+static const float OFFSETS[SAMPLES] = GAUSSIAN_KERNEL(BLUR_RADIUS, OFFSETS);
+
 Texture2D shaderTexture : register(t0);
 SamplerState SampleType : register(s0);
 
 cbuffer ScreenSizeBuffer : register(b0)
 {
     float screenWidth;
-    float3 padding;
+    float threshold;
+    int thresholdEnabled; // bloom's first pass thresholds the scene as it downsamples it
+    float padding;
 };
 
 struct InputType
@@ -13,41 +27,47 @@ struct InputType
     float2 tex : TEXCOORD0;
 };
 
-float4 main(InputType input) : SV_TARGET
+// the pixel if r + g + b is over the threshold, otherwise black
+float4 applyThreshold(float4 colour)
 {
-    float weight[6];
-    float2 blurCoords[11];
-    float4 colour;
-
-	// Create the weights that each neighbor pixel will contribute to the blur.   
-    // 0.2476614 + 0.230713 + 0.0321703 + 0.075984 + 0.028002 + 0.0093 + 0.230713 + 0.0321703 + 0.075984 + 0.028002 + 0.0093 = 1
-    
-    // kernel size of 11
-    weight[0] = 0.2476614;
-    weight[1] = 0.230713;
-    weight[2] = 0.075984;
-    weight[3] = 0.0321703;
-    weight[4] = 0.028002;
-    weight[5] = 0.0093;
-
-    // Initialize the colour to black.
-    colour = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    return (colour.r + colour.g + colour.b > threshold) ? colour : float4(0.0f, 0.0f, 0.0f, 1.0f);
+}
 
+// bilinear blend of the thresholded texels, the same as sampling a full size thresholded copy of the texture
+float4 sampleThresholded(float2 uv)
+{
+    float width, height;
+    shaderTexture.GetDimensions(width, height);
+    float2 texel = clamp(uv * float2(width, height) - 0.5f, 0.0f, float2(width, height) - 1.0f);
+    int2 first = (int2)texel;
+    int2 second = min(first + 1, int2(width, height) - 1);
+    float2 blend = texel - first;
+
+    float4 top = lerp(applyThreshold(shaderTexture.Load(int3(first.x, first.y, 0))), applyThreshold(shaderTexture.Load(int3(second.x, first.y, 0))), blend.x);
+    float4 bottom = lerp(applyThreshold(shaderTexture.Load(int3(first.x, second.y, 0))), applyThreshold(shaderTexture.Load(int3(second.x, second.y, 0))), blend.x);
+    return lerp(top, bottom, blend.y);
+}
+
+float4 sampleSource(float2 uv)
+{
+    if (thresholdEnabled)
+        return sampleThresholded(uv);
+    return shaderTexture.Sample(SampleType, uv);
+}
+
+float4 main(InputType input) : SV_TARGET
+{
     float texelSize = 1.0f / screenWidth;
-    // Add the vertical pixels to the colour by the specific weight of each.
-    
-    // set the blur coordinates
-    for (int i = -5; i <= 5; i++)
-    {
-        blurCoords[i + 5] = input.tex + float2(texelSize * i, 0.0f);
-    }
-    
-    // set the colour by adding the neightboring texels
-    for (int j = -5; j <= 5; j++)
+
+    // the centre, then each merged pair either side of it
+    float4 colour = sampleSource(input.tex) * WEIGHTS[0];
+    [unroll]
+    for (int i = 1; i < SAMPLES; i++)
     {
-        colour += shaderTexture.Sample(SampleType, blurCoords[j + 5]) * weight[abs(j)];
+        float2 offset = float2(texelSize * OFFSETS[i], 0.0f);
+        colour += (sampleSource(input.tex - offset) + sampleSource(input.tex + offset)) * WEIGHTS[i];
     }
-    
+
 	// Set the alpha channel to one.
     colour.a = 1.0f;
     return colour;
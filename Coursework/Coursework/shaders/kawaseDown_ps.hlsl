@@ -0,0 +1,64 @@
+// Dual kawase downsample pixel shader
+// Halves the texture with 5 bilinear taps, the centre and the four diagonals a texel out, covering 4x4 source texels.
+// Each level down the chain doubles the blur radius, so a wide blur takes a handful of small passes
+Texture2D shaderTexture : register(t0);
+SamplerState SampleType : register(s0);
+
+cbuffer KawaseBuffer : register(b0)
+{
+    float2 texelSize; // of the source texture
+    float offset; // spreads the taps, widening the blur
+    float threshold;
+    int thresholdEnabled; // bloom's first pass thresholds the scene as it downsamples it
+    float3 padding;
+};
+
+struct InputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+};
+
+// the pixel if r + g + b is over the threshold, otherwise black
+float4 applyThreshold(float4 colour)
+{
+    return (colour.r + colour.g + colour.b > threshold) ? colour : float4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// bilinear blend of the thresholded texels, the same as sampling a full size thresholded copy of the texture
+float4 sampleThresholded(float2 uv)
+{
+    float width, height;
+    shaderTexture.GetDimensions(width, height);
+    float2 texel = clamp(uv * float2(width, height) - 0.5f, 0.0f, float2(width, height) - 1.0f);
+    int2 first = (int2)texel;
+    int2 second = min(first + 1, int2(width, height) - 1);
+    float2 blend = texel - first;
+
+    float4 top = lerp(applyThreshold(shaderTexture.Load(int3(first.x, first.y, 0))), applyThreshold(shaderTexture.Load(int3(second.x, first.y, 0))), blend.x);
+    float4 bottom = lerp(applyThreshold(shaderTexture.Load(int3(first.x, second.y, 0))), applyThreshold(shaderTexture.Load(int3(second.x, second.y, 0))), blend.x);
+    return lerp(top, bottom, blend.y);
+}
+
+float4 sampleSource(float2 uv)
+{
+    if (thresholdEnabled)
+        return sampleThresholded(uv);
+    return shaderTexture.Sample(SampleType, uv);
+}
+
+float4 main(InputType input) : SV_TARGET
+{
+    float2 spread = texelSize * offset;
+
+    // the centre counts for half
+    float4 colour = sampleSource(input.tex) * 4.0f;
+    colour += sampleSource(input.tex + float2(-spread.x, -spread.y));
+    colour += sampleSource(input.tex + float2(spread.x, -spread.y));
+    colour += sampleSource(input.tex + float2(-spread.x, spread.y));
+    colour += sampleSource(input.tex + float2(spread.x, spread.y));
+    colour /= 8.0f;
+
+    colour.a = 1.0f;
+    return colour;
+}
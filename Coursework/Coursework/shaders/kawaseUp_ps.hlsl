@@ -0,0 +1,41 @@
+// Dual kawase upsample pixel shader
+// Doubles the texture with an 8 tap tent, four taps along the axes a texel out and four on the diagonals half a texel out.
+// Bloom adds the downsampled level of the same size on the way back up, like the gaussian chain's merge
+Texture2D shaderTexture : register(t0);
+Texture2D levelTexture : register(t1);
+SamplerState SampleType : register(s0);
+
+cbuffer KawaseBuffer : register(b0)
+{
+    float2 texelSize; // of the source texture
+    float offset; // spreads the taps, widening the blur
+    float levelWeight; // 0 when only blurring, the level isn't sampled
+};
+
+struct InputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+};
+
+float4 main(InputType input) : SV_TARGET
+{
+    float2 spread = texelSize * offset;
+
+    // the axis taps count once and the diagonals twice
+    float4 colour = shaderTexture.Sample(SampleType, input.tex + float2(-spread.x, 0.0f));
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(spread.x, 0.0f));
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(0.0f, -spread.y));
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(0.0f, spread.y));
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(-spread.x, -spread.y) * 0.5f) * 2.0f;
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(spread.x, -spread.y) * 0.5f) * 2.0f;
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(-spread.x, spread.y) * 0.5f) * 2.0f;
+    colour += shaderTexture.Sample(SampleType, input.tex + float2(spread.x, spread.y) * 0.5f) * 2.0f;
+    colour /= 12.0f;
+
+    if (levelWeight > 0.0f)
+        colour += levelTexture.Sample(SampleType, input.tex) * levelWeight;
+
+    colour.a = 1.0f;
+    return colour;
+}
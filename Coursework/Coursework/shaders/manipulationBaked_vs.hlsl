@@ -0,0 +1,47 @@
+// Baked manipulation vertex shader
+// Draws the plane baked by manipulationTessBake_ds. The vertices are already displaced and in world space,
+// so this only has to project them and output what manipulationTess_ps expects
+
+cbuffer MatrixBuffer : register(b0)
+{
+    matrix worldMatrix;
+    matrix viewMatrix;
+    matrix projectionMatrix;
+};
+
+cbuffer CameraBuffer : register(b1)
+{
+    float3 cameraPosition;
+    float pad;
+}
+
+struct InputType
+{
+    float3 position : POSITION;
+    float2 tex : TEXCOORD0;
+    float3 normal : NORMAL;
+};
+
+struct OutputType
+{
+    float4 position : SV_POSITION;
+    float3 normal : NORMAL;
+    float2 tex : TEXCOORD0;
+    float3 viewVector : TEXCOORD1;
+    float3 worldPosition : TEXCOORD2;
+};
+
+OutputType main(InputType input)
+{
+    OutputType output;
+
+    output.position = mul(float4(input.position, 1.0f), viewMatrix);
+    output.position = mul(output.position, projectionMatrix);
+
+    output.normal = input.normal;
+    output.tex = input.tex;
+    output.worldPosition = input.position;
+    output.viewVector = normalize(cameraPosition.xyz - output.worldPosition.xyz);
+
+    return output;
+}
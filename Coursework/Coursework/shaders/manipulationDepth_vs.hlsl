@@ -1,3 +1,4 @@
+#include "../WaveMath.h"
 
 Texture2D texture0 : register(t0);
 SamplerState sampler0 : register(s0);
@@ -43,109 +44,17 @@ float getHeight(float2 uv)
     return offset * height;
 }
 
-float getWaveOffset(float2 pos)
-{
-    float offset = ((sin((pos.x * frequency.x) + (time * speed.x)) * amplitude.x) + (sin((pos.y * frequency.y) + (time * speed.y)) * amplitude.y)) / 2.0f;
-    return offset;
-}
-
-float3 calculateWaveNormal(float3 oldNormal, float3 position, float amp)
-{
-    float WorldStep = 1.0f;
-    
-    float hN = getWaveOffset(float2(position.x, position.z + WorldStep));
-    float hS = getWaveOffset(float2(position.x, position.z - WorldStep));
-    float hE = getWaveOffset(float2(position.x + WorldStep, position.z));
-    float hW = getWaveOffset(float2(position.x - WorldStep, position.z));
-    
-    float h = getWaveOffset(position.xz);
-    
-    float3 tan1 = normalize(float3(WorldStep, hE - h, 0.0f));
-    float3 tan2 = normalize(float3(-WorldStep, hW - h, 0.0f));
-    float3 bi1 = normalize(float3(0.0f, hN - h, WorldStep));
-    float3 bi2 = normalize(float3(0.0f, hS - h, -WorldStep));
-    
-    float3 n1 = cross(bi1, tan1);
-    float3 n2 = cross(tan1, bi2);
-    float3 n3 = cross(bi2, tan2);
-    float3 n4 = cross(tan2, bi1);
-    return (n1 + n2 + n3 + n4) * 0.25f;
-}
-
 float3 calculateNormal(float2 uv)
 {
-    float u = (1.0f / 100.0f);
-    
-    float WorldStep = 100.0f * u;
+    // the neighbouring vertices, a texel of the plane's uv and a unit apart on the plane
+    float u = 1.0f / PLANE_RESOLUTION;
     
     float hN = getHeight(float2(uv.x, uv.y + u));
     float hS = getHeight(float2(uv.x, uv.y - u));
     float hE = getHeight(float2(uv.x + u, uv.y));
     float hW = getHeight(float2(uv.x - u, uv.y));
     
-    float h = getHeight(uv);
-    
-    float3 tan1 = normalize(float3(WorldStep, hE - h, 0.0f));
-    float3 tan2 = normalize(float3(-WorldStep, hW - h, 0.0f));
-    float3 bi1 = normalize(float3(0.0f, hN - h, WorldStep));
-    float3 bi2 = normalize(float3(0.0f, hS - h, -WorldStep));
-    
-    float3 n1 = cross(bi1, tan1);
-    float3 n2 = cross(tan1, bi2);
-    float3 n3 = cross(bi2, tan2);
-    float3 n4 = cross(tan2, bi1);
-    return (n1 + n2 + n3 + n4) * 0.25f;
-}
-
-float3 rotateNormal(float3 flatNorm, float3 newSurfaceNormal)
-{
-    float3 up = float3(0.0f, 1.0f, 0.0f);
-    
-    float3 a = normalize(up); // vector a
-    float3 b = normalize(newSurfaceNormal); // to be rotated to vector b
-    float3 u = normalize(cross(newSurfaceNormal, up)); // axis of rotation   
-    
-    float c = dot(a, b); // cosine of the angle
-    float angle = acos(c);
-    float s = sin(angle); // sine of the angle
-    
-    float3x3 identity = float3x3(
-    float3(1, 0, 0),
-    float3(0, 1, 0),
-    float3(0, 0, 1));
-    
-    float3x3 axisMatrix = float3x3(
-    float3(0, -u.z, u.y),
-    float3(u.z, 0, -u.x),
-    float3(-u.y, u.x, 0));
-    
-    // https://math.stackexchange.com/questions/142821/matrix-for-rotation-around-a-vector
-    float3x3 rotationMatrix = identity + (axisMatrix * s) + (mul(axisMatrix, axisMatrix) * ((1 - c) / pow(s, 2)));
-    
-    return normalize(mul(flatNorm, rotationMatrix));
-}
-
-float3 pointToSphere(float3 pos, float2 uv, float3 center)
-{
-    float lon, lat, r;
-    float radius = spherePos.w;
-    
-    float pi = 3.14159265359;
-    
-    // remove the gap in the seam where the plane edges meet
-    float resolution = 1 / 100.0f;
-    uv.x *= 1 + resolution;
-    uv.y *= 1 + resolution;
-    // convert UV space to logitude and latitude
-    lon = pi * (uv.x - 0.25f) * 2; // offset the x by -0.25 change the position of the seam
-    lat = pi * (uv.y - 0.5);
-        
-    r = radius + pos.y;
-    pos.x = -r * cos(lat) * cos(lon) + center.x;
-    pos.y = r * cos(lat) * sin(lon) + center.y;
-    pos.z = r * sin(lat) + center.z;
-    
-    return pos;
+    return getHeightMapNormal(getHeight(uv), hN, hS, hE, hW, 1.0f);
 }
 
 OutputType main(InputType input)
@@ -158,21 +67,21 @@ OutputType main(InputType input)
     float4 textureColour = texture0.SampleLevel(sampler0, input.tex, 0);
     // calculate wave offset 
     //float offset = sin((input.position.x * frequency) + (time * speed)) * cos((input.position.z * frequency) + (time * speed)) * 1.0f;
-    float offset = getWaveOffset(input.position.xz);
+    float offset = getWaveOffset(input.position.xz, amplitude, frequency, speed, time);
     // adjust the position by the texture and offset
     input.position.y = height * textureColour.r + offset;
     
     // calculate the wave normals before adjusting the position
-    float3 waveNormal = calculateWaveNormal(input.normal, input.position.xyz, 1.0f);
+    float3 waveNormal = getWaveNormal(input.position.xz, amplitude, frequency, speed, time);
     
     // get the position of the vertex, lerp'd betweek the flat and spherical plane
-    input.position = lerp(input.position, float4(pointToSphere(input.position.xyz, input.tex, center), 1.0f), planeToSphere);
+    input.position = lerp(input.position, float4(getSpherePosition(input.position.xyz, input.tex, spherePos, PLANE_RESOLUTION), 1.0f), planeToSphere);
     // calculate the normal based on the height map
     
     float3 heightMapNormal = calculateNormal(input.tex);
     float3 flatNormal = (waveNormal + heightMapNormal) / 2.0f;
     // rotate that normal onto the sphere
-    float3 normalOnSphere = rotateNormal(flatNormal, input.position.xyz - center);
+    float3 normalOnSphere = getSphereNormal(flatNormal, input.position.xyz - center);
     input.normal = lerp(flatNormal, normalOnSphere, planeToSphere);
     
     // Calculate the position of the vertex against the world, view, and projection matrices.
@@ -6,8 +6,6 @@ cbuffer MatrixBuffer : register(b0)
     matrix worldMatrix;
     matrix viewMatrix;
     matrix projectionMatrix;
-    matrix lightViewMatrix[4][6];
-    matrix lightProjectionMatrix[4];
 };
 
 cbuffer CameraBuffer : register(b1)
@@ -51,7 +49,6 @@ struct OutputType
     float4 color : COLOR;
     float3 viewVector : TEXCOORD1;
     float3 worldPosition : TEXCOORD2;
-    float4 lightViewPos[4][6] : TEXCOORD3;
 };
 
 // generate pseudo random numbers
@@ -184,17 +181,6 @@ void main(point InputType input[1], inout TriangleStream<OutputType> triStream)
         
         output.normal = normalize(output.normal);
         
-        // Calculate the position of the vertice as viewed by the light source.
-        for (int i = 0; i < 4; i++)
-        {
-            for (int j = 0; j < 6; j++)
-            {
-                output.lightViewPos[i][j] = mul(vPos, worldMatrix);
-                output.lightViewPos[i][j] = mul(output.lightViewPos[i][j], lightViewMatrix[i][j]);
-                output.lightViewPos[i][j] = mul(output.lightViewPos[i][j], lightProjectionMatrix[i]);
-            }
-        }
-        
         output.worldPosition = mul(vPos, worldMatrix).xyz;
         output.viewVector = normalize(cameraPosition.xyz - output.worldPosition.xyz);
         
@@ -1,6 +1,10 @@
 // Tessellation Hull Shader
-// Prepares control points for tessellation
-Texture2D texture0 : register(t0);
+// Prepares control points for tessellation, and culls the patches the view can't see
+
+#include "../PatchCulling.h"
+#include "../WaveMath.h"
+
+Texture2D texture0 : register(t0); // displacement map, xyz = flat normal, w = height
 SamplerState sampler0 : register(s0);
 
 cbuffer TimerBuffer : register(b0)
@@ -28,6 +32,16 @@ cbuffer CameraBuffer : register(b1)
     float pad2;    
 };
 
+cbuffer CullBuffer : register(b2)
+{
+    float4 frustumPlanes[6]; // object space
+    float4 occluder; // the sphere under the wrapped plane, w = 0 when it doesn't hide anything
+    float3 viewer;
+    float cullMargin;
+    bool frustumCull;
+    float3 pad3;
+};
+
 cbuffer MatrixBuffer : register(b3)
 {
     matrix worldMatrix;
@@ -53,59 +67,15 @@ struct OutputType
     float2 tex : TEXCOORD0;
 };
 
-// calculate the height map offset
-float getHeight(float2 uv)
-{
-    float offset = texture0.SampleLevel(sampler0, uv, 0).r;
-    return offset * height;
-}
-
-// calculate the wave offset
-float getWaveOffset(float2 pos)
-{
-    float offset = ((sin((pos.x * frequency.x) + (time * speed.x)) * amplitude.x) + (sin((pos.y * frequency.y) + (time * speed.y)) * amplitude.y)) / 2.0f;
-    return offset;
-}
-
 // calculate the vertex position when projected onto a sphere
-float3 pointToSphere(float3 pos, float2 uv, float3 center)
-{
-    float lon, lat, r;
-    float radius = spherePos.w;
-    
-    float pi = 3.14159265359;
-    
-    // remove the gap in the seam where the plane edges meet
-    float resolution = 1 / (30.0f - 1.0f);
-    uv.x *= 1 + resolution;
-    uv.y *= 1 + resolution;
-    
-    // convert UV space to logitude and latitude
-    lon = pi * (uv.x - 0.25f) * 2; // offset the x by -0.25 change the position of the seam
-    lat = pi * (uv.y - 0.5);
-    
-    // set the radius to the vertex
-    r = radius + pos.y;
-    pos.x = -r * cos(lat) * cos(lon) + center.x;
-    pos.y = r * cos(lat) * sin(lon) + center.y;
-    pos.z = r * sin(lat) + center.z;
-    
-    return pos;
-}
-
 // apply vertex manipulation to the vertex
 float3 manipulateVertex(float3 vertexPosition, float2 texCoords)
 {
     // -- VERTEX MANIPULATION
-    float3 center = spherePos.xyz;
-	// calculate height of vertex
-    float4 textureColour = texture0.SampleLevel(sampler0, texCoords, 0);
-    // calculate wave offset 
-    float offset = getWaveOffset(vertexPosition.xz);
-    // adjust the position by the heightmap and offset
-    vertexPosition.y = height * textureColour.r + offset;
+    // the heightmap and wave offset are baked into the displacement map
+    vertexPosition.y = texture0.SampleLevel(sampler0, texCoords, 0).w;
     // interpolate between the vertex position and the position of the vertex on the sphere
-    vertexPosition = lerp(vertexPosition, pointToSphere(vertexPosition, texCoords, center), planeToSphere);
+    vertexPosition = lerp(vertexPosition, getSpherePosition(vertexPosition, texCoords, spherePos, TESSELLATED_PLANE_RESOLUTION), planeToSphere);
     return vertexPosition;
 }
 
@@ -116,17 +86,29 @@ ConstantOutputType PatchConstantFunction(InputPatch<InputType, 4> inputPatch, ui
     // there's a bug somewhere that is offsetting the camera position. This is a bandaid fix.
     float3 cameraPos = camPos - float3(-15, -5, -15);
     
+    // manipulate the new verticies to ensure that the culling and dynamic tesselation work off of the current vertex position
+    float3 new_position[4];
+    for (int j = 0; j < 4; j++)
+    {
+        new_position[j] = manipulateVertex(inputPatch[j].position, inputPatch[j].tex);
+    }
+    
+    // zero tessellation factors make the tessellator discard the patch, so nothing hidden gets tessellated
+    if (cullPatch(new_position[0], new_position[1], new_position[2], new_position[3], cullMargin, frustumPlanes, frustumCull, viewer, occluder))
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            output.edges[k] = 0.0f;
+        }
+        output.inside[0] = 0.0f;
+        output.inside[1] = 0.0f;
+        return output;
+    }
+    
     // if dynamic tessellation is enabled
     if (dynamicTess)
     {
         float dist = 0.0f;
-        float3 new_position[4];
-        
-        // manipulate the new verticies to ensure that the dynamic tesselation works off of the current vertex position
-        for (int j = 0; j < 4; j++)
-        {
-            new_position[j] = manipulateVertex(inputPatch[j].position, inputPatch[j].tex);
-        }
     
         // calculate the inside tessellation
         float3 avg_pos = 0.0f;
@@ -0,0 +1,104 @@
+// Tessellation bake domain shader
+// Same displacement and normals as manipulationTess_ds, but outputs world space vertices for stream output.
+// The baked plane is drawn by every depth view and the camera pass, so it only has to be tessellated once a frame
+
+#include "../WaveMath.h"
+
+Texture2D texture0 : register(t0); // displacement map, xyz = flat normal, w = height
+SamplerState sampler0 : register(s0);
+
+cbuffer MatrixBuffer : register(b0)
+{
+    matrix worldMatrix;
+};
+
+cbuffer TimerBuffer : register(b1)
+{
+    float time;
+    float planeToSphere;
+    float height;
+    int pad;
+    
+    float2 amplitude;
+    float2 frequency;
+    float2 speed;
+    float2 pad1;    
+    float4 spherePos;
+    
+    bool dynamicTess;
+    float3 pad2;
+}
+
+struct ConstantOutputType
+{
+    float edges[4] : SV_TessFactor;
+    float inside[2] : SV_InsideTessFactor;
+};
+
+struct InputType
+{
+    float3 position : POSITION;
+    float3 normal : NORMAL;
+    float2 tex : TEXCOORD0;
+};
+
+// same order as the default input layout so the baked vertices can be drawn by any standard vertex shader.
+// depthPosition is streamed to its own buffer for the position only depth passes
+struct OutputType
+{
+    float3 position : POSITION;
+    float2 tex : TEXCOORD0;
+    float3 normal : NORMAL;
+    float3 depthPosition : POSITION1;
+};
+
+[domain("quad")]
+OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, const OutputPatch<InputType, 4> patch)
+{
+    float3 vertexPosition;
+    float2 texCoord;
+    float3 normal;
+    OutputType output;
+ 
+    // Determine the position of the new vertex.
+	// Invert the y and Z components of uvwCoord as these coords are generated in UV space and therefore y is positive downward.
+	// Alternatively you can set the output topology of the hull shader to cw instead of ccw (or vice versa).
+	//vertexPosition = uvwCoord.x * patch[0].position + -uvwCoord.y * patch[1].position + -uvwCoord.z * patch[2].position;
+    float3 v1 = lerp(patch[0].position, patch[1].position, uvwCoord.y);
+    float3 v2 = lerp(patch[3].position, patch[2].position, uvwCoord.y);
+    vertexPosition = lerp(v1, v2, uvwCoord.x);
+    
+    float2 t1 = lerp(patch[0].tex, patch[1].tex, uvwCoord.y);
+    float2 t2 = lerp(patch[3].tex, patch[2].tex, uvwCoord.y);
+    texCoord = lerp(t1, t2, uvwCoord.x);
+    
+    float3 n1 = lerp(patch[0].normal, patch[1].normal, uvwCoord.y);
+    float3 n2 = lerp(patch[3].normal, patch[2].normal, uvwCoord.y);
+    normal = lerp(n1, n2, uvwCoord.x);
+    
+    // -- VERTEX MANIPULATION
+    float3 center = spherePos.xyz;    
+    // the heightmap, the waves and their combined normal are baked into the displacement map
+    float4 displacement = texture0.SampleLevel(sampler0, texCoord, 0);
+    vertexPosition.y = displacement.w;
+    // get the position of the vertex, lerp'd between the flat and spherical plane
+    vertexPosition = lerp(vertexPosition, getSpherePosition(vertexPosition, texCoord, spherePos, TESSELLATED_PLANE_RESOLUTION), planeToSphere);
+    
+    float3 flatNormal = displacement.xyz;
+    // rotate that normal onto the sphere
+    float3 normalOnSphere = getSphereNormal(flatNormal, vertexPosition - center);
+    normal = lerp(flatNormal, normalOnSphere, planeToSphere);
+    
+    // world space only, each pass applies its own view and projection
+    output.position = mul(float4(vertexPosition, 1.0f), worldMatrix).xyz;
+    output.depthPosition = output.position;
+    
+    // Calculate the normal vector against the world matrix only and normalise.
+    output.normal = mul(normal, (float3x3) worldMatrix);
+    output.normal = normalize(output.normal);
+    
+    output.tex = texCoord;
+
+    return output;
+}
+
@@ -1,7 +1,10 @@
 // Tessellation domain shader
 // After tessellation the domain shader processes the all the vertices
 
-Texture2D texture0 : register(t0);
+#include "../ShadowMath.h"
+#include "../WaveMath.h"
+
+Texture2D texture0 : register(t0); // displacement map, xyz = flat normal, w = height
 SamplerState sampler0 : register(s0);
 
 cbuffer MatrixBuffer : register(b0)
@@ -34,6 +37,14 @@ cbuffer CameraBuffer : register(b2)
     float padding1;
 }
 
+cbuffer ParaboloidBuffer : register(b3)
+{
+    int paraboloid; // 1 warps the view space position onto a paraboloid instead of using the projection matrix
+    float paraboloidNear;
+    float paraboloidFar;
+    float paraboloidPadding;
+};
+
 struct ConstantOutputType
 {
     float edges[4] : SV_TessFactor;
@@ -50,43 +61,9 @@ struct OutputType
 {
     float4 position : SV_POSITION;
     float4 depthPosition : TEXCOORD0;
+    float clipDistance : SV_ClipDistance0;
 };
 
-float getHeight(float2 uv)
-{
-    float offset = texture0.SampleLevel(sampler0, uv, 0).r;
-    return offset * height;
-}
-
-float getWaveOffset(float2 pos)
-{
-    float offset = ((sin((pos.x * frequency.x) + (time * speed.x)) * amplitude.x) + (sin((pos.y * frequency.y) + (time * speed.y)) * amplitude.y)) / 2.0f;
-    return offset;
-}
-
-float3 pointToSphere(float3 pos, float2 uv, float3 center)
-{
-    float lon, lat, r;
-    float radius = spherePos.w;
-    
-    float pi = 3.14159265359;
-    
-    // remove the gap in the seam where the plane edges meet
-    float resolution = 1/(30.0f - 1.0f);
-    uv.x *= 1 + resolution;
-    uv.y *= 1 + resolution;
-    // convert UV space to logitude and latitude
-    lon = pi * (uv.x - 0.25f) * 2; // offset the x by -0.25 change the position of the seam
-    lat = pi * (uv.y - 0.5);
-        
-    r = radius + pos.y;
-    pos.x = -r * cos(lat) * cos(lon) + center.x;
-    pos.y = r * cos(lat) * sin(lon) + center.y;
-    pos.z = r * sin(lat) + center.z;
-    
-    return pos;
-}
-
 [domain("quad")]
 OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, const OutputPatch<InputType, 4> patch)
 {
@@ -105,20 +82,25 @@ OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, c
     texCoord = lerp(t1, t2, uvwCoord.x);
     
     // -- VERTEX MANIPULATION
-    float3 center = spherePos.xyz;    
-	// calculate height of vertex
-    float4 textureColour = texture0.SampleLevel(sampler0, texCoord, 0);
-    // calculate wave offset 
-    float offset = getWaveOffset(vertexPosition.xz);
-    // adjust the position by the texture and offset
-    vertexPosition.y = height * textureColour.r + offset;
+    // the heightmap and wave offset are baked into the displacement map
+    vertexPosition.y = texture0.SampleLevel(sampler0, texCoord, 0).w;
     // get the position of the vertex, lerp'd betweek the flat and spherical plane
-    vertexPosition = lerp(vertexPosition, pointToSphere(vertexPosition, texCoord, center), planeToSphere);
+    vertexPosition = lerp(vertexPosition, getSpherePosition(vertexPosition, texCoord, spherePos, TESSELLATED_PLANE_RESOLUTION), planeToSphere);
     
     // Calculate the position of the new vertex against the world, view, and projection matrices.
     output.position = mul(float4(vertexPosition, 1.0f), worldMatrix);
     output.position = mul(output.position, viewMatrix);
-    output.position = mul(output.position, projectionMatrix);
+    output.clipDistance = 1.0f;
+    if (paraboloid)
+    {
+        // only keep the hemisphere in front of the paraboloid
+        output.clipDistance = output.position.z;
+        output.position = float4(paraboloidProject(output.position.xyz, paraboloidNear, paraboloidFar), 1.0f);
+    }
+    else
+    {
+        output.position = mul(output.position, projectionMatrix);
+    }
     
     output.depthPosition = output.position;
 
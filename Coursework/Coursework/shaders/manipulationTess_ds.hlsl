@@ -1,7 +1,9 @@
 // Tessellation domain shader
 // After tessellation the domain shader processes the all the vertices
 
-Texture2D texture0 : register(t0);
+#include "../WaveMath.h"
+
+Texture2D texture0 : register(t0); // displacement map, xyz = flat normal, w = height
 SamplerState sampler0 : register(s0);
 
 cbuffer MatrixBuffer : register(b0)
@@ -9,8 +11,6 @@ cbuffer MatrixBuffer : register(b0)
     matrix worldMatrix;
     matrix viewMatrix;
     matrix projectionMatrix;
-    matrix lightViewMatrix[4][6];
-    matrix lightProjectionMatrix[4];
 };
 
 cbuffer TimerBuffer : register(b1)
@@ -56,119 +56,8 @@ struct OutputType
     float2 tex : TEXCOORD0;
     float3 viewVector : TEXCOORD1;
     float3 worldPosition : TEXCOORD2;
-    float4 lightViewPos[4][6] : TEXCOORD3;
 };
 
-float getHeight(float2 uv)
-{
-    float offset = texture0.SampleLevel(sampler0, uv, 0).r;
-    return offset * height;
-}
-
-float getWaveOffset(float2 pos)
-{
-    float offset = ((sin((pos.x * frequency.x) + (time * speed.x)) * amplitude.x) + (sin((pos.y * frequency.y) + (time * speed.y)) * amplitude.y)) / 2.0f;
-    return offset;
-}
-
-float3 calculateWaveNormal(float3 oldNormal, float3 position, float amp)
-{
-    float WorldStep = 1.0f / 5.0f;
-    
-    float hN = getWaveOffset(float2(position.x, position.z + WorldStep));
-    float hS = getWaveOffset(float2(position.x, position.z - WorldStep));
-    float hE = getWaveOffset(float2(position.x + WorldStep, position.z));
-    float hW = getWaveOffset(float2(position.x - WorldStep, position.z));
-    
-    float h = getWaveOffset(position.xz);
-    
-    float3 tan1 = normalize(float3(WorldStep, hE - h, 0.0f));
-    float3 tan2 = normalize(float3(-WorldStep, hW - h, 0.0f));
-    float3 bi1 = normalize(float3(0.0f, hN - h, WorldStep));
-    float3 bi2 = normalize(float3(0.0f, hS - h, -WorldStep));
-    
-    float3 n1 = cross(bi1, tan1);
-    float3 n2 = cross(tan1, bi2);
-    float3 n3 = cross(bi2, tan2);
-    float3 n4 = cross(tan2, bi1);
-    return (n1 + n2 + n3 + n4) * 0.25f;
-}
-
-float3 calculateNormal(float2 uv)
-{
-    float u = (1.0f / 150.0f);
-    float WorldStep = 1/5.0f;
-    
-    float hN = getHeight(float2(uv.x, uv.y + u));
-    float hS = getHeight(float2(uv.x, uv.y - u));
-    float hE = getHeight(float2(uv.x + u, uv.y));
-    float hW = getHeight(float2(uv.x - u, uv.y));
-    
-    float h = getHeight(uv);
-    
-    float3 tan1 = normalize(float3(WorldStep, hE - h, 0.0f));
-    float3 tan2 = normalize(float3(-WorldStep, hW - h, 0.0f));
-    float3 bi1 = normalize(float3(0.0f, hN - h, WorldStep));
-    float3 bi2 = normalize(float3(0.0f, hS - h, -WorldStep));
-    
-    float3 n1 = cross(bi1, tan1);
-    float3 n2 = cross(tan1, bi2);
-    float3 n3 = cross(bi2, tan2);
-    float3 n4 = cross(tan2, bi1);
-    return (n1 + n2 + n3 + n4) * 0.25f;
-}
-
-float3 rotateNormal(float3 flatNorm, float3 newSurfaceNormal)
-{
-    // set the up vector
-    float3 up = float3(0.0f, 1.0f, 0.0f);
-    float3 b = normalize(newSurfaceNormal); // to be rotated to vector b
-    float3 u = normalize(cross(newSurfaceNormal, up)); // axis of rotation   
-    
-    float c = dot(up, b); // cosine of the angle
-    float angle = acos(c);
-    float s = sin(angle); // sine of the angle
-    
-    float3x3 identity = float3x3(
-    float3(1, 0, 0),
-    float3(0, 1, 0),
-    float3(0, 0, 1));
-    
-    float3x3 axisMatrix = float3x3(
-    float3(0, -u.z, u.y),
-    float3(u.z, 0, -u.x),
-    float3(-u.y, u.x, 0));
-    
-    // https://math.stackexchange.com/questions/142821/matrix-for-rotation-around-a-vector
-    float3x3 rotationMatrix = identity + (axisMatrix * s) + (mul(axisMatrix, axisMatrix) * ((1 - c) / pow(s, 2)));
-    
-    return normalize(mul(flatNorm, rotationMatrix));
-}
-
-float3 pointToSphere(float3 pos, float2 uv, float3 center)
-{
-    float lon, lat, r;
-    float radius = spherePos.w;
-    
-    float pi = 3.14159265359;
-    
-    // remove the gap in the seam where the plane edges meet
-    float resolution = 1 / (30.0f - 1.0f);
-    uv.x *= 1 + resolution;
-    uv.y *= 1 + resolution;
-    
-    // convert UV space to logitude and latitude
-    lon = pi * (uv.x - 0.25f) * 2; // offset the x by -0.25 change the position of the seam
-    lat = pi * (uv.y - 0.5);
-        
-    r = radius + pos.y;
-    pos.x = -r * cos(lat) * cos(lon) + center.x;
-    pos.y = r * cos(lat) * sin(lon) + center.y;
-    pos.z = r * sin(lat) + center.z;
-    
-    return pos;
-}
-
 [domain("quad")]
 OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, const OutputPatch<InputType, 4> patch)
 {
@@ -195,22 +84,15 @@ OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, c
     
     // -- VERTEX MANIPULATION
     float3 center = spherePos.xyz;    
-	// calculate height of vertex
-    float4 textureColour = texture0.SampleLevel(sampler0, texCoord, 0);
-    // calculate wave offset 
-    float offset = getWaveOffset(vertexPosition.xz);
-    // adjust the position by the texture and offset
-    vertexPosition.y = height * textureColour.r + offset;
-    // calculate the wave normals before adjusting the position
-    float3 waveNormal = calculateWaveNormal(normal, vertexPosition, 1.0f);
+    // the heightmap, the waves and their combined normal are baked into the displacement map
+    float4 displacement = texture0.SampleLevel(sampler0, texCoord, 0);
+    vertexPosition.y = displacement.w;
     // get the position of the vertex, lerp'd between the flat and spherical plane
-    vertexPosition = lerp(vertexPosition, pointToSphere(vertexPosition, texCoord, center), planeToSphere);
+    vertexPosition = lerp(vertexPosition, getSpherePosition(vertexPosition, texCoord, spherePos, TESSELLATED_PLANE_RESOLUTION), planeToSphere);
     
-    // calculate the normal based on the height map    
-    float3 heightMapNormal = calculateNormal(texCoord);
-    float3 flatNormal = (waveNormal + heightMapNormal) / 2.0f;
+    float3 flatNormal = displacement.xyz;
     // rotate that normal onto the sphere
-    float3 normalOnSphere = rotateNormal(flatNormal, vertexPosition - center);
+    float3 normalOnSphere = getSphereNormal(flatNormal, vertexPosition - center);
     normal = lerp(flatNormal, normalOnSphere, planeToSphere);
     
     // Calculate the position of the new vertex against the world, view, and projection matrices.
@@ -218,17 +100,6 @@ OutputType main(ConstantOutputType input, float2 uvwCoord : SV_DomainLocation, c
     output.position = mul(output.position, viewMatrix);
     output.position = mul(output.position, projectionMatrix);
     
-    // Calculate the position of the vertice as viewed by the light source.
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j < 6; j++)
-        {
-            output.lightViewPos[i][j] = mul(float4(vertexPosition, 1.0f), worldMatrix);
-            output.lightViewPos[i][j] = mul(output.lightViewPos[i][j], lightViewMatrix[i][j]);
-            output.lightViewPos[i][j] = mul(output.lightViewPos[i][j], lightProjectionMatrix[i]);
-        }
-    }
-    
     // Calculate the normal vector against the world matrix only and normalise.
     output.normal = mul(normal, (float3x3) worldMatrix);
     output.normal = normalize(output.normal);
@@ -1,6 +1,8 @@
+#include "../ShadowMath.h"
 
 Texture2D shaderTexture : register(t0);
-Texture2D depthMapTexture[4][6] : register(t1);
+Texture2D shadowAtlas : register(t1); // every spot/directional light's depth view packed into one texture
+Texture2DArray pointShadowMaps : register(t2); // six slices per enabled point light, one for each cube face
 
 SamplerState diffuseSampler : register(s0);
 SamplerState shadowSampler : register(s1);
@@ -21,6 +23,25 @@ cbuffer LightBuffer : register(b0)
     float4 attenuation;
     float4 bias;
     
+    float4 tileRect[4][4]; // xy = uv scale, zw = uv offset into the atlas. directional lights have one per cascade
+    float2 atlasTexelSize;
+    float cubeTexelSize;
+    float shadowPadding;
+    int4 cubeIndex; // each point light's cube in the cube array
+    int4 cascadeCount;
+    float4 cascadeBlend; // fraction of a cascade's edge that fades into the next cascade
+    int4 paraboloid; // 1 if a point light uses dual paraboloid shadows instead of a cube
+    float4 paraboloidNear;
+    float4 paraboloidFar;
+};
+
+cbuffer LightMatrixBuffer : register(b1)
+{
+    matrix lightViewProjection[4][6]; // each light view combined with its light's projection
+};
+
+cbuffer NormalBuffer : register(b2)
+{
     bool showNormals;
     float3 padding;
 };
@@ -32,7 +53,6 @@ struct InputType
     float2 tex : TEXCOORD0;
     float3 viewVector : TEXCOORD1;
     float3 worldPosition : TEXCOORD2;
-    float4 lightViewPos[4][6] : TEXCOORD3;
 };
 
 float4 calculateSpecular(float3 eyeVec, float3 lightVec, float3 normal, int index)
@@ -86,23 +106,27 @@ bool hasDepthData(float2 uv)
     return true;
 }
 
-float isInShadow(Texture2D sMap, float2 uv, float4 lightViewPosition, float bias)
-{       
-    float depthMapSize = 2048.0f;
-    float depthTexelSize = 1.0f / depthMapSize;
-    int pcfSampleSize = 2; // sample a 5x5 area
-    float pcfArea = pow(pcfSampleSize * 2 + 1, 2);
+float isInShadow(float2 uv, float4 tile, float4 lightViewPosition, float bias)
+{
+    // a view without a tile has nothing to sample, which happens when the atlas couldn't fit every light
+    if (tile.x <= 0.0f)
+        return 1.0f;
+
+    // move the uv into this view's tile, the kernel is clamped so it never reads a neighbouring tile
+    float2 atlasUV = uv * tile.xy + tile.zw;
+    float2 tileMin = tile.zw + atlasTexelSize * 0.5f;
+    float2 tileMax = tile.zw + tile.xy - atlasTexelSize * 0.5f;
     float texelsNotInShadow = 0.0f;
     
     [unroll] 
-    for (int x = -pcfSampleSize; x <= pcfSampleSize; x++)
+    for (int x = -PCF_RADIUS; x <= PCF_RADIUS; x++)
     {
         [unroll] 
-        for (int y = -pcfSampleSize; y <= pcfSampleSize; y++)
+        for (int y = -PCF_RADIUS; y <= PCF_RADIUS; y++)
         {
             // Sample the shadow map (get depth of geometry)
-            float2 newUV = uv + (float2(x, y) * depthTexelSize);
-            float depthValue = sMap.Sample(shadowSampler, newUV).r;
+            float2 newUV = clamp(atlasUV + (float2(x, y) * atlasTexelSize), tileMin, tileMax);
+            float depthValue = shadowAtlas.Sample(shadowSampler, newUV).r;
             
 	        // Calculate the depth from the light.
             float lightDepthValue = lightViewPosition.z / lightViewPosition.w;
@@ -115,18 +139,114 @@ float isInShadow(Texture2D sMap, float2 uv, float4 lightViewPosition, float bias
         }
     }
     
-    texelsNotInShadow /= pcfArea;
+    texelsNotInShadow *= pcfWeight(PCF_RADIUS);
     
     return texelsNotInShadow;
 }
 
-float2 getProjectiveCoords(float4 lightViewPosition)
+// samples one face of a point light's cube, each face is stored as its own slice of the array
+float isInCubeShadow(float2 uv, float slice, float4 lightViewPosition, float bias)
 {
-    // Calculate the projected texture coordinates.
-    float2 projTex = lightViewPosition.xy / lightViewPosition.w;
-    projTex *= float2(0.5, -0.5);
-    projTex += float2(0.5f, 0.5f);
-    return projTex;
+    float texelsNotInShadow = 0.0f;
+    
+    [unroll] 
+    for (int x = -PCF_RADIUS; x <= PCF_RADIUS; x++)
+    {
+        [unroll] 
+        for (int y = -PCF_RADIUS; y <= PCF_RADIUS; y++)
+        {
+            // Sample the shadow map (get depth of geometry)
+            float2 newUV = uv + (float2(x, y) * cubeTexelSize);
+            float depthValue = pointShadowMaps.Sample(shadowSampler, float3(newUV, slice)).r;
+            
+	        // Calculate the depth from the light.
+            float lightDepthValue = lightViewPosition.z / lightViewPosition.w;
+            lightDepthValue -= bias;
+            // Compare the depth of the shadow map value and the depth of the light to determine whether to shadow or to light this pixel.
+            if (lightDepthValue < depthValue)
+            {
+                texelsNotInShadow += 1.0f;
+            }
+        }
+    }
+    
+    texelsNotInShadow *= pcfWeight(PCF_RADIUS);
+    
+    return texelsNotInShadow;
+}
+
+// light space position of a pixel for one of a light's views, rebuilt from its world position
+float4 getLightViewPos(int light, int view, float3 worldPosition)
+{
+    return mul(float4(worldPosition, 1.0f), lightViewProjection[light][view]);
+}
+
+// spot lights use a single tile, pixels outside the light's frustum are unlit
+float getSpotShadow(int light, float3 worldPosition, float bias)
+{
+    float4 lightViewPos = getLightViewPos(light, 0, worldPosition);
+    float2 uv = getProjectiveCoords(lightViewPos);
+    if (!hasDepthData(uv))
+        return 0.0f;
+
+    return isInShadow(uv, tileRect[light][0], lightViewPos, bias);
+}
+
+// cube point lights only sample the face the pixel falls in
+float getCubeShadow(int light, float3 worldPosition, float3 lightToPixel, float bias)
+{
+    int face = cubeFaceIndex(lightToPixel);
+    float4 lightViewPos = getLightViewPos(light, face, worldPosition);
+    return isInCubeShadow(getProjectiveCoords(lightViewPos), cubeIndex[light] * 6 + face, lightViewPos, bias);
+}
+
+// dual paraboloid point lights store the down and up hemispheres as two tiles of the atlas
+float getParaboloidShadow(int light, float3 worldPosition, float bias)
+{
+    // the first two views face down and up, with no projection applied
+    float4 lightViewPos = getLightViewPos(light, 0, worldPosition);
+    int hemisphere = 0;
+    if (lightViewPos.z < 0.0f)
+    {
+        lightViewPos = getLightViewPos(light, 1, worldPosition);
+        hemisphere = 1;
+    }
+    
+    float3 projected = paraboloidProject(lightViewPos.xyz, paraboloidNear[light], paraboloidFar[light]);
+    return isInShadow(paraboloidToUV(projected), tileRect[light][hemisphere], float4(0.0f, 0.0f, projected.z, 1.0f), bias);
+}
+
+// picks the first cascade the pixel falls inside, fading into the next cascade near its edge.
+// a directional light without cascades has a single cascade using its own projection
+float getCascadeShadow(int light, float3 worldPosition, float bias)
+{
+    for (int c = 0; c < cascadeCount[light]; c++)
+    {
+        float4 lightViewPos = getLightViewPos(light, c, worldPosition);
+        float2 uv = getProjectiveCoords(lightViewPos);
+        if (hasDepthData(uv))
+        {
+            float shadow = isInShadow(uv, tileRect[light][c], lightViewPos, bias);
+            
+            // distance to the nearest edge of the cascade, 0 at the edge and 0.5 in the centre
+            float2 edge = min(uv, 1.0f - uv);
+            float fade = min(edge.x, edge.y) / max(cascadeBlend[light], 0.0001f);
+            if (fade < 1.0f && c + 1 < cascadeCount[light])
+            {
+                float4 nextViewPos = getLightViewPos(light, c + 1, worldPosition);
+                float2 nextUV = getProjectiveCoords(nextViewPos);
+                if (hasDepthData(nextUV))
+                {
+                    float nextShadow = isInShadow(nextUV, tileRect[light][c + 1], nextViewPos, bias);
+                    shadow = lerp(nextShadow, shadow, fade);
+                }
+            }
+            return shadow;
+        }
+    }
+    
+    // outside every cascade
+    return 0.0f;
 }
 
 float4 main(InputType input) : SV_TARGET
@@ -142,16 +262,6 @@ float4 main(InputType input) : SV_TARGET
     float4 intensity, spec;
     float atten = 1.0f;
     float shadowFactor = 0.0f;
-// Calculate the projected texture coordinates.
-    float2 pTexCoord[4][6];
-    for (int x = 0; x < 4; x++)
-    {
-        for (int y = 0; y < 6; y++)
-        {
-            pTexCoord[x][y] = getProjectiveCoords(input.lightViewPos[x][y]);
-        }
-    }
-    
 // loop through all the lights
     for (int i = 0; i < 4; i++)
     {
@@ -164,53 +274,39 @@ float4 main(InputType input) : SV_TARGET
         {
         // point light
             case 0:
-                for (int j = 0; j < 6; j++)
+                // dual paraboloid lights pick a hemisphere, cube lights pick a face
+                if (paraboloid[i])
+                    shadowFactor = getParaboloidShadow(i, input.worldPosition, bias[i]);
+                else
+                    shadowFactor = getCubeShadow(i, input.worldPosition, -lightVec, bias[i]);
+
+                if (shadowFactor)
                 {
-                    if (hasDepthData(pTexCoord[i][j]))
-                    {
-                        // Has depth map data
-                        shadowFactor = isInShadow(depthMapTexture[i][j], pTexCoord[i][j], input.lightViewPos[i][j], bias[i]);
-                        if (shadowFactor)
-                        {
-                            intensity = calculateIntensity(lightVec, input.normal) * shadowFactor;
-                            spec = calculateSpecular(input.viewVector, lightVec, input.normal, i);
-            
-                            lightColour += ((intensity * diffuse[i]) + (intensity * spec)) * atten;
-                            break; // only add one instance of lighting for the pointlight       
-                        }
-                    }
+                    intensity = calculateIntensity(lightVec, input.normal) * shadowFactor;
+                    spec = calculateSpecular(input.viewVector, lightVec, input.normal, i);
+                    lightColour += ((intensity * diffuse[i]) + (intensity * spec)) * atten;
                 }
-                
                 lightColour += ambient[i] * textureColour;
                 break;
             
         // directional light
             case 1:
-                if (hasDepthData(pTexCoord[i][0]))
+                shadowFactor = getCascadeShadow(i, input.worldPosition, bias[i]);
+                if (shadowFactor)
                 {
-                // Has depth map data
-                    float shadowFactor = isInShadow(depthMapTexture[i][0], pTexCoord[i][0], input.lightViewPos[i][0], bias[i]);
-                    if (shadowFactor)
-                    {
-                        intensity = calculateIntensity(-direction[i].xyz, input.normal) * shadowFactor;
-                        spec = calculateSpecular(input.viewVector, -direction[i].xyz, input.normal, i);
-                        lightColour += (intensity * diffuse[i]) + (intensity * spec) * atten;
-                    }
+                    intensity = calculateIntensity(-direction[i].xyz, input.normal) * shadowFactor;
+                    spec = calculateSpecular(input.viewVector, -direction[i].xyz, input.normal, i);
+                    lightColour += (intensity * diffuse[i]) + (intensity * spec) * atten;
                 }
                 lightColour += ambient[i] * textureColour;
                 break;
             
         // spot light
             case 2:
-                if (hasDepthData(pTexCoord[i][0]))
+                shadowFactor = getSpotShadow(i, input.worldPosition, bias[i]);
+                if (shadowFactor)
                 {
-                // Has depth map data
-                    float shadowFactor = isInShadow(depthMapTexture[i][0], pTexCoord[i][0], input.lightViewPos[i][0], bias[i]);
-                    
-                    if (shadowFactor)
-                    {
-                        lightColour += shadowFactor * atten * calculateSpotlight(lightVec, normalize(input.normal), textureColour, normalize(input.viewVector), i);
-                    }
+                    lightColour += shadowFactor * atten * calculateSpotlight(lightVec, normalize(input.normal), textureColour, normalize(input.viewVector), i);
                 }
                 lightColour += ambient[i] * textureColour;
                 break;
@@ -4,8 +4,6 @@ cbuffer MatrixBuffer : register(b0)
     matrix worldMatrix;
     matrix viewMatrix;
     matrix projectionMatrix;
-    matrix lightViewMatrix[4][6];
-    matrix lightProjectionMatrix[4];
 };
 
 cbuffer CameraBuffer : register(b2)
@@ -28,7 +26,6 @@ struct OutputType
     float3 normal : NORMAL;
     float3 viewVector : TEXCOORD1;    
     float3 worldPosition : TEXCOORD2;    
-    float4 lightViewPos[4][6] : TEXCOORD3;
 };
 
 
@@ -41,17 +38,6 @@ OutputType main(InputType input)
     output.position = mul(output.position, viewMatrix);
     output.position = mul(output.position, projectionMatrix);
     
-	// Calculate the position of the vertex as viewed by the light source.
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j < 6; j++)
-        {
-            output.lightViewPos[i][j] = mul(input.position, worldMatrix);
-            output.lightViewPos[i][j] = mul(output.lightViewPos[i][j], lightViewMatrix[i][j]);
-            output.lightViewPos[i][j] = mul(output.lightViewPos[i][j], lightProjectionMatrix[i]);
-        }
-    }
-    
     output.tex = input.tex;
     output.normal = mul(input.normal, (float3x3) worldMatrix);
     output.normal = normalize(output.normal);
@@ -0,0 +1,45 @@
+// Summed area table box pixel shader
+// Blurs with a few stacked box averages (see StackedBoxes.h), each one 4 loads from the summed area table whatever its
+// size. Boxes are cut off at the edges of the image and averaged over what's left of them
+Texture2D summedArea : register(t0);
+
+cbuffer BoxBuffer : register(b0)
+{
+    int4 radii; // texels either side of the centre, smallest first
+    float4 weights; // of each box's average, unused boxes weigh nothing
+    int boxCount;
+    float3 padding;
+};
+
+struct InputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+};
+
+float4 main(InputType input) : SV_TARGET
+{
+    // the table is a texel bigger than the image, its first row and column are zero
+    float tableWidth, tableHeight;
+    summedArea.GetDimensions(tableWidth, tableHeight);
+    int2 size = int2(tableWidth, tableHeight) - 1;
+    int2 texel = (int2)input.position.xy;
+
+    float4 colour = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    [unroll]
+    for (int i = 0; i < 4; i++)
+    {
+        if (i < boxCount)
+        {
+            // table texel (x, y) is the sum of the image texels before x and y
+            int2 first = max(texel - radii[i], 0);
+            int2 last = min(texel + radii[i] + 1, size);
+            float4 sum = summedArea.Load(int3(last.x, last.y, 0)) - summedArea.Load(int3(first.x, last.y, 0)) - summedArea.Load(int3(last.x, first.y, 0)) + summedArea.Load(int3(first.x, first.y, 0));
+            float area = (last.x - first.x) * (last.y - first.y);
+            colour += sum * (weights[i] / area);
+        }
+    }
+
+    colour.a = 1.0f;
+    return colour;
+}
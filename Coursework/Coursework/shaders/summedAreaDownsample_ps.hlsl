@@ -0,0 +1,66 @@
+// Summed area table downsample pixel shader
+// Box filters the scene down to the table's size, 4 bilinear taps a quarter of a table texel out from the centre cover
+// 4x4 scene texels. The table has an extra row and column of zeros at the top and left, so a box reaching the edge
+// of the image doesn't need a special case when it's looked up
+Texture2D shaderTexture : register(t0);
+SamplerState SampleType : register(s0);
+
+cbuffer DownsampleBuffer : register(b0)
+{
+    float2 cellSize; // one texel of the downsampled image in uv, the table is a texel bigger each way
+    float threshold;
+    int thresholdEnabled; // bloom thresholds the scene as it downsamples it
+};
+
+struct InputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+};
+
+// the pixel if r + g + b is over the threshold, otherwise black
+float4 applyThreshold(float4 colour)
+{
+    return (colour.r + colour.g + colour.b > threshold) ? colour : float4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// bilinear blend of the thresholded texels, the same as sampling a full size thresholded copy of the texture
+float4 sampleThresholded(float2 uv)
+{
+    float width, height;
+    shaderTexture.GetDimensions(width, height);
+    float2 texel = clamp(uv * float2(width, height) - 0.5f, 0.0f, float2(width, height) - 1.0f);
+    int2 first = (int2)texel;
+    int2 second = min(first + 1, int2(width, height) - 1);
+    float2 blend = texel - first;
+
+    float4 top = lerp(applyThreshold(shaderTexture.Load(int3(first.x, first.y, 0))), applyThreshold(shaderTexture.Load(int3(second.x, first.y, 0))), blend.x);
+    float4 bottom = lerp(applyThreshold(shaderTexture.Load(int3(first.x, second.y, 0))), applyThreshold(shaderTexture.Load(int3(second.x, second.y, 0))), blend.x);
+    return lerp(top, bottom, blend.y);
+}
+
+float4 sampleSource(float2 uv)
+{
+    if (thresholdEnabled)
+        return sampleThresholded(uv);
+    return shaderTexture.Sample(SampleType, uv);
+}
+
+float4 main(InputType input) : SV_TARGET
+{
+    int2 texel = (int2)input.position.xy;
+    if (texel.x == 0 || texel.y == 0)
+        return float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // table texel (x, y) holds image texel (x - 1, y - 1)
+    float2 uv = (texel - 0.5f) * cellSize;
+    float2 spread = cellSize * 0.25f;
+    float4 colour = sampleSource(uv + float2(-spread.x, -spread.y));
+    colour += sampleSource(uv + float2(spread.x, -spread.y));
+    colour += sampleSource(uv + float2(-spread.x, spread.y));
+    colour += sampleSource(uv + float2(spread.x, spread.y));
+    colour *= 0.25f;
+
+    colour.a = 1.0f;
+    return colour;
+}
@@ -0,0 +1,33 @@
+// Summed area table scan pixel shader
+// One pass of the prefix sum along a row or a column. Each texel adds the texels 1, 2 and 3 strides before it and each
+// pass multiplies the stride by 4, so after log4(size) passes every texel holds the sum of itself and everything
+// before it. Rows then columns makes the summed area table
+Texture2D shaderTexture : register(t0);
+
+cbuffer ScanBuffer : register(b0)
+{
+    int2 direction; // (1, 0) along the rows, (0, 1) down the columns
+    int stride;
+    int padding;
+};
+
+struct InputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+};
+
+float4 main(InputType input) : SV_TARGET
+{
+    int2 texel = (int2)input.position.xy;
+    float4 sum = shaderTexture.Load(int3(texel, 0));
+
+    [unroll]
+    for (int i = 1; i < 4; i++)
+    {
+        int2 previous = texel - direction * stride * i;
+        if (previous.x >= 0 && previous.y >= 0)
+            sum += shaderTexture.Load(int3(previous, 0));
+    }
+    return sum;
+}
@@ -1,16 +1,37 @@
-// Texture pixel/fragment shader
-// Basic fragment shader for rendering textured geometry
+// Tone map pixel shader
+// Final composite of the post processing. Adds the blurred or bloom texture to the scene and tone maps the result
+// straight to the back buffer, so there's no separate merge, tone map or copy pass at full resolution. The tone curve
+// and grade are baked into a 3D LUT on the CPU (ColourGrade), so the whole grade is one fetch. A blur or bloom made at a
+// reduced resolution is upsampled here too, guided by the reduced scene so it doesn't bleed across depth edges
 
 // Texture and sampler registers
-Texture2D texture0 : register(t0);
+Texture2D sceneTexture : register(t0);
+Texture2D bloomTexture : register(t1);
+Texture3D gradeLut : register(t2);
+Texture2D guideTexture : register(t3); // bilateralDownsample_ps's reduced scene, alpha is linear depth
+Texture2D<float> depthTexture : register(t4); // the scene's depth buffer
 SamplerState Sampler0 : register(s0);
+SamplerState LutSampler : register(s1);
 
 cbuffer ToneBuffer : register(b0)
 {
-    float exposure;
-    bool gammaCorrection;
-    bool pad;
-    float2 padding;
+    float sceneWeight; // 0 when only blurring
+    float bloomWeight; // bloom intensity, 1 when only blurring
+    float lutScale; // the LUT's coordinates are log2(colour) * lutScale + lutOffset, the offset includes the exposure
+    float lutOffset;
+    int toneMapping;
+    float3 padding;
+}
+
+cbuffer UpsampleBuffer : register(b1)
+{
+    int bilateral; // the bloom texture was made from the guide, otherwise it's sampled as it is
+    float2 guideSize;
+    float depthWeight; // one over the sigmas, 0 ignores depth or luminance
+    float luminanceWeight;
+    float nearPlane;
+    float farPlane;
+    float upsamplePadding;
 }
 
 struct InputType
@@ -21,24 +42,57 @@ struct InputType
 };
 
 
+float logLuminance(float3 colour)
+{
+    return log2(max(dot(colour, float3(0.2126f, 0.7152f, 0.0722f)), 1e-6f));
+}
+
+// joint bilateral upsample, PostProcessChain::jointBilateralUpsample is the reference. the bloom texture is sampled at
+// the 2x2 guide texels around the pixel, each weighted bilinearly and by how close the texel's depth and luminance are
+// to the full resolution pixel's
+float3 upsampleBloom(float2 tex, float2 position, float3 scene)
+{
+    float depth = max(nearPlane * farPlane / (farPlane - depthTexture.Load(int3((int2)position, 0)) * (farPlane - nearPlane)), 1e-6f);
+    float luminance = logLuminance(scene);
+
+    float2 texel = tex * guideSize - 0.5f;
+    int2 base = (int2)floor(texel);
+    float2 blend = texel - base;
+
+    float3 sum = 0.0f;
+    float weightSum = 0.0f;
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            int2 guide = clamp(base + int2(i, j), 0, (int2)guideSize - 1);
+            float4 guideTexel = guideTexture.Load(int3(guide, 0));
+            float depthDifference = (guideTexel.a - depth) / depth * depthWeight;
+            float luminanceDifference = (logLuminance(guideTexel.rgb) - luminance) * luminanceWeight;
+
+            // texels that are all too different fall back to bilinear
+            float edge = max(exp(-(depthDifference * depthDifference + luminanceDifference * luminanceDifference)), 1e-4f);
+            float weight = (i ? blend.x : 1.0f - blend.x) * (j ? blend.y : 1.0f - blend.y) * edge;
+            sum += bloomTexture.SampleLevel(Sampler0, (guide + 0.5f) / guideSize, 0).rgb * weight;
+            weightSum += weight;
+        }
+    }
+    return sum / weightSum;
+}
+
 float4 main(InputType input) : SV_TARGET
 {
-	// Sample the pixel color from the texture using the sampler at this texture coordinate location.
-    float4 textureColour = texture0.Sample(Sampler0, input.tex);
-    
-    // apply tone mapping
-    // https://learnopengl.com/Advanced-Lighting/HDR
-    
-    float gamma = 2.2f;
-    float3 colour = textureColour.rgb;    
-    // reinhard tone mapping
-    colour *= exposure;
-    colour = colour / (colour + 1.0f);
-    // gamma correction
-    if(gammaCorrection)
-        colour = pow(colour, gamma);
-    
-    // return the LDR colour
-    return saturate(float4(colour, 1.0f));
-    
-}
\ No newline at end of file
+    // the same sum bloomMerge_ps makes
+    float3 scene = sceneTexture.Sample(Sampler0, input.tex).rgb;
+    float3 bloom;
+    if (bilateral)
+        bloom = upsampleBloom(input.tex, input.position.xy, scene);
+    else
+        bloom = bloomTexture.Sample(Sampler0, input.tex).rgb;
+    float3 colour = bloom * bloomWeight + scene * sceneWeight;
+
+    if (!toneMapping)
+        return float4(colour, 1.0f);
+
+    // exposure, tone curve, grade and gamma in one trilinear fetch. the LUT's edges clamp anything outside its range
+    float3 coordinates = log2(max(colour, 1e-10f)) * lutScale + lutOffset;
+    return float4(gradeLut.Sample(LutSampler, coordinates).rgb, 1.0f);
+}
@@ -0,0 +1,3 @@
+// Vertical blur pixel shader, radius 12
+#define BLUR_RADIUS 12
+#include "verticalBlur_ps.hlsl"
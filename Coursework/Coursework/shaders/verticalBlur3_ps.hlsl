@@ -0,0 +1,3 @@
+// Vertical blur pixel shader, radius 3
+#define BLUR_RADIUS 3
+#include "verticalBlur_ps.hlsl"
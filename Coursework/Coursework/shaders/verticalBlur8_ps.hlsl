@@ -0,0 +1,3 @@
+// Vertical blur pixel shader, radius 8
+#define BLUR_RADIUS 8
+#include "verticalBlur_ps.hlsl"
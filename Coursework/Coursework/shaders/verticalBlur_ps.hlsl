@@ -1,3 +1,15 @@
+// Vertical blur pixel shader
+// Gaussian blur of radius BLUR_RADIUS, the wrapper shaders (verticalBlur3_ps...) compile the other radii.
+// Taps come in pairs merged into one bilinear sample, see GaussianKernel.h
+#ifndef BLUR_RADIUS
+#define BLUR_RADIUS 5
+#endif
+#include "../GaussianKernels.h"
+
+static const int SAMPLES = GAUSSIAN_KERNEL(BLUR_RADIUS, SAMPLES);
+static const float WEIGHTS[SAMPLES] = GAUSSIAN_KERNEL(BLUR_RADIUS, WEIGHTS);
+static const float OFFSETS[SAMPLES] = GAUSSIAN_KERNEL(BLUR_RADIUS, OFFSETS);
+
 Texture2D shaderTexture : register(t0);
 SamplerState SampleType : register(s0);
 
@@ -15,39 +27,18 @@ struct InputType
 
 float4 main(InputType input) : SV_TARGET
 {
-    float weight[6];
-    float2 blurCoords[11];
-    float4 colour;
-
-	// Create the weights that each neighbor pixel will contribute to the blur.   
-    // 0.2476614 + 0.230713 + 0.0321703 + 0.075984 + 0.028002 + 0.0093 + 0.230713 + 0.0321703 + 0.075984 + 0.028002 + 0.0093 = 1
-    weight[0] = 0.2476614;
-    weight[1] = 0.230713;
-    weight[2] = 0.075984;
-    weight[3] = 0.0321703;
-    weight[4] = 0.028002;
-    weight[5] = 0.0093;
-
-    // Initialize the colour to black.
-    colour = float4(0.0f, 0.0f, 0.0f, 0.0f);
-
     float texelSize = 1.0f / screenHeight;
-    // Add the vertical pixels to the colour by the specific weight of each.
-    
-    // sets the blur coordinates
-    for (int i = -5; i <= 5; i++)
+
+    // the centre, then each merged pair either side of it
+    float4 colour = shaderTexture.Sample(SampleType, input.tex) * WEIGHTS[0];
+    [unroll]
+    for (int i = 1; i < SAMPLES; i++)
     {
-        blurCoords[i + 5] = input.tex + float2(0.0f, texelSize * i);
+        float2 offset = float2(0.0f, texelSize * OFFSETS[i]);
+        colour += (shaderTexture.Sample(SampleType, input.tex - offset) + shaderTexture.Sample(SampleType, input.tex + offset)) * WEIGHTS[i];
     }
-    
-    // add the neighboring texels
-    for (int j = -5; j <= 5; j++)
-    {
-        colour += shaderTexture.Sample(SampleType, blurCoords[j + 5]) * weight[abs(j)];
-    }  
-    
+
     // Set the alpha channel to one.
     colour.a = 1.0f;
     return colour;
 }
-
@@ -7,6 +7,8 @@ BaseMesh::BaseMesh()
 {
 	vertexBuffer = nullptr;
 	indexBuffer = nullptr;
+	positionBuffer = nullptr;
+	positionTextureBuffer = nullptr;
 	vertexCount = 0;
 	indexCount = 0;
 
@@ -26,6 +28,18 @@ BaseMesh::~BaseMesh()
 		vertexBuffer->Release();
 		vertexBuffer = 0;
 	}
+
+	if (positionBuffer)
+	{
+		positionBuffer->Release();
+		positionBuffer = 0;
+	}
+
+	if (positionTextureBuffer)
+	{
+		positionTextureBuffer->Release();
+		positionTextureBuffer = 0;
+	}
 }
 
 int BaseMesh::getIndexCount()
@@ -49,6 +63,97 @@ void BaseMesh::sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLO
 	deviceContext->IASetPrimitiveTopology(top);
 }
 
+// Depth passes only read positions, plus texture coordinates for displaced geometry. Reads the vertex buffer back once
+// and keeps a copy of just those, so shadow passes fetch 12 or 20 bytes per vertex instead of 32.
+void BaseMesh::buildDepthStreams(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+{
+	D3D11_BUFFER_DESC vertexBufferDesc;
+	D3D11_SUBRESOURCE_DATA vertexData;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	ID3D11Buffer* stagingBuffer;
+
+	if (!vertexBuffer || positionBuffer)
+	{
+		return;
+	}
+
+	// Copy the vertices somewhere the CPU can read them.
+	vertexBuffer->GetDesc(&vertexBufferDesc);
+	vertexBufferDesc.Usage = D3D11_USAGE_STAGING;
+	vertexBufferDesc.BindFlags = 0;
+	vertexBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	vertexBufferDesc.MiscFlags = 0;
+	stagingBuffer = 0;
+	if (device->CreateBuffer(&vertexBufferDesc, NULL, &stagingBuffer) != S_OK)
+	{
+		return;
+	}
+	deviceContext->CopyResource(stagingBuffer, vertexBuffer);
+
+	int count = vertexBufferDesc.ByteWidth / sizeof(VertexType);
+	XMFLOAT3* positions = new XMFLOAT3[count];
+	VertexType_Texture* positionTextures = new VertexType_Texture[count];
+
+	deviceContext->Map(stagingBuffer, 0, D3D11_MAP_READ, 0, &mappedResource);
+	VertexType* vertices = (VertexType*)mappedResource.pData;
+	for (int i = 0; i < count; i++)
+	{
+		positions[i] = vertices[i].position;
+		positionTextures[i].position = vertices[i].position;
+		positionTextures[i].texture = vertices[i].texture;
+	}
+	deviceContext->Unmap(stagingBuffer, 0);
+	stagingBuffer->Release();
+	stagingBuffer = 0;
+
+	// Set up the description of the depth streams.
+	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	vertexBufferDesc.ByteWidth = sizeof(XMFLOAT3) * count;
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vertexBufferDesc.CPUAccessFlags = 0;
+	vertexBufferDesc.MiscFlags = 0;
+	vertexBufferDesc.StructureByteStride = 0;
+	vertexData.pSysMem = positions;
+	vertexData.SysMemPitch = 0;
+	vertexData.SysMemSlicePitch = 0;
+	device->CreateBuffer(&vertexBufferDesc, &vertexData, &positionBuffer);
 
+	vertexBufferDesc.ByteWidth = sizeof(VertexType_Texture) * count;
+	vertexData.pSysMem = positionTextures;
+	device->CreateBuffer(&vertexBufferDesc, &vertexData, &positionTextureBuffer);
 
+	delete[] positions;
+	positions = 0;
+	delete[] positionTextures;
+	positionTextures = 0;
+}
 
+// Sends the depth stream with the same index buffer. The position only and position/texture layouts match the start of
+// VertexType, so the full vertices work with either if the streams weren't built.
+void BaseMesh::sendDepthData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top, bool texture)
+{
+	unsigned int stride;
+	unsigned int offset;
+	ID3D11Buffer* buffer;
+
+	if (texture && positionTextureBuffer)
+	{
+		buffer = positionTextureBuffer;
+		stride = sizeof(VertexType_Texture);
+	}
+	else if (!texture && positionBuffer)
+	{
+		buffer = positionBuffer;
+		stride = sizeof(XMFLOAT3);
+	}
+	else
+	{
+		buffer = vertexBuffer;
+		stride = sizeof(VertexType);
+	}
+	offset = 0;
+
+	deviceContext->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+	deviceContext->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	deviceContext->IASetPrimitiveTopology(top);
+}
@@ -178,6 +178,69 @@ void BaseShader::loadTextureVertexShader(const wchar_t* filename)
 	vertexShaderBuffer = 0;
 }
 
+void BaseShader::loadPositionVertexShader(const wchar_t* filename)
+{
+	ID3DBlob* vertexShaderBuffer;
+	
+	unsigned int numElements;
+
+	vertexShaderBuffer = 0;
+
+	// check file extension for correct loading function.
+	std::wstring fn(filename);
+	std::string::size_type idx;
+	std::wstring extension;
+
+	idx = fn.rfind('.');
+
+	if (idx != std::string::npos)
+	{
+		extension = fn.substr(idx + 1);
+	}
+	else
+	{
+		// No extension found
+		MessageBox(hwnd, L"Error finding vertex shader file", L"ERROR", MB_OK);
+		exit(0);
+	}
+
+	// Load the texture in.
+	if (extension != L"cso")
+	{
+		MessageBox(hwnd, L"Incorrect vertex shader file type", L"ERROR", MB_OK);
+		exit(0);
+	}
+
+	// Reads compiled shader into buffer (bytecode).
+	HRESULT result = D3DReadFileToBlob(filename, &vertexShaderBuffer);
+	if (result != S_OK)
+	{
+		MessageBox(NULL, filename, L"File ERROR", MB_OK);
+		exit(0);
+	}
+
+	// Create the vertex shader from the buffer.
+	renderer->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &vertexShader);
+
+	// Create the vertex input layout description.
+	// This setup needs to match the VertexType stucture in the MeshClass and in the shader.
+
+	// Depth passes only need the position, it's first in every vertex type so this also reads full vertices.
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	// Get a count of the elements in the layout.
+	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
+
+	// Create the vertex input layout.
+	renderer->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &layout);
+
+	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
+	vertexShaderBuffer->Release();
+	vertexShaderBuffer = 0;
+}
+
 void BaseShader::loadColourVertexShader(const wchar_t* filename)
 {
 	ID3DBlob* vertexShaderBuffer;
@@ -461,8 +524,24 @@ void BaseShader::loadComputeShader(const wchar_t* filename)
 	computeShaderBuffer->Release();
 }
 
-// De/Activate shader stages and send shaders to GPU.
+// Sets the shader stages and draws the indexed data.
 void BaseShader::render(ID3D11DeviceContext* deviceContext, int indexCount)
+{
+	setShaders(deviceContext);
+
+	// Render the triangle.
+	deviceContext->DrawIndexed(indexCount, 0, 0);
+}
+
+// Draws the vertices written by the last stream output pass, the vertex count never has to come back to the CPU.
+void BaseShader::renderAuto(ID3D11DeviceContext* deviceContext)
+{
+	setShaders(deviceContext);
+	deviceContext->DrawAuto();
+}
+
+// De/Activate shader stages and send shaders to GPU.
+void BaseShader::setShaders(ID3D11DeviceContext* deviceContext)
 {
 	// Set the vertex input layout.
 	deviceContext->IASetInputLayout(layout);
@@ -493,9 +572,6 @@ void BaseShader::render(ID3D11DeviceContext* deviceContext, int indexCount)
 	{
 		deviceContext->GSSetShader(NULL, NULL, 0);
 	}
-
-	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
 }
 
 // Dispatch the compute shader.
@@ -3,7 +3,7 @@
 #include "rendertexture.h"
 
 // Initialise texture object based on provided dimensions. Usually to match window.
-RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextureHeight, float screenNear, float screenFar)
+RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextureHeight, float screenNear, float screenFar, DXGI_FORMAT format)
 {
 	D3D11_TEXTURE2D_DESC textureDesc;
 	HRESULT result;
@@ -14,6 +14,7 @@ RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextu
 
 	textureWidth = ltextureWidth;
 	textureHeight = ltextureHeight;
+	textureFormat = format;
 
 	ZeroMemory(&textureDesc, sizeof(textureDesc));
 
@@ -22,7 +23,7 @@ RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextu
 	textureDesc.Height = textureHeight;
 	textureDesc.MipLevels = 1;
 	textureDesc.ArraySize = 1;
-	textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	textureDesc.Format = textureFormat;
 	textureDesc.SampleDesc.Count = 1;
 	textureDesc.Usage = D3D11_USAGE_DEFAULT;
 	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
@@ -52,11 +53,11 @@ RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextu
 	depthBufferDesc.Height = textureHeight;
 	depthBufferDesc.MipLevels = 1;
 	depthBufferDesc.ArraySize = 1;
-	depthBufferDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthBufferDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
 	depthBufferDesc.SampleDesc.Count = 1;
 	depthBufferDesc.SampleDesc.Quality = 0;
 	depthBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	depthBufferDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	depthBufferDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
 	depthBufferDesc.CPUAccessFlags = 0;
 	depthBufferDesc.MiscFlags = 0;
 
@@ -72,6 +73,10 @@ RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextu
 
 	// Create the depth stencil view.
 	result = device->CreateDepthStencilView(depthStencilBuffer, &depthStencilViewDesc, &depthStencilView);
+
+	// Let shaders read the depth once it's no longer bound.
+	shaderResourceViewDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+	result = device->CreateShaderResourceView(depthStencilBuffer, &shaderResourceViewDesc, &depthShaderResourceView);
 	
 	// Setup the viewport for rendering.
 	viewport.Width = (float)textureWidth;
@@ -91,6 +96,12 @@ RenderTexture::RenderTexture(ID3D11Device* device, int ltextureWidth, int ltextu
 // Release resources.
 RenderTexture::~RenderTexture()
 {
+	if (depthShaderResourceView)
+	{
+		depthShaderResourceView->Release();
+		depthShaderResourceView = 0;
+	}
+
 	if (depthStencilView)
 	{
 		depthStencilView->Release();
@@ -149,6 +160,11 @@ ID3D11ShaderResourceView* RenderTexture::getShaderResourceView()
 	return shaderResourceView;
 }
 
+ID3D11ShaderResourceView* RenderTexture::getDepthShaderResourceView()
+{
+	return depthShaderResourceView;
+}
+
 XMMATRIX RenderTexture::getProjectionMatrix()
 {
 	return projectionMatrix;
@@ -167,4 +183,33 @@ int RenderTexture::getTextureWidth()
 int RenderTexture::getTextureHeight()
 {
 	return textureHeight;
+}
+
+DXGI_FORMAT RenderTexture::getFormat()
+{
+	return textureFormat;
+}
+
+int RenderTexture::getBytesPerTexel()
+{
+	switch (textureFormat)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		return 8;
+	case DXGI_FORMAT_R8_UNORM:
+		return 1;
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R8G8_UNORM:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+size_t RenderTexture::getMemorySize()
+{
+	// colour plus the D24S8 depth buffer
+	return (size_t)textureWidth * textureHeight * (getBytesPerTexel() + 4);
 }
\ No newline at end of file
@@ -32,28 +32,34 @@ public:
 	}
 
 	/** \brief Initialises render textures
-	*	Required renderer device, specified width and height of texture/target, and near + far planes
+	*	Required renderer device, specified width and height of texture/target, and near + far planes. Format defaults to 32 bit float RGBA
 	*/
-	RenderTexture(ID3D11Device* device, int textureWidth, int textureHeight, float screenNear, float screenDepth);
+	RenderTexture(ID3D11Device* device, int textureWidth, int textureHeight, float screenNear, float screenDepth, DXGI_FORMAT format = DXGI_FORMAT_R32G32B32A32_FLOAT);
 	~RenderTexture();
 
 	void setRenderTarget(ID3D11DeviceContext* deviceContext);		///< Set this render texture as the render target
 	void clearRenderTarget(ID3D11DeviceContext* deviceContext, float red, float green, float blue, float alpha);	///< Empties the render texture, provide device context and RGBA (background colour)
 	ID3D11ShaderResourceView* getShaderResourceView();			///< Get the data from this render target as a texture resource.
+	ID3D11ShaderResourceView* getDepthShaderResourceView();		///< Get the depth buffer as a texture resource, R is the projected depth
 
 	XMMATRIX getProjectionMatrix();		///< Get the projection matrix related to this render target (Could be different based on dimensions or near/far plane)
 	XMMATRIX getOrthoMatrix();			///< Get the orthographics matrix stored within this render target (could be different based on dimension)
 
 	int getTextureWidth();		///< Get width of this render texture
 	int getTextureHeight();		///< Get height of this render texture
+	DXGI_FORMAT getFormat();	///< Get the colour format of this render texture
+	int getBytesPerTexel();		///< Get the size of one colour texel
+	size_t getMemorySize();		///< Get the bytes used by the colour and depth textures
 
 private:
 	int textureWidth, textureHeight;
+	DXGI_FORMAT textureFormat;
 	ID3D11Texture2D* renderTargetTexture;
 	ID3D11RenderTargetView* renderTargetView;
 	ID3D11ShaderResourceView* shaderResourceView;
 	ID3D11Texture2D* depthStencilBuffer;
 	ID3D11DepthStencilView* depthStencilView;
+	ID3D11ShaderResourceView* depthShaderResourceView;
 	D3D11_VIEWPORT viewport;
 	XMMATRIX projectionMatrix;
 	XMMATRIX orthoMatrix;
@@ -1,16 +1,39 @@
 #include "ShadowMap.h"
 
-ShadowMap::ShadowMap(ID3D11Device* device, int mWidth, int mHeight)
+ShadowMap::ShadowMap(ID3D11Device* device, int mWidth, int mHeight, int arraySize, bool cube, DXGI_FORMAT format)
 {
+	width = mWidth;
+	height = mHeight;
+	sliceCount = cube ? arraySize * 6 : arraySize;
+	depthFormat = format;
+
 	// Use typeless format because the DSV is going to interpret
-	// the bits as DXGI_FORMAT_D24_UNORM_S8_UINT, whereas the SRV is going to interpret
-	// the bits as DXGI_FORMAT_R24_UNORM_X8_TYPELESS.
+	// the bits as a depth format, whereas the SRV is going to interpret
+	// the bits as a colour format.
+	DXGI_FORMAT textureFormat, srvFormat;
+	switch (depthFormat)
+	{
+	case DXGI_FORMAT_D16_UNORM:
+		textureFormat = DXGI_FORMAT_R16_TYPELESS;
+		srvFormat = DXGI_FORMAT_R16_UNORM;
+		break;
+	case DXGI_FORMAT_D32_FLOAT:
+		textureFormat = DXGI_FORMAT_R32_TYPELESS;
+		srvFormat = DXGI_FORMAT_R32_FLOAT;
+		break;
+	default:
+		depthFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		textureFormat = DXGI_FORMAT_R24G8_TYPELESS;
+		srvFormat = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+		break;
+	}
+
 	D3D11_TEXTURE2D_DESC texDesc;
 	texDesc.Width = mWidth;
 	texDesc.Height = mHeight;
 	texDesc.MipLevels = 1;
-	texDesc.ArraySize = 1;
-	texDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
+	texDesc.ArraySize = sliceCount;
+	texDesc.Format = textureFormat;
 	texDesc.SampleDesc.Count = 1;
 	texDesc.SampleDesc.Quality = 0;
 	texDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -21,18 +44,45 @@ ShadowMap::ShadowMap(ID3D11Device* device, int mWidth, int mHeight)
 	//ID3D11Texture2D* depthMap = 0;
 	device->CreateTexture2D(&texDesc, 0, &depthMap);
 
-	D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-	dsvDesc.Flags = 0;
-	dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-	dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	dsvDesc.Texture2D.MipSlice = 0;
-	device->CreateDepthStencilView(depthMap, &dsvDesc, &mDepthMapDSV);
+	// Each slice gets its own depth view so it can be rendered to separately.
+	mDepthMapDSV = new ID3D11DepthStencilView*[sliceCount];
+	for (int i = 0; i < sliceCount; i++)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc;
+		dsvDesc.Flags = 0;
+		dsvDesc.Format = depthFormat;
+		if (sliceCount == 1)
+		{
+			dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+			dsvDesc.Texture2D.MipSlice = 0;
+		}
+		else
+		{
+			dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+			dsvDesc.Texture2DArray.MipSlice = 0;
+			dsvDesc.Texture2DArray.FirstArraySlice = i;
+			dsvDesc.Texture2DArray.ArraySize = 1;
+		}
+		device->CreateDepthStencilView(depthMap, &dsvDesc, &mDepthMapDSV[i]);
+	}
 
+	// A single SRV covers every slice.
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-	srvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = texDesc.MipLevels;
-	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Format = srvFormat;
+	if (sliceCount == 1)
+	{
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = texDesc.MipLevels;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MipLevels = texDesc.MipLevels;
+		srvDesc.Texture2DArray.MostDetailedMip = 0;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = sliceCount;
+	}
 	device->CreateShaderResourceView(depthMap, &srvDesc, &mDepthMapSRV);
 
 	// Setup the viewport for rendering.
@@ -44,23 +94,54 @@ ShadowMap::ShadowMap(ID3D11Device* device, int mWidth, int mHeight)
 	viewport.TopLeftY = 0.0f;
 
 	//NULL render target
-	renderTargets[1] = { 0 };
+	renderTargets[0] = 0;
 }
 
 ShadowMap::~ShadowMap()
 {
-	delete mDepthMapDSV;
-	delete mDepthMapSRV;
+	// views and texture are COM objects, release rather than delete
+	if (mDepthMapDSV)
+	{
+		for (int i = 0; i < sliceCount; i++)
+		{
+			if (mDepthMapDSV[i])
+			{
+				mDepthMapDSV[i]->Release();
+			}
+		}
+		delete[] mDepthMapDSV;
+		mDepthMapDSV = 0;
+	}
+	if (mDepthMapSRV)
+	{
+		mDepthMapSRV->Release();
+		mDepthMapSRV = 0;
+	}
+	if (depthMap)
+	{
+		depthMap->Release();
+		depthMap = 0;
+	}
 }
 
-void ShadowMap::BindDsvAndSetNullRenderTarget(ID3D11DeviceContext* dc)
+void ShadowMap::BindDsvAndSetNullRenderTarget(ID3D11DeviceContext* dc, int slice)
 {
 	dc->RSSetViewports(1, &viewport);
 
 	// Set null render target because we are only going to draw to depth buffer.
 	// Setting a null render target will disable color writes.
 	//ID3D11RenderTargetView* renderTargets[1] = { 0 };
-	dc->OMSetRenderTargets(1, renderTargets, mDepthMapDSV);
+	dc->OMSetRenderTargets(1, renderTargets, mDepthMapDSV[slice]);
+
+	dc->ClearDepthStencilView(mDepthMapDSV[slice], D3D11_CLEAR_DEPTH, 1.0f, 0);
+}
 
-	dc->ClearDepthStencilView(mDepthMapDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
+int ShadowMap::getBytesPerTexel()
+{
+	return depthFormat == DXGI_FORMAT_D16_UNORM ? 2 : 4;
+}
+
+size_t ShadowMap::getMemorySize()
+{
+	return (size_t)width * height * sliceCount * getBytesPerTexel();
 }
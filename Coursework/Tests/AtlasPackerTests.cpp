@@ -0,0 +1,146 @@
+// Atlas packer tests
+#include "Test.h"
+#include "AtlasPacker.h"
+#include <random>
+
+static bool isPowerOfTwo(int x)
+{
+	return x > 0 && (x & (x - 1)) == 0;
+}
+
+// everything a layout has to be: each tile its request scaled down, inside the atlas and not overlapping another
+static void checkLayout(const AtlasPacker& packer, const std::vector<int>& sizes)
+{
+	const std::vector<AtlasPacker::Rect>& rects = packer.getRects();
+	CHECK(rects.size() == sizes.size());
+	CHECK(isPowerOfTwo(packer.getWidth()));
+	CHECK(packer.getWidth() <= packer.getMaxSize());
+	CHECK(packer.getHeight() <= packer.getMaxSize());
+
+	int bottom = 0;
+	for (size_t i = 0; i < rects.size() && i < sizes.size(); i++) {
+		const AtlasPacker::Rect& a = rects[i];
+		CHECK(a.size == sizes[i] >> packer.getScaleShift());
+		CHECK(a.x >= 0 && a.y >= 0);
+		CHECK(a.x + a.size <= packer.getWidth() && a.y + a.size <= packer.getHeight());
+		bottom = a.y + a.size > bottom ? a.y + a.size : bottom;
+
+		for (size_t j = i + 1; j < rects.size(); j++) {
+			const AtlasPacker::Rect& b = rects[j];
+			bool apart = a.x + a.size <= b.x || b.x + b.size <= a.x || a.y + a.size <= b.y || b.y + b.size <= a.y;
+			CHECK(apart);
+		}
+	}
+
+	// the atlas is no taller than the tiles need
+	CHECK(packer.getHeight() == bottom);
+}
+
+TEST(atlasPackerEmpty)
+{
+	AtlasPacker packer;
+	CHECK(packer.pack(std::vector<int>()));
+	CHECK(packer.getRects().empty());
+	CHECK(packer.getWidth() == 0 && packer.getHeight() == 0);
+}
+
+TEST(atlasPackerFitsWithoutScaling)
+{
+	// four equal tiles fill the smallest atlas exactly
+	AtlasPacker packer(8192);
+	std::vector<int> sizes(4, 1024);
+	CHECK(packer.pack(sizes));
+	checkLayout(packer, sizes);
+	CHECK(packer.getScaleShift() == 0);
+	CHECK(packer.getWidth() * packer.getHeight() == 4 * 1024 * 1024);
+
+	// and a tile the size of the largest atlas still fits on its own
+	sizes.assign(1, 8192);
+	CHECK(packer.pack(sizes));
+	checkLayout(packer, sizes);
+	CHECK(packer.getScaleShift() == 0);
+}
+
+TEST(atlasPackerHalvesToFit)
+{
+	// two of the largest tiles only fit at half size
+	AtlasPacker packer(8192);
+	std::vector<int> sizes(2, 8192);
+	CHECK(packer.pack(sizes));
+	checkLayout(packer, sizes);
+	CHECK(packer.getScaleShift() == 1);
+}
+
+TEST(atlasPackerSmallTiles)
+{
+	// tiles under 16 texels are never scaled, but still pack at full size
+	AtlasPacker packer(64);
+	std::vector<int> sizes(3, 8);
+	CHECK(packer.pack(sizes));
+	checkLayout(packer, sizes);
+	CHECK(packer.getScaleShift() == 0);
+}
+
+TEST(atlasPackerFailure)
+{
+	// 16 texel tiles are the smallest the packer scales to, a 64 x 64 atlas only has room for 16 of them
+	AtlasPacker packer(64);
+	std::vector<int> sizes(17, 64);
+	CHECK(!packer.pack(sizes));
+	CHECK(packer.getRects().empty());
+	CHECK(packer.getWidth() == 0 && packer.getHeight() == 0);
+
+	// a later pack that fits recovers
+	sizes.resize(16);
+	CHECK(packer.pack(sizes));
+	checkLayout(packer, sizes);
+	CHECK(packer.getScaleShift() == 2);
+}
+
+TEST(atlasPackerFuzz)
+{
+	std::mt19937 random(26);
+	const int maxSizes[4] = { 1024, 2048, 4096, 8192 };
+	int failures = 0;
+
+	for (int run = 0; run < 2000; run++) {
+		AtlasPacker packer(maxSizes[random() % 4]);
+		std::vector<int> sizes(1 + random() % 32);
+		for (size_t i = 0; i < sizes.size(); i++)
+			sizes[i] = 16 + (int)(random() % 4081);
+
+		if (packer.pack(sizes)) {
+			checkLayout(packer, sizes);
+		}
+		else {
+			// a failure leaves nothing half built
+			CHECK(packer.getRects().empty());
+			CHECK(packer.getWidth() == 0 && packer.getHeight() == 0);
+			failures++;
+		}
+	}
+
+	// tiles can always be halved until 32 of them fit, so none of these should fail
+	CHECK(failures == 0);
+}
+
+BENCHMARK(atlasPackerBenchmark)
+{
+	// the app's heaviest request, 4 cascaded directional lights with 4 tiles each, and a worst case of mixed sizes
+	std::vector<int> cascades(16, 2048);
+	std::mt19937 random(26);
+	std::vector<int> mixed(32);
+	for (size_t i = 0; i < mixed.size(); i++)
+		mixed[i] = 256 + (int)(random() % 3841);
+
+	const std::vector<int>* requests[2] = { &cascades, &mixed };
+	const char* names[2] = { "16 x 2048", "32 mixed" };
+	for (int r = 0; r < 2; r++) {
+		AtlasPacker packer(8192);
+		const int runs = 200;
+		Stopwatch timer;
+		for (int i = 0; i < runs; i++)
+			packer.pack(*requests[r]);
+		printf("  %s: %.3f ms per pack, %d x %d, scale shift %d\n", names[r], timer.elapsed() / runs, packer.getWidth(), packer.getHeight(), packer.getScaleShift());
+	}
+}
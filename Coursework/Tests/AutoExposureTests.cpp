@@ -0,0 +1,204 @@
+// Auto exposure tests
+#include "Test.h"
+#include "AutoExposure.h"
+#include <algorithm>
+#include <limits>
+
+// pixels with log2 luminances spread evenly from -12 to 8, past both ends of the histogram, and a few that aren't colours
+static std::vector<float> spreadPixels(int width, int height)
+{
+	std::vector<float> pixels((size_t)width * height * 4);
+	unsigned int random = 3;
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		random = random * 1664525u + 1013904223u;
+		float luminance = powf(2.0f, -12.0f + 20.0f * ((random >> 8) / 16777216.0f));
+		pixels[i * 4] = luminance * 1.1f;
+		pixels[i * 4 + 1] = luminance;
+		pixels[i * 4 + 2] = luminance * 0.8f;
+		pixels[i * 4 + 3] = 1.0f;
+	}
+	pixels[0] = std::numeric_limits<float>::quiet_NaN();
+	pixels[5] = std::numeric_limits<float>::infinity();
+	pixels[8] = -1.0f;
+	return pixels;
+}
+
+// the same bins with the library's log2 and one pixel at a time
+static void referenceHistogram(const AutoExposure::Settings& settings, const std::vector<float>& pixels, unsigned int histogram[AutoExposure::HISTOGRAM_BINS])
+{
+	float range = settings.maxLogLuminance - settings.minLogLuminance;
+	float darkest = powf(2.0f, settings.minLogLuminance);
+	std::fill(histogram, histogram + AutoExposure::HISTOGRAM_BINS, 0u);
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		float luminance = 0.2126f * pixels[i] + 0.7152f * pixels[i + 1] + 0.0722f * pixels[i + 2];
+		luminance = luminance > darkest ? luminance : darkest;
+		float bin = (log2f(luminance) - settings.minLogLuminance) * AutoExposure::HISTOGRAM_BINS / range;
+		bin = std::min(std::max(bin, 0.0f), (float)(AutoExposure::HISTOGRAM_BINS - 1));
+		histogram[(int)bin]++;
+	}
+}
+
+TEST(autoExposureHistogram)
+{
+	const int width = 1203, height = 677;
+	std::vector<float> pixels = spreadPixels(width, height);
+	AutoExposure one(1), several(4);
+	unsigned int histogram[AutoExposure::HISTOGRAM_BINS], threaded[AutoExposure::HISTOGRAM_BINS], expected[AutoExposure::HISTOGRAM_BINS];
+	one.buildHistogram(pixels.data(), width, height, histogram);
+	several.buildHistogram(pixels.data(), width, height, threaded);
+	referenceHistogram(one.getSettings(), pixels, expected);
+
+	// every pixel lands somewhere, NaN and negatives in the first bin, and the threads count the same. the fast log2 only
+	// moves pixels right on a bin's edge
+	unsigned int total = 0;
+	int moved = 0;
+	for (int b = 0; b < AutoExposure::HISTOGRAM_BINS; b++) {
+		total += histogram[b];
+		CHECK(histogram[b] == threaded[b]);
+		moved += abs((int)histogram[b] - (int)expected[b]);
+	}
+	CHECK(total == (unsigned int)(width * height));
+	CHECK(moved / 2 < width * height / 1000);
+
+	// luminances past the ends pile up in the end bins
+	CHECK(histogram[0] > 2 * histogram[1]);
+	CHECK(histogram[AutoExposure::HISTOGRAM_BINS - 1] > 2 * histogram[AutoExposure::HISTOGRAM_BINS - 2]);
+}
+
+TEST(autoExposureTrimmedAverage)
+{
+	const int width = 640, height = 360;
+	std::vector<float> pixels = spreadPixels(width, height);
+	AutoExposure exposure(1);
+	const AutoExposure::Settings& settings = exposure.getSettings();
+	unsigned int histogram[AutoExposure::HISTOGRAM_BINS];
+	exposure.buildHistogram(pixels.data(), width, height, histogram);
+
+	// every pixel's bin centre sorted, and the mean of the ones ranked between the percentiles
+	float binSize = (settings.maxLogLuminance - settings.minLogLuminance) / AutoExposure::HISTOGRAM_BINS;
+	std::vector<float> centres;
+	for (int b = 0; b < AutoExposure::HISTOGRAM_BINS; b++)
+		centres.insert(centres.end(), histogram[b], settings.minLogLuminance + (b + 0.5f) * binSize);
+	size_t low = (size_t)(centres.size() * settings.lowPercentile);
+	size_t high = (size_t)(centres.size() * settings.highPercentile);
+	double sum = 0.0;
+	for (size_t i = low; i < high; i++)
+		sum += centres[i];
+	CHECK_CLOSE(exposure.trimmedAverage(histogram), sum / (high - low), 1e-3);
+
+	// nothing measured is the key itself
+	unsigned int empty[AutoExposure::HISTOGRAM_BINS] = {};
+	CHECK_CLOSE(exposure.trimmedAverage(empty), log2f(settings.key), 1e-6);
+
+	// a flat grey image is exposed to the key, to within half a bin
+	std::vector<float> grey((size_t)64 * 64 * 4, 0.5f);
+	AutoExposure flat;
+	flat.measure(grey.data(), 64, 64);
+	CHECK(flat.getState() == AutoExposure::SETTLED);
+	CHECK_CLOSE(log2f(flat.getExposure() / (settings.key / 0.5f)), 0.0f, binSize / 2.0f + 1e-3f);
+}
+
+// WAITING takes the first measurement straight away, SETTLED holds it through small changes, ADAPTING_UP and
+// ADAPTING_DOWN close the gap at their own speeds until it's within the settle threshold
+TEST(autoExposureStates)
+{
+	AutoExposure exposure;
+	const AutoExposure::Settings& settings = exposure.getSettings();
+	float key = log2f(settings.key);
+	CHECK(exposure.getState() == AutoExposure::WAITING);
+	CHECK(exposure.update(0.016f) == 1.0f);
+
+	exposure.setMeasurement(key);
+	CHECK(exposure.getState() == AutoExposure::SETTLED);
+	CHECK_CLOSE(exposure.getExposure(), 1.0f, 1e-6f);
+
+	// inside the start threshold nothing moves
+	exposure.setMeasurement(key + settings.startThreshold * 0.6f);
+	exposure.update(0.016f);
+	CHECK(exposure.getState() == AutoExposure::SETTLED);
+	CHECK_CLOSE(exposure.getExposure(), 1.0f, 1e-6f);
+
+	// two stops brighter adapts down, closing 1 - e^(-speed * time) of the gap in stops
+	exposure.setMeasurement(key + 2.0f);
+	exposure.update(0.1f);
+	CHECK(exposure.getState() == AutoExposure::ADAPTING_DOWN);
+	CHECK_CLOSE(exposure.getExposure(), powf(2.0f, -2.0f * (1.0f - expf(-settings.speedDown * 0.1f))), 1e-5f);
+
+	int frames = 1;
+	while (exposure.getState() != AutoExposure::SETTLED && frames < 10000) {
+		exposure.update(1.0f / 60.0f);
+		frames++;
+	}
+	float downTime = frames / 60.0f;
+	CHECK(exposure.getState() == AutoExposure::SETTLED);
+	CHECK(fabsf(log2f(exposure.getExposure() / 0.25f)) < settings.settleThreshold);
+
+	// back to the key adapts up, and once adapting it carries on inside the start threshold until it settles
+	exposure.setMeasurement(key);
+	frames = 0;
+	do {
+		exposure.update(1.0f / 60.0f);
+		CHECK(exposure.getState() != AutoExposure::ADAPTING_DOWN);
+		frames++;
+	} while (exposure.getState() != AutoExposure::SETTLED && frames < 10000);
+	CHECK(fabsf(log2f(exposure.getExposure())) < settings.settleThreshold);
+
+	// eyes take longer to get used to the dark
+	CHECK(frames / 60.0f > downTime);
+
+	// a cut waits for the next measurement and jumps to it
+	exposure.reset();
+	CHECK(exposure.getState() == AutoExposure::WAITING);
+	exposure.setMeasurement(key - 3.0f);
+	CHECK_CLOSE(exposure.getExposure(), 8.0f, 1e-4f);
+}
+
+TEST(autoExposureFrameRateIndependent)
+{
+	AutoExposure sixty, twoForty;
+	sixty.setMeasurement(0.0f);
+	twoForty.setMeasurement(0.0f);
+	sixty.setMeasurement(3.0f);
+	twoForty.setMeasurement(3.0f);
+	for (int i = 0; i < 60; i++)
+		sixty.update(1.0f / 60.0f);
+	for (int i = 0; i < 240; i++)
+		twoForty.update(1.0f / 240.0f);
+	CHECK_CLOSE(sixty.getExposure() / twoForty.getExposure(), 1.0f, 1e-3f);
+}
+
+TEST(autoExposureLimits)
+{
+	AutoExposure exposure;
+	exposure.setMeasurement(-30.0f);
+	CHECK(exposure.getExposure() == exposure.getSettings().maxExposure);
+	exposure.reset();
+	exposure.setMeasurement(30.0f);
+	CHECK(exposure.getExposure() == exposure.getSettings().minExposure);
+
+	// an empty image isn't a measurement
+	exposure.reset();
+	exposure.measure(NULL, 0, 0);
+	CHECK(exposure.getState() == AutoExposure::WAITING);
+}
+
+// App1 measures ExposureMeter's 150x85 readback every frame
+BENCHMARK(autoExposureBenchmark)
+{
+	AutoExposure exposure(1);
+	unsigned int histogram[AutoExposure::HISTOGRAM_BINS];
+	const int sizes[2][2] = { { 1203, 677 }, { 150, 85 } };
+	for (int s = 0; s < 2; s++) {
+		std::vector<float> pixels = spreadPixels(sizes[s][0], sizes[s][1]);
+		const int runs = 20;
+		Stopwatch stopwatch;
+		for (int run = 0; run < runs; run++)
+			exposure.buildHistogram(pixels.data(), sizes[s][0], sizes[s][1], histogram);
+		double time = stopwatch.elapsed() / runs;
+
+		unsigned int expected[AutoExposure::HISTOGRAM_BINS];
+		Stopwatch reference;
+		referenceHistogram(exposure.getSettings(), pixels, expected);
+		printf("  %dx%d histogram: %.3f ms, one log2f at a time %.3f ms\n", sizes[s][0], sizes[s][1], time, reference.elapsed());
+	}
+}
@@ -0,0 +1,166 @@
+// Cascaded shadows tests
+#include "Test.h"
+#include "CascadedShadows.h"
+#include <random>
+
+static const float NEAR_PLANE = 0.1f;
+static const float FAR_PLANE = 150.0f;
+
+static XMMATRIX testProjection()
+{
+	return XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, NEAR_PLANE, 200.0f);
+}
+
+static XMMATRIX testView(float x, float y, float z, float yaw, float pitch)
+{
+	XMVECTOR eye = XMVectorSet(x, y, z, 1.0f);
+	XMVECTOR forward = XMVectorSet(sinf(yaw) * cosf(pitch), sinf(pitch), cosf(yaw) * cosf(pitch), 0.0f);
+	return XMMatrixLookToLH(eye, forward, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+}
+
+TEST(cascadeSplitsEndAtTheFarPlane)
+{
+	float splits[CascadedShadows::MAX_CASCADES];
+	for (int count = 1; count <= CascadedShadows::MAX_CASCADES; count++) {
+		CascadedShadows::calculateSplits(count, NEAR_PLANE, FAR_PLANE, 0.75f, splits);
+		CHECK(splits[count - 1] == FAR_PLANE);
+		float previous = NEAR_PLANE;
+		for (int i = 0; i < count; i++) {
+			CHECK(splits[i] > previous);
+			previous = splits[i];
+		}
+	}
+}
+
+TEST(cascadeSplitsBlendUniformAndLogarithmic)
+{
+	float uniform[4], logarithmic[4], blended[4];
+	CascadedShadows::calculateSplits(4, 1.0f, 256.0f, 0.0f, uniform);
+	CascadedShadows::calculateSplits(4, 1.0f, 256.0f, 1.0f, logarithmic);
+	CascadedShadows::calculateSplits(4, 1.0f, 256.0f, 0.5f, blended);
+
+	for (int i = 0; i < 3; i++) {
+		CHECK_CLOSE(uniform[i], 1.0f + 255.0f * (i + 1) / 4.0f, 1e-3f);
+		CHECK_CLOSE(logarithmic[i], powf(4.0f, (float)(i + 1)), 1e-3f);
+		CHECK_CLOSE(blended[i], (uniform[i] + logarithmic[i]) * 0.5f, 1e-3f);
+	}
+}
+
+TEST(cascadeFrustumCornersProjectToTheScreenEdges)
+{
+	XMMATRIX view = testView(3.0f, 2.0f, -8.0f, 0.6f, -0.3f);
+	XMMATRIX projection = testProjection();
+	XMMATRIX viewProjection = view * projection;
+
+	XMVECTOR corners[8];
+	CascadedShadows::getFrustumCorners(XMMatrixInverse(nullptr, view), projection, 5.0f, 40.0f, corners);
+	for (int i = 0; i < 8; i++) {
+		XMVECTOR clip = XMVector3TransformCoord(corners[i], viewProjection);
+		CHECK_CLOSE(fabsf(XMVectorGetX(clip)), 1.0f, 1e-4f);
+		CHECK_CLOSE(fabsf(XMVectorGetY(clip)), 1.0f, 1e-4f);
+
+		XMVECTOR viewSpace = XMVector3TransformCoord(corners[i], view);
+		CHECK_CLOSE(XMVectorGetZ(viewSpace), i < 4 ? 5.0f : 40.0f, 1e-3f);
+	}
+}
+
+TEST(cascadeSphereHoldsTheCornersWhateverTheOrientation)
+{
+	std::mt19937 random(29);
+	std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	XMMATRIX projection = testProjection();
+
+	float firstRadius = 0.0f;
+	for (int run = 0; run < 200; run++) {
+		XMMATRIX view = testView(position(random), position(random), position(random), angle(random), angle(random) * 0.5f);
+		XMVECTOR corners[8];
+		XMVECTOR centre;
+		float radius;
+		CascadedShadows::getFrustumCorners(XMMatrixInverse(nullptr, view), projection, 2.0f, 30.0f, corners);
+		CascadedShadows::fitSphere(corners, &centre, &radius);
+
+		for (int i = 0; i < 8; i++)
+			CHECK(XMVectorGetX(XMVector3Length(corners[i] - centre)) <= radius);
+
+		// rounded to sixteenths, and the same for every camera so the cascade never changes size
+		CHECK(radius * 16.0f == floorf(radius * 16.0f));
+		if (run == 0)
+			firstRadius = radius;
+		CHECK(radius == firstRadius);
+	}
+}
+
+TEST(cascadeSnapLandsOnTheTexelGrid)
+{
+	std::mt19937 random(30);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	const float radius = 12.5f;
+	const int resolution = 1024;
+	const float texelSize = radius * 2.0f / resolution;
+
+	for (int run = 0; run < 1000; run++) {
+		XMVECTOR original = XMVectorSet(position(random), position(random), position(random), 0.0f);
+		XMVECTOR snapped = CascadedShadows::snapToTexel(original, radius, resolution);
+
+		float x = XMVectorGetX(snapped) / texelSize;
+		float y = XMVectorGetY(snapped) / texelSize;
+		CHECK_CLOSE(x, roundf(x), 1e-3f);
+		CHECK_CLOSE(y, roundf(y), 1e-3f);
+
+		// moves down by less than a texel, never along the light's direction
+		float dx = XMVectorGetX(original) - XMVectorGetX(snapped);
+		float dy = XMVectorGetY(original) - XMVectorGetY(snapped);
+		CHECK(dx >= -1e-4f && dx < texelSize + 1e-4f);
+		CHECK(dy >= -1e-4f && dy < texelSize + 1e-4f);
+		CHECK(XMVectorGetZ(snapped) == XMVectorGetZ(original));
+	}
+}
+
+TEST(cascadesCoverTheirSliceOfTheFrustum)
+{
+	CascadedShadows cascades;
+	cascades.setCascadeCount(4);
+	XMMATRIX view = testView(10.0f, 5.0f, -20.0f, 0.4f, -0.2f);
+	XMMATRIX projection = testProjection();
+	XMMATRIX inverseView = XMMatrixInverse(nullptr, view);
+	cascades.update(view, projection, NEAR_PLANE, FAR_PLANE, XMFLOAT3(0.3f, -1.0f, 0.5f), 2048);
+
+	float start = NEAR_PLANE;
+	for (int c = 0; c < cascades.getCascadeCount(); c++) {
+		XMMATRIX lightViewProjection = cascades.getViewMatrix(c) * cascades.getProjectionMatrix(c);
+		XMVECTOR corners[8];
+		CascadedShadows::getFrustumCorners(inverseView, projection, start, cascades.getSplit(c), corners);
+		for (int i = 0; i < 8; i++) {
+			XMVECTOR clip = XMVector3TransformCoord(corners[i], lightViewProjection);
+			CHECK(fabsf(XMVectorGetX(clip)) <= 1.0f && fabsf(XMVectorGetY(clip)) <= 1.0f);
+			CHECK(XMVectorGetZ(clip) >= 0.0f && XMVectorGetZ(clip) <= 1.0f);
+		}
+		start = cascades.getSplit(c);
+	}
+}
+
+// a fixed world point has to land on the same sub-texel offset whatever the camera does, otherwise the shadow edges crawl
+TEST(cascadesDontShimmerAsTheCameraMoves)
+{
+	const int resolution = 1024;
+	CascadedShadows cascades;
+	cascades.setCascadeCount(3);
+	XMMATRIX projection = testProjection();
+	XMVECTOR point = XMVectorSet(1.234f, 0.5f, 7.89f, 1.0f);
+
+	float firstOffset[2] = { 0.0f, 0.0f };
+	for (int step = 0; step < 100; step++) {
+		XMMATRIX view = testView(step * 0.037f, 2.0f, step * 0.021f - 10.0f, 0.5f + step * 0.01f, -0.2f);
+		cascades.update(view, projection, NEAR_PLANE, FAR_PLANE, XMFLOAT3(-0.5f, -1.0f, 0.25f), resolution);
+
+		XMVECTOR clip = XMVector3TransformCoord(point, cascades.getViewMatrix(2) * cascades.getProjectionMatrix(2));
+		float texel[2] = { (XMVectorGetX(clip) * 0.5f + 0.5f) * resolution, (XMVectorGetY(clip) * 0.5f + 0.5f) * resolution };
+		for (int axis = 0; axis < 2; axis++) {
+			float offset = texel[axis] - floorf(texel[axis]);
+			if (step == 0)
+				firstOffset[axis] = offset;
+			CHECK_CLOSE(offset, firstOffset[axis], 0.01f);
+		}
+	}
+}
@@ -0,0 +1,158 @@
+// Colour grade tests
+#include "Test.h"
+#include "ColourGrade.h"
+#include <algorithm>
+
+static bool isFinite(float x)
+{
+	return x == x && x - x == 0.0f;
+}
+
+// the table looked up trilinearly against the grade worked out exactly, over random colours near the grey axis and well
+// away from it, at exposures inside the range the table covers. the errors are in 8 bit steps and the bound is on the
+// 99.9th percentile, the curve bends fastest where saturation pushes a channel into clipping, a texel or two is allowed that
+TEST(colourGradeLookupMatchesEvaluate)
+{
+	std::vector<ColourGrade::Settings> cases(5);
+	cases[1].gamma = 2.2f;
+	cases[2].toneCurve = ColourGrade::ACES;
+	cases[3] = cases[2];
+	cases[3].balance[0] = 1.1f;
+	cases[3].balance[2] = 0.8f;
+	cases[3].saturation = 1.3f;
+	cases[3].gamma = 2.2f;
+	cases[4] = cases[3];
+	cases[4].saturation = 0.6f;
+
+	for (size_t s = 0; s < cases.size(); s++) {
+		ColourGrade grade(4);
+		CHECK(grade.bake(cases[s]));
+
+		unsigned int random = 49;
+		auto next = [&random]() {
+			random = random * 1664525u + 1013904223u;
+			return (random >> 8) / 16777216.0f;
+		};
+		std::vector<float> errors;
+		for (int i = 0; i < 100000; i++) {
+			float exposure = powf(2.0f, -3.0f + 6.0f * next());
+			float level = powf(2.0f, -9.0f + 14.0f * next());
+			float colour[3], exposed[3];
+			bool inside = true;
+			for (int c = 0; c < 3; c++) {
+				colour[c] = level * powf(2.0f, (next() - 0.5f) * (i % 2 ? 1.0f : 8.0f));
+				exposed[c] = colour[c] * exposure;
+				inside = inside && exposed[c] >= powf(2.0f, ColourGrade::MIN_LOG) && exposed[c] <= powf(2.0f, ColourGrade::MAX_LOG);
+			}
+			if (!inside)
+				continue;
+
+			float expected[3], graded[3];
+			ColourGrade::evaluate(cases[s], exposed, expected);
+			grade.lookup(colour, exposure, graded);
+			for (int c = 0; c < 3; c++)
+				errors.push_back(fabsf(graded[c] - expected[c]) * 255.0f);
+		}
+		CHECK(errors.size() > 100000);
+		std::sort(errors.begin(), errors.end());
+		CHECK(errors[errors.size() * 999 / 1000] < (cases[s].saturation > 1.0f ? 8.0f : 2.0f));
+	}
+}
+
+// the default grade with gamma 2.2 is the Reinhard curve toneMap_ps had before the table
+TEST(colourGradeGreyRamp)
+{
+	ColourGrade grade(1);
+	ColourGrade::Settings settings;
+	settings.gamma = 2.2f;
+	grade.bake(settings);
+	for (int i = 0; i < 1000; i++) {
+		float x = powf(2.0f, -8.0f + 12.0f * i / 1000.0f);
+		float colour[3] = { x, x, x }, graded[3];
+		grade.lookup(colour, 1.0f, graded);
+		CHECK_CLOSE(graded[0], powf(x / (x + 1.0f), 2.2f), 1.0f / 255.0f);
+		// and stays grey, to within the luminance's rounding
+		CHECK_CLOSE(graded[0], graded[1], 1e-6f);
+		CHECK_CLOSE(graded[1], graded[2], 1e-6f);
+	}
+}
+
+TEST(colourGradeBakesOnlyOnChange)
+{
+	ColourGrade grade(1);
+	ColourGrade::Settings settings;
+	CHECK(grade.bake(settings));
+	CHECK(!grade.bake(settings));
+	settings.balance[1] = 0.9f;
+	CHECK(grade.bake(settings));
+	CHECK(grade.getSettings() == settings);
+	CHECK(!grade.bake(settings));
+}
+
+// the blue slices are split between threads, the table can't depend on how many
+TEST(colourGradeThreadsAgree)
+{
+	ColourGrade::Settings settings;
+	settings.toneCurve = ColourGrade::ACES;
+	settings.saturation = 1.2f;
+	settings.gamma = 2.2f;
+	const int threads[3] = { 1, 4, 0 };
+	ColourGrade one(threads[0]);
+	one.bake(settings);
+	const size_t size = (size_t)ColourGrade::LUT_SIZE * ColourGrade::LUT_SIZE * ColourGrade::LUT_SIZE * 4;
+	for (int t = 1; t < 3; t++) {
+		ColourGrade several(threads[t]);
+		several.bake(settings);
+		CHECK(std::equal(one.getTable(), one.getTable() + size, several.getTable()));
+	}
+}
+
+// App1's exposure slider reaches the bottom of its range, and nothing stops a caller passing 0 or less
+TEST(colourGradeZeroExposure)
+{
+	float scale, offset, smallestScale, smallestOffset;
+	ColourGrade::coordinates(1e-6f, smallestScale, smallestOffset);
+	const float exposures[3] = { 0.0f, -1.0f, 1e-9f };
+	for (int e = 0; e < 3; e++) {
+		ColourGrade::coordinates(exposures[e], scale, offset);
+		CHECK(isFinite(scale) && isFinite(offset));
+		CHECK(scale == smallestScale && offset == smallestOffset);
+	}
+
+	// the exposed colour lands on the first texels, which are black whatever the grade
+	ColourGrade grade(1);
+	ColourGrade::Settings settings;
+	settings.toneCurve = ColourGrade::ACES;
+	settings.gamma = 2.2f;
+	grade.bake(settings);
+	float colour[3] = { 100.0f, 1.0f, 0.01f }, graded[3];
+	grade.lookup(colour, 0.0f, graded);
+	for (int c = 0; c < 3; c++) {
+		CHECK(isFinite(graded[c]));
+		CHECK_CLOSE(graded[c], 0.0f, 1.0f / 255.0f);
+	}
+
+	// and an ordinary exposure still shifts by its log2
+	ColourGrade::coordinates(1.0f, scale, offset);
+	float doubled;
+	ColourGrade::coordinates(2.0f, scale, doubled);
+	CHECK_CLOSE(doubled - offset, scale, 1e-6f);
+}
+
+// rebaking the table is what a grade slider costs each frame it moves
+BENCHMARK(colourGradeBenchmark)
+{
+	const int threads[2] = { 1, 0 };
+	const int runs = 20;
+	ColourGrade::Settings settings;
+	settings.toneCurve = ColourGrade::ACES;
+	for (int t = 0; t < 2; t++) {
+		ColourGrade grade(threads[t]);
+		Stopwatch stopwatch;
+		for (int run = 0; run < runs; run++) {
+			settings.saturation = 1.0f + (t * runs + run) * 0.01f;
+			grade.bake(settings);
+		}
+		printf("  %s bake: %.2f ms\n", threads[t] ? "one thread" : "every core", stopwatch.elapsed() / runs);
+	}
+}
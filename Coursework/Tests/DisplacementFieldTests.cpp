@@ -0,0 +1,103 @@
+// Displacement field tests
+#include "Test.h"
+#include "DisplacementField.h"
+#include <algorithm>
+#include <vector>
+
+// an RGBA heightmap with padded rows, hills in red and noise in the other channels that setHeightMap has to skip
+static void setHills(DisplacementField& field, int mapWidth, int mapHeight)
+{
+	const int rowPitch = mapWidth * 4 + 12;
+	std::vector<unsigned char> pixels(rowPitch * mapHeight);
+	unsigned int random = 35;
+	for (size_t i = 0; i < pixels.size(); i++) {
+		random = random * 1664525u + 1013904223u;
+		pixels[i] = (unsigned char)(random >> 24);
+	}
+	for (int y = 0; y < mapHeight; y++) {
+		for (int x = 0; x < mapWidth; x++)
+			pixels[y * rowPitch + x * 4] = (unsigned char)(127.0f + 90.0f * sinf(x * 0.09f) * cosf(y * 0.06f) + (pixels[y * rowPitch + x * 4] & 31) - 16.0f);
+	}
+	field.setHeightMap(pixels.data(), mapWidth, mapHeight, 4, rowPitch);
+}
+
+// the largest difference between update()'s data and evaluate() over every texel, the padding columns included
+static float largestError(const DisplacementField& field, float time, const DisplacementField::Wave waves[2], float heightAmplitude)
+{
+	float largest = 0.0f;
+	for (int y = 0; y < field.getHeight(); y++) {
+		for (int x = 0; x < field.getWidth(); x++) {
+			float expected[4];
+			field.evaluate(x, y, time, waves, heightAmplitude, expected);
+			const float* texel = field.getData() + (y * field.getWidth() + x) * 4;
+			for (int c = 0; c < 4; c++)
+				largest = std::max(largest, fabsf(texel[c] - expected[c]));
+		}
+	}
+	return largest;
+}
+
+TEST(displacementFieldUpdateMatchesEvaluate)
+{
+	const int widths[3] = { 256, 257, 130 };
+	for (int w = 0; w < 3; w++) {
+		DisplacementField field(widths[w], 67, 30.0f);
+		CHECK(field.getWidth() == (widths[w] + 3) / 4 * 4);
+		setHills(field, 150, 113);
+
+		DisplacementField::Wave waves[2] = { { 2.0f, 0.65f, 1.0f }, { 1.5f, 0.5f, -0.7f } };
+		for (int frame = 0; frame < 4; frame++) {
+			float time = frame * 0.83f;
+			field.update(time, waves, 6.0f, 1);
+			CHECK(largestError(field, time, waves, 6.0f) < 2e-6f);
+		}
+
+		// flat water on the heightmap, and the heightmap flattened under the waves
+		DisplacementField::Wave still[2] = { { 0.0f, 0.65f, 1.0f }, { 0.0f, 0.5f, 1.0f } };
+		field.update(1.0f, still, 6.0f, 1);
+		CHECK(largestError(field, 1.0f, still, 6.0f) < 2e-6f);
+		field.update(1.0f, waves, 0.0f, 1);
+		CHECK(largestError(field, 1.0f, waves, 0.0f) < 2e-6f);
+	}
+}
+
+// the rows are split between threads, the data can't depend on how many
+TEST(displacementFieldThreadsAgree)
+{
+	DisplacementField::Wave waves[2] = { { 2.0f, 0.8f, 1.0f }, { 1.0f, 0.4f, 2.0f } };
+	DisplacementField one(257, 101, 30.0f);
+	setHills(one, 150, 150);
+	one.update(2.5f, waves, 4.0f, 1);
+	const size_t size = (size_t)one.getWidth() * one.getHeight() * 4;
+
+	const int threads[3] = { 3, 7, 0 };
+	for (int t = 0; t < 3; t++) {
+		DisplacementField several(257, 101, 30.0f);
+		setHills(several, 150, 150);
+		several.update(2.5f, waves, 4.0f, threads[t]);
+		CHECK(std::equal(one.getData(), one.getData() + size, several.getData()));
+	}
+}
+
+TEST(displacementFieldRebuildsOnlyOnChange)
+{
+	DisplacementField field(128, 64, 30.0f);
+	setHills(field, 150, 150);
+	DisplacementField::Wave waves[2] = { { 1.0f, 0.65f, 1.0f }, { 1.0f, 0.5f, 1.0f } };
+	CHECK(field.update(0.0f, waves, 6.0f, 1));
+	// the waves move every frame without touching the heightmap part
+	CHECK(!field.update(0.5f, waves, 6.0f, 1));
+	waves[0].amplitude = 3.0f;
+	CHECK(!field.update(1.0f, waves, 6.0f, 1));
+	CHECK(largestError(field, 1.0f, waves, 6.0f) < 2e-6f);
+
+	// a new amplitude rescales the heights and their normals
+	CHECK(field.update(1.0f, waves, 2.0f, 1));
+	CHECK(largestError(field, 1.0f, waves, 2.0f) < 2e-6f);
+	CHECK(!field.update(1.5f, waves, 2.0f, 1));
+
+	// and a new heightmap is rebuilt even at the same amplitude
+	setHills(field, 90, 70);
+	CHECK(field.update(1.5f, waves, 2.0f, 1));
+	CHECK(largestError(field, 1.5f, waves, 2.0f) < 2e-6f);
+}
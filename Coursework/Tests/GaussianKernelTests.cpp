@@ -0,0 +1,107 @@
+// Gaussian kernel tests
+#include "Test.h"
+#include "GaussianKernel.h"
+#include "GaussianKernels.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+TEST(gaussianExpMatchesExp)
+{
+	for (double x = 0.0; x > -80.0; x -= 0.173)
+		CHECK_CLOSE(gaussianExp(x) / exp(x), 1.0, 1e-12);
+}
+
+TEST(gaussianKernelWeights)
+{
+	for (int radius = 1; radius <= MAX_GAUSSIAN_RADIUS; radius++) {
+		GaussianKernel kernel = makeGaussianKernel(radius);
+		CHECK(kernel.radius == radius);
+		CHECK(kernel.samples == 1 + (radius + 1) / 2);
+
+		// normalised, both as taps and as paired samples
+		double taps = kernel.weights[0];
+		for (int i = 1; i <= radius; i++)
+			taps += 2.0 * kernel.weights[i];
+		double samples = kernel.sampleWeights[0];
+		for (int i = 1; i < kernel.samples; i++)
+			samples += 2.0 * kernel.sampleWeights[i];
+		CHECK_CLOSE(taps, 1.0, 1e-6);
+		CHECK_CLOSE(samples, 1.0, 1e-6);
+
+		// a gaussian with sigma a third of the radius
+		double sigma = radius / 3.0;
+		for (int i = 1; i <= radius; i++)
+			CHECK_CLOSE(kernel.weights[i] / kernel.weights[0], exp(-i * i / (2.0 * sigma * sigma)), 1e-6);
+
+		// every paired sample sits between the two taps it stands in for
+		for (int i = 1; i < kernel.samples; i++) {
+			CHECK(kernel.offsets[i] >= 2 * i - 1 && kernel.offsets[i] <= 2 * i);
+			CHECK(i == 1 || kernel.offsets[i] > kernel.offsets[i - 1]);
+		}
+	}
+
+	// out of range radii are clamped
+	CHECK(makeGaussianKernel(0).radius == 1);
+	CHECK(makeGaussianKernel(MAX_GAUSSIAN_RADIUS + 5).radius == MAX_GAUSSIAN_RADIUS);
+}
+
+// a linearly filtered fetch of a row, the way the samplers read between texels
+static double linearFetch(const std::vector<float>& row, double x)
+{
+	int first = (int)floor(x);
+	return row[first] + (row[first + 1] - row[first]) * (x - first);
+}
+
+// the paired samples have to blur exactly like the full 2r + 1 taps when the fetches land between texels of the same size
+TEST(gaussianKernelPairsMatchTheTaps)
+{
+	std::vector<float> row(256);
+	unsigned int random = 46;
+	for (size_t i = 0; i < row.size(); i++) {
+		random = random * 1664525u + 1013904223u;
+		row[i] = (random >> 8) / 16777216.0f * ((i % 31) == 0 ? 20.0f : 1.0f);
+	}
+
+	for (int radius = 1; radius <= MAX_GAUSSIAN_RADIUS; radius++) {
+		GaussianKernel kernel = makeGaussianKernel(radius);
+		for (int x = radius; x < (int)row.size() - radius - 1; x++) {
+			double taps = 0.0;
+			for (int i = -radius; i <= radius; i++)
+				taps += row[x + i] * kernel.weights[i < 0 ? -i : i];
+
+			double samples = row[x] * kernel.sampleWeights[0];
+			for (int i = 1; i < kernel.samples; i++)
+				samples += (linearFetch(row, x - kernel.offsets[i]) + linearFetch(row, x + kernel.offsets[i])) * kernel.sampleWeights[i];
+			// only as close as the offsets rounded to floats, next to the bright texels that's a few parts in a hundred thousand
+			CHECK_CLOSE(samples / taps, 1.0, 1e-4);
+		}
+	}
+}
+
+// the blur shaders are compiled against GaussianKernels.h, which has to be what gaussianKernelDefines writes today
+TEST(gaussianKernelsHeaderIsUpToDate)
+{
+	std::string path = __FILE__;
+	size_t slash = path.find_last_of("/\\");
+	path = (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "../Coursework/GaussianKernels.h";
+
+	std::ifstream file(path.c_str(), std::ios::binary);
+	CHECK(file.is_open());
+	std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// however git checked it out
+	contents.erase(std::remove(contents.begin(), contents.end(), '\r'), contents.end());
+	CHECK(contents == gaussianKernelDefines(GAUSSIAN_RADII, 4));
+
+	// and the shaders' token pasting picks the right radius
+	const float weights[] = GAUSSIAN_KERNEL(5, WEIGHTS);
+	const float offsets[] = GAUSSIAN_KERNEL(5, OFFSETS);
+	GaussianKernel kernel = makeGaussianKernel(5);
+	CHECK(GAUSSIAN_KERNEL(5, SAMPLES) == kernel.samples);
+	for (int i = 0; i < kernel.samples; i++) {
+		CHECK(weights[i] == kernel.sampleWeights[i]);
+		CHECK(offsets[i] == kernel.offsets[i]);
+	}
+}
@@ -0,0 +1,240 @@
+// Light matrices tests
+#include "Test.h"
+#include "LightMatrices.h"
+#include "ShadowMath.h"
+#include <random>
+
+// one light of each kind the lit shaders handle, set up the way App1 does before the lit draws
+struct TestLights
+{
+	Light* light[4];
+	int lType[4];
+	int pointMode[4];
+	float nearPlane[4];
+	float farPlane[4];
+	CascadedShadows cascades[4];
+
+	TestLights(const XMMATRIX& cameraView, const XMMATRIX& cameraProjection)
+	{
+		for (int i = 0; i < 4; i++) {
+			light[i] = new Light();
+			nearPlane[i] = 0.1f;
+			farPlane[i] = 100.0f;
+			pointMode[i] = 0;
+		}
+
+		// cube point light
+		lType[0] = 0;
+		light[0]->setPosition(0.0f, 10.0f, 0.0f);
+		light[0]->generateProjectionMatrix(nearPlane[0], farPlane[0]);
+
+		// dual paraboloid point light
+		lType[1] = 0;
+		pointMode[1] = 1;
+		light[1]->setPosition(5.0f, 8.0f, -3.0f);
+
+		// cascaded directional light
+		lType[2] = 1;
+		light[2]->setPosition(0.0f, 0.0f, 0.0f);
+		light[2]->setDirection(0.3f, -1.0f, 0.2f);
+		light[2]->generateOrthoMatrix(100.0f, 100.0f, 0.1f, 200.0f);
+		cascades[2].setCascadeCount(3);
+		cascades[2].update(cameraView, cameraProjection, 0.1f, 150.0f, XMFLOAT3(0.3f, -1.0f, 0.2f), 2048);
+
+		// spot light
+		lType[3] = 2;
+		light[3]->setPosition(-10.0f, 15.0f, 5.0f);
+		light[3]->setDirection(0.3f, -1.0f, -0.1f);
+		light[3]->generateViewMatrix();
+		light[3]->generateProjectionMatrix(nearPlane[3], farPlane[3]);
+	}
+
+	~TestLights()
+	{
+		for (int i = 0; i < 4; i++)
+			delete light[i];
+	}
+
+	// the separate view and projection the vertex stages used to transform every vertex by, one pair per light view
+	void getViewAndProjection(int i, int j, XMMATRIX* view, XMMATRIX* projection)
+	{
+		if (lType[i] == 1 && j < cascades[i].getCascadeCount()) {
+			*view = cascades[i].getViewMatrix(j);
+			*projection = cascades[i].getProjectionMatrix(j);
+			return;
+		}
+
+		if (lType[i] == 0) {
+			light[i]->setDirection(LightMatrices::cubeDirections[j].x, LightMatrices::cubeDirections[j].y, LightMatrices::cubeDirections[j].z);
+			light[i]->generateViewMatrix();
+		}
+		*view = light[i]->getViewMatrix();
+		if (lType[i] == 1)
+			*projection = light[i]->getOrthoMatrix();
+		else if (lType[i] == 0 && pointMode[i] == 1)
+			*projection = XMMatrixIdentity();
+		else
+			*projection = light[i]->getProjectionMatrix();
+	}
+};
+
+static float4 toFloat4(FXMVECTOR v)
+{
+	return float4(XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v), XMVectorGetW(v));
+}
+
+// the interpolated light space position the vertex stages used to output for a pixel of a triangle, against the one the pixel
+// shaders now rebuild from the interpolated world position. both interpolate with the same perspective correct weights, and a
+// light view is affine in the world position, so they have to land on the same shadow map texel at the same depth
+TEST(lightSpaceRebuiltMatchesInterpolated)
+{
+	XMMATRIX cameraView = XMMatrixLookAtLH(XMVectorSet(0.0f, 5.0f, -30.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX cameraProjection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 200.0f);
+	XMMATRIX cameraViewProjection = cameraView * cameraProjection;
+	TestLights lights(cameraView, cameraProjection);
+
+	XMMATRIX uploaded[4][6];
+	LightMatrices::build(lights.light, lights.lType, lights.pointMode, lights.cascades, uploaded);
+
+	std::mt19937 random(32);
+	std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// a 4096 shadow map texel, and a fraction of the smallest depth bias the GUI allows
+	const float uvTolerance = 0.05f / 4096.0f;
+	const float depthTolerance = 0.0002f * 0.05f;
+	int compared = 0;
+
+	for (int run = 0; run < 2000; run++) {
+		XMVECTOR corner[3];
+		float clipW[3];
+		for (int k = 0; k < 3; k++) {
+			corner[k] = XMVectorSet(position(random), position(random) * 0.25f, position(random), 1.0f);
+			clipW[k] = XMVectorGetW(XMVector4Transform(corner[k], cameraViewProjection));
+		}
+		if (clipW[0] <= 0.1f || clipW[1] <= 0.1f || clipW[2] <= 0.1f)
+			continue;
+
+		// screen space barycentrics, turned into the perspective correct weights the rasteriser interpolates with
+		float b[3] = { unit(random), unit(random), 0.0f };
+		if (b[0] + b[1] > 1.0f) {
+			b[0] = 1.0f - b[0];
+			b[1] = 1.0f - b[1];
+		}
+		b[2] = 1.0f - b[0] - b[1];
+		float weight[3];
+		float weightSum = 0.0f;
+		for (int k = 0; k < 3; k++) {
+			weight[k] = b[k] / clipW[k];
+			weightSum += weight[k];
+		}
+
+		XMVECTOR worldPosition = XMVectorZero();
+		for (int k = 0; k < 3; k++)
+			worldPosition += corner[k] * (weight[k] / weightSum);
+
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 6; j++) {
+				XMMATRIX view, projection;
+				lights.getViewAndProjection(i, j, &view, &projection);
+
+				XMVECTOR interpolated = XMVectorZero();
+				for (int k = 0; k < 3; k++)
+					interpolated += XMVector4Transform(XMVector4Transform(corner[k], view), projection) * (weight[k] / weightSum);
+
+				// the shaders read the uploaded matrix column major, which undoes the transpose
+				XMVECTOR rebuilt = XMVector4Transform(worldPosition, XMMatrixTranspose(uploaded[i][j]));
+
+				float4 a = toFloat4(interpolated);
+				float4 r = toFloat4(rebuilt);
+				if (lights.lType[i] == 0 && lights.pointMode[i] == 1) {
+					// each hemisphere is only sampled for the pixels in front of it
+					if (j > 1 || a.z < 0.0f || length(float3(a.x, a.y, a.z)) < lights.nearPlane[i])
+						continue;
+					float3 projectedA = paraboloidProject(float3(a.x, a.y, a.z), lights.nearPlane[i], lights.farPlane[i]);
+					float3 projectedR = paraboloidProject(float3(r.x, r.y, r.z), lights.nearPlane[i], lights.farPlane[i]);
+					CHECK_CLOSE(projectedR.x, projectedA.x, uvTolerance);
+					CHECK_CLOSE(projectedR.y, projectedA.y, uvTolerance);
+					CHECK_CLOSE(projectedR.z, projectedA.z, depthTolerance);
+				}
+				else {
+					// pixels behind a view or off its map never sample it
+					if (a.w < 0.1f)
+						continue;
+					float2 uvA = getProjectiveCoords(a);
+					float2 uvR = getProjectiveCoords(r);
+					if (uvA.x < 0.0f || uvA.x > 1.0f || uvA.y < 0.0f || uvA.y > 1.0f)
+						continue;
+					CHECK_CLOSE(uvR.x, uvA.x, uvTolerance);
+					CHECK_CLOSE(uvR.y, uvA.y, uvTolerance);
+					CHECK_CLOSE(r.z / r.w, a.z / a.w, depthTolerance);
+				}
+				compared++;
+			}
+		}
+	}
+
+	CHECK(compared > 5000);
+}
+
+// the combined matrices have to keep every view the depth passes render, in the slot the shaders index
+TEST(lightMatricesKeepEveryView)
+{
+	XMMATRIX cameraView = XMMatrixLookAtLH(XMVectorSet(10.0f, 5.0f, -20.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX cameraProjection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 200.0f);
+	TestLights lights(cameraView, cameraProjection);
+
+	XMMATRIX uploaded[4][6];
+	LightMatrices::build(lights.light, lights.lType, lights.pointMode, lights.cascades, uploaded);
+
+	XMVECTOR point = XMVectorSet(3.0f, -2.0f, 7.0f, 1.0f);
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 6; j++) {
+			XMMATRIX view, projection;
+			lights.getViewAndProjection(i, j, &view, &projection);
+			float4 expected = toFloat4(XMVector4Transform(point, view * projection));
+			float4 actual = toFloat4(XMVector4Transform(point, XMMatrixTranspose(uploaded[i][j])));
+			CHECK_CLOSE(actual.x, expected.x, 1e-4f);
+			CHECK_CLOSE(actual.y, expected.y, 1e-4f);
+			CHECK_CLOSE(actual.z, expected.z, 1e-4f);
+			CHECK_CLOSE(actual.w, expected.w, 1e-4f);
+		}
+	}
+
+	// the point lights are left on their last face, like after their depth passes
+	CHECK(lights.light[0]->getDirection().z == -1.0f);
+}
+
+// the light matrices used to be rebuilt by every lit draw's setShaderParameters, LightFrameData builds them once a frame.
+// App1 makes up to 8 lit draws a frame: the four light cubes, the plane, the grass, the sphere and the floor
+BENCHMARK(lightMatricesBenchmark)
+{
+	const int litDraws = 8;
+	const int frames = 20000;
+	XMMATRIX cameraView = XMMatrixLookAtLH(XMVectorSet(0.0f, 5.0f, -30.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX cameraProjection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 200.0f);
+	TestLights lights(cameraView, cameraProjection);
+	XMMATRIX uploaded[4][6];
+
+	// read something back from every build so none of them can be optimised away
+	float checksum = 0.0f;
+	Stopwatch perDraw;
+	for (int frame = 0; frame < frames; frame++) {
+		for (int draw = 0; draw < litDraws; draw++) {
+			LightMatrices::build(lights.light, lights.lType, lights.pointMode, lights.cascades, uploaded);
+			checksum += XMVectorGetX(uploaded[draw % 4][draw % 6].r[0]);
+		}
+	}
+	double perDrawTime = perDraw.elapsed();
+
+	Stopwatch perFrame;
+	for (int frame = 0; frame < frames; frame++) {
+		LightMatrices::build(lights.light, lights.lType, lights.pointMode, lights.cascades, uploaded);
+		checksum += XMVectorGetX(uploaded[frame % 4][frame % 6].r[0]);
+	}
+	double perFrameTime = perFrame.elapsed();
+
+	printf("  rebuilt per draw: %.2f us a frame\n", perDrawTime * 1000.0 / frames);
+	printf("  built once a frame: %.2f us a frame (checksum %g)\n", perFrameTime * 1000.0 / frames, checksum);
+	CHECK(perFrameTime < perDrawTime);
+}
@@ -0,0 +1,41 @@
+// Tests
+// Runs every registered test, and the benchmarks too with "bench". Returns the number of failed tests
+#include "Test.h"
+#include <string.h>
+
+static int failures = 0;
+
+std::vector<TestCase>& testCases()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void testFailed(const char* file, int line, const char* message)
+{
+	printf("  %s(%d): %s\n", file, line, message);
+	failures++;
+}
+
+int main(int argc, char** argv)
+{
+	bool benchmarks = argc > 1 && strcmp(argv[1], "bench") == 0;
+
+	int failedTests = 0;
+	int run = 0;
+	std::vector<TestCase>& tests = testCases();
+	for (size_t i = 0; i < tests.size(); i++) {
+		if (tests[i].benchmark && !benchmarks)
+			continue;
+
+		printf("%s\n", tests[i].name);
+		int before = failures;
+		tests[i].run();
+		if (failures > before)
+			failedTests++;
+		run++;
+	}
+
+	printf("%d of %d passed\n", run - failedTests, run);
+	return failedTests;
+}
@@ -0,0 +1,159 @@
+// Patch culling tests
+#include "Test.h"
+#include "PatchCulling.h"
+#include "SurfaceQuery.h"
+#include <directxmath.h>
+#include <vector>
+
+using namespace DirectX;
+
+static void lookAtPerspective(float3 eye, float3 at, float viewProjection[4][4])
+{
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f), XMVectorSet(at.x, at.y, at.z, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, view * XMMatrixPerspectiveFovLH(0.785f, 16.0f / 9.0f, 0.1f, 100.0f));
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			viewProjection[i][j] = m.m[i][j];
+}
+
+static bool pointInFrustum(float3 p, const float m[4][4])
+{
+	float clip[4];
+	for (int c = 0; c < 4; c++)
+		clip[c] = p.x * m[0][c] + p.y * m[1][c] + p.z * m[2][c] + m[3][c];
+	return clip[0] >= -clip[3] && clip[0] <= clip[3] && clip[1] >= -clip[3] && clip[1] <= clip[3] && clip[2] >= 0.0f && clip[2] <= clip[3];
+}
+
+// true if the segment from the viewer to the point passes through the occluder, so the point can't be seen
+static bool segmentHitsSphere(float3 a, float3 b, float4 sphere)
+{
+	if (sphere.w <= 0.0f)
+		return false;
+	float3 centre(sphere.x, sphere.y, sphere.z);
+	float3 d = b - a;
+	float t = saturate(dot(centre - a, d) / dot(d, d));
+	return length(a + d * t - centre) < sphere.w;
+}
+
+// flies a camera around and through the surface for a few seconds of its animation, and checks every tessellated point
+// of every culled patch really is off screen or behind the sphere
+TEST(patchCullingNeverHidesAVisiblePoint)
+{
+	const int resolution = 30;
+	DisplacementField field(256, 256, (float)resolution);
+	// rolling hills with noise on top, so the heights between a patch's corners can be anywhere in the range
+	const int mapSize = 300;
+	std::vector<unsigned char> pixels(mapSize * mapSize);
+	for (int y = 0; y < mapSize; y++) {
+		for (int x = 0; x < mapSize; x++) {
+			unsigned int hash = (x * 73856093u) ^ (y * 19349663u);
+			hash = (hash ^ (hash >> 13)) * 1274126177u;
+			pixels[y * mapSize + x] = (unsigned char)(127.0f + 60.0f * sinf(x * 0.07f) * cosf(y * 0.05f) + (float)((hash >> 24) & 127) - 64.0f);
+		}
+	}
+	field.setHeightMap(pixels.data(), mapSize, mapSize, 1, mapSize);
+	SurfaceQuery query(&field);
+
+	const float planeToSphere[3] = { 0.0f, 0.5f, 1.0f };
+	for (int t = 0; t < 3; t++) {
+		SurfaceQuery::Settings s;
+		s.waveAmplitude = float2(2.0f, 1.5f);
+		s.waveFrequency = float2(0.8f, 0.5f);
+		s.waveSpeed = float2(1.0f, 1.0f);
+		s.heightAmplitude = 6.0f;
+		s.planeToSphere = planeToSphere[t];
+		s.sphere = float4(15.0f, 10.0f, 15.0f, 10.0f);
+		s.planeResolution = (float)resolution;
+		s.worldOffset = float3(0.0f, 0.0f, 0.0f);
+
+		// the same margin and occluder PatchCullData hands the hull shaders
+		float margin = getPatchMargin(field.getHeightMapMin(), field.getHeightMapMax(), s.heightAmplitude, s.waveAmplitude, s.sphere.w, (float)resolution);
+		float wave = (fabsf(s.waveAmplitude.x) + fabsf(s.waveAmplitude.y)) / 2.0f;
+		float innerRadius = s.sphere.w + field.getHeightMapMin() * s.heightAmplitude - wave;
+		float4 occluder = (s.planeToSphere >= 1.0f && innerRadius > 0.0f) ? float4(s.sphere.x, s.sphere.y, s.sphere.z, innerRadius) : float4();
+
+		int patches = 0;
+		int culled = 0;
+		int horizonCulled = 0;
+		for (int frame = 0; frame < 60; frame++) {
+			s.time = frame / 15.0f;
+			query.setSettings(s);
+
+			// orbit the sphere at a changing distance, half the time looking at it and half along the orbit
+			float angle = frame * 0.105f;
+			float distance = 18.0f + 12.0f * sinf(frame * 0.2f);
+			float3 eye(15.0f + distance * cosf(angle), 10.0f + 8.0f * sinf(angle * 1.7f), 15.0f + distance * sinf(angle));
+			float3 at = (frame / 15) % 2 ? float3(15.0f, 10.0f, 15.0f) : eye + float3(-sinf(angle), 0.1f, cosf(angle));
+			float viewProjection[4][4];
+			lookAtPerspective(eye, at, viewProjection);
+			float4 planes[6];
+			getFrustumPlanes(viewProjection, planes);
+
+			for (int j = 0; j < resolution - 1; j++) {
+				for (int i = 0; i < resolution - 1; i++) {
+					float2 uv[4] = { float2((float)i, (float)j), float2(i + 1.0f, (float)j), float2(i + 1.0f, j + 1.0f), float2((float)i, j + 1.0f) };
+					float3 corner[4];
+					float3 normal;
+					for (int k = 0; k < 4; k++)
+						query.evaluate(uv[k] / (float)resolution, &corner[k], &normal);
+
+					patches++;
+					if (!cullPatch(corner[0], corner[1], corner[2], corner[3], margin, planes, true, eye, occluder))
+						continue;
+					culled++;
+					if (!sphereOutsideFrustum(getPatchSphere(corner[0], corner[1], corner[2], corner[3], margin), planes))
+						horizonCulled++;
+
+					for (int v = 0; v <= 8; v++) {
+						for (int u = 0; u <= 8; u++) {
+							float3 p;
+							query.evaluate(float2(i + u / 8.0f, j + v / 8.0f) / (float)resolution, &p, &normal);
+							CHECK(!pointInFrustum(p, viewProjection) || segmentHitsSphere(eye, p, occluder));
+						}
+					}
+				}
+			}
+		}
+
+		// it has to be worth running, and the horizon only culls once the plane wraps the sphere
+		CHECK(culled > patches / 10);
+		CHECK((horizonCulled > 0) == (planeToSphere[t] >= 1.0f));
+	}
+}
+
+TEST(patchCullingHorizon)
+{
+	float4 occluder(0.0f, 0.0f, 0.0f, 10.0f);
+	float3 viewer(0.0f, 0.0f, -30.0f);
+
+	// straight behind the sphere is hidden, beside it isn't, and neither is anything in front of it
+	CHECK(sphereBehindHorizon(float4(0.0f, 0.0f, 12.0f, 1.0f), viewer, occluder));
+	CHECK(!sphereBehindHorizon(float4(15.0f, 0.0f, 12.0f, 1.0f), viewer, occluder));
+	CHECK(!sphereBehindHorizon(float4(0.0f, 0.0f, -12.0f, 1.0f), viewer, occluder));
+
+	// a bigger bounds sphere reaches past the silhouette
+	CHECK(!sphereBehindHorizon(float4(0.0f, 0.0f, 12.0f, 16.0f), viewer, occluder));
+
+	// no occluder, or a viewer inside it, never culls
+	CHECK(!sphereBehindHorizon(float4(0.0f, 0.0f, 12.0f, 1.0f), viewer, float4()));
+	CHECK(!sphereBehindHorizon(float4(0.0f, 0.0f, 12.0f, 1.0f), float3(0.0f, 0.0f, -5.0f), occluder));
+}
+
+TEST(patchCullingFrustumPlanes)
+{
+	float viewProjection[4][4];
+	lookAtPerspective(float3(3.0f, 4.0f, -20.0f), float3(0.0f, 0.0f, 0.0f), viewProjection);
+	float4 planes[6];
+	getFrustumPlanes(viewProjection, planes);
+
+	// the target is inside every plane, a point behind the camera is outside the near plane
+	for (int i = 0; i < 6; i++)
+		CHECK(dot(float3(planes[i].x, planes[i].y, planes[i].z), float3(0.0f, 0.0f, 0.0f)) + planes[i].w > 0.0f);
+	CHECK(sphereOutsideFrustum(float4(6.0f, 8.0f, -40.0f, 1.0f), planes));
+	CHECK(!sphereOutsideFrustum(float4(6.0f, 8.0f, -40.0f, 25.0f), planes));
+
+	// planes are normalised, so the bounds radius is a real distance
+	for (int i = 0; i < 6; i++)
+		CHECK_CLOSE(length(float3(planes[i].x, planes[i].y, planes[i].z)), 1.0f, 1e-5f);
+}
@@ -0,0 +1,439 @@
+// Post process chain tests
+#include "Test.h"
+#include "PostProcessChain.h"
+#include "GaussianKernel.h"
+#include <algorithm>
+
+typedef PostProcessChain::Image Image;
+
+// a scene with a few very bright texels scattered through it, so bloom has something to pick out
+static Image testScene(int width, int height)
+{
+	Image scene;
+	scene.resize(width, height);
+	unsigned int random = 1;
+	for (size_t i = 0; i < scene.pixels.size(); i++) {
+		random = random * 1664525u + 1013904223u;
+		scene.pixels[i] = (random >> 8) / 16777216.0f * ((i % 97) < 3 ? 8.0f : 1.2f);
+	}
+	return scene;
+}
+
+// App1's blur levels for a scene a third of the size
+static void smallLevels(PostProcessChain::Settings& settings)
+{
+	for (int i = 0; i < PostProcessChain::MAX_LEVELS; i++) {
+		settings.levelWidth[i] = std::max(settings.levelWidth[i] / 3, 1);
+		settings.levelHeight[i] = std::max(settings.levelHeight[i] / 3, 1);
+	}
+}
+
+// REFERENCE
+// the shaders one tap at a time: every sample is its own clamped bilinear fetch at the target pixel's centre plus an offset
+struct Colour
+{
+	float c[4];
+};
+
+static Colour sampleAt(const Image& image, float u, float v)
+{
+	float x = std::min(std::max(u * image.width - 0.5f, 0.0f), (float)(image.width - 1));
+	float y = std::min(std::max(v * image.height - 0.5f, 0.0f), (float)(image.height - 1));
+	int x0 = (int)x;
+	int y0 = (int)y;
+	int x1 = std::min(x0 + 1, image.width - 1);
+	int y1 = std::min(y0 + 1, image.height - 1);
+	float fx = x - x0;
+	float fy = y - y0;
+
+	Colour colour;
+	for (int k = 0; k < 4; k++) {
+		float top = image.row(y0)[x0 * 4 + k] + (image.row(y0)[x1 * 4 + k] - image.row(y0)[x0 * 4 + k]) * fx;
+		float bottom = image.row(y1)[x0 * 4 + k] + (image.row(y1)[x1 * 4 + k] - image.row(y1)[x0 * 4 + k]) * fx;
+		colour.c[k] = top + (bottom - top) * fy;
+	}
+	return colour;
+}
+
+template <typename F>
+static void eachPixel(Image& target, F pixel)
+{
+	for (int y = 0; y < target.height; y++) {
+		for (int x = 0; x < target.width; x++) {
+			Colour colour = pixel((x + 0.5f) / target.width, (y + 0.5f) / target.height);
+			colour.c[3] = 1.0f;
+			for (int k = 0; k < 4; k++)
+				target.row(y)[x * 4 + k] = colour.c[k];
+		}
+	}
+}
+
+// the old bloomThreshold_ps as its own full size pass
+static void referenceThreshold(const Image& source, Image& target, float threshold)
+{
+	target = source;
+	for (size_t i = 0; i < target.pixels.size(); i += 4) {
+		if (target.pixels[i] + target.pixels[i + 1] + target.pixels[i + 2] <= threshold) {
+			target.pixels[i] = target.pixels[i + 1] = target.pixels[i + 2] = 0.0f;
+			target.pixels[i + 3] = 1.0f;
+		}
+	}
+}
+
+static void referenceBlur(const Image& source, Image& target, int radius, bool horizontal)
+{
+	GaussianKernel kernel = makeGaussianKernel(radius);
+	eachPixel(target, [&](float u, float v) {
+		Colour sum = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+		for (int i = 1 - kernel.samples; i < kernel.samples; i++) {
+			float offset = i < 0 ? -kernel.offsets[-i] : kernel.offsets[i];
+			Colour colour = horizontal ? sampleAt(source, u + offset / target.width, v) : sampleAt(source, u, v + offset / target.height);
+			for (int k = 0; k < 4; k++)
+				sum.c[k] += colour.c[k] * kernel.sampleWeights[i < 0 ? -i : i];
+		}
+		return sum;
+	});
+}
+
+static void referenceBlend(const Image& first, const Image& second, Image& target, float firstWeight, float secondWeight)
+{
+	eachPixel(target, [&](float u, float v) {
+		Colour a = sampleAt(first, u, v);
+		Colour b = sampleAt(second, u, v);
+		for (int k = 0; k < 3; k++)
+			a.c[k] = a.c[k] * firstWeight + b.c[k] * secondWeight;
+		return a;
+	});
+}
+
+// kawaseDown_ps, the centre and the four diagonals offset source texels away
+static void referenceKawaseDown(const Image& source, Image& target, float offset)
+{
+	eachPixel(target, [&](float u, float v) {
+		float du = offset / source.width, dv = offset / source.height;
+		Colour sum = sampleAt(source, u, v);
+		for (int k = 0; k < 4; k++)
+			sum.c[k] *= 4.0f / 8.0f;
+		const float corners[4][2] = { { -du, -dv }, { du, -dv }, { -du, dv }, { du, dv } };
+		for (int i = 0; i < 4; i++) {
+			Colour colour = sampleAt(source, u + corners[i][0], v + corners[i][1]);
+			for (int k = 0; k < 4; k++)
+				sum.c[k] += colour.c[k] / 8.0f;
+		}
+		return sum;
+	});
+}
+
+// kawaseUp_ps, four taps offset source texels along the axes and four diagonals half that, which count twice. the level
+// it's coming back up to is added on top
+static void referenceKawaseUp(const Image& source, const Image& level, Image& target, float offset, float levelWeight)
+{
+	eachPixel(target, [&](float u, float v) {
+		float du = offset / source.width, dv = offset / source.height;
+		const float taps[8][3] = { { -du, 0.0f, 1.0f }, { du, 0.0f, 1.0f }, { 0.0f, -dv, 1.0f }, { 0.0f, dv, 1.0f },
+			{ -du / 2, -dv / 2, 2.0f }, { du / 2, -dv / 2, 2.0f }, { -du / 2, dv / 2, 2.0f }, { du / 2, dv / 2, 2.0f } };
+		Colour sum = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+		for (int i = 0; i < 8; i++) {
+			Colour colour = sampleAt(source, u + taps[i][0], v + taps[i][1]);
+			for (int k = 0; k < 4; k++)
+				sum.c[k] += colour.c[k] * taps[i][2] / 12.0f;
+		}
+		Colour below = sampleAt(level, u, v);
+		for (int k = 0; k < 4; k++)
+			sum.c[k] += below.c[k] * levelWeight;
+		return sum;
+	});
+}
+
+// App1's gaussian levels, bloom merging them back up
+static void referenceGaussian(const Image& source, const PostProcessChain::Settings& settings, Image& filtered)
+{
+	int passes = settings.blurPasses;
+	Image horizontal[PostProcessChain::MAX_LEVELS], vertical[PostProcessChain::MAX_LEVELS];
+	for (int i = 0; i < passes; i++) {
+		horizontal[i].resize(settings.levelWidth[i], settings.levelHeight[i]);
+		vertical[i].resize(settings.levelWidth[i], settings.levelHeight[i]);
+		referenceBlur(i ? vertical[i - 1] : source, horizontal[i], settings.blurRadius, true);
+		referenceBlur(horizontal[i], vertical[i], settings.blurRadius, false);
+	}
+
+	filtered = vertical[passes - 1];
+	if (settings.enableBloom) {
+		for (int i = passes - 2; i >= 0; i--) {
+			Image combined;
+			combined.resize(vertical[i].width, vertical[i].height);
+			referenceBlend(vertical[i], filtered, combined, 1.0f, 1.0f);
+			filtered = combined;
+		}
+	}
+}
+
+// App1's kawase levels, down to the last then back up to the first, bloom adding each level on the way
+static void referenceKawase(const Image& source, const PostProcessChain::Settings& settings, Image& filtered)
+{
+	int passes = settings.kawasePasses;
+	Image down[PostProcessChain::MAX_KAWASE_LEVELS];
+	for (int i = 0; i < passes; i++) {
+		int width, height;
+		PostProcessChain::kawaseSize(source.width, source.height, i, width, height);
+		down[i].resize(width, height);
+		referenceKawaseDown(i ? down[i - 1] : source, down[i], settings.kawaseOffset);
+	}
+
+	filtered = down[passes - 1];
+	for (int i = passes - 2; i >= 0; i--) {
+		Image up;
+		up.resize(down[i].width, down[i].height);
+		referenceKawaseUp(filtered, down[i], up, settings.kawaseOffset, settings.enableBloom ? 1.0f : 0.0f);
+		filtered = up;
+	}
+}
+
+// App1's gaussian or kawase blur and bloom, the composite left ungraded
+static void referenceProcess(const Image& scene, const PostProcessChain::Settings& settings, Image& output)
+{
+	Image thresholded;
+	const Image* source = &scene;
+	if (settings.enableBloom) {
+		referenceThreshold(scene, thresholded, settings.bloomThreshold);
+		source = &thresholded;
+	}
+
+	Image filtered;
+	if (settings.blurMethod == PostProcessChain::KAWASE_BLUR)
+		referenceKawase(*source, settings, filtered);
+	else
+		referenceGaussian(*source, settings, filtered);
+
+	output.resize(scene.width, scene.height);
+	if (settings.enableBloom)
+		referenceBlend(scene, filtered, output, 1.0f, settings.bloomIntensity);
+	else
+		referenceBlend(scene, filtered, output, 0.0f, 1.0f);
+}
+
+static float maxDifference(const Image& a, const Image& b)
+{
+	float worst = 0.0f;
+	for (size_t i = 0; i < a.pixels.size(); i++)
+		worst = std::max(worst, fabsf(a.pixels[i] - b.pixels[i]) / std::max(1.0f, fabsf(b.pixels[i])));
+	return worst;
+}
+
+// the fused threshold, the row caching and the SSE have to give the same image as sampling every tap like the shaders
+TEST(postProcessChainMatchesReference)
+{
+	Image scene = testScene(400, 225);
+	PostProcessChain chain;
+
+	const int passes[3] = { 1, 4, 9 };
+	for (int bloom = 0; bloom < 2; bloom++) {
+		for (int p = 0; p < 3; p++) {
+			for (int r = 0; r < 4; r++) {
+				PostProcessChain::Settings settings;
+				smallLevels(settings);
+				settings.enableBloom = bloom == 1;
+				settings.bloomIntensity = 0.7f;
+				settings.blurPasses = passes[p];
+				settings.blurRadius = GAUSSIAN_RADII[r];
+
+				Image output, expected;
+				chain.process(scene, settings, output);
+				referenceProcess(scene, settings, expected);
+				CHECK(output.width == expected.width && output.height == expected.height);
+				CHECK_CLOSE(maxDifference(output, expected), 0.0f, 1e-4f);
+			}
+		}
+	}
+}
+
+// the kawase passes fuse the threshold into the first down pass's taps and add each level in the up pass that reaches it,
+// the reference thresholds a full size copy first and samples every tap. odd sizes round each halving up
+TEST(postProcessChainKawaseMatchesReference)
+{
+	// the reference sizes its levels with kawaseSize too, so check that on its own
+	int width, height;
+	PostProcessChain::kawaseSize(401, 223, 0, width, height);
+	CHECK(width == 201 && height == 112);
+	PostProcessChain::kawaseSize(401, 223, 2, width, height);
+	CHECK(width == 51 && height == 28);
+
+	const int sizes[2][2] = { { 400, 225 }, { 401, 223 } };
+	const int passes[3] = { 1, 3, 6 };
+	const float offsets[2] = { 1.0f, 2.5f };
+	PostProcessChain chain;
+	for (int s = 0; s < 2; s++) {
+		Image scene = testScene(sizes[s][0], sizes[s][1]);
+		for (int bloom = 0; bloom < 2; bloom++) {
+			for (int p = 0; p < 3; p++) {
+				for (int o = 0; o < 2; o++) {
+					PostProcessChain::Settings settings;
+					settings.blurMethod = PostProcessChain::KAWASE_BLUR;
+					settings.enableBloom = bloom == 1;
+					settings.bloomIntensity = 0.7f;
+					settings.kawasePasses = passes[p];
+					settings.kawaseOffset = offsets[o];
+
+					Image output, expected;
+					chain.process(scene, settings, output);
+					referenceProcess(scene, settings, expected);
+					CHECK(output.width == expected.width && output.height == expected.height);
+					CHECK_CLOSE(maxDifference(output, expected), 0.0f, 1e-4f);
+				}
+			}
+		}
+	}
+}
+
+// with HDR on the composite is the same image looked up in the grade's table
+TEST(postProcessChainGradesTheComposite)
+{
+	Image scene = testScene(400, 225);
+	PostProcessChain chain;
+	PostProcessChain::Settings settings;
+	smallLevels(settings);
+	settings.enableBloom = true;
+	settings.enableHDR = true;
+	settings.gammaCorrection = true;
+	settings.exposure = 1.3f;
+	settings.toneCurve = ColourGrade::ACES;
+	settings.saturation = 0.8f;
+
+	Image output, expected;
+	chain.process(scene, settings, output);
+	referenceProcess(scene, settings, expected);
+
+	ColourGrade grade(1);
+	ColourGrade::Settings gradeSettings;
+	gradeSettings.toneCurve = settings.toneCurve;
+	gradeSettings.saturation = settings.saturation;
+	gradeSettings.gamma = 2.2f;
+	grade.bake(gradeSettings);
+	for (size_t i = 0; i < expected.pixels.size(); i += 4)
+		grade.lookup(&expected.pixels[i], settings.exposure, &expected.pixels[i]);
+
+	CHECK_CLOSE(maxDifference(output, expected), 0.0f, 1e-4f);
+}
+
+// known outputs: a flat image blurs to itself, and bloom leaves a scene with nothing over the threshold alone
+TEST(postProcessChainGolden)
+{
+	Image flat;
+	flat.resize(400, 225);
+	for (size_t i = 0; i < flat.pixels.size(); i += 4) {
+		flat.pixels[i] = 0.25f;
+		flat.pixels[i + 1] = 0.5f;
+		flat.pixels[i + 2] = 0.125f;
+		flat.pixels[i + 3] = 1.0f;
+	}
+
+	PostProcessChain chain;
+	PostProcessChain::Settings settings;
+	smallLevels(settings);
+	Image output;
+	chain.process(flat, settings, output);
+	CHECK_CLOSE(maxDifference(output, flat), 0.0f, 1e-5f);
+
+	settings.enableBloom = true;
+	chain.process(flat, settings, output);
+	CHECK_CLOSE(maxDifference(output, flat), 0.0f, 1e-5f);
+
+	// one bright texel spreads out symmetrically and keeps its energy at the first level
+	Image spot = flat;
+	for (size_t i = 0; i < spot.pixels.size(); i++)
+		spot.pixels[i] = (i % 4) == 3 ? 1.0f : 0.0f;
+	float* centre = spot.row(112) + 200 * 4;
+	centre[0] = centre[1] = centre[2] = 100.0f;
+
+	Image blurred;
+	blurred.resize(400, 225);
+	Image across;
+	across.resize(400, 225);
+	chain.horizontalBlur(spot, across, 5, true, 1.4f);
+	chain.verticalBlur(across, blurred, 5);
+	float total = 0.0f;
+	for (size_t i = 0; i < blurred.pixels.size(); i += 4)
+		total += blurred.pixels[i];
+	CHECK_CLOSE(total, 100.0f, 1e-3f);
+	CHECK_CLOSE(blurred.row(112)[(200 - 3) * 4], blurred.row(112)[(200 + 3) * 4], 1e-4f);
+	CHECK_CLOSE(blurred.row(112 - 3)[200 * 4], blurred.row(112 + 3)[200 * 4], 1e-4f);
+	CHECK(blurred.row(112)[200 * 4] > blurred.row(112)[201 * 4]);
+}
+
+// the rows are split between threads, each row has to come out the same whichever thread ran it
+TEST(postProcessChainThreadsAgree)
+{
+	Image scene = testScene(400, 225);
+	PostProcessChain::Settings settings;
+	smallLevels(settings);
+	settings.enableBloom = true;
+	settings.enableHDR = true;
+
+	for (int method = 0; method < 3; method++) {
+		settings.blurMethod = method;
+		PostProcessChain one(1), several(3);
+		Image a, b;
+		one.process(scene, settings, a);
+		several.process(scene, settings, b);
+		CHECK(a.pixels == b.pixels);
+	}
+}
+
+// App1's screen through the default bloom and HDR chain, single threaded and on every core
+BENCHMARK(postProcessChainBenchmark)
+{
+	Image scene = testScene(1200, 675);
+	PostProcessChain::Settings settings;
+	settings.enableBloom = true;
+	settings.enableHDR = true;
+	const int runs = 10;
+
+	Image output;
+	const int threads[2] = { 1, 0 };
+	for (int t = 0; t < 2; t++) {
+		PostProcessChain chain(threads[t]);
+		chain.process(scene, settings, output);
+		Stopwatch stopwatch;
+		for (int run = 0; run < runs; run++)
+			chain.process(scene, settings, output);
+		double time = stopwatch.elapsed() / runs;
+		printf("  %s: %.2f ms, %.1f megapixels a second\n", threads[t] ? "one thread" : "every core", time, scene.width * scene.height / time / 1000.0);
+	}
+
+	Image expected;
+	Stopwatch stopwatch;
+	referenceProcess(scene, settings, expected);
+	printf("  one tap at a time: %.2f ms\n", stopwatch.elapsed());
+}
+
+// bloom on App1's screen through the gaussian levels and the kawase levels that reach about as far, in pairs of equal
+// impulse response sigma
+BENCHMARK(kawaseBenchmark)
+{
+	Image scene = testScene(1200, 675);
+	PostProcessChain chain;
+	const int gaussianPasses[4] = { 6, 7, 8, 9 };
+	const int kawasePasses[4] = { 3, 4, 5, 6 };
+	const int runs = 5;
+
+	Image output;
+	for (int i = 0; i < 4; i++) {
+		PostProcessChain::Settings settings;
+		settings.enableBloom = true;
+		settings.blurPasses = gaussianPasses[i];
+		settings.kawasePasses = kawasePasses[i];
+		settings.kawaseOffset = 3.0f;
+
+		double times[2];
+		for (int method = 0; method < 2; method++) {
+			settings.blurMethod = method == 0 ? PostProcessChain::GAUSSIAN_BLUR : PostProcessChain::KAWASE_BLUR;
+			chain.process(scene, settings, output);
+			Stopwatch stopwatch;
+			for (int run = 0; run < runs; run++)
+				chain.process(scene, settings, output);
+			times[method] = stopwatch.elapsed() / runs;
+		}
+		printf("  gaussian %d levels: %.2f ms, kawase %d levels x 3: %.2f ms, %.1fx\n", gaussianPasses[i], times[0], kawasePasses[i], times[1],
+			times[0] / times[1]);
+	}
+}
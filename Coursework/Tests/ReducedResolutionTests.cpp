@@ -0,0 +1,246 @@
+// Reduced resolution tests
+#include "Test.h"
+#include "PostProcessChain.h"
+#include <algorithm>
+
+typedef PostProcessChain::Image Image;
+
+// a far textured background behind a near bright disc and a near dark bar, alpha is linear depth
+static Image depthScene(int width, int height)
+{
+	Image scene;
+	scene.resize(width, height);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float* texel = scene.row(y) + x * 4;
+			float background = 0.2f + 0.1f * sinf(x * 0.05f) * cosf(y * 0.07f);
+			texel[0] = background;
+			texel[1] = background * 0.9f;
+			texel[2] = background * 1.2f;
+			texel[3] = 80.0f + y * 0.05f;
+
+			float dx = x - width * 0.35f, dy = y - height * 0.5f;
+			if (dx * dx + dy * dy < (height * 0.23f) * (height * 0.23f)) {
+				texel[0] = 6.0f;
+				texel[1] = 5.0f;
+				texel[2] = 3.0f;
+				texel[3] = 6.0f + dx * 0.01f;
+			}
+			if (x > width * 0.62f && x < width * 0.62f + 37 && y > height * 0.1f) {
+				texel[0] = 0.02f;
+				texel[1] = 0.02f;
+				texel[2] = 0.03f;
+				texel[3] = 12.0f;
+			}
+		}
+	}
+	return scene;
+}
+
+// whether a depth edge is within radius pixels
+static bool nearEdge(const Image& scene, int x, int y, int radius)
+{
+	float depth = scene.row(y)[x * 4 + 3];
+	for (int j = std::max(y - radius, 0); j <= std::min(y + radius, scene.height - 1); j++) {
+		for (int i = std::max(x - radius, 0); i <= std::min(x + radius, scene.width - 1); i++) {
+			if (fabsf(scene.row(j)[i * 4 + 3] - depth) / depth > 0.3f)
+				return true;
+		}
+	}
+	return false;
+}
+
+// the mean colour difference from the expected image next to the scene's depth edges and away from them
+static void edgeErrors(const Image& image, const Image& expected, const Image& scene, double& edges, double& elsewhere)
+{
+	double edgeSum = 0.0, otherSum = 0.0;
+	long edgeCount = 0, otherCount = 0;
+	for (int y = 0; y < scene.height; y++) {
+		for (int x = 0; x < scene.width; x++) {
+			double difference = 0.0;
+			for (int c = 0; c < 3; c++)
+				difference += fabs(image.row(y)[x * 4 + c] - expected.row(y)[x * 4 + c]) / 3.0;
+			if (nearEdge(scene, x, y, 2)) {
+				edgeSum += difference;
+				edgeCount++;
+			}
+			else {
+				otherSum += difference;
+				otherCount++;
+			}
+		}
+	}
+	edges = edgeSum / edgeCount;
+	elsewhere = otherSum / otherCount;
+}
+
+TEST(reducedResolutionReduce)
+{
+	Image scene = depthScene(641, 359);
+	PostProcessChain chain(1);
+	const int scales[3] = { 1, 2, 4 };
+	for (int s = 0; s < 3; s++) {
+		int scale = scales[s];
+		int width, height;
+		PostProcessChain::reducedSize(scene.width, scene.height, scale, width, height);
+		CHECK(width == (scene.width + scale - 1) / scale && height == (scene.height + scale - 1) / scale);
+
+		Image reduced;
+		reduced.resize(width, height);
+		chain.reduce(scene, reduced, scale);
+
+		// the blocks past the right and bottom edges repeat the last column and row
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				for (int c = 0; c < 4; c++) {
+					double sum = 0.0;
+					for (int j = 0; j < scale; j++) {
+						for (int i = 0; i < scale; i++)
+							sum += scene.row(std::min(y * scale + j, scene.height - 1))[std::min(x * scale + i, scene.width - 1) * 4 + c];
+					}
+					CHECK_CLOSE(reduced.row(y)[x * 4 + c], sum / (scale * scale), 1e-4);
+				}
+			}
+		}
+
+		// scale 1 is the scene itself, so the full resolution chain is unchanged
+		if (scale == 1)
+			CHECK(reduced.pixels == scene.pixels);
+	}
+}
+
+// with both sigmas 0 every guide texel weighs the same and the upsample is a clamped bilinear fetch
+TEST(reducedResolutionBilinearFallback)
+{
+	Image scene = depthScene(320, 180);
+	PostProcessChain chain(1);
+	Image reduced, upsampled;
+	reduced.resize(80, 45);
+	chain.reduce(scene, reduced, 4);
+	upsampled.resize(scene.width, scene.height);
+	chain.jointBilateralUpsample(reduced, reduced, scene, upsampled, 0.0f, 0.0f);
+
+	for (int y = 0; y < scene.height; y++) {
+		float v = std::min(std::max((y + 0.5f) / scene.height * reduced.height - 0.5f, 0.0f), (float)(reduced.height - 1));
+		int y0 = (int)v, y1 = std::min(y0 + 1, reduced.height - 1);
+		for (int x = 0; x < scene.width; x++) {
+			float u = std::min(std::max((x + 0.5f) / scene.width * reduced.width - 0.5f, 0.0f), (float)(reduced.width - 1));
+			int x0 = (int)u, x1 = std::min(x0 + 1, reduced.width - 1);
+			for (int c = 0; c < 3; c++) {
+				float top = reduced.row(y0)[x0 * 4 + c] + (reduced.row(y0)[x1 * 4 + c] - reduced.row(y0)[x0 * 4 + c]) * (u - x0);
+				float bottom = reduced.row(y1)[x0 * 4 + c] + (reduced.row(y1)[x1 * 4 + c] - reduced.row(y1)[x0 * 4 + c]) * (u - x0);
+				CHECK_CLOSE(upsampled.row(y)[x * 4 + c], top + (bottom - top) * (v - y0), 1e-4f);
+			}
+			CHECK(upsampled.row(y)[x * 4 + 3] == 1.0f);
+		}
+	}
+}
+
+// upsampling the reduced scene itself, which has the scene's edges, the depth and luminance weights have to keep the near
+// objects from bleeding into the background without blurring anything else
+TEST(reducedResolutionKeepsDepthEdges)
+{
+	Image scene = depthScene(640, 360);
+	PostProcessChain chain(1);
+	for (int scale = 2; scale <= 4; scale *= 2) {
+		int width, height;
+		PostProcessChain::reducedSize(scene.width, scene.height, scale, width, height);
+		Image reduced, bilinear, guided;
+		reduced.resize(width, height);
+		chain.reduce(scene, reduced, scale);
+		bilinear.resize(scene.width, scene.height);
+		guided.resize(scene.width, scene.height);
+		chain.jointBilateralUpsample(reduced, reduced, scene, bilinear, 0.0f, 0.0f);
+		PostProcessChain::Settings settings;
+		chain.jointBilateralUpsample(reduced, reduced, scene, guided, settings.upsampleDepthSigma, settings.upsampleLuminanceSigma);
+
+		double bilinearEdges, bilinearElsewhere, guidedEdges, guidedElsewhere;
+		edgeErrors(bilinear, scene, scene, bilinearEdges, bilinearElsewhere);
+		edgeErrors(guided, scene, scene, guidedEdges, guidedElsewhere);
+		CHECK(guidedEdges < bilinearEdges * 0.2);
+		CHECK(guidedElsewhere < bilinearElsewhere * 1.05 + 1e-3);
+	}
+
+	// a flat source stays flat whatever the weights, they're normalised
+	Image flat;
+	flat.resize(160, 90);
+	for (size_t i = 0; i < flat.pixels.size(); i += 4) {
+		flat.pixels[i] = 0.7f;
+		flat.pixels[i + 1] = 1.5f;
+		flat.pixels[i + 2] = 3.0f;
+		flat.pixels[i + 3] = 1.0f;
+	}
+	Image guide, upsampled;
+	guide.resize(160, 90);
+	chain.reduce(scene, guide, 4);
+	upsampled.resize(scene.width, scene.height);
+	chain.jointBilateralUpsample(flat, guide, scene, upsampled, 0.1f, 2.0f);
+	for (size_t i = 0; i < upsampled.pixels.size(); i += 4) {
+		CHECK_CLOSE(upsampled.pixels[i], 0.7f, 1e-5f);
+		CHECK_CLOSE(upsampled.pixels[i + 1], 1.5f, 1e-5f);
+		CHECK_CLOSE(upsampled.pixels[i + 2], 3.0f, 1e-5f);
+	}
+}
+
+// App1's levels for a 640x360 scene
+static void levels(PostProcessChain::Settings& settings)
+{
+	const int sizes[3][2] = { { 640, 360 }, { 512, 288 }, { 256, 144 } };
+	for (int i = 0; i < 3; i++) {
+		settings.levelWidth[i] = sizes[i][0];
+		settings.levelHeight[i] = sizes[i][1];
+	}
+	settings.blurPasses = 3;
+	settings.kawasePasses = 3;
+	settings.summedAreaRadius = 60.0f;
+}
+
+// the reduced chains on every blur method: split between threads the same, and close to the full resolution chain
+TEST(reducedResolutionChain)
+{
+	Image scene = depthScene(640, 360);
+	for (int bloom = 0; bloom < 2; bloom++) {
+		for (int method = 0; method < 3; method++) {
+			PostProcessChain::Settings settings;
+			levels(settings);
+			settings.enableBloom = bloom == 1;
+			settings.blurMethod = method;
+
+			PostProcessChain one(1), several(3);
+			Image full, a, b;
+			one.process(scene, settings, full);
+			for (int scale = 2; scale <= 4; scale *= 2) {
+				settings.resolutionScale = scale;
+				one.process(scene, settings, a);
+				several.process(scene, settings, b);
+				CHECK(a.width == scene.width && a.height == scene.height);
+				CHECK(a.pixels == b.pixels);
+
+				// the blurs' kernels are in texels of the image they blur, at a quarter of the size they reach further
+				double edges, elsewhere;
+				edgeErrors(a, full, scene, edges, elsewhere);
+				CHECK(edges < 0.7);
+				CHECK(elsewhere < (scale == 2 ? 0.12 : 0.35));
+			}
+		}
+	}
+}
+
+// App1's screen through the default bloom at full, half and quarter resolution
+BENCHMARK(reducedResolutionBenchmark)
+{
+	Image scene = depthScene(1200, 675);
+	PostProcessChain chain;
+	PostProcessChain::Settings settings;
+	settings.enableBloom = true;
+	const int runs = 10;
+	Image output;
+	for (int scale = 1; scale <= 4; scale *= 2) {
+		settings.resolutionScale = scale;
+		chain.process(scene, settings, output);
+		Stopwatch stopwatch;
+		for (int run = 0; run < runs; run++)
+			chain.process(scene, settings, output);
+		printf("  1/%d resolution: %.2f ms\n", scale, stopwatch.elapsed() / runs);
+	}
+}
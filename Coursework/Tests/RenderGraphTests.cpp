@@ -0,0 +1,270 @@
+// Render graph tests
+#include "Test.h"
+#include "RenderGraph.h"
+
+// records what the graph asks for instead of binding and clearing, and which resource's contents each texture holds
+struct MockExecutor : RenderGraph::Executor
+{
+	vector<string> calls;
+	vector<int> contents; // per physical target, the transient resource last written to it
+	int bound;
+
+	MockExecutor() : bound(-1) {}
+
+	void allocate(const RenderGraph& graph)
+	{
+		contents.assign(graph.getPhysicalCount(), -1);
+		calls.push_back("allocate");
+	}
+
+	void bind(const RenderGraph& graph, int resource)
+	{
+		bound = resource;
+		calls.push_back(string("bind ") + (graph.isImported(resource) ? "imported" : "transient"));
+	}
+
+	void clear(const RenderGraph&, int)
+	{
+		calls.push_back("clear");
+	}
+
+	void release(const RenderGraph&)
+	{
+		calls.push_back("release");
+	}
+};
+
+// declares passes whose functions check they run after everything they read was written, into the texture they read it from
+struct TestFrame
+{
+	RenderGraph graph;
+	MockExecutor executor;
+	vector<string> ran;
+
+	int pass(const char* name, vector<int> reads, int target, RenderGraph::WriteMode mode)
+	{
+		int index = graph.addPass(name, [this, name, reads, target]() {
+			for (size_t i = 0; i < reads.size(); i++) {
+				int physical = graph.getPhysical(reads[i]);
+				if (!graph.isImported(reads[i]))
+					CHECK(physical >= 0 && executor.contents[physical] == reads[i]);
+			}
+			if (target >= 0 && !graph.isImported(target)) {
+				CHECK(executor.bound == target);
+				executor.contents[graph.getPhysical(target)] = target;
+			}
+			ran.push_back(name);
+		});
+		for (size_t i = 0; i < reads.size(); i++)
+			graph.read(index, reads[i]);
+		if (target >= 0)
+			graph.write(index, target, mode);
+		return index;
+	}
+
+	int count(const char* name) const
+	{
+		int found = 0;
+		for (size_t i = 0; i < ran.size(); i++)
+			found += ran[i] == name;
+		return found;
+	}
+
+	bool run()
+	{
+		if (!graph.compile())
+			return false;
+		graph.execute(executor);
+		return true;
+	}
+};
+
+// App1's blur levels
+static const int LEVEL_WIDTHS[9] = { 1184, 1024, 896, 512, 256, 128, 64, 32, 16 };
+static const int LEVEL_HEIGHTS[9] = { 666, 576, 504, 288, 144, 72, 36, 18, 9 };
+
+// the frame App1::render declares, with addPostProcessing's gaussian chain
+static void declareFrame(TestFrame& frame, bool postProcessing, bool bloom, bool hdr, int passes, bool bake)
+{
+	RenderGraph& graph = frame.graph;
+	graph.reset();
+	int backBuffer = graph.importResource("back buffer", true);
+	int shadowMaps = graph.importResource("shadow maps", false);
+	int bakedPlane = graph.importResource("baked plane", false);
+
+	if (bake)
+		graph.writeExternal(frame.pass("tessellation bake", {}, -1, RenderGraph::WRITE_LOAD), bakedPlane);
+	graph.writeExternal(frame.pass("shadow maps", { bakedPlane }, -1, RenderGraph::WRITE_LOAD), shadowMaps);
+
+	if (!postProcessing) {
+		frame.pass("scene", { shadowMaps, bakedPlane }, backBuffer, RenderGraph::WRITE_CLEAR);
+		frame.pass("overlay", {}, backBuffer, RenderGraph::WRITE_LOAD);
+		return;
+	}
+
+	int scene = graph.createTarget("scene", 1200, 675, 2);
+	frame.pass("scene", { shadowMaps, bakedPlane }, scene, RenderGraph::WRITE_CLEAR);
+	int threshold = graph.createTarget("threshold", 1200, 675, 2);
+	frame.pass("bloom threshold", { scene }, threshold, RenderGraph::WRITE_COVER);
+
+	int vertical[9];
+	for (int i = 0; i < passes; i++) {
+		int horizontal = graph.createTarget("horizontal", LEVEL_WIDTHS[i], LEVEL_HEIGHTS[i], 2);
+		frame.pass("horizontal blur", { i ? vertical[i - 1] : (bloom ? threshold : scene) }, horizontal, RenderGraph::WRITE_COVER);
+		vertical[i] = graph.createTarget("vertical", LEVEL_WIDTHS[i], LEVEL_HEIGHTS[i], 2);
+		frame.pass("vertical blur", { horizontal }, vertical[i], RenderGraph::WRITE_COVER);
+	}
+	int blurFilter = graph.createTarget("blur filter", 1200, 675, 2);
+	frame.pass("blur filter", { vertical[passes - 1] }, blurFilter, RenderGraph::WRITE_COVER);
+
+	int combined = vertical[passes - 1];
+	for (int i = passes - 2; i >= 0; i--) {
+		int upscaled = graph.createTarget("upscaled", LEVEL_WIDTHS[i], LEVEL_HEIGHTS[i], 2);
+		frame.pass("upscale", { combined }, upscaled, RenderGraph::WRITE_COVER);
+		combined = graph.createTarget("combined", LEVEL_WIDTHS[i], LEVEL_HEIGHTS[i], 2);
+		frame.pass("combine", { vertical[i], upscaled }, combined, RenderGraph::WRITE_COVER);
+	}
+	int bloomFilter = graph.createTarget("bloom filter", 1200, 675, 2);
+	frame.pass("bloom filter", { scene, combined }, bloomFilter, RenderGraph::WRITE_COVER);
+
+	int filter = bloom ? bloomFilter : blurFilter;
+	int toneMapped = graph.createTarget("tone mapped", 1200, 675, 2);
+	frame.pass("tone map", { filter }, toneMapped, RenderGraph::WRITE_COVER);
+
+	frame.pass("final", { hdr ? toneMapped : filter }, backBuffer, RenderGraph::WRITE_COVER);
+	frame.pass("overlay", {}, backBuffer, RenderGraph::WRITE_LOAD);
+}
+
+TEST(renderGraphRunsOnlyWhatTheFrameNeeds)
+{
+	struct Case { bool postProcessing, bloom, hdr; int passes; bool bake; };
+	const Case cases[] = {
+		{ false, false, false, 9, true }, { true, false, false, 9, true }, { true, false, true, 9, false },
+		{ true, true, true, 9, true }, { true, true, false, 1, true }, { true, true, false, 4, false },
+	};
+
+	for (const Case& c : cases) {
+		TestFrame frame;
+		declareFrame(frame, c.postProcessing, c.bloom, c.hdr, c.passes, c.bake);
+		CHECK(frame.run());
+
+		const RenderGraph::Stats& stats = frame.graph.getStats();
+		CHECK((int)frame.ran.size() == stats.passes - stats.culled);
+		CHECK(frame.ran.front() == (c.bake ? "tessellation bake" : "shadow maps"));
+		CHECK(frame.ran.back() == "overlay");
+		CHECK(frame.executor.calls.front() == "allocate" && frame.executor.calls.back() == "release");
+		if (!c.postProcessing)
+			continue;
+
+		CHECK(frame.count("bloom threshold") == (c.bloom ? 1 : 0));
+		CHECK(frame.count("blur filter") == (c.bloom ? 0 : 1));
+		CHECK(frame.count("bloom filter") == (c.bloom ? 1 : 0));
+		CHECK(frame.count("tone map") == (c.hdr ? 1 : 0));
+		CHECK(frame.count("upscale") == (c.bloom ? c.passes - 1 : 0));
+		CHECK(frame.count("horizontal blur") == c.passes);
+		CHECK(frame.ran[frame.ran.size() - 2] == "final");
+	}
+}
+
+// only the scene is partly drawn, everything else covers its target. the overlay draws on the back buffer final left bound
+TEST(renderGraphSkipsClearsAndBinds)
+{
+	TestFrame frame;
+	declareFrame(frame, true, true, true, 9, true);
+	CHECK(frame.run());
+
+	const vector<RenderGraph::Step>& steps = frame.graph.getSteps();
+	for (size_t i = 0; i < steps.size(); i++) {
+		if (steps[i].clear)
+			CHECK(string(frame.graph.getPassName(steps[i].pass)) == "scene");
+	}
+	CHECK(!steps.back().bind && !steps.back().clear);
+
+	const RenderGraph::Stats& stats = frame.graph.getStats();
+	CHECK(stats.clears == 1);
+	CHECK(stats.skippedClears > 0);
+	CHECK(stats.skippedBinds >= 1);
+
+	int clears = 0;
+	int binds = 0;
+	for (size_t i = 0; i < frame.executor.calls.size(); i++) {
+		clears += frame.executor.calls[i] == "clear";
+		binds += frame.executor.calls[i].compare(0, 4, "bind") == 0;
+	}
+	CHECK(clears == stats.clears);
+	CHECK(binds == stats.binds);
+}
+
+// targets share a texture only when they're the same size and format and nothing in between still needs the first
+TEST(renderGraphAliasesDisjointTargets)
+{
+	TestFrame frame;
+	RenderGraph& graph = frame.graph;
+	int backBuffer = graph.importResource("back buffer", true);
+	int target[3];
+	for (int i = 0; i < 3; i++)
+		target[i] = graph.createTarget("target", 8, 8, 1);
+	int other = graph.createTarget("other format", 8, 8, 2);
+
+	frame.pass("a", {}, target[0], RenderGraph::WRITE_CLEAR);
+	frame.pass("b", { target[0] }, target[1], RenderGraph::WRITE_COVER);
+	frame.pass("c", { target[1] }, target[2], RenderGraph::WRITE_COVER);
+	frame.pass("d", { target[2] }, other, RenderGraph::WRITE_COVER);
+	frame.pass("e", { other }, backBuffer, RenderGraph::WRITE_COVER);
+	CHECK(frame.run());
+
+	CHECK(graph.getPhysicalCount() == 3);
+	CHECK(graph.getPhysical(target[0]) == graph.getPhysical(target[2]));
+	CHECK(graph.getPhysical(target[0]) != graph.getPhysical(target[1]));
+	CHECK(graph.getPhysical(other) != graph.getPhysical(target[0]) && graph.getPhysical(other) != graph.getPhysical(target[1]));
+	CHECK(graph.getPhysicalDesc(graph.getPhysical(other)).format == 2);
+	CHECK(graph.getPhysical(backBuffer) == -1);
+
+	// App1's whole chain fits in fewer textures than it declares, and every read still saw the right contents
+	TestFrame chain;
+	declareFrame(chain, true, true, true, 9, true);
+	CHECK(chain.run());
+	CHECK(chain.graph.getStats().physicalTargets < chain.graph.getStats().targets);
+	const vector<RenderGraph::Step>& steps = chain.graph.getSteps();
+	for (size_t i = 0; i < steps.size(); i++) {
+		if (steps[i].target < 0 || chain.graph.getPhysical(steps[i].target) < 0)
+			continue;
+		int physical = chain.graph.getPhysical(steps[i].target);
+		CHECK(chain.graph.getPhysicalDesc(physical).width == chain.graph.getDesc(steps[i].target).width);
+		CHECK(chain.graph.getPhysicalDesc(physical).height == chain.graph.getDesc(steps[i].target).height);
+	}
+}
+
+TEST(renderGraphOrdersByDependency)
+{
+	// declared with the reader first, it still runs after the pass that fills its input. nothing reads unused
+	TestFrame frame;
+	int backBuffer = frame.graph.importResource("back buffer", true);
+	int target = frame.graph.createTarget("target", 4, 4, 1);
+	frame.pass("present", { target }, backBuffer, RenderGraph::WRITE_COVER);
+	frame.pass("fill", {}, target, RenderGraph::WRITE_CLEAR);
+	int unused = frame.pass("unused", {}, frame.graph.createTarget("unused", 4, 4, 1), RenderGraph::WRITE_CLEAR);
+	CHECK(frame.run());
+	CHECK(frame.ran.size() == 2 && frame.ran[0] == "fill" && frame.ran[1] == "present");
+	CHECK(frame.graph.isCulled(unused));
+
+	// a pass covering the whole output makes the one before it that cleared and drew it pointless
+	TestFrame overwritten;
+	backBuffer = overwritten.graph.importResource("back buffer", true);
+	overwritten.pass("first", {}, backBuffer, RenderGraph::WRITE_CLEAR);
+	overwritten.pass("second", {}, backBuffer, RenderGraph::WRITE_COVER);
+	CHECK(overwritten.run());
+	CHECK(overwritten.ran.size() == 1 && overwritten.ran[0] == "second");
+}
+
+TEST(renderGraphRejectsLoops)
+{
+	TestFrame frame;
+	int backBuffer = frame.graph.importResource("back buffer", true);
+	int first = frame.graph.createTarget("first", 4, 4, 1);
+	int second = frame.graph.createTarget("second", 4, 4, 1);
+	frame.pass("a", { second }, first, RenderGraph::WRITE_COVER);
+	frame.pass("b", { first }, second, RenderGraph::WRITE_COVER);
+	frame.pass("c", { first }, backBuffer, RenderGraph::WRITE_COVER);
+	CHECK(!frame.graph.compile());
+}
@@ -0,0 +1,190 @@
+// Shadow math tests
+#include "Test.h"
+#include "ShadowMath.h"
+#include <directxmath.h>
+#include <random>
+
+using namespace DirectX;
+
+static const float PARABOLOID_NEAR = 0.5f;
+static const float PARABOLOID_FAR = 120.0f;
+
+// a random direction in the hemisphere a paraboloid covers, including its edge
+static float3 randomHemisphereDirection(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (;;) {
+		float3 direction(unit(random), unit(random), unit(random));
+		float len = length(direction);
+		if (len > 0.01f && len <= 1.0f) {
+			direction = direction / len;
+			direction.z = fabsf(direction.z);
+			return direction;
+		}
+	}
+}
+
+TEST(paraboloidRoundTrip)
+{
+	std::mt19937 random(30);
+	std::uniform_real_distribution<float> distance(PARABOLOID_NEAR, PARABOLOID_FAR);
+
+	for (int run = 0; run < 10000; run++) {
+		float3 position = randomHemisphereDirection(random) * distance(random);
+		float3 projected = paraboloidProject(position, PARABOLOID_NEAR, PARABOLOID_FAR);
+		CHECK(projected.x * projected.x + projected.y * projected.y <= 1.0f + 1e-5f);
+		CHECK(projected.z >= -1e-5f && projected.z <= 1.0f + 1e-5f);
+
+		float3 back = paraboloidUnproject(projected, PARABOLOID_NEAR, PARABOLOID_FAR);
+		CHECK_CLOSE(length(back - position) / length(position), 0.0f, 1e-4f);
+	}
+}
+
+TEST(paraboloidUnprojectRoundTrip)
+{
+	std::mt19937 random(31);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+	for (int run = 0; run < 10000; run++) {
+		float3 projected(unit(random), unit(random), depth(random));
+		if (projected.x * projected.x + projected.y * projected.y > 1.0f)
+			continue;
+
+		float3 back = paraboloidProject(paraboloidUnproject(projected, PARABOLOID_NEAR, PARABOLOID_FAR), PARABOLOID_NEAR, PARABOLOID_FAR);
+		CHECK_CLOSE(back.x, projected.x, 1e-5f);
+		CHECK_CLOSE(back.y, projected.y, 1e-5f);
+		CHECK_CLOSE(back.z, projected.z, 1e-5f);
+	}
+}
+
+TEST(paraboloidLandmarks)
+{
+	// straight ahead is the middle of the disc, the hemisphere's edge is its rim
+	float3 ahead = paraboloidProject(float3(0.0f, 0.0f, 10.0f), PARABOLOID_NEAR, PARABOLOID_FAR);
+	CHECK_CLOSE(ahead.x, 0.0f, 1e-6f);
+	CHECK_CLOSE(ahead.y, 0.0f, 1e-6f);
+
+	for (int i = 0; i < 16; i++) {
+		float angle = i * 3.14159265f / 8.0f;
+		float3 edge = paraboloidProject(float3(cosf(angle), sinf(angle), 0.0f) * 10.0f, PARABOLOID_NEAR, PARABOLOID_FAR);
+		CHECK_CLOSE(edge.x * edge.x + edge.y * edge.y, 1.0f, 1e-5f);
+	}
+
+	// 45 degrees off axis sits at tan(22.5) from the middle
+	float3 diagonal = paraboloidProject(float3(1.0f, 0.0f, 1.0f), PARABOLOID_NEAR, PARABOLOID_FAR);
+	CHECK_CLOSE(diagonal.x, tanf(3.14159265f / 8.0f), 1e-5f);
+
+	// depth is linear between the planes
+	CHECK_CLOSE(paraboloidProject(float3(0.0f, PARABOLOID_NEAR, 0.0f), PARABOLOID_NEAR, PARABOLOID_FAR).z, 0.0f, 1e-6f);
+	CHECK_CLOSE(paraboloidProject(float3(0.0f, 0.0f, PARABOLOID_FAR), PARABOLOID_NEAR, PARABOLOID_FAR).z, 1.0f, 1e-6f);
+	float middle = (PARABOLOID_NEAR + PARABOLOID_FAR) * 0.5f;
+	CHECK_CLOSE(paraboloidProject(float3(middle, 0.0f, 0.0f), PARABOLOID_NEAR, PARABOLOID_FAR).z, 0.5f, 1e-6f);
+}
+
+TEST(paraboloidUVMatchesProjectiveCoords)
+{
+	std::mt19937 random(32);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	for (int run = 0; run < 1000; run++) {
+		float3 projected(unit(random), unit(random), 0.5f);
+		float2 uv = paraboloidToUV(projected);
+		float2 expected = getProjectiveCoords(float4(projected.x, projected.y, 0.5f, 1.0f));
+		CHECK_CLOSE(uv.x, expected.x, 1e-6f);
+		CHECK_CLOSE(uv.y, expected.y, 1e-6f);
+	}
+}
+
+// CUBE FACES
+// the cube faces App1 renders, in slice order
+static const XMFLOAT3 CUBE_DIRECTIONS[6] = {
+	XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f),
+	XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f)
+};
+
+// a cube face's view projection, built the way Light::generateViewMatrix and generateProjectionMatrix do
+static XMMATRIX cubeFaceViewProjection(int face, float nearPlane, float farPlane)
+{
+	XMFLOAT3 direction = CUBE_DIRECTIONS[face];
+	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f);
+	if (direction.x == 0.0f && direction.z == 0.0f)
+		up = XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f);
+	XMVECTOR dir = XMLoadFloat3(&direction);
+	XMVECTOR right = XMVector3Cross(dir, up);
+	up = XMVector3Cross(right, dir);
+
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorZero(), dir, up);
+	return view * XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, nearPlane, farPlane);
+}
+
+static float4 cubeFaceClipPosition(int face, float3 lightToPixel)
+{
+	XMVECTOR clip = XMVector4Transform(XMVectorSet(lightToPixel.x, lightToPixel.y, lightToPixel.z, 1.0f), cubeFaceViewProjection(face, 0.1f, 100.0f));
+	return float4(XMVectorGetX(clip), XMVectorGetY(clip), XMVectorGetZ(clip), XMVectorGetW(clip));
+}
+
+static bool faceCovers(int face, float3 lightToPixel, float tolerance)
+{
+	float4 clip = cubeFaceClipPosition(face, lightToPixel);
+	float2 uv = getProjectiveCoords(clip);
+	return clip.w > 0.0f && uv.x >= -tolerance && uv.x <= 1.0f + tolerance && uv.y >= -tolerance && uv.y <= 1.0f + tolerance;
+}
+
+// the per face path the shaders used before cubeFaceIndex: project into every face in turn and take the first one with
+// depth data. a pixel behind a face also lands inside its uv square, the old loop only moved past it because the depth
+// comparison failed there, which is the w > 0 test here
+static int perFaceLookup(float3 lightToPixel)
+{
+	for (int face = 0; face < 6; face++) {
+		if (faceCovers(face, lightToPixel, 0.0f))
+			return face;
+	}
+	return -1;
+}
+
+TEST(cubeFaceIndexMatchesPerFaceLookup)
+{
+	std::mt19937 random(31);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> distance(0.5f, 90.0f);
+
+	int edges = 0;
+	for (int run = 0; run < 100000; run++) {
+		float3 lightToPixel = float3(unit(random), unit(random), unit(random));
+		if (length(lightToPixel) < 0.01f)
+			continue;
+		lightToPixel = normalize(lightToPixel) * distance(random);
+
+		int face = cubeFaceIndex(lightToPixel);
+		int reference = perFaceLookup(lightToPixel);
+		CHECK(reference >= 0);
+
+		// right on an edge both faces have the pixel, and either is fine as long as the chosen face really covers it
+		if (face != reference) {
+			edges++;
+			CHECK(faceCovers(face, lightToPixel, 1e-5f));
+		}
+	}
+
+	// only the rounding at the edges may disagree
+	CHECK(edges < 10);
+}
+
+TEST(cubeFaceIndexOnTheEdges)
+{
+	// the axes and the diagonals between faces, where the two lookups are most likely to drift apart
+	for (int x = -1; x <= 1; x++) {
+		for (int y = -1; y <= 1; y++) {
+			for (int z = -1; z <= 1; z++) {
+				if (x == 0 && y == 0 && z == 0)
+					continue;
+
+				float3 lightToPixel((float)x, (float)y, (float)z);
+				int face = cubeFaceIndex(lightToPixel);
+				CHECK(face >= 0 && face < 6);
+				CHECK(faceCovers(face, lightToPixel * 10.0f, 1e-5f));
+			}
+		}
+	}
+}
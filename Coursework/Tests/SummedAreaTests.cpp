@@ -0,0 +1,363 @@
+// Summed area tests
+#include "Test.h"
+#include "PostProcessChain.h"
+#include "StackedBoxes.h"
+#include <algorithm>
+
+typedef PostProcessChain::Image Image;
+
+// bright blocks on a dim background with some noise, the kind of image a small box misses detail of when its sums lose precision
+static Image blockScene(int width, int height)
+{
+	Image scene;
+	scene.resize(width, height);
+	unsigned int random = 7;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			random = random * 1664525u + 1013904223u;
+			float noise = (random >> 8) / 16777216.0f;
+			float level = ((x / 41 + y / 29) % 4 == 0) ? 4.0f : 0.3f;
+			float* texel = scene.row(y) + x * 4;
+			for (int c = 0; c < 3; c++)
+				texel[c] = level * (0.6f + 0.4f * noise) + c * 0.1f;
+			texel[3] = 1.0f;
+		}
+	}
+	return scene;
+}
+
+// the image inside a table, without its zero row and column
+static Image tableImage(const Image& table)
+{
+	Image image;
+	image.resize(table.width - 1, table.height - 1);
+	for (int y = 0; y < image.height; y++)
+		std::copy(table.row(y + 1) + 4, table.row(y + 1) + table.width * 4, image.row(y));
+	return image;
+}
+
+// the weighted box averages added up texel by texel, in doubles
+static void bruteForceBoxes(const Image& image, const StackedBoxes& boxes, std::vector<double>& result)
+{
+	result.assign(image.pixels.size(), 0.0);
+	for (int y = 0; y < image.height; y++) {
+		for (int x = 0; x < image.width; x++) {
+			for (int i = 0; i < boxes.count; i++) {
+				int r = boxes.radii[i];
+				int firstX = std::max(x - r, 0), lastX = std::min(x + r + 1, image.width);
+				int firstY = std::max(y - r, 0), lastY = std::min(y + r + 1, image.height);
+				double sum[3] = { 0.0, 0.0, 0.0 };
+				for (int v = firstY; v < lastY; v++) {
+					for (int u = firstX; u < lastX; u++) {
+						for (int c = 0; c < 3; c++)
+							sum[c] += image.row(v)[u * 4 + c];
+					}
+				}
+				double area = (double)(lastX - firstX) * (lastY - firstY);
+				for (int c = 0; c < 3; c++)
+					result[((size_t)y * image.width + x) * 4 + c] += boxes.weights[i] * sum[c] / area;
+			}
+		}
+	}
+}
+
+static double maxColourDifference(const Image& image, const std::vector<double>& expected)
+{
+	double worst = 0.0;
+	for (size_t i = 0; i < expected.size(); i++) {
+		if (i % 4 != 3)
+			worst = std::max(worst, fabs(image.pixels[i] - expected[i]));
+	}
+	return worst;
+}
+
+// a gaussian out to three sigma as a horizontal pass then a vertical one, texel by texel with the edges clamped
+static void separableGaussian(const Image& image, Image& target, float sigma)
+{
+	int radius = (int)ceilf(sigma * 3.0f);
+	std::vector<float> weights(radius + 1);
+	float total = 0.0f;
+	for (int i = 0; i <= radius; i++) {
+		weights[i] = expf(-(i * i) / (2.0f * sigma * sigma));
+		total += i == 0 ? weights[i] : weights[i] * 2.0f;
+	}
+	for (int i = 0; i <= radius; i++)
+		weights[i] /= total;
+
+	Image across;
+	across.resize(image.width, image.height);
+	target.resize(image.width, image.height);
+	for (int pass = 0; pass < 2; pass++) {
+		const Image& source = pass == 0 ? image : across;
+		Image& out = pass == 0 ? across : target;
+		for (int y = 0; y < image.height; y++) {
+			for (int x = 0; x < image.width; x++) {
+				float sum[3] = { 0.0f, 0.0f, 0.0f };
+				for (int i = -radius; i <= radius; i++) {
+					int u = pass == 0 ? std::min(std::max(x + i, 0), image.width - 1) : x;
+					int v = pass == 1 ? std::min(std::max(y + i, 0), image.height - 1) : y;
+					const float* texel = source.row(v) + u * 4;
+					for (int c = 0; c < 3; c++)
+						sum[c] += texel[c] * weights[abs(i)];
+				}
+				float* texel = out.row(y) + x * 4;
+				for (int c = 0; c < 3; c++)
+					texel[c] = sum[c];
+				texel[3] = 1.0f;
+			}
+		}
+	}
+}
+
+// a stacked box kernel's weight at a texel offset from the centre
+static double stackedWeight(const StackedBoxes& boxes, int x, int y)
+{
+	double weight = 0.0;
+	for (int i = 0; i < boxes.count; i++) {
+		int r = boxes.radii[i];
+		if (abs(x) <= r && abs(y) <= r)
+			weight += boxes.weights[i] / ((2.0 * r + 1.0) * (2.0 * r + 1.0));
+	}
+	return weight;
+}
+
+TEST(stackedBoxesWeights)
+{
+	for (int count = 1; count <= MAX_STACKED_BOXES; count++) {
+		for (float sigma = 0.5f; sigma < 100.0f; sigma *= 1.3f) {
+			StackedBoxes boxes = makeStackedBoxes(sigma, count);
+			CHECK(boxes.count == count);
+
+			float total = 0.0f;
+			for (int i = 0; i < count; i++) {
+				CHECK(boxes.weights[i] > 0.0f);
+				CHECK(i == 0 || boxes.radii[i] > boxes.radii[i - 1]);
+				total += boxes.weights[i];
+			}
+			CHECK_CLOSE(total, 1.0f, 1e-5f);
+		}
+	}
+
+	CHECK(makeStackedBoxes(5.0f, 0).count == 1);
+	CHECK(makeStackedBoxes(5.0f, MAX_STACKED_BOXES + 1).count == MAX_STACKED_BOXES);
+}
+
+// the stepped pyramid has to spread as far as the gaussian it stands in for and get closer to it with every box. the
+// differences are the kernels' total absolute difference, out of the 2 it would be with no overlap at all
+TEST(stackedBoxesApproximateAGaussian)
+{
+	const float sigmas[3] = { 3.0f, 10.0f, 40.0f };
+	for (int s = 0; s < 3; s++) {
+		float sigma = sigmas[s];
+		double previous = 2.0;
+		for (int count = 2; count <= MAX_STACKED_BOXES; count++) {
+			StackedBoxes boxes = makeStackedBoxes(sigma, count);
+			int extent = boxes.radii[count - 1] + (int)sigma * 2;
+
+			double gaussianTotal = 0.0;
+			for (int y = -extent; y <= extent; y++) {
+				for (int x = -extent; x <= extent; x++)
+					gaussianTotal += exp(-(x * x + y * y) / (2.0 * sigma * sigma));
+			}
+
+			double difference = 0.0;
+			double variance = 0.0;
+			for (int y = -extent; y <= extent; y++) {
+				for (int x = -extent; x <= extent; x++) {
+					double weight = stackedWeight(boxes, x, y);
+					difference += fabs(weight - exp(-(x * x + y * y) / (2.0 * sigma * sigma)) / gaussianTotal);
+					variance += weight * x * x;
+				}
+			}
+			CHECK(difference < previous);
+			CHECK(difference < (count == 2 ? 0.42 : 0.34));
+			CHECK_CLOSE(sqrt(variance) / sigma, 1.0, 0.05);
+			previous = difference;
+		}
+	}
+}
+
+// the table's texels are the average of four bilinear taps a quarter of a texel either side of their centre
+TEST(summedAreaDownsample)
+{
+	Image scene = blockScene(401, 226);
+	PostProcessChain chain(1);
+	int width, height;
+	PostProcessChain::summedAreaSize(scene.width, scene.height, width, height);
+	CHECK(width == 101 && height == 57);
+
+	Image table;
+	table.resize(width + 1, height + 1);
+	const float threshold = 3.0f;
+	chain.summedAreaDownsample(scene, table, true, threshold);
+
+	// the zero row and column
+	for (int x = 0; x < table.width * 4; x++)
+		CHECK(table.row(0)[x] == 0.0f);
+	for (int y = 0; y < table.height; y++)
+		CHECK(table.row(y)[0] == 0.0f && table.row(y)[1] == 0.0f && table.row(y)[2] == 0.0f && table.row(y)[3] == 0.0f);
+
+	for (int y = 1; y < table.height; y += 3) {
+		for (int x = 1; x < table.width; x += 3) {
+			double expected[3] = { 0.0, 0.0, 0.0 };
+			for (int j = 0; j < 2; j++) {
+				for (int i = 0; i < 2; i++) {
+					float sx = std::min(std::max((x - 0.75f + i * 0.5f) / width * scene.width - 0.5f, 0.0f), (float)(scene.width - 1));
+					float sy = std::min(std::max((y - 0.75f + j * 0.5f) / height * scene.height - 0.5f, 0.0f), (float)(scene.height - 1));
+					int x0 = (int)sx, y0 = (int)sy;
+					int x1 = std::min(x0 + 1, scene.width - 1), y1 = std::min(y0 + 1, scene.height - 1);
+					const int xs[4] = { x0, x1, x0, x1 };
+					const int ys[4] = { y0, y0, y1, y1 };
+					const double bilinear[4] = { (1 - (sx - x0)) * (1 - (sy - y0)), (sx - x0) * (1 - (sy - y0)), (1 - (sx - x0)) * (sy - y0), (sx - x0) * (sy - y0) };
+					for (int t = 0; t < 4; t++) {
+						const float* texel = scene.row(ys[t]) + xs[t] * 4;
+						bool bright = texel[0] + texel[1] + texel[2] > threshold;
+						for (int c = 0; c < 3; c++)
+							expected[c] += (bright ? texel[c] : 0.0f) * bilinear[t] * 0.25;
+					}
+				}
+			}
+			for (int c = 0; c < 3; c++)
+				CHECK_CLOSE(table.row(y)[x * 4 + c], expected[c], 1e-5);
+		}
+	}
+}
+
+// each table texel is the sum of the texels above and left of it, less the mean of each
+TEST(summedAreaScan)
+{
+	Image scene = blockScene(1200, 675);
+	Image table;
+	table.resize(scene.width + 1, scene.height + 1);
+	for (int y = 0; y < scene.height; y++)
+		std::copy(scene.row(y), scene.row(y) + scene.width * 4, table.row(y + 1) + 4);
+	Image image = tableImage(table);
+
+	PostProcessChain chain(3);
+	float mean[4];
+	chain.summedAreaScan(table, mean);
+
+	std::vector<double> total(4, 0.0);
+	for (size_t i = 0; i < image.pixels.size(); i++)
+		total[i % 4] += image.pixels[i];
+	for (int c = 0; c < 4; c++)
+		CHECK_CLOSE(mean[c], total[c] / (image.width * image.height), 1e-5);
+
+	// a running sum in doubles along every row
+	std::vector<double> columnSums((size_t)table.width * 4, 0.0);
+	for (int y = 1; y < table.height; y++) {
+		double rowSum[4] = { 0.0, 0.0, 0.0, 0.0 };
+		for (int x = 1; x < table.width; x++) {
+			for (int c = 0; c < 4; c++) {
+				rowSum[c] += image.row(y - 1)[(x - 1) * 4 + c] - (double)mean[c];
+				columnSums[x * 4 + c] += rowSum[c];
+				// a float holds the sum to a few parts in ten million of the biggest it reaches
+				CHECK_CLOSE(table.row(y)[x * 4 + c], columnSums[x * 4 + c], 2e-2);
+			}
+		}
+	}
+}
+
+TEST(summedAreaBoxMatchesBruteForce)
+{
+	Image scene = blockScene(1200, 675);
+	PostProcessChain chain(1);
+	int width, height;
+	PostProcessChain::summedAreaSize(scene.width, scene.height, width, height);
+
+	Image table;
+	table.resize(width + 1, height + 1);
+	chain.summedAreaDownsample(scene, table);
+	Image image = tableImage(table);
+	float mean[4];
+	chain.summedAreaScan(table, mean);
+
+	const float sigmas[5] = { 1.0f, 2.0f, 5.0f, 10.0f, 40.0f };
+	for (int s = 0; s < 5; s++) {
+		StackedBoxes boxes = makeStackedBoxes(sigmas[s]);
+		std::vector<double> expected;
+		bruteForceBoxes(image, boxes, expected);
+
+		Image blurred;
+		blurred.resize(width, height);
+		chain.summedAreaBox(table, mean, blurred, boxes);
+		CHECK_CLOSE(maxColourDifference(blurred, expected), 0.0, 1e-4);
+	}
+
+	// a full size table sums 800,000 texels, a one texel box out of it still has to come out right
+	Image full;
+	full.resize(scene.width + 1, scene.height + 1);
+	for (int y = 0; y < scene.height; y++)
+		std::copy(scene.row(y), scene.row(y) + scene.width * 4, full.row(y + 1) + 4);
+	chain.summedAreaScan(full, mean);
+	StackedBoxes boxes = makeStackedBoxes(1.0f);
+	std::vector<double> expected;
+	bruteForceBoxes(scene, boxes, expected);
+	Image blurred;
+	blurred.resize(scene.width, scene.height);
+	chain.summedAreaBox(full, mean, blurred, boxes);
+	CHECK_CLOSE(maxColourDifference(blurred, expected), 0.0, 1e-3);
+}
+
+// a flat image stays flat, edges included, because the boxes are cut off at the edges rather than clamped
+TEST(summedAreaFlatImage)
+{
+	Image flat;
+	flat.resize(300, 169);
+	for (size_t i = 0; i < flat.pixels.size(); i += 4) {
+		flat.pixels[i] = 0.5f;
+		flat.pixels[i + 1] = 2.0f;
+		flat.pixels[i + 2] = 7.0f;
+		flat.pixels[i + 3] = 1.0f;
+	}
+
+	Image table;
+	table.resize(flat.width + 1, flat.height + 1);
+	for (int y = 0; y < flat.height; y++)
+		std::copy(flat.row(y), flat.row(y) + flat.width * 4, table.row(y + 1) + 4);
+	PostProcessChain chain;
+	float mean[4];
+	chain.summedAreaScan(table, mean);
+
+	Image blurred;
+	blurred.resize(flat.width, flat.height);
+	chain.summedAreaBox(table, mean, blurred, makeStackedBoxes(30.0f));
+	std::vector<double> expected(flat.pixels.begin(), flat.pixels.end());
+	CHECK_CLOSE(maxColourDifference(blurred, expected), 0.0, 1e-5);
+}
+
+// App1's quarter size table, single threaded: the box pass against a separable gaussian of the same sigma. the table is
+// built once whatever the sigma
+BENCHMARK(summedAreaBenchmark)
+{
+	Image scene = blockScene(1200, 675);
+	PostProcessChain chain(1);
+	int width, height;
+	PostProcessChain::summedAreaSize(scene.width, scene.height, width, height);
+	Image table;
+	table.resize(width + 1, height + 1);
+	float mean[4];
+
+	Stopwatch build;
+	chain.summedAreaDownsample(scene, table);
+	Image image = tableImage(table);
+	chain.summedAreaScan(table, mean);
+	printf("  %dx%d table: %.2f ms\n", width, height, build.elapsed());
+
+	Image blurred, gaussian;
+	blurred.resize(width, height);
+	const int runs = 5;
+	for (float sigma = 2.0f; sigma <= 64.0f; sigma *= 2.0f) {
+		StackedBoxes boxes = makeStackedBoxes(sigma);
+		Stopwatch box;
+		for (int run = 0; run < runs; run++)
+			chain.summedAreaBox(table, mean, blurred, boxes);
+		double boxTime = box.elapsed() / runs;
+
+		Stopwatch separable;
+		for (int run = 0; run < runs; run++)
+			separableGaussian(image, gaussian, sigma);
+		double gaussianTime = separable.elapsed() / runs;
+		printf("  sigma %2.0f: box pass %.2f ms, separable gaussian %.2f ms\n", sigma, boxTime, gaussianTime);
+	}
+}
@@ -0,0 +1,179 @@
+// Surface bounds tests
+#include "Test.h"
+#include "SurfaceBounds.h"
+#include "WaveMath.h"
+#include <directxmath.h>
+#include <random>
+
+using namespace DirectX;
+
+// App1's manipulation plane
+static const float PLANE_EXTENT = TESSELLATED_PLANE_RESOLUTION - 1.0f;
+static const float3 WORLD_OFFSET(-15.0f, -8.0f, -15.0f);
+
+struct SurfaceSettings
+{
+	float heightMin, heightMax, heightAmplitude;
+	float2 waveAmplitude, waveFrequency, waveSpeed;
+	float planeToSphere;
+	float4 sphere;
+};
+
+static SurfaceSettings randomSettings(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	SurfaceSettings s;
+	s.heightMin = unit(random) * 0.5f;
+	s.heightMax = s.heightMin + unit(random) * (1.0f - s.heightMin);
+	s.heightAmplitude = unit(random) * 50.0f - 20.0f;
+	s.waveAmplitude = float2(unit(random) * 30.0f, unit(random) * 30.0f);
+	s.waveFrequency = float2(unit(random) * 4.0f, unit(random) * 4.0f);
+	s.waveSpeed = float2(unit(random) * 20.0f - 10.0f, unit(random) * 20.0f - 10.0f);
+	s.planeToSphere = unit(random);
+	s.sphere = float4(unit(random) * 100.0f - 50.0f, unit(random) * 100.0f - 50.0f, unit(random) * 100.0f - 50.0f, unit(random) * 40.0f);
+	return s;
+}
+
+static SurfaceBounds boundsFor(const SurfaceSettings& s)
+{
+	SurfaceBounds bounds;
+	bounds.update(s.heightMin, s.heightMax, s.heightAmplitude, s.waveAmplitude, s.planeToSphere, s.sphere, PLANE_EXTENT, WORLD_OFFSET);
+	return bounds;
+}
+
+// a vertex of the plane the way the manipulation shaders displace it, with a height anywhere in the heightmap's range
+static float3 randomVertex(const SurfaceSettings& s, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float3 position(unit(random) * PLANE_EXTENT, 0.0f, unit(random) * PLANE_EXTENT);
+	float2 uv(position.x / TESSELLATED_PLANE_RESOLUTION, position.z / TESSELLATED_PLANE_RESOLUTION);
+	float time = unit(random) * 100.0f;
+	float height = (s.heightMin + unit(random) * (s.heightMax - s.heightMin)) * s.heightAmplitude
+		+ getWaveOffset(float2(position.x, position.z), s.waveAmplitude, s.waveFrequency, s.waveSpeed, time);
+	return getManipulatedPosition(position, uv, height, s.sphere, s.planeToSphere, TESSELLATED_PLANE_RESOLUTION) + WORLD_OFFSET;
+}
+
+static void lookAtPerspective(float3 eye, float3 at, float viewProjection[4][4])
+{
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f), XMVectorSet(at.x, at.y, at.z, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, view * XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 200.0f));
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			viewProjection[i][j] = m.m[i][j];
+}
+
+static bool pointInFrustum(float3 p, const float m[4][4])
+{
+	float clip[4];
+	for (int c = 0; c < 4; c++)
+		clip[c] = p.x * m[0][c] + p.y * m[1][c] + p.z * m[2][c] + m[3][c];
+	return clip[0] >= -clip[3] && clip[0] <= clip[3] && clip[1] >= -clip[3] && clip[1] <= clip[3] && clip[2] >= 0.0f && clip[2] <= clip[3];
+}
+
+TEST(surfaceBoundsContainEveryVertex)
+{
+	std::mt19937 random(37);
+	for (int trial = 0; trial < 2000; trial++) {
+		SurfaceSettings s = randomSettings(random);
+		SurfaceBounds bounds = boundsFor(s);
+		for (int k = 0; k < 200; k++)
+			CHECK(bounds.contains(randomVertex(s, random)));
+	}
+}
+
+TEST(surfaceBoundsFlatPlane)
+{
+	SurfaceSettings s = {};
+	s.heightMin = 0.2f;
+	s.heightMax = 0.6f;
+	s.heightAmplitude = 10.0f;
+	s.waveAmplitude = float2(2.0f, 4.0f);
+	s.sphere = float4(0.0f, 0.0f, 0.0f, 10.0f);
+	SurfaceBounds bounds = boundsFor(s);
+
+	// flat, the box is the plane's extent and the heights plus half the combined wave amplitude
+	CHECK_CLOSE(bounds.getMin().x, WORLD_OFFSET.x, 1e-5f);
+	CHECK_CLOSE(bounds.getMax().x, WORLD_OFFSET.x + PLANE_EXTENT, 1e-5f);
+	CHECK_CLOSE(bounds.getMin().y, WORLD_OFFSET.y + 2.0f - 3.0f, 1e-5f);
+	CHECK_CLOSE(bounds.getMax().y, WORLD_OFFSET.y + 6.0f + 3.0f, 1e-5f);
+	CHECK_CLOSE(bounds.getMax().z, WORLD_OFFSET.z + PLANE_EXTENT, 1e-5f);
+
+	// a negative amplitude swaps which end of the heightmap is lowest
+	s.heightAmplitude = -10.0f;
+	bounds = boundsFor(s);
+	CHECK_CLOSE(bounds.getMin().y, WORLD_OFFSET.y - 6.0f - 3.0f, 1e-5f);
+	CHECK_CLOSE(bounds.getMax().y, WORLD_OFFSET.y - 2.0f + 3.0f, 1e-5f);
+}
+
+TEST(surfaceBoundsOnTheSphere)
+{
+	SurfaceSettings s = {};
+	s.heightMin = 0.0f;
+	s.heightMax = 1.0f;
+	s.heightAmplitude = 2.0f;
+	s.planeToSphere = 1.0f;
+	s.sphere = float4(5.0f, 6.0f, 7.0f, 10.0f);
+	SurfaceBounds bounds = boundsFor(s);
+
+	// fully wrapped, the bounds are the sphere grown by the tallest height, wherever the plane was
+	float3 centre = float3(5.0f, 6.0f, 7.0f) + WORLD_OFFSET;
+	CHECK_CLOSE(bounds.getMin().x, centre.x - 12.0f, 1e-5f);
+	CHECK_CLOSE(bounds.getMax().y, centre.y + 12.0f, 1e-5f);
+	CHECK_CLOSE(bounds.getCentre().z, centre.z, 1e-5f);
+	CHECK_CLOSE(bounds.getRadius(), 12.0f, 1e-5f);
+}
+
+TEST(surfaceBoundsSphereIsNoLooserThanTheBox)
+{
+	std::mt19937 random(38);
+	for (int trial = 0; trial < 2000; trial++) {
+		SurfaceBounds bounds = boundsFor(randomSettings(random));
+		float3 halfSize = (bounds.getMax() - bounds.getMin()) / 2.0f;
+		CHECK(bounds.getRadius() <= length(halfSize) + 1e-4f);
+	}
+}
+
+// the plane can only be culled when none of it is on screen
+TEST(surfaceBoundsNeverCullAVisibleVertex)
+{
+	std::mt19937 random(39);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	int culled = 0;
+
+	for (int trial = 0; trial < 2000; trial++) {
+		SurfaceSettings s = randomSettings(random);
+		SurfaceBounds bounds = boundsFor(s);
+
+		float viewProjection[4][4];
+		float3 eye(unit(random) * 80.0f, unit(random) * 80.0f, unit(random) * 80.0f);
+		lookAtPerspective(eye, eye + float3(unit(random), unit(random) * 0.9f, unit(random)), viewProjection);
+		if (bounds.intersects(viewProjection))
+			continue;
+
+		culled++;
+		for (int k = 0; k < 200; k++)
+			CHECK(!pointInFrustum(randomVertex(s, random), viewProjection));
+	}
+
+	// the cameras look every way, so plenty of them can't see the plane
+	CHECK(culled > 200);
+}
+
+TEST(surfaceBoundsIntersectsWhenLookingAtThePlane)
+{
+	SurfaceSettings s = {};
+	s.heightMax = 1.0f;
+	s.heightAmplitude = 5.0f;
+	s.sphere = float4(0.0f, 0.0f, 0.0f, 10.0f);
+	SurfaceBounds bounds = boundsFor(s);
+
+	float viewProjection[4][4];
+	float3 middle = (bounds.getMin() + bounds.getMax()) / 2.0f;
+	lookAtPerspective(middle + float3(0.0f, 20.0f, -40.0f), middle, viewProjection);
+	CHECK(bounds.intersects(viewProjection));
+
+	// turned around it's behind the camera
+	lookAtPerspective(middle + float3(0.0f, 20.0f, -40.0f), middle + float3(0.0f, 40.0f, -80.0f), viewProjection);
+	CHECK(!bounds.intersects(viewProjection));
+}
@@ -0,0 +1,117 @@
+// Surface query tests
+#include "Test.h"
+#include "SurfaceQuery.h"
+#include "WaveMath.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// bumps and noise, steep enough that the heightmap normal matters
+static void setBumps(DisplacementField& field)
+{
+	const int mapSize = 200;
+	std::vector<unsigned char> pixels(mapSize * mapSize);
+	for (int y = 0; y < mapSize; y++) {
+		for (int x = 0; x < mapSize; x++) {
+			unsigned int hash = (x * 73856093u) ^ (y * 19349663u);
+			hash = (hash ^ (hash >> 13)) * 1274126177u;
+			pixels[y * mapSize + x] = (unsigned char)(127.0f + 80.0f * sinf(x * 0.11f) * sinf(y * 0.08f) + (float)((hash >> 24) & 63) - 32.0f);
+		}
+	}
+	field.setHeightMap(pixels.data(), mapSize, mapSize, 1, mapSize);
+}
+
+static SurfaceQuery::Settings randomSettings(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	SurfaceQuery::Settings s;
+	s.time = unit(random) * 60.0f;
+	s.waveAmplitude = float2(unit(random) * 3.0f, unit(random) * 3.0f);
+	s.waveFrequency = float2(unit(random) * 4.0f, unit(random) * 4.0f);
+	s.waveSpeed = float2((unit(random) - 0.5f) * 20.0f, (unit(random) - 0.5f) * 20.0f);
+	s.heightAmplitude = unit(random) * 10.0f;
+	s.planeToSphere = unit(random) < 0.25f ? (unit(random) < 0.5f ? 0.0f : 1.0f) : unit(random);
+	s.sphere = float4((unit(random) - 0.5f) * 20.0f, (unit(random) - 0.5f) * 20.0f, (unit(random) - 0.5f) * 20.0f, 5.0f + unit(random) * 15.0f);
+	s.planeResolution = unit(random) < 0.5f ? (float)TESSELLATED_PLANE_RESOLUTION : (float)PLANE_RESOLUTION;
+	s.worldOffset = float3(-15.0f, -8.0f, -15.0f);
+	return s;
+}
+
+// the SSE batch against the scalar reference, over random uvs and settings. the batches are a few points past a multiple
+// of 4, so the last one is padded
+TEST(surfaceQueryBatchMatchesEvaluate)
+{
+	DisplacementField field(64, 64, 30.0f);
+	setBumps(field);
+	SurfaceQuery query(&field);
+	std::mt19937 random(38);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	for (int c = 0; c < 20; c++) {
+		SurfaceQuery::Settings settings = randomSettings(random);
+		query.setSettings(settings);
+
+		const int count = 1001 + c % 4;
+		std::vector<float2> uv(count);
+		for (int i = 0; i < count; i++)
+			uv[i] = float2(unit(random), unit(random));
+
+		std::vector<float3> positions(count), normals(count), positionsOnly(count + 1);
+		positionsOnly[count] = float3(1234.0f, 0.0f, 0.0f);
+		query.evaluateBatch(uv.data(), count, positions.data(), normals.data());
+		query.evaluateBatch(uv.data(), count, positionsOnly.data(), 0);
+		for (int i = 0; i < count; i++) {
+			float3 position, normal;
+			query.evaluate(uv[i], &position, &normal);
+			CHECK_CLOSE(length(positions[i] - position), 0.0f, 8e-6f);
+			CHECK_CLOSE(length(normals[i] - normal), 0.0f, 3e-5f);
+			// leaving out the normals doesn't change the positions
+			CHECK(positionsOnly[i].x == positions[i].x && positionsOnly[i].y == positions[i].y && positionsOnly[i].z == positions[i].z);
+		}
+		// and the padded batch only writes the points asked for
+		CHECK(positionsOnly[count].x == 1234.0f);
+	}
+
+	// fewer points than one batch
+	for (int count = 1; count < 4; count++) {
+		float2 uv[3] = { float2(0.1f, 0.9f), float2(0.5f, 0.5f), float2(0.93f, 0.02f) };
+		float3 positions[3], normals[3];
+		query.evaluateBatch(uv, count, positions, normals);
+		for (int i = 0; i < count; i++) {
+			float3 position, normal;
+			query.evaluate(uv[i], &position, &normal);
+			CHECK_CLOSE(length(positions[i] - position), 0.0f, 8e-6f);
+			CHECK_CLOSE(length(normals[i] - normal), 0.0f, 3e-5f);
+		}
+	}
+}
+
+// a picking or collision query's worth of points through the scalar path and the batch
+BENCHMARK(surfaceQueryBenchmark)
+{
+	DisplacementField field(64, 64, 30.0f);
+	setBumps(field);
+	SurfaceQuery query(&field);
+	std::mt19937 random(138);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	query.setSettings(randomSettings(random));
+
+	const int count = 100000;
+	std::vector<float2> uv(count);
+	for (int i = 0; i < count; i++)
+		uv[i] = float2(unit(random), unit(random));
+	std::vector<float3> positions(count), normals(count);
+
+	Stopwatch scalar;
+	for (int i = 0; i < count; i++)
+		query.evaluate(uv[i], &positions[i], &normals[i]);
+	double scalarTime = scalar.elapsed();
+	Stopwatch batch;
+	query.evaluateBatch(uv.data(), count, positions.data(), normals.data());
+	double batchTime = batch.elapsed();
+	Stopwatch positionsOnly;
+	query.evaluateBatch(uv.data(), count, positions.data(), 0);
+	double positionsTime = positionsOnly.elapsed();
+	printf("  scalar: %.1fM points/s, batch: %.1fM points/s, positions only: %.1fM points/s\n", count / scalarTime / 1000.0,
+		count / batchTime / 1000.0, count / positionsTime / 1000.0);
+}
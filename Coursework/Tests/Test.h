@@ -0,0 +1,54 @@
+// Test
+// A small self registering test harness for the parts of Coursework that don't need D3D. Each TEST runs every time,
+// each BENCHMARK only runs when Tests is started with "bench". CHECK and CHECK_CLOSE report the failure and carry on
+#pragma once
+
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+struct TestCase
+{
+	const char* name;
+	void (*run)();
+	bool benchmark;
+};
+
+std::vector<TestCase>& testCases();
+void testFailed(const char* file, int line, const char* message);
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*run)(), bool benchmark)
+	{
+		TestCase test = { name, run, benchmark };
+		testCases().push_back(test);
+	}
+};
+
+// milliseconds since it was made
+class Stopwatch
+{
+public:
+	Stopwatch() { start = std::chrono::high_resolution_clock::now(); };
+	double elapsed() const { return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count(); };
+
+private:
+	std::chrono::high_resolution_clock::time_point start;
+};
+
+#define TEST(name) static void name(); static TestRegistrar name##Registrar(#name, name, false); static void name()
+#define BENCHMARK(name) static void name(); static TestRegistrar name##Registrar(#name, name, true); static void name()
+
+#define CHECK(condition) do { if (!(condition)) testFailed(__FILE__, __LINE__, #condition); } while (0)
+
+// fails if a and b are further apart than tolerance, or either isn't a number
+#define CHECK_CLOSE(a, b, tolerance) do { \
+	double checkA = (double)(a), checkB = (double)(b); \
+	if (!(fabs(checkA - checkB) <= (tolerance))) { \
+		char checkMessage[256]; \
+		snprintf(checkMessage, sizeof(checkMessage), "%s (%g) is not within %g of %s (%g)", #a, checkA, (double)(tolerance), #b, checkB); \
+		testFailed(__FILE__, __LINE__, checkMessage); \
+	} \
+} while (0)
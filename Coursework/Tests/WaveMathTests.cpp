@@ -0,0 +1,171 @@
+// Wave math tests
+#include "Test.h"
+#include "WaveMath.h"
+#include <algorithm>
+#include <random>
+
+// the helpers the manipulation shaders each had their own copy of before they included WaveMath.h, as they were written
+
+// pointToSphere, with the seam closed for the tessellated plane
+static float3 shaderPointToSphere(float3 pos, float2 uv, float3 center, float radius)
+{
+	float pi = 3.14159265359f;
+	float resolution = 1 / (30.0f - 1.0f);
+	uv.x *= 1 + resolution;
+	uv.y *= 1 + resolution;
+	float lon = pi * (uv.x - 0.25f) * 2;
+	float lat = pi * (uv.y - 0.5f);
+
+	float r = radius + pos.y;
+	pos.x = -r * cosf(lat) * cosf(lon) + center.x;
+	pos.y = r * cosf(lat) * sinf(lon) + center.y;
+	pos.z = r * sinf(lat) + center.z;
+	return pos;
+}
+
+// rotateNormal, the rotation matrix built in full and the normal multiplied as a row vector
+static float3 shaderRotateNormal(float3 flatNorm, float3 newSurfaceNormal)
+{
+	float3 up(0.0f, 1.0f, 0.0f);
+	float3 b = normalize(newSurfaceNormal);
+	float3 u = normalize(cross(newSurfaceNormal, up));
+	float c = dot(up, b);
+	float s = sinf(acosf(c));
+
+	const float axis[3][3] = { { 0.0f, -u.z, u.y }, { u.z, 0.0f, -u.x }, { -u.y, u.x, 0.0f } };
+	float rotation[3][3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			float squared = 0.0f;
+			for (int k = 0; k < 3; k++)
+				squared += axis[i][k] * axis[k][j];
+			rotation[i][j] = (i == j ? 1.0f : 0.0f) + axis[i][j] * s + squared * ((1 - c) / powf(s, 2));
+		}
+	}
+
+	const float v[3] = { flatNorm.x, flatNorm.y, flatNorm.z };
+	float rotated[3];
+	for (int j = 0; j < 3; j++)
+		rotated[j] = v[0] * rotation[0][j] + v[1] * rotation[1][j] + v[2] * rotation[2][j];
+	return normalize(float3(rotated[0], rotated[1], rotated[2]));
+}
+
+// calculateNormal in manipulation_vs, its neighbours a unit apart on the plane
+static float3 shaderCalculateNormal(float h, float hN, float hS, float hE, float hW)
+{
+	float WorldStep = 1.0f;
+	float3 tan1 = normalize(float3(WorldStep, hE - h, 0.0f));
+	float3 tan2 = normalize(float3(-WorldStep, hW - h, 0.0f));
+	float3 bi1 = normalize(float3(0.0f, hN - h, WorldStep));
+	float3 bi2 = normalize(float3(0.0f, hS - h, -WorldStep));
+	return (cross(bi1, tan1) + cross(tan1, bi2) + cross(bi2, tan2) + cross(tan2, bi1)) * 0.25f;
+}
+
+// calculateWaveNormal in manipulation_vs before the analytic normal, the wave at five points step apart on the plane
+static float3 shaderCalculateWaveNormal(float2 pos, float2 amplitude, float2 frequency, float2 speed, float time, float step)
+{
+	float hN = getWaveOffset(float2(pos.x, pos.y + step), amplitude, frequency, speed, time);
+	float hS = getWaveOffset(float2(pos.x, pos.y - step), amplitude, frequency, speed, time);
+	float hE = getWaveOffset(float2(pos.x + step, pos.y), amplitude, frequency, speed, time);
+	float hW = getWaveOffset(float2(pos.x - step, pos.y), amplitude, frequency, speed, time);
+	float h = getWaveOffset(pos, amplitude, frequency, speed, time);
+
+	float3 tan1 = normalize(float3(step, hE - h, 0.0f));
+	float3 tan2 = normalize(float3(-step, hW - h, 0.0f));
+	float3 bi1 = normalize(float3(0.0f, hN - h, step));
+	float3 bi2 = normalize(float3(0.0f, hS - h, -step));
+	return (cross(bi1, tan1) + cross(tan1, bi2) + cross(bi2, tan2) + cross(tan2, bi1)) * 0.25f;
+}
+
+// the largest angle in degrees between the analytic wave normal and the finite difference one, over a 30x30 grid of the
+// plane at a few times
+static float largestWaveNormalAngle(float2 amplitude, float2 frequency, float step)
+{
+	float2 speed(1.0f, 1.0f);
+	float largest = 0.0f;
+	for (int t = 0; t < 8; t++) {
+		float time = t * 0.37f;
+		for (int z = 0; z < 30; z++) {
+			for (int x = 0; x < 30; x++) {
+				float2 pos((float)x, (float)z);
+				float3 analytic = getWaveNormal(pos, amplitude, frequency, speed, time);
+				float3 estimate = normalize(shaderCalculateWaveNormal(pos, amplitude, frequency, speed, time, step));
+				float cosine = std::min(std::max(dot(analytic, estimate), -1.0f), 1.0f);
+				largest = std::max(largest, acosf(cosine) * 180.0f / 3.14159265359f);
+			}
+		}
+	}
+	return largest;
+}
+
+static float3 randomDirection(std::mt19937& random)
+{
+	std::normal_distribution<float> normal;
+	return normalize(float3(normal(random), normal(random), normal(random)));
+}
+
+TEST(waveMathSpherePositionMatchesTheShaders)
+{
+	std::mt19937 random(38);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (int i = 0; i < 10000; i++) {
+		float2 uv(unit(random) * 29.0f / 30.0f, unit(random) * 29.0f / 30.0f);
+		float3 pos(uv.x * 30.0f, (unit(random) - 0.5f) * 6.0f, uv.y * 30.0f);
+		float4 sphere((unit(random) - 0.5f) * 40.0f, (unit(random) - 0.5f) * 40.0f, (unit(random) - 0.5f) * 40.0f, 2.0f + unit(random) * 20.0f);
+
+		float3 expected = shaderPointToSphere(pos, uv, float3(sphere.x, sphere.y, sphere.z), sphere.w);
+		float3 position = getSpherePosition(pos, uv, sphere, TESSELLATED_PLANE_RESOLUTION);
+		CHECK_CLOSE(length(position - expected), 0.0f, 1e-5f * (sphere.w + 40.0f));
+	}
+
+	// the last vertex's uv lands exactly on the first's, so the seam is closed
+	float4 sphere(0.0f, 0.0f, 0.0f, 10.0f);
+	float last = (TESSELLATED_PLANE_RESOLUTION - 1.0f) / TESSELLATED_PLANE_RESOLUTION;
+	float3 first = getSpherePosition(float3(0.0f, 0.0f, 0.0f), float2(0.0f, 0.5f), sphere, TESSELLATED_PLANE_RESOLUTION);
+	float3 wrapped = getSpherePosition(float3(0.0f, 0.0f, 0.0f), float2(last, 0.5f), sphere, TESSELLATED_PLANE_RESOLUTION);
+	CHECK_CLOSE(length(first - wrapped), 0.0f, 1e-4f);
+}
+
+// the cross product form has to turn normals exactly like the matrix, anywhere but straight above or below the centre
+// where the axis is undefined in both
+TEST(waveMathSphereNormalMatchesTheShaders)
+{
+	std::mt19937 random(138);
+	for (int i = 0; i < 10000; i++) {
+		float3 fromCentre = randomDirection(random) * 12.0f;
+		if (fabsf(fromCentre.y) > 11.99f)
+			continue;
+		float3 flatNormal = normalize(randomDirection(random) + float3(0.0f, 1.5f, 0.0f));
+
+		float3 expected = shaderRotateNormal(flatNormal, fromCentre);
+		float3 normal = getSphereNormal(flatNormal, fromCentre);
+		CHECK_CLOSE(length(normal - expected), 0.0f, 1e-4f);
+	}
+}
+
+TEST(waveMathHeightMapNormalMatchesTheShaders)
+{
+	std::mt19937 random(238);
+	std::uniform_real_distribution<float> height(-3.0f, 3.0f);
+	for (int i = 0; i < 10000; i++) {
+		float h = height(random), hN = height(random), hS = height(random), hE = height(random), hW = height(random);
+		float3 expected = shaderCalculateNormal(h, hN, hS, hE, hW);
+		float3 normal = getHeightMapNormal(h, hN, hS, hE, hW, 1.0f);
+		CHECK_CLOSE(length(normal - expected), 0.0f, 1e-6f);
+	}
+}
+
+// App1's default frequencies with both waves at amplitude 3. the 0.2 step the tessellation shaders used came within 0.12
+// degrees of the analytic normal, manipulation_vs's coarser 1.0 step cuts across the crests and was 2.8 degrees off
+TEST(waveMathWaveNormalMatchesTheFiniteDifference)
+{
+	float2 amplitude(3.0f, 3.0f), frequency(0.65f, 0.5f);
+	float fine = largestWaveNormalAngle(amplitude, frequency, 0.2f);
+	float coarse = largestWaveNormalAngle(amplitude, frequency, 1.0f);
+	CHECK(fine < 0.13f);
+	CHECK(coarse < 2.9f);
+	CHECK(fine < coarse);
+
+	// flat water has no waves to disagree about
+	CHECK(largestWaveNormalAngle(float2(0.0f, 0.0f), frequency, 1.0f) < 1e-3f);
+}
@@ -50,6 +50,10 @@ public:
 
 	/// Transfers mesh data to the GPU.
 	virtual void sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	/// Optional. Copies the positions, and the positions with texture coordinates, into slimmer vertex buffers for depth passes. Meshes using VertexType only
+	void buildDepthStreams(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+	/// Transfers the position only stream to the GPU, or position and texture coordinates for displaced geometry. Sends the full vertices if the streams weren't built
+	void sendDepthData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, bool texture = false);
 	int getIndexCount();			///< Returns total index value of the mesh
 	//D3D11_INPUT_ELEMENT_DESC getInputLayout();
 
@@ -57,6 +61,7 @@ protected:
 	virtual void initBuffers(ID3D11Device*) = 0;
 
 	ID3D11Buffer *vertexBuffer, *indexBuffer;
+	ID3D11Buffer *positionBuffer, *positionTextureBuffer;	///< Depth streams, null until buildDepthStreams
 	//D3D11_INPUT_ELEMENT_DESC *inputLayout;
 	int vertexCount, indexCount;
 };
@@ -54,13 +54,19 @@ public:
 	* Sets shader stages and draws the indexed data
 	*/
 	virtual void render(ID3D11DeviceContext* deviceContext, int vertexCount);
+	/** \Brief render function for stream output
+	* Sets shader stages and draws every vertex the last stream output pass wrote to the bound vertex buffer
+	*/
+	void renderAuto(ID3D11DeviceContext* deviceContext);
 	void compute(ID3D11DeviceContext* dc, int x, int y, int z);
 
 protected:
 	virtual void initShader(const wchar_t*, const wchar_t*) = 0;
+	void setShaders(ID3D11DeviceContext* deviceContext);	///< Binds the loaded stages, unused stages are cleared
 	void loadVertexShader(const wchar_t* filename);		///< Load Vertex shader, for stand position, tex, normal geomtry
 	void loadColourVertexShader(const wchar_t* filename);		///< Load Vertex shader, pre-made for position and colour only
 	void loadTextureVertexShader(const wchar_t* filename);		///< Load Vertex shader, pre-made for position and tex only
+	void loadPositionVertexShader(const wchar_t* filename);		///< Load Vertex shader, pre-made for position only
 	void loadHullShader(const wchar_t* filename);		///< Load Hull shader
 	void loadDomainShader(const wchar_t* filename);		///< Load Domain shader
 	void loadGeometryShader(const wchar_t* filename);	///< Load Geometry shader
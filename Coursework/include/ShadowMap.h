@@ -6,16 +6,30 @@ using namespace DirectX;
 class ShadowMap
 {
 public:
-	ShadowMap(ID3D11Device* device, int mWidth, int mHeight);
+	// arraySize is the number of slices, or the number of cubes (6 slices each) when cube is true
+	// cube faces are plain array slices in the order the shaders index them, there's no cube view
+	// format is the depth format, D16_UNORM, D24_UNORM_S8_UINT or D32_FLOAT
+	ShadowMap(ID3D11Device* device, int mWidth, int mHeight, int arraySize = 1, bool cube = false, DXGI_FORMAT format = DXGI_FORMAT_D24_UNORM_S8_UINT);
 	~ShadowMap();
 
-	void BindDsvAndSetNullRenderTarget(ID3D11DeviceContext* dc);
-	ID3D11ShaderResourceView* getDepthMapSRV() { return mDepthMapSRV; };
+	void BindDsvAndSetNullRenderTarget(ID3D11DeviceContext* dc, int slice = 0);
+	ID3D11ShaderResourceView* getDepthMapSRV() { return mDepthMapSRV; };	// Texture2D for a single map, Texture2DArray otherwise
+
+	int getWidth() { return width; };
+	int getHeight() { return height; };
+	int getSliceCount() { return sliceCount; };
+	DXGI_FORMAT getFormat() { return depthFormat; };
+	int getBytesPerTexel();
+	size_t getMemorySize();	// bytes used by every slice
 
 private:
-	ID3D11DepthStencilView* mDepthMapDSV;
+	ID3D11DepthStencilView** mDepthMapDSV;	// one per slice
 	ID3D11ShaderResourceView* mDepthMapSRV;
 	D3D11_VIEWPORT viewport;
 	ID3D11RenderTargetView* renderTargets[1];
 	ID3D11Texture2D* depthMap;
-};
\ No newline at end of file
+	int width;
+	int height;
+	int sliceCount;
+	DXGI_FORMAT depthFormat;
+};